@@ -300,6 +300,7 @@ void cfs_get_random_bytes(void *buf, int size);
 #include <libcfs/libcfs_workitem.h>
 #include <libcfs/libcfs_hash.h>
 #include <libcfs/libcfs_heap.h>
+#include <libcfs/libcfs_wheel.h>
 #include <libcfs/libcfs_fail.h>
 #include <libcfs/params_tree.h>
 #include <libcfs/libcfs_crypto.h>
@@ -0,0 +1,132 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License version 2 for more details.  A copy is
+ * included in the COPYING file that accompanied this code.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * GPL HEADER END
+ */
+/*
+ * libcfs/include/libcfs/libcfs_wheel.h
+ */
+
+#ifndef __LIBCFS_WHEEL_H__
+#define __LIBCFS_WHEEL_H__
+
+/** \defgroup wheel Timer wheel
+ *
+ * A hierarchical timer wheel with one second resolution, for subsystems that
+ * track many timeouts at once (adaptive timeouts, lock callbacks, pinger
+ * events) and want O(1) insertion and removal instead of a sorted list.
+ *
+ * The first level has one slot per second for the next CFS_WHEEL_L0_SIZE
+ * seconds, the second level has one slot per CFS_WHEEL_L0_SIZE seconds for
+ * the next CFS_WHEEL_L1_SIZE such windows, and anything further out sits on an
+ * overflow list. Nodes are moved down a level once their window comes close.
+ *
+ * A single timer is armed for the earliest non-empty second. When it fires,
+ * the wheel calls cfs_wheel_t::cw_notify() from timer context; the user then
+ * calls cfs_wheel_expire(), either from the callback itself or from a thread
+ * it wakes up, and gets all the nodes that are due in one list, so expiry is
+ * handled in batches.
+ *
+ * Like the binary heap, the wheel enforces no locking scheme: users serialize
+ * calls to add, delete and expire themselves, and are expected to keep one
+ * wheel per CPT where contention matters. A user that expires nodes from the
+ * notify callback must serialize with a lock that is safe to take from timer
+ * context (e.g. spin_lock_bh()), and must not sleep while expiring.
+ * @{
+ */
+
+#define CFS_WHEEL_L0_BITS	8
+#define CFS_WHEEL_L0_SIZE	(1 << CFS_WHEEL_L0_BITS)
+#define CFS_WHEEL_L0_MASK	(CFS_WHEEL_L0_SIZE - 1)
+#define CFS_WHEEL_L1_BITS	6
+#define CFS_WHEEL_L1_SIZE	(1 << CFS_WHEEL_L1_BITS)
+#define CFS_WHEEL_L1_MASK	(CFS_WHEEL_L1_SIZE - 1)
+
+/**
+ * Timer wheel node.
+ *
+ * Embedded into every object that is to be timed by a \e cfs_wheel_t.
+ */
+typedef struct {
+	/** linkage into a wheel slot, or the list returned by expire */
+	cfs_list_t		cwn_link;
+	/** expiry time, in seconds */
+	time_t			cwn_expiry;
+} cfs_wheel_node_t;
+
+struct cfs_wheel;
+
+typedef void (cfs_wheel_notify_t)(struct cfs_wheel *wheel);
+
+/**
+ * Timer wheel.
+ */
+typedef struct cfs_wheel {
+	/** one slot per second */
+	cfs_list_t		cw_l0[CFS_WHEEL_L0_SIZE];
+	/** one slot per CFS_WHEEL_L0_SIZE seconds */
+	cfs_list_t		cw_l1[CFS_WHEEL_L1_SIZE];
+	/** nodes too far in the future for the two levels above */
+	cfs_list_t		cw_overflow;
+	/** all seconds up to and including this one have been expired */
+	time_t			cw_now;
+	/** # nodes on the wheel */
+	unsigned int		cw_count;
+	/** fires at the earliest non-empty second */
+	struct timer_list	cw_timer;
+	/** called from the timer when nodes are due */
+	cfs_wheel_notify_t     *cw_notify;
+	/** private data of the user */
+	void		       *cw_private;
+} cfs_wheel_t;
+
+void cfs_wheel_init(cfs_wheel_t *w, cfs_wheel_notify_t *notify, void *arg);
+void cfs_wheel_fini(cfs_wheel_t *w);
+void cfs_wheel_stop(cfs_wheel_t *w);
+void cfs_wheel_add(cfs_wheel_t *w, cfs_wheel_node_t *e, time_t expiry);
+void cfs_wheel_del(cfs_wheel_t *w, cfs_wheel_node_t *e);
+int cfs_wheel_expire(cfs_wheel_t *w, time_t now, cfs_list_t *expired);
+
+static inline void cfs_wheel_node_init(cfs_wheel_node_t *e)
+{
+	CFS_INIT_LIST_HEAD(&e->cwn_link);
+	e->cwn_expiry = 0;
+}
+
+/**
+ * Whether \a e is linked into a wheel, or into the list it was expired to.
+ */
+static inline int cfs_wheel_node_is_queued(cfs_wheel_node_t *e)
+{
+	return !cfs_list_empty(&e->cwn_link);
+}
+
+static inline int cfs_wheel_is_empty(cfs_wheel_t *w)
+{
+	return w->cw_count == 0;
+}
+
+static inline unsigned int cfs_wheel_count(cfs_wheel_t *w)
+{
+	return w->cw_count;
+}
+
+/** @} wheel */
+
+#endif /* __LIBCFS_WHEEL_H__ */
@@ -159,6 +159,7 @@ int kmem_is_in_cache(const void *addr, const struct kmem_cache *kmem);
 	kmem_cache_alloc(cache, gfp)
 
 #define smp_rmb()	do {} while (0)
+#define smp_wmb()	do {} while (0)
 
 /*
  * Copy to/from user
@@ -0,0 +1,335 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License version 2 for more details.  A copy is
+ * included in the COPYING file that accompanied this code.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * GPL HEADER END
+ */
+/*
+ * libcfs/libcfs/wheel.c
+ */
+/** \addtogroup wheel
+ *
+ * @{
+ */
+
+#define DEBUG_SUBSYSTEM S_LNET
+
+#include <libcfs/libcfs.h>
+
+/** seconds covered by both levels of the wheel */
+#define CW_SPAN		(CFS_WHEEL_L0_SIZE * CFS_WHEEL_L1_SIZE)
+
+/**
+ * Returns the list a node expiring at \a expiry belongs to, given that all
+ * seconds up to cfs_wheel_t::cw_now have been expired already.
+ */
+static cfs_list_t *cfs_wheel_slot(cfs_wheel_t *w, time_t expiry)
+{
+	time_t	base = w->cw_now;
+
+	/* already due, pick it up on the next second */
+	if (expiry <= base)
+		expiry = base + 1;
+
+	if (expiry - base <= CFS_WHEEL_L0_SIZE)
+		return &w->cw_l0[expiry & CFS_WHEEL_L0_MASK];
+
+	/* the window is always in the future here, so it will be cascaded */
+	if ((expiry >> CFS_WHEEL_L0_BITS) - ((base + 1) >> CFS_WHEEL_L0_BITS) <=
+	    CFS_WHEEL_L1_SIZE)
+		return &w->cw_l1[(expiry >> CFS_WHEEL_L0_BITS) &
+				 CFS_WHEEL_L1_MASK];
+
+	return &w->cw_overflow;
+}
+
+/**
+ * Moves all nodes of \a head to the slots they belong to now.
+ */
+static void cfs_wheel_refile(cfs_wheel_t *w, cfs_list_t *head)
+{
+	cfs_wheel_node_t	*e;
+	CFS_LIST_HEAD		(tmp);
+
+	cfs_list_splice_init(head, &tmp);
+	while (!cfs_list_empty(&tmp)) {
+		e = cfs_list_entry(tmp.next, cfs_wheel_node_t, cwn_link);
+		cfs_list_move_tail(&e->cwn_link,
+				   cfs_wheel_slot(w, e->cwn_expiry));
+	}
+}
+
+/**
+ * Returns the next second at which the wheel has work to do, either nodes to
+ * expire or a window to cascade, or 0 if the wheel is empty.
+ */
+static time_t cfs_wheel_next(cfs_wheel_t *w)
+{
+	time_t	t;
+	int	idx;
+
+	if (w->cw_count == 0)
+		return 0;
+
+	for (t = w->cw_now + 1; t <= w->cw_now + CFS_WHEEL_L0_SIZE; t++) {
+		if ((t & CFS_WHEEL_L0_MASK) == 0) {
+			idx = (t >> CFS_WHEEL_L0_BITS) & CFS_WHEEL_L1_MASK;
+			if (!cfs_list_empty(&w->cw_l1[idx]) ||
+			    (idx == 0 && !cfs_list_empty(&w->cw_overflow)))
+				return t;
+		}
+		if (!cfs_list_empty(&w->cw_l0[t & CFS_WHEEL_L0_MASK]))
+			return t;
+	}
+
+	/* nothing in the first level, find the next window to cascade */
+	for (t = ((t >> CFS_WHEEL_L0_BITS) << CFS_WHEEL_L0_BITS);
+	     t <= w->cw_now + CW_SPAN; t += CFS_WHEEL_L0_SIZE) {
+		idx = (t >> CFS_WHEEL_L0_BITS) & CFS_WHEEL_L1_MASK;
+		if (!cfs_list_empty(&w->cw_l1[idx]) ||
+		    (idx == 0 && !cfs_list_empty(&w->cw_overflow)))
+			return t;
+	}
+
+	return t;
+}
+
+/**
+ * Arms the wheel timer for second \a t, unless it is armed earlier already.
+ */
+static void cfs_wheel_arm(cfs_wheel_t *w, time_t t)
+{
+	time_t		now = cfs_time_current_sec();
+	cfs_time_t	deadline;
+
+	if (t > now)
+		deadline = cfs_time_shift(t - now);
+	else
+		deadline = cfs_time_current();
+
+	if (!cfs_timer_is_armed(&w->cw_timer) ||
+	    cfs_time_before(deadline, cfs_timer_deadline(&w->cw_timer)))
+		cfs_timer_arm(&w->cw_timer, deadline);
+}
+
+static void cfs_wheel_timer(ulong_ptr_t data)
+{
+	cfs_wheel_t *w = (cfs_wheel_t *)data;
+
+	w->cw_notify(w);
+}
+
+/**
+ * Initializes a timer wheel.
+ *
+ * \param[in] w		The wheel
+ * \param[in] notify	Called from the wheel timer when nodes are due
+ * \param[in] arg	Private data of the user
+ */
+void cfs_wheel_init(cfs_wheel_t *w, cfs_wheel_notify_t *notify, void *arg)
+{
+	int	i;
+
+	for (i = 0; i < CFS_WHEEL_L0_SIZE; i++)
+		CFS_INIT_LIST_HEAD(&w->cw_l0[i]);
+	for (i = 0; i < CFS_WHEEL_L1_SIZE; i++)
+		CFS_INIT_LIST_HEAD(&w->cw_l1[i]);
+	CFS_INIT_LIST_HEAD(&w->cw_overflow);
+
+	w->cw_now = cfs_time_current_sec();
+	w->cw_count = 0;
+	w->cw_notify = notify;
+	w->cw_private = arg;
+	cfs_timer_init(&w->cw_timer, cfs_wheel_timer, w);
+}
+EXPORT_SYMBOL(cfs_wheel_init);
+
+/**
+ * Disarms the wheel timer, so that cw_notify() is not called anymore. The
+ * queued nodes are kept, and the timer is armed again by the next add or
+ * expire.
+ *
+ * \param[in] w The wheel
+ */
+void cfs_wheel_stop(cfs_wheel_t *w)
+{
+	cfs_timer_disarm(&w->cw_timer);
+}
+EXPORT_SYMBOL(cfs_wheel_stop);
+
+/**
+ * Stops the wheel timer. Nodes still queued are unlinked and left to their
+ * owners, which should have removed them by now.
+ *
+ * \param[in] w The wheel
+ */
+void cfs_wheel_fini(cfs_wheel_t *w)
+{
+	CFS_LIST_HEAD	(tmp);
+	unsigned int	 count = 0;
+	int		 idx;
+
+	cfs_wheel_stop(w);
+
+	for (idx = 0; idx < CFS_WHEEL_L0_SIZE; idx++)
+		cfs_list_splice_init(&w->cw_l0[idx], &tmp);
+	for (idx = 0; idx < CFS_WHEEL_L1_SIZE; idx++)
+		cfs_list_splice_init(&w->cw_l1[idx], &tmp);
+	cfs_list_splice_init(&w->cw_overflow, &tmp);
+
+	while (!cfs_list_empty(&tmp)) {
+		cfs_list_del_init(tmp.next);
+		count++;
+	}
+
+	if (count != 0 || w->cw_count != 0)
+		CERROR("timer wheel %p: %u nodes left (%u accounted)\n",
+		       w, count, w->cw_count);
+	w->cw_count = 0;
+}
+EXPORT_SYMBOL(cfs_wheel_fini);
+
+/**
+ * Queues a node to expire at \a expiry. A node which is due already will be
+ * returned by the next cfs_wheel_expire() that covers the next second.
+ *
+ * \param[in] w		The wheel
+ * \param[in] e		The node, which must not be queued
+ * \param[in] expiry	Expiry time, in seconds
+ */
+void cfs_wheel_add(cfs_wheel_t *w, cfs_wheel_node_t *e, time_t expiry)
+{
+	time_t	now;
+
+	LASSERT(cfs_list_empty(&e->cwn_link));
+
+	/* an idle wheel may be far behind, catch up for free */
+	if (w->cw_count == 0) {
+		now = cfs_time_current_sec();
+		if (w->cw_now < now - 1)
+			w->cw_now = now - 1;
+	}
+
+	e->cwn_expiry = expiry;
+	cfs_list_add_tail(&e->cwn_link, cfs_wheel_slot(w, expiry));
+	w->cw_count++;
+
+	cfs_wheel_arm(w, max(expiry, w->cw_now + 1));
+}
+EXPORT_SYMBOL(cfs_wheel_add);
+
+/**
+ * Removes a node from the wheel. Nodes which have been handed out by
+ * cfs_wheel_expire() belong to the caller, and are unlinked by it instead.
+ *
+ * \param[in] w The wheel
+ * \param[in] e The node, which must be queued on \a w
+ */
+void cfs_wheel_del(cfs_wheel_t *w, cfs_wheel_node_t *e)
+{
+	LASSERT(!cfs_list_empty(&e->cwn_link));
+	LASSERT(w->cw_count > 0);
+
+	cfs_list_del_init(&e->cwn_link);
+	if (--w->cw_count == 0)
+		cfs_timer_disarm(&w->cw_timer);
+}
+EXPORT_SYMBOL(cfs_wheel_del);
+
+/**
+ * Moves all nodes expiring at or before \a now to the tail of \a expired,
+ * cascading the later ones to the first level as their windows come up, and
+ * re-arms the timer for whatever is left.
+ *
+ * \param[in] w		The wheel
+ * \param[in] now	Current time, in seconds
+ * \param[out] expired	List to queue due nodes on, linked by cwn_link
+ *
+ * \retval		The number of nodes moved to \a expired
+ */
+int cfs_wheel_expire(cfs_wheel_t *w, time_t now, cfs_list_t *expired)
+{
+	cfs_wheel_node_t	*e;
+	cfs_list_t		*slot;
+	CFS_LIST_HEAD		(tmp);
+	time_t			 t;
+	int			 count = 0;
+	int			 idx;
+
+	if (w->cw_count == 0) {
+		if (w->cw_now < now)
+			w->cw_now = now;
+		return 0;
+	}
+
+	if (now - w->cw_now > CW_SPAN) {
+		/* far behind, sorting everything again is cheaper */
+		for (idx = 0; idx < CFS_WHEEL_L0_SIZE; idx++)
+			cfs_list_splice_init(&w->cw_l0[idx], &tmp);
+		for (idx = 0; idx < CFS_WHEEL_L1_SIZE; idx++)
+			cfs_list_splice_init(&w->cw_l1[idx], &tmp);
+		cfs_list_splice_init(&w->cw_overflow, &tmp);
+
+		w->cw_now = now;
+		while (!cfs_list_empty(&tmp)) {
+			e = cfs_list_entry(tmp.next, cfs_wheel_node_t,
+					   cwn_link);
+			if (e->cwn_expiry <= now) {
+				cfs_list_move_tail(&e->cwn_link, expired);
+				count++;
+			} else {
+				cfs_list_move_tail(&e->cwn_link,
+						   cfs_wheel_slot(w,
+							e->cwn_expiry));
+			}
+		}
+		goto out;
+	}
+
+	for (t = w->cw_now + 1; t <= now; t++) {
+		if ((t & CFS_WHEEL_L0_MASK) == 0) {
+			idx = (t >> CFS_WHEEL_L0_BITS) & CFS_WHEEL_L1_MASK;
+			if (idx == 0)
+				cfs_wheel_refile(w, &w->cw_overflow);
+			cfs_wheel_refile(w, &w->cw_l1[idx]);
+		}
+
+		slot = &w->cw_l0[t & CFS_WHEEL_L0_MASK];
+		while (!cfs_list_empty(slot)) {
+			cfs_list_move_tail(slot->next, expired);
+			count++;
+		}
+		w->cw_now = t;
+
+		if (count == w->cw_count) {
+			w->cw_now = now;
+			break;
+		}
+	}
+out:
+	w->cw_count -= count;
+	if (w->cw_count == 0)
+		cfs_timer_disarm(&w->cw_timer);
+	else
+		cfs_wheel_arm(w, cfs_wheel_next(w));
+
+	return count;
+}
+EXPORT_SYMBOL(cfs_wheel_expire);
+
+/** @} wheel */
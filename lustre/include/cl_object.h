@@ -2397,7 +2397,19 @@ struct cl_io {
 	/**
 	 * O_NOATIME
 	 */
-			     ci_noatime:1;
+			     ci_noatime:1,
+	/**
+	 * RPCs for pages submitted through this io are built and sent by
+	 * ptlrpcd rather than by the submitting thread. Set by lov on sub-ios
+	 * when a single submission spans several stripes, so that the stripes
+	 * are processed in parallel.
+	 */
+			     ci_async_rpc:1,
+	/**
+	 * The file was opened for parallel stripe submission
+	 * (LL_FILE_PARALLEL_IO), regardless of lov.*.parallel_stripes.
+	 */
+			     ci_parallel_stripes:1;
 	/**
 	 * Number of pages owned by this IO. For invariant checking.
 	 */
@@ -2798,6 +2810,8 @@ int             cl_page_gang_lookup (const struct lu_env *env,
                                      cl_page_gang_cb_t cb, void *cbdata);
 struct cl_page *cl_page_lookup      (struct cl_object_header *hdr,
                                      pgoff_t index);
+/** max # of pages handled by one cl_page_find_batch() call */
+#define CL_PAGE_BATCH_MAX 16
 struct cl_page *cl_page_find        (const struct lu_env *env,
                                      struct cl_object *obj,
                                      pgoff_t idx, struct page *vmpage,
@@ -2806,6 +2820,10 @@ struct cl_page *cl_page_find_sub    (const struct lu_env *env,
                                      struct cl_object *obj,
                                      pgoff_t idx, struct page *vmpage,
                                      struct cl_page *parent);
+void            cl_page_find_batch  (const struct lu_env *env,
+				     struct cl_object *obj,
+				     struct page **vmpages, int nr,
+				     struct cl_page **pages);
 void            cl_page_get         (struct cl_page *page);
 void            cl_page_put         (const struct lu_env *env,
                                      struct cl_page *page);
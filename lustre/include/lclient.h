@@ -442,6 +442,34 @@ struct cl_client_cache {
 	cfs_atomic_t	ccc_lru_left; /* # of LRU entries available */
 	unsigned long	ccc_lru_max;  /* Max # of LRU entries possible */
 	unsigned int	ccc_lru_shrinkers; /* # of threads reclaiming */
+	cfs_atomic_t	ccc_dirty_users; /* # of users with dirty pages */
+	cfs_atomic_t	ccc_dirty_idle; /* max_dirty_mb of the users without
+					 * dirty pages, in pages */
 };
 
+/**
+ * Bytes of dirty pages \a cli may cache. Besides its own max_dirty_mb, an
+ * OSC which is writing may use its share of the max_dirty_mb left unused by
+ * the OSCs of the mount which are not, so that a job writing to a few OSTs
+ * is not held back by limits sized for all of them writing at once. The
+ * OSCs of a mount together stay within the sum of their max_dirty_mb, and a
+ * single OSC within the largest value max_dirty_mb may be set to.
+ */
+static inline long ccc_dirty_max(struct client_obd *cli)
+{
+	struct cl_client_cache *cache = cli->cl_cache;
+	long			pages;
+
+	/* an idle OSC lends its limit, it starts sharing once it writes */
+	if (cache == NULL || cli->cl_dirty == 0)
+		return cli->cl_dirty_max;
+
+	pages = cfs_atomic_read(&cache->ccc_dirty_idle) /
+		max(cfs_atomic_read(&cache->ccc_dirty_users), 1);
+	pages += cli->cl_dirty_max >> PAGE_CACHE_SHIFT;
+	pages = min(pages, (long)OSC_MAX_DIRTY_MB_MAX <<
+			   (20 - PAGE_CACHE_SHIFT));
+	return max(cli->cl_dirty_max, pages << PAGE_CACHE_SHIFT);
+}
+
 #endif /*LCLIENT_H */
@@ -259,6 +259,7 @@ struct ost_id {
 #define LL_IOC_SET_LEASE		_IOWR('f', 243, long)
 #define LL_IOC_GET_LEASE		_IO('f', 244)
 #define LL_IOC_HSM_IMPORT		_IOWR('f', 245, struct hsm_user_import)
+#define LL_IOC_SYNC_RANGE		_IOW('f', 246, struct ll_sync_range)
 
 #define LL_STATFS_LMV		1
 #define LL_STATFS_LOV		2
@@ -291,6 +292,7 @@ struct ost_id {
 #define LL_FILE_LOCKED_DIRECTIO 0x00000008 /* client-side locks with dio */
 #define LL_FILE_LOCKLESS_IO     0x00000010 /* server-side locks with cio */
 #define LL_FILE_RMTACL          0x00000020
+#define LL_FILE_PARALLEL_IO     0x00000040 /* send stripes in parallel */
 
 #define LOV_USER_MAGIC_V1 0x0BD10BD0
 #define LOV_USER_MAGIC    LOV_USER_MAGIC_V1
@@ -867,6 +869,16 @@ struct ioc_data_version {
 #define LL_DV_RD_FLUSH (1 << 0) /* Flush dirty pages from clients */
 #define LL_DV_WR_FLUSH (1 << 1) /* Flush all caching pages from clients */
 
+struct ll_sync_range {
+	__u64	sr_start;
+	__u64	sr_end;		/* inclusive, OBD_OBJECT_EOF for all */
+	__u32	sr_flags;	/* See LL_SYNC_xxx */
+	__u32	sr_padding;
+};
+/* Without flags the writeback of the range is only started */
+#define LL_SYNC_WAIT	(1 << 0) /* Wait for the writes to reach the OSTs */
+#define LL_SYNC_COMMIT	(1 << 1) /* And for them to be committed there */
+
 #ifndef offsetof
 # define offsetof(typ,memb)     ((unsigned long)((char *)&(((typ *)0)->memb)))
 #endif
@@ -252,6 +252,19 @@ struct ldlm_pool {
 	cfs_atomic_t		pl_limit;
 	/** Number of granted locks in */
 	cfs_atomic_t		pl_granted;
+	/**
+	 * Memory used by the granted locks, the resources and LVBs of the
+	 * namespace and the extent interval nodes, in LDLM_POOL_MEM_SHIFT
+	 * units.
+	 */
+	cfs_atomic_t		pl_mem;
+	/**
+	 * Memory budget of the pool in bytes, the server SLV is computed
+	 * against the number of locks fitting in it. 0 means the budget is
+	 * derived from pl_limit and the nominal lock size. Protected by
+	 * pl_lock.
+	 */
+	__u64			pl_mem_budget;
 	/** Grant rate per T. */
 	cfs_atomic_t		pl_grant_rate;
 	/** Cancel rate per T. */
@@ -281,6 +294,28 @@ typedef int (*ldlm_res_policy)(struct ldlm_namespace *, struct ldlm_lock **,
 
 typedef int (*ldlm_cancel_for_recovery)(struct ldlm_lock *lock);
 
+/**
+ * Returns how much cached data (in pages) an unused client lock covers, used
+ * by the cost aware LRU policy to keep locks that are costly to lose.
+ */
+typedef unsigned long (*ldlm_weigh_callback)(struct ldlm_lock *lock);
+
+/**
+ * One shard of the client lock LRU.
+ *
+ * The LRU of a namespace is split per CPU partition, so that the locks used
+ * on different CPTs are added, touched and removed under different spinlocks.
+ * Each shard is in LRU order, the cancel policies pick the oldest lock among
+ * the shard heads.
+ */
+struct ldlm_lru_shard {
+	spinlock_t		ls_lock;
+	/** unused locks, linked via ldlm_lock::l_lru */
+	cfs_list_t		ls_list;
+	/** number of locks in ls_list */
+	int			ls_nr;
+} ____cacheline_aligned;
+
 /**
  * LVB operations.
  * LVB is Lock Value Block. This is a special opaque (to LDLM) value that could
@@ -407,18 +442,25 @@ struct ldlm_namespace {
 	cfs_list_t		ns_list_chain;
 
 	/**
-	 * List of unused locks for this namespace. This list is also called
-	 * LRU lock list.
+	 * Lists of unused locks for this namespace, one per CPU partition.
+	 * These lists are also called LRU lock list.
 	 * Unused locks are locks with zero reader/writer reference counts.
-	 * This list is only used on clients for lock caching purposes.
+	 * These lists are only used on clients for lock caching purposes.
 	 * When we want to release some locks voluntarily or if server wants
 	 * us to release some locks due to e.g. memory pressure, we take locks
-	 * to release from the head of this list.
+	 * to release from the heads of these lists.
 	 * Locks are linked via l_lru field in \see struct ldlm_lock.
 	 */
-	cfs_list_t		ns_unused_list;
-	/** Number of locks in the LRU list above */
-	int			ns_nr_unused;
+	struct ldlm_lru_shard	*ns_lru;
+	/** Number of LRU shards above */
+	int			ns_lru_nr;
+	/** Number of locks in all the LRU shards */
+	cfs_atomic_t		ns_nr_unused;
+	/**
+	 * If set, LRU cancellation picks among the oldest locks of the shards
+	 * the ones that are the cheapest to lose, see ldlm_lru_lock_value().
+	 */
+	unsigned int		ns_lru_cost_aware;
 
 	/**
 	 * Maximum number of locks permitted in the LRU. If 0, means locks
@@ -500,6 +542,9 @@ struct ldlm_namespace {
 	/** Callback to cancel locks before replaying it during recovery. */
 	ldlm_cancel_for_recovery ns_cancel_for_recovery;
 
+	/** Callback to weigh unused locks for the cost aware LRU policy. */
+	ldlm_weigh_callback	ns_weigh;
+
 	/** LDLM lock stats */
 	struct lprocfs_stats	*ns_stats;
 
@@ -561,6 +606,13 @@ static inline void ns_register_cancel(struct ldlm_namespace *ns,
         ns->ns_cancel_for_recovery = arg;
 }
 
+static inline void ns_register_weigh(struct ldlm_namespace *ns,
+				     ldlm_weigh_callback arg)
+{
+	LASSERT(ns != NULL);
+	ns->ns_weigh = arg;
+}
+
 struct ldlm_lock;
 
 /** Type for blocking callback function of a lock. */
@@ -688,9 +740,11 @@ struct ldlm_lock {
 	struct ldlm_resource	*l_resource;
 	/**
 	 * List item for client side LRU list.
-	 * Protected by ns_lock in struct ldlm_namespace.
+	 * Protected by ls_lock of the namespace LRU shard \a l_lru_shard.
 	 */
 	cfs_list_t		l_lru;
+	/** LRU shard the lock is on, valid while l_lru is not empty */
+	int			l_lru_shard;
 	/**
 	 * Linkage to resource's lock queues according to current lock state.
 	 * (could be granted, waiting or converting)
@@ -805,6 +859,13 @@ struct ldlm_lock {
 
 	enum lvb_type	      l_lvb_type;
 
+	/**
+	 * Inodebits the server asked to give up with blocking ASTs, the lock
+	 * may keep the other bits by dropping these only, see
+	 * ldlm_cli_dropbits(). Protected by lr_lock.
+	 */
+	__u64			l_ibits_cancel;
+
 	/**
 	 * Temporary storage for a LVB received during an enqueue operation.
 	 */
@@ -826,14 +887,13 @@ struct ldlm_lock {
 	__u64			l_client_cookie;
 
 	/**
-	 * List item for locks waiting for cancellation from clients.
-	 * The lists this could be linked into are:
-	 * waiting_locks_list (protected by waiting_locks_spinlock),
-	 * then if the lock timed out, it is moved to
-	 * expired_lock_thread.elt_expired_locks for further processing.
+	 * Timer wheel node for locks waiting for cancellation from clients.
+	 * The lock is queued on waiting_locks_wheel (protected by
+	 * waiting_locks_spinlock), then if the lock timed out, it is moved
+	 * to expired_lock_thread.elt_expired_locks for further processing.
 	 * Protected by elt_lock.
 	 */
-	cfs_list_t		l_pending_chain;
+	cfs_wheel_node_t	l_pending_node;
 
 	/**
 	 * Set when lock is sent a blocking AST. Time in seconds when timeout
@@ -894,6 +954,9 @@ struct ldlm_lock {
 	cfs_list_t		l_exp_list;
 };
 
+/* expired locks and client side cancel lists only need the list linkage */
+#define l_pending_chain		l_pending_node.cwn_link
+
 /**
  * LDLM resource description.
  * Basically, resource is a representation for a single object.
@@ -1420,6 +1483,7 @@ int ldlm_cli_enqueue_local(struct ldlm_namespace *ns,
 int ldlm_server_ast(struct lustre_handle *lockh, struct ldlm_lock_desc *new,
                     void *data, __u32 data_len);
 int ldlm_cli_convert(struct lustre_handle *, int new_mode, __u32 *flags);
+int ldlm_cli_dropbits(struct ldlm_lock *lock, __u64 drop_bits);
 int ldlm_cli_update_pool(struct ptlrpc_request *req);
 int ldlm_cli_cancel(struct lustre_handle *lockh,
 		    ldlm_cancel_flags_t cancel_flags);
@@ -310,6 +310,18 @@ static inline int exp_connect_lru_resize(struct obd_export *exp)
 	return !!(exp_connect_flags(exp) & OBD_CONNECT_LRU_RESIZE);
 }
 
+static inline int exp_connect_bl_batch(struct obd_export *exp)
+{
+	LASSERT(exp != NULL);
+	return !!(exp_connect_flags(exp) & OBD_CONNECT_BL_BATCH);
+}
+
+static inline int exp_connect_lock_convert(struct obd_export *exp)
+{
+	LASSERT(exp != NULL);
+	return !!(exp_connect_flags(exp) & OBD_CONNECT_LOCK_CONVERT);
+}
+
 static inline int exp_connect_rmtclient(struct obd_export *exp)
 {
 	LASSERT(exp != NULL);
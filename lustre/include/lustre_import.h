@@ -70,14 +70,6 @@ struct adaptive_timeout {
 	spinlock_t	at_lock;
 };
 
-struct ptlrpc_at_array {
-        cfs_list_t       *paa_reqs_array; /** array to hold requests */
-        __u32             paa_size;       /** the size of array */
-        __u32             paa_count;      /** the total count of reqs */
-        time_t            paa_deadline;   /** the earliest deadline of reqs */
-        __u32            *paa_reqs_count; /** the count of reqs in each entry */
-};
-
 #define IMP_AT_MAX_PORTALS 8
 struct imp_at {
         int                     iat_portal[IMP_AT_MAX_PORTALS];
@@ -167,6 +159,12 @@ struct obd_import {
         struct ptlrpc_client     *imp_client;
         /** List element for linking into pinger chain */
         cfs_list_t                imp_pinger_chain;
+	/**
+	 * Imports whose ping is carried by an aggregated ping, grouped by
+	 * server node. Protected by pinger_mutex.
+	 */
+	cfs_list_t		  imp_ping_agg_chain;
+	lnet_nid_t		  imp_ping_agg_nid;
         /** List element for linking into chain for destruction */
         cfs_list_t                imp_zombie_chain;
 
@@ -204,6 +204,19 @@ int llog_cat_process(const struct lu_env *env, struct llog_handle *cat_llh,
 int llog_cat_reverse_process(const struct lu_env *env,
 			     struct llog_handle *cat_llh, llog_cb_t cb,
 			     void *data);
+
+/* llog_cat_process_parallel() flags */
+enum llog_par_flags {
+	/** issue callbacks in catalog order, workers only read ahead */
+	LLOG_PAR_ORDERED	= 0x0001,
+};
+
+/** blocks of the next plain log read ahead by an ordered worker */
+#define LLOG_PAR_PREFETCH_BLOCKS	8
+
+int llog_cat_process_parallel(const struct lu_env *env,
+			      struct llog_handle *cat_llh, llog_cb_t cb,
+			      void *data, int nthreads, __u32 flags);
 int llog_cat_init_and_process(const struct lu_env *env,
 			      struct llog_handle *llh);
 
@@ -134,6 +134,10 @@
 #endif /* __KERNEL__ */
 
 #define PTLRPC_NTHRS_INIT	2
+/** seconds an idle service thread above the minimum is kept by default */
+#define PTLRPC_THR_IDLE_TIMEOUT	120
+/** # log2 buckets for the service time histogram, up to 2^23 usec */
+#define PTLRPC_SVC_TIME_BUCKETS	24
 
 /**
  * Buffer Constants
@@ -145,7 +149,10 @@
  * ?_MAXREQSIZE         # maximum request service will receive
  *
  * When fewer than ?_NBUFS/2 buffers are posted for receive, another chunk
- * of ?_NBUFS is added to the pool.
+ * of ?_NBUFS is added to the pool.  Under load the low watermark follows
+ * the observed request arrival rate instead, so that enough buffers are
+ * posted to absorb roughly 100ms worth of incoming requests before the
+ * pool runs dry.
  *
  * Messages larger than ?_MAXREQSIZE are dropped.  Request buffers are
  * considered full when less than ?_MAXREQSIZE is left in them.
@@ -675,6 +682,7 @@ struct ptlrpc_reply_state {
         unsigned long          rs_committed:1;/* the transaction was committed
                                                  and the rs was dispatched
                                                  by ptlrpc_commit_replies */
+	unsigned long		rs_cached:1;   /* rs from scp_rep_cache */
         /** Size of the state */
         int                    rs_size;
         /** opcode */
@@ -1787,13 +1795,12 @@ struct ptlrpc_request {
          */
         cfs_list_t rq_list;
         /**
-         * Server side list of incoming unserved requests sorted by arrival
-         * time.  Traversed from time to time to notice about to expire
-         * requests and sent back "early replies" to clients to let them
-         * know server is alive and well, just very busy to service their
-         * requests in time
+         * Server side timer wheel node of incoming unserved requests, due
+         * at_early_margin ahead of the request deadline, to send back
+         * "early replies" to clients to let them know server is alive and
+         * well, just very busy to service their requests in time
          */
-        cfs_list_t rq_timed_list;
+	cfs_wheel_node_t rq_timed_node;
         /** server-side history, used for debuging purposes. */
         cfs_list_t rq_history_list;
         /** server-side per-export list */
@@ -1812,8 +1819,6 @@ struct ptlrpc_request {
 	/** stub for NRS request */
 	struct ptlrpc_nrs_request rq_nrq;
 	/** @} nrs */
-        /** the index of service's srv_at_array into which request is linked */
-        time_t rq_at_index;
         /** Lock to protect request flags and some other important bits, like
          * rq_list
          */
@@ -1838,7 +1843,7 @@ struct ptlrpc_request {
                 /* server-side flags */
                 rq_packed_final:1,  /* packed final reply */
                 rq_hp:1,            /* high priority RPC */
-                rq_at_linked:1,     /* link into service's srv_at_array */
+                rq_at_linked:1,     /* link into service's scp_at_wheel */
                 rq_reply_truncate:1,
                 rq_committed:1,
                 /* whether the "rq_set" is a valid one */
@@ -2037,6 +2042,9 @@ struct ptlrpc_request {
         struct req_capsule          rq_pill;
 };
 
+/* the early reply lists only need the list linkage */
+#define rq_timed_list		rq_timed_node.cwn_link
+
 /**
  * Call completion handler for rpc if any, return it's status or original
  * rc if there was no handler defined for this request.
@@ -2310,6 +2318,7 @@ enum {
         SVC_RUNNING     = 1 << 3,
         SVC_EVENT       = 1 << 4,
         SVC_SIGNAL      = 1 << 5,
+	SVC_REAPING	= 1 << 6,
 };
 
 #define PTLRPC_THR_NAME_LEN		32
@@ -2362,6 +2371,11 @@ static inline int thread_is_stopping(struct ptlrpc_thread *thread)
         return !!(thread->t_flags & SVC_STOPPING);
 }
 
+static inline int thread_is_reaping(struct ptlrpc_thread *thread)
+{
+	return !!(thread->t_flags & SVC_REAPING);
+}
+
 static inline int thread_is_starting(struct ptlrpc_thread *thread)
 {
         return !!(thread->t_flags & SVC_STARTING);
@@ -2497,6 +2511,9 @@ struct ptlrpc_service {
 	int				srv_nthrs_cpt_init;
 	/** limit of threads number for each partition */
 	int				srv_nthrs_cpt_limit;
+	/** seconds a thread above srv_nthrs_cpt_init may stay idle, 0: never
+	 * reap idle threads */
+	int				srv_thr_idle_timeout;
         /** Root of /proc dir tree for this service */
         cfs_proc_dir_entry_t           *srv_procroot;
         /** Pointer to statistic data for this service */
@@ -2574,6 +2591,12 @@ struct ptlrpc_service_part {
 	int				scp_nthrs_running;
 	/** service threads list */
 	cfs_list_t			scp_threads;
+	/** # threads wanted for the predicted load */
+	int				scp_nthrs_want;
+	/** # threads started ahead of the predicted load */
+	unsigned long			scp_nthrs_prespawned;
+	/** # idle threads reaped */
+	unsigned long			scp_nthrs_reaped;
 
 	/**
 	 * serialize the following fields, used for protecting
@@ -2597,6 +2620,16 @@ struct ptlrpc_service_part {
 	cfs_list_t			scp_req_incoming;
 	/** timeout before re-posting reqs, in tick */
 	cfs_duration_t			scp_rqbd_timeout;
+	/** preallocated request descriptors for request_in_callback */
+	cfs_list_t			scp_req_idle;
+	/** # request descriptors on scp_req_idle */
+	int				scp_nreqs_idle;
+	/** # requests arrived since scp_req_rate_time */
+	int				scp_nreqs_arrived;
+	/** incoming request rate (reqs/sec), sizes the rqbd and req pools */
+	int				scp_req_rate;
+	/** when scp_req_rate was last sampled */
+	cfs_time_t			scp_req_rate_time;
 	/**
 	 * all threads sleep on this. This wait-queue is signalled when new
 	 * incoming request arrives and when difficult reply has to be handled.
@@ -2626,6 +2659,10 @@ struct ptlrpc_service_part {
 	int				scp_nhreqs_active;
 	/** # hp requests handled */
 	int				scp_hreq_count;
+	/** log2 histogram of service times (usec) in the current period */
+	unsigned int			scp_svc_time_hist[PTLRPC_SVC_TIME_BUCKETS];
+	/** 90th percentile of service time (usec) in the last period */
+	unsigned int			scp_svc_time_p90;
 
 	/** NRS head for regular requests */
 	struct ptlrpc_nrs		scp_nrs_reg;
@@ -2642,10 +2679,8 @@ struct ptlrpc_service_part {
 	spinlock_t			scp_at_lock __cfs_cacheline_aligned;
 	/** estimated rpc service time */
 	struct adaptive_timeout		scp_at_estimate;
-	/** reqs waiting for replies */
-	struct ptlrpc_at_array		scp_at_array;
-	/** early reply timer */
-	struct timer_list		scp_at_timer;
+	/** reqs waiting for early replies, with the early reply timer */
+	cfs_wheel_t			scp_at_wheel;
 	/** debug */
 	cfs_time_t			scp_at_checktime;
 	/** check early replies */
@@ -2665,10 +2700,28 @@ struct ptlrpc_service_part {
 #endif
 	/** List of free reply_states */
 	cfs_list_t			scp_rep_idle;
+	/**
+	 * # reply states of reaped threads which were in use then, to be
+	 * freed instead of going back to scp_rep_idle
+	 */
+	int				scp_rep_idle_excess;
 	/** waitq to run, when adding stuff to srv_free_rs_list */
 	wait_queue_head_t		scp_rep_waitq;
 	/** # 'difficult' replies */
 	cfs_atomic_t			scp_nreps_difficult;
+	/**
+	 * free reply states of srv_max_reply_size, allocated on this CPT and
+	 * reused before going back to the allocator
+	 */
+	cfs_list_t			scp_rep_cache;
+	/** # reply states on scp_rep_cache */
+	unsigned int			scp_rep_cache_count;
+	/** # reply states taken from, and allocated for, the cache */
+	unsigned long			scp_rep_cache_hits;
+	unsigned long			scp_rep_cache_misses;
+	/** committed replies handed to HR threads, and in how many batches */
+	unsigned long			scp_rep_commit_replies;
+	unsigned long			scp_rep_commit_batches;
 };
 
 #define ptlrpc_service_for_each_part(part, i, svc)			\
@@ -3096,15 +3149,20 @@ int liblustre_check_services(void *arg);
 void ptlrpc_daemonize(char *name);
 int ptlrpc_service_health_check(struct ptlrpc_service *);
 void ptlrpc_server_drop_request(struct ptlrpc_request *req);
+void ptlrpc_update_export_timer(struct obd_export *exp, long extra_delay);
 void ptlrpc_request_change_export(struct ptlrpc_request *req,
 				  struct obd_export *export);
 
 #ifdef __KERNEL__
 int ptlrpc_hr_init(void);
 void ptlrpc_hr_fini(void);
+void ptlrpc_hr_stats(struct cfs_cpt_table *cptab, int cpt,
+		     unsigned long *handled, unsigned long *wakeups);
 #else
 # define ptlrpc_hr_init() (0)
 # define ptlrpc_hr_fini() do {} while(0)
+# define ptlrpc_hr_stats(cptab, cpt, handled, wakeups)		\
+	do { *(handled) = *(wakeups) = 0; } while (0)
 #endif
 
 /** @} */
@@ -3152,6 +3210,7 @@ int lustre_pack_reply_flags(struct ptlrpc_request *, int count, __u32 *lens,
 int lustre_shrink_msg(struct lustre_msg *msg, int segment,
                       unsigned int newlen, int move_data);
 void lustre_free_reply_state(struct ptlrpc_reply_state *rs);
+void lustre_free_reply_states(cfs_list_t *list);
 int __lustre_unpack_msg(struct lustre_msg *m, int len);
 int lustre_msg_hdr_size(__u32 magic, int count);
 int lustre_msg_size(__u32 magic, int count, __u32 *lengths);
@@ -292,6 +292,8 @@ struct timeout_item {
         void              *ti_cb_data;
         cfs_list_t         ti_obd_list;
         cfs_list_t         ti_chain;
+	/* queued on the pinger wheel until the callback is due */
+	cfs_wheel_node_t   ti_node;
 };
 
 #define OSC_MAX_RIF_DEFAULT       8
@@ -395,6 +397,7 @@ struct client_obd {
 	/* lru for osc caching pages */
 	struct cl_client_cache	*cl_cache;
 	cfs_list_t		 cl_lru_osc; /* member of cl_cache->ccc_lru */
+	cfs_list_t		 cl_shrink_list; /* member of osc_shrink_list */
 	cfs_atomic_t		*cl_lru_left;
 	cfs_atomic_t		 cl_lru_busy;
 	cfs_atomic_t		 cl_lru_shrinkers;
@@ -577,6 +580,10 @@ struct lov_obd {
 	void		       *lov_cache;
 
 	struct rw_semaphore     lov_notify_lock;
+
+	/* submissions spanning at least this many stripes have their RPCs
+	 * sent by ptlrpcd in parallel, 0 to disable */
+	int			lov_parallel_stripes;
 };
 
 struct lmv_tgt_desc {
@@ -821,11 +828,34 @@ struct obd_notify_upcall {
         void *onu_owner;
 };
 
+/* max number of threads replaying locks during target recovery */
+#define TRD_LOCK_THREADS_MAX	16
+
+/* recovery phases, timed in target_recovery_data::trd_phase_ms */
+enum target_recovery_phase {
+	TRD_PHASE_CONNECT = 0,	/* waiting for clients to reconnect */
+	TRD_PHASE_REQ_REPLAY,	/* replaying requests in transno order */
+	TRD_PHASE_LOCK_REPLAY,	/* replaying locks */
+	TRD_PHASE_FINAL,	/* replying to final pings */
+	TRD_PHASE_NR
+};
+
 struct target_recovery_data {
 	svc_handler_t		trd_recovery_handler;
 	pid_t			trd_processing_task;
 	struct completion	trd_starting;
 	struct completion	trd_finishing;
+	/* lock replay requests handed over to the lock replay threads, one
+	 * queue per thread, protected by obd_recovery_task_lock as other
+	 * recovery lists */
+	cfs_list_t		trd_lock_queue[TRD_LOCK_THREADS_MAX];
+	wait_queue_head_t	trd_lock_waitq;
+	struct completion	trd_lock_started;
+	int			trd_lock_threads;	/* threads running */
+	int			trd_lock_inflight;	/* queued or handled */
+	int			trd_lock_stopping;
+	/* duration of each recovery phase, in milliseconds */
+	unsigned int		trd_phase_ms[TRD_PHASE_NR];
 };
 
 struct obd_llog_group {
@@ -1028,6 +1058,7 @@ enum obd_cleanup_stage {
 
 #define KEY_CACHE_SET		"cache_set"
 #define KEY_CACHE_LRU_SHRINK	"cache_lru_shrink"
+#define KEY_SRVLOCK		"srvlock"
 #define KEY_CHANGELOG_INDEX	"changelog_index"
 
 struct lu_context;
@@ -68,6 +68,8 @@ struct osc_setattr_args {
         struct obdo         *sa_oa;
         obd_enqueue_update_f sa_upcall;
         void                *sa_cookie;
+	/* where to store the transno of the reply, if not NULL */
+	__u64		    *sa_transno;
 };
 
 struct osc_fsync_args {
@@ -292,6 +292,11 @@ static void ldlm_extent_policy(struct ldlm_resource *res,
                 /* fast-path whole file locks */
                 return;
 
+	/* grant the requested extent only, so that a client gets many
+	 * locks on the same object */
+	if (OBD_FAIL_CHECK(OBD_FAIL_LDLM_NO_EXPANSION))
+		return;
+
         ldlm_extent_internal_policy_granted(lock, &new_ex);
         ldlm_extent_internal_policy_waiting(lock, &new_ex);
 
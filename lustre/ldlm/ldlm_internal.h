@@ -94,6 +94,10 @@ void ldlm_namespace_move_to_active_locked(struct ldlm_namespace *, ldlm_side_t);
 void ldlm_namespace_move_to_inactive_locked(struct ldlm_namespace *, ldlm_side_t);
 struct ldlm_namespace *ldlm_namespace_first_locked(ldlm_side_t);
 
+/* ldlm_pool.c */
+void ldlm_pool_mem_add(struct ldlm_pool *pl, int bytes);
+void ldlm_pool_mem_del(struct ldlm_pool *pl, int bytes);
+
 /* ldlm_request.c */
 /* Cancel lru flag, it indicates we cancel aged locks. */
 enum {
@@ -105,6 +109,11 @@ enum {
                                       * sending nor waiting for any rpcs) */
 };
 
+/* number of oldest locks per LRU shard compared by the cost aware policy */
+#define LDLM_LRU_COST_WINDOW	8
+/* fixed point scale of the lock value computed by ldlm_lru_lock_value() */
+#define LDLM_LRU_VALUE_SCALE	1024
+
 int ldlm_cancel_lru(struct ldlm_namespace *ns, int nr,
 		    ldlm_cancel_flags_t sync, int flags);
 int ldlm_cancel_lru_local(struct ldlm_namespace *ns,
@@ -122,12 +131,18 @@ void ldlm_namespace_free_prior(struct ldlm_namespace *ns,
 void ldlm_namespace_free_post(struct ldlm_namespace *ns);
 /* ldlm_lock.c */
 
+/* max number of locks notified by one batched blocking AST */
+#define LDLM_BL_BATCH_MAX	32
+/* max number of BL AST work items looked at to fill a batch */
+#define LDLM_BL_BATCH_SCAN	256
+
 struct ldlm_cb_set_arg {
 	struct ptlrpc_request_set	*set;
 	int				 type; /* LDLM_{CP,BL,GL}_CALLBACK */
 	cfs_atomic_t			 restart;
 	cfs_list_t			*list;
 	union ldlm_gl_desc		*gl_desc; /* glimpse AST descriptor */
+	struct ldlm_lock		*bl_batch[LDLM_BL_BATCH_MAX];
 };
 
 typedef enum {
@@ -138,6 +153,7 @@ typedef enum {
 } ldlm_desc_ast_t;
 
 void ldlm_grant_lock(struct ldlm_lock *lock, cfs_list_t *work_list);
+void ldlm_inodebits_drop(struct ldlm_lock *lock, __u64 to_drop);
 int ldlm_fill_lvb(struct ldlm_lock *lock, struct req_capsule *pill,
 		  enum req_location loc, void *data, int size);
 struct ldlm_lock *
@@ -179,6 +195,10 @@ int ldlm_bl_to_thread_list(struct ldlm_namespace *ns,
 
 void ldlm_handle_bl_callback(struct ldlm_namespace *ns,
                              struct ldlm_lock_desc *ld, struct ldlm_lock *lock);
+#ifdef HAVE_SERVER_SUPPORT
+int ldlm_server_blocking_ast_batch(struct ldlm_lock **locks, int count,
+				   struct ldlm_lock_desc *desc, void *data);
+#endif
 
 #ifdef HAVE_SERVER_SUPPORT
 /* ldlm_plain.c */
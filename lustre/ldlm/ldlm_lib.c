@@ -365,6 +365,7 @@ int client_obd_setup(struct obd_device *obddev, struct lustre_cfg *lcfg)
 
 	/* lru for osc. */
 	CFS_INIT_LIST_HEAD(&cli->cl_lru_osc);
+	CFS_INIT_LIST_HEAD(&cli->cl_shrink_list);
 	cfs_atomic_set(&cli->cl_lru_shrinkers, 0);
 	cfs_atomic_set(&cli->cl_lru_busy, 0);
 	cfs_atomic_set(&cli->cl_lru_in_list, 0);
@@ -1385,6 +1386,19 @@ static void target_exp_dequeue_req_replay(struct ptlrpc_request *req)
 }
 
 #ifdef __KERNEL__
+static int recovery_lock_threads = 4;
+CFS_MODULE_PARM(recovery_lock_threads, "i", int, 0644,
+		"number of threads replaying locks during target recovery, "
+		"0 or 1 to replay locks from the recovery thread only");
+
+/* wait until the lock replay threads have handled all queued requests */
+static void target_lock_replay_drain(struct obd_device *obd)
+{
+	struct target_recovery_data *trd = &obd->obd_recovery_data;
+
+	wait_event(trd->trd_lock_waitq, trd->trd_lock_inflight == 0);
+}
+
 static void target_finish_recovery(struct obd_device *obd)
 {
         ENTRY;
@@ -1794,6 +1808,10 @@ static int target_recovery_overseer(struct obd_device *obd,
 {
 repeat:
 	wait_event(obd->obd_next_transno_waitq, check_routine(obd));
+	/* do not evict exports the lock replay threads are still working
+	 * for */
+	if (obd->obd_abort_recovery || obd->obd_recovery_expired)
+		target_lock_replay_drain(obd);
 	if (obd->obd_abort_recovery) {
 		CWARN("recovery is aborted, evict exports in recovery\n");
 		/** evict exports which didn't finish recovery yet */
@@ -1871,6 +1889,7 @@ static struct ptlrpc_request *target_next_replay_lock(struct obd_device *obd)
 		spin_unlock(&obd->obd_recovery_task_lock);
                 LASSERT(cfs_list_empty(&obd->obd_lock_replay_queue));
                 LASSERT(cfs_atomic_read(&obd->obd_lock_replay_clients) == 0);
+		target_lock_replay_drain(obd);
                 /** evict exports failed VBR */
                 class_disconnect_stale_exports(obd, exp_vbr_healthy);
         }
@@ -1962,41 +1981,169 @@ reqcopy_put:
         RETURN(rc);
 }
 
+/* set up the ptlrpc_thread and environment of a recovery thread */
+static struct ptlrpc_thread *target_recovery_thread_init(void)
+{
+	struct ptlrpc_thread	*thread;
+	struct lu_env		*env;
+	int			 rc;
+
+	unshare_fs_struct();
+	OBD_ALLOC_PTR(thread);
+	if (thread == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	OBD_ALLOC_PTR(env);
+	if (env == NULL) {
+		OBD_FREE_PTR(thread);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	rc = lu_context_init(&env->le_ctx, LCT_MD_THREAD | LCT_DT_THREAD);
+	if (rc) {
+		OBD_FREE_PTR(thread);
+		OBD_FREE_PTR(env);
+		return ERR_PTR(rc);
+	}
+
+	thread->t_env = env;
+	thread->t_id = -1; /* force filter_iobuf_get/put to use local buffers */
+	env->le_ctx.lc_thread = thread;
+	thread->t_data = NULL;
+	thread->t_watchdog = NULL;
+	return thread;
+}
+
+static void target_recovery_thread_fini(struct ptlrpc_thread *thread)
+{
+	struct lu_env *env = thread->t_env;
+
+	lu_context_fini(&env->le_ctx);
+	OBD_FREE_PTR(thread);
+	OBD_FREE_PTR(env);
+}
+
+/**
+ * Lock replay thread.
+ *
+ * Replayed locks do not depend on each other, so unlike requests which
+ * are replayed one at a time in transno order, lock replay requests can be
+ * handled in parallel. The main recovery thread keeps control of the lock
+ * replay queue and of stale client eviction, and hands requests over to a
+ * pool of these threads through trd_lock_queue. All lock replays of one
+ * export go to the same thread, so that they are handled in the order the
+ * client sent them.
+ */
+static int target_lock_replay_thread(void *arg)
+{
+	struct lu_target		*lut = arg;
+	struct obd_device		*obd = lut->lut_obd;
+	struct target_recovery_data	*trd = &obd->obd_recovery_data;
+	struct ptlrpc_request		*req;
+	struct ptlrpc_thread		*thread;
+	cfs_list_t			*queue;
+	ENTRY;
+
+	thread = target_recovery_thread_init();
+	if (IS_ERR(thread)) {
+		complete(&trd->trd_lock_started);
+		RETURN(PTR_ERR(thread));
+	}
+
+	/* threads are started one at a time, each takes the next queue */
+	spin_lock(&obd->obd_recovery_task_lock);
+	queue = &trd->trd_lock_queue[trd->trd_lock_threads++];
+	spin_unlock(&obd->obd_recovery_task_lock);
+	complete(&trd->trd_lock_started);
+
+	while (1) {
+		wait_event(trd->trd_lock_waitq,
+			   !cfs_list_empty(queue) || trd->trd_lock_stopping);
+
+		spin_lock(&obd->obd_recovery_task_lock);
+		if (cfs_list_empty(queue)) {
+			spin_unlock(&obd->obd_recovery_task_lock);
+			if (trd->trd_lock_stopping)
+				break;
+			continue;
+		}
+		req = cfs_list_entry(queue->next,
+				     struct ptlrpc_request, rq_list);
+		cfs_list_del_init(&req->rq_list);
+		spin_unlock(&obd->obd_recovery_task_lock);
+
+		DEBUG_REQ(D_HA, req, "processing lock from %s: ",
+			  libcfs_nid2str(req->rq_peer.nid));
+		handle_recovery_req(thread, req, trd->trd_recovery_handler);
+		target_request_copy_put(req);
+
+		spin_lock(&obd->obd_recovery_task_lock);
+		obd->obd_replayed_locks++;
+		trd->trd_lock_inflight--;
+		spin_unlock(&obd->obd_recovery_task_lock);
+		wake_up_all(&trd->trd_lock_waitq);
+	}
+
+	target_recovery_thread_fini(thread);
+
+	spin_lock(&obd->obd_recovery_task_lock);
+	trd->trd_lock_threads--;
+	spin_unlock(&obd->obd_recovery_task_lock);
+	wake_up_all(&trd->trd_lock_waitq);
+	RETURN(0);
+}
+
+/* start the lock replay threads, return the number of threads running */
+static int target_lock_replay_start(struct lu_target *lut)
+{
+	struct obd_device		*obd = lut->lut_obd;
+	struct target_recovery_data	*trd = &obd->obd_recovery_data;
+	int				 i;
+
+	if (recovery_lock_threads <= 1)
+		return 0;
+
+	for (i = 0; i < min(recovery_lock_threads, TRD_LOCK_THREADS_MAX);
+	     i++) {
+		init_completion(&trd->trd_lock_started);
+		if (IS_ERR(kthread_run(target_lock_replay_thread, lut,
+				       "tgt_recov_%02d", i)))
+			break;
+		wait_for_completion(&trd->trd_lock_started);
+	}
+
+	CDEBUG(D_HA, "%s: %d lock replay threads started\n", obd->obd_name,
+	       trd->trd_lock_threads);
+	return trd->trd_lock_threads;
+}
+
+/* wait for pending lock replays to complete and stop the threads */
+static void target_lock_replay_stop(struct obd_device *obd)
+{
+	struct target_recovery_data *trd = &obd->obd_recovery_data;
+
+	target_lock_replay_drain(obd);
+	trd->trd_lock_stopping = 1;
+	wake_up_all(&trd->trd_lock_waitq);
+	wait_event(trd->trd_lock_waitq, trd->trd_lock_threads == 0);
+}
+
 static int target_recovery_thread(void *arg)
 {
         struct lu_target *lut = arg;
         struct obd_device *obd = lut->lut_obd;
         struct ptlrpc_request *req;
         struct target_recovery_data *trd = &obd->obd_recovery_data;
-        unsigned long delta;
-        struct lu_env *env;
+        unsigned long delta, phase;
         struct ptlrpc_thread *thread = NULL;
+        int lock_threads;
         int rc = 0;
+        int i;
         ENTRY;
 
-	unshare_fs_struct();
-        OBD_ALLOC_PTR(thread);
-        if (thread == NULL)
-                RETURN(-ENOMEM);
-
-        OBD_ALLOC_PTR(env);
-        if (env == NULL) {
-                OBD_FREE_PTR(thread);
-                RETURN(-ENOMEM);
-        }
-
-        rc = lu_context_init(&env->le_ctx, LCT_MD_THREAD | LCT_DT_THREAD);
-        if (rc) {
-                OBD_FREE_PTR(thread);
-                OBD_FREE_PTR(env);
-                RETURN(rc);
-        }
-
-        thread->t_env = env;
-        thread->t_id = -1; /* force filter_iobuf_get/put to use local buffers */
-        env->le_ctx.lc_thread = thread;
-        thread->t_data = NULL;
-        thread->t_watchdog = NULL;
+	thread = target_recovery_thread_init();
+	if (IS_ERR(thread))
+		RETURN(PTR_ERR(thread));
 
 	CDEBUG(D_HA, "%s: started recovery thread pid %d\n", obd->obd_name,
 	       current_pid());
@@ -2007,15 +2154,19 @@ static int target_recovery_thread(void *arg)
 	spin_unlock(&obd->obd_dev_lock);
 	complete(&trd->trd_starting);
 
+	phase = jiffies;
         /* first of all, we have to know the first transno to replay */
         if (target_recovery_overseer(obd, check_for_clients,
                                      exp_connect_healthy)) {
                 abort_req_replay_queue(obd);
                 abort_lock_replay_queue(obd);
         }
+	trd->trd_phase_ms[TRD_PHASE_CONNECT] = jiffies_to_msecs(jiffies -
+								phase);
 
         /* next stage: replay requests */
         delta = jiffies;
+	phase = jiffies;
         CDEBUG(D_INFO, "1: request replay stage - %d clients from t"LPU64"\n",
                cfs_atomic_read(&obd->obd_req_replay_clients),
                obd->obd_next_recovery_transno);
@@ -2037,14 +2188,30 @@ static int target_recovery_thread(void *arg)
                 target_request_copy_put(req);
                 obd->obd_replayed_requests++;
         }
+	trd->trd_phase_ms[TRD_PHASE_REQ_REPLAY] = jiffies_to_msecs(jiffies -
+								   phase);
 
         /**
          * The second stage: replay locks
          */
-        CDEBUG(D_INFO, "2: lock replay stage - %d clients\n",
-               cfs_atomic_read(&obd->obd_lock_replay_clients));
+	phase = jiffies;
+	lock_threads = target_lock_replay_start(lut);
+	CDEBUG(D_INFO, "2: lock replay stage - %d clients, %d threads\n",
+	       cfs_atomic_read(&obd->obd_lock_replay_clients), lock_threads);
 	while ((req = target_next_replay_lock(obd))) {
 		LASSERT(trd->trd_processing_task == current_pid());
+		if (lock_threads > 0) {
+			/* keep the lock replays of an export in order */
+			i = cfs_hash_long((unsigned long)req->rq_export, 16) %
+			    lock_threads;
+			spin_lock(&obd->obd_recovery_task_lock);
+			cfs_list_add_tail(&req->rq_list,
+					  &trd->trd_lock_queue[i]);
+			trd->trd_lock_inflight++;
+			spin_unlock(&obd->obd_recovery_task_lock);
+			wake_up_all(&trd->trd_lock_waitq);
+			continue;
+		}
 		DEBUG_REQ(D_HA, req, "processing lock from %s: ",
 			  libcfs_nid2str(req->rq_peer.nid));
                 handle_recovery_req(thread, req,
@@ -2052,12 +2219,17 @@ static int target_recovery_thread(void *arg)
                 target_request_copy_put(req);
                 obd->obd_replayed_locks++;
         }
+	if (lock_threads > 0)
+		target_lock_replay_stop(obd);
+	trd->trd_phase_ms[TRD_PHASE_LOCK_REPLAY] = jiffies_to_msecs(jiffies -
+								    phase);
 
         /**
          * The third stage: reply on final pings, at this moment all clients
          * must have request in final queue
          */
         CDEBUG(D_INFO, "3: final stage - process recovery completion pings\n");
+	phase = jiffies;
         /** Update server last boot epoch */
         tgt_boot_epoch_update(lut);
         /* We drop recoverying flag to forward all new requests
@@ -2076,6 +2248,7 @@ static int target_recovery_thread(void *arg)
                                     trd->trd_recovery_handler);
                 target_request_copy_put(req);
         }
+	trd->trd_phase_ms[TRD_PHASE_FINAL] = jiffies_to_msecs(jiffies - phase);
 
 	delta = (jiffies - delta) / HZ;
 	CDEBUG(D_INFO,"4: recovery completed in %lus - %d/%d reqs/locks\n",
@@ -2087,12 +2260,10 @@ static int target_recovery_thread(void *arg)
 
         target_finish_recovery(obd);
 
-        lu_context_fini(&env->le_ctx);
+	target_recovery_thread_fini(thread);
         trd->trd_processing_task = 0;
 	complete(&trd->trd_finishing);
 
-        OBD_FREE_PTR(thread);
-        OBD_FREE_PTR(env);
         RETURN(rc);
 }
 
@@ -2101,11 +2272,15 @@ static int target_start_recovery_thread(struct lu_target *lut,
 {
 	struct obd_device *obd = lut->lut_obd;
 	int rc = 0;
+	int i;
 	struct target_recovery_data *trd = &obd->obd_recovery_data;
 
 	memset(trd, 0, sizeof(*trd));
 	init_completion(&trd->trd_starting);
 	init_completion(&trd->trd_finishing);
+	for (i = 0; i < TRD_LOCK_THREADS_MAX; i++)
+		CFS_INIT_LIST_HEAD(&trd->trd_lock_queue[i]);
+	init_waitqueue_head(&trd->trd_lock_waitq);
 	trd->trd_recovery_handler = handler;
 
 	if (!IS_ERR(kthread_run(target_recovery_thread,
@@ -2216,6 +2391,16 @@ static int target_process_req_flags(struct obd_device *obd,
 	return 0;
 }
 
+/* whether \a req is being handled by a lock replay thread, which sets up
+ * the request recovery session as handle_recovery_req() does */
+static inline int target_req_in_lock_replay(struct ptlrpc_request *req)
+{
+	struct ptlrpc_thread *thread = req->rq_svc_thread;
+
+	return thread != NULL && thread->t_env != NULL &&
+	       thread->t_env->le_ses == &req->rq_recov_session;
+}
+
 int target_queue_recovery_request(struct ptlrpc_request *req,
                                   struct obd_device *obd)
 {
@@ -2224,7 +2409,8 @@ int target_queue_recovery_request(struct ptlrpc_request *req,
         __u64 transno = lustre_msg_get_transno(req->rq_reqmsg);
         ENTRY;
 
-	if (obd->obd_recovery_data.trd_processing_task == current_pid()) {
+	if (obd->obd_recovery_data.trd_processing_task == current_pid() ||
+	    target_req_in_lock_replay(req)) {
 		/* Processing the queue right now, don't re-add. */
 		RETURN(1);
 	}
@@ -2350,9 +2536,76 @@ int target_queue_recovery_request(struct ptlrpc_request *req,
 }
 EXPORT_SYMBOL(target_queue_recovery_request);
 
+/**
+ * An aggregated ping carries the handles of the other exports the client
+ * has on this node, and counts as a ping for each of them. The reply lists
+ * the indices of the handles which could not be refreshed, so that the
+ * client pings those targets on their own.
+ */
+static int target_handle_ping_agg(struct ptlrpc_request *req)
+{
+	struct lustre_handle	*handles;
+	struct obd_export	*exp;
+	__u32			*stale;
+	int			 nstale = 0;
+	int			 count;
+	int			 rc;
+	int			 i;
+
+	req_capsule_extend(&req->rq_pill, &RQF_OBD_PING_AGG);
+	handles = req_capsule_client_get(&req->rq_pill, &RMF_PING_HANDLES);
+	if (handles == NULL)
+		return -EPROTO;
+
+	count = req_capsule_get_size(&req->rq_pill, &RMF_PING_HANDLES,
+				     RCL_CLIENT) / sizeof(*handles);
+	req_capsule_set_size(&req->rq_pill, &RMF_PING_STALE, RCL_SERVER,
+			     count * sizeof(*stale));
+	rc = req_capsule_server_pack(&req->rq_pill);
+	if (rc != 0)
+		return rc;
+	stale = req_capsule_server_get(&req->rq_pill, &RMF_PING_STALE);
+
+	for (i = 0; i < count; i++) {
+		/* past the limit, the client has to ping on its own */
+		if (i >= PING_AGG_MAX_HANDLES) {
+			stale[nstale++] = i;
+			continue;
+		}
+
+		exp = class_conn2export(&handles[i]);
+		if (exp == NULL) {
+			stale[nstale++] = i;
+			continue;
+		}
+
+		/* a client can only keep its own exports alive */
+		if (exp->exp_connection != NULL &&
+		    exp->exp_connection->c_peer.nid == req->rq_peer.nid &&
+		    !exp->exp_failed && !exp->exp_obd->obd_stopping) {
+			ptlrpc_update_export_timer(exp, 0);
+		} else {
+			CDEBUG(D_HA, "%s: skip ping for export %p from %s\n",
+			       exp->exp_obd->obd_name, exp,
+			       libcfs_nid2str(req->rq_peer.nid));
+			stale[nstale++] = i;
+		}
+		class_export_put(exp);
+	}
+	req_capsule_shrink(&req->rq_pill, &RMF_PING_STALE,
+			   nstale * sizeof(*stale), RCL_SERVER);
+
+	CDEBUG(D_INFO, "%s: aggregated ping for %d exports from %s, %d stale\n",
+	       req->rq_export->exp_obd->obd_name, count,
+	       libcfs_nid2str(req->rq_peer.nid), nstale);
+	return 0;
+}
+
 int target_handle_ping(struct ptlrpc_request *req)
 {
         obd_ping(req->rq_svc_thread->t_env, req->rq_export);
+	if (lustre_msg_bufcount(req->rq_reqmsg) > 1)
+		return target_handle_ping_agg(req);
         return req_capsule_server_pack(&req->rq_pill);
 }
 EXPORT_SYMBOL(target_handle_ping);
@@ -246,20 +246,45 @@ void ldlm_lock_put(struct ldlm_lock *lock)
 EXPORT_SYMBOL(ldlm_lock_put);
 
 /**
- * Removes LDLM lock \a lock from LRU. Assumes LRU is already locked.
+ * Locks and returns the LRU shard \a lock is on, or was last added to.
+ *
+ * ldlm_lock::l_lru_shard is only changed while the lock is not on any LRU, so
+ * it is stable once the shard it names is locked and the lock is on it.
+ */
+static struct ldlm_lru_shard *ldlm_lock_lru_shard_lock(struct ldlm_lock *lock)
+{
+	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+	struct ldlm_lru_shard *ls;
+	int		       idx;
+
+	while (1) {
+		idx = lock->l_lru_shard;
+		ls = &ns->ns_lru[idx];
+		spin_lock(&ls->ls_lock);
+		if (likely(idx == lock->l_lru_shard))
+			return ls;
+		spin_unlock(&ls->ls_lock);
+	}
+}
+
+/**
+ * Removes LDLM lock \a lock from LRU. Assumes the LRU shard of the lock is
+ * already locked.
  */
 int ldlm_lock_remove_from_lru_nolock(struct ldlm_lock *lock)
 {
         int rc = 0;
         if (!cfs_list_empty(&lock->l_lru)) {
                 struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+		struct ldlm_lru_shard *ls = &ns->ns_lru[lock->l_lru_shard];
 
                 LASSERT(lock->l_resource->lr_type != LDLM_FLOCK);
                 cfs_list_del_init(&lock->l_lru);
                 if (lock->l_flags & LDLM_FL_SKIPPED)
                         lock->l_flags &= ~LDLM_FL_SKIPPED;
-                LASSERT(ns->ns_nr_unused > 0);
-                ns->ns_nr_unused--;
+		LASSERT(ls->ls_nr > 0);
+		ls->ls_nr--;
+		cfs_atomic_dec(&ns->ns_nr_unused);
                 rc = 1;
         }
         return rc;
@@ -270,7 +295,7 @@ int ldlm_lock_remove_from_lru_nolock(struct ldlm_lock *lock)
  */
 int ldlm_lock_remove_from_lru(struct ldlm_lock *lock)
 {
-	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+	struct ldlm_lru_shard *ls;
 	int rc;
 
 	ENTRY;
@@ -279,40 +304,46 @@ int ldlm_lock_remove_from_lru(struct ldlm_lock *lock)
 		RETURN(0);
 	}
 
-	spin_lock(&ns->ns_lock);
+	ls = ldlm_lock_lru_shard_lock(lock);
 	rc = ldlm_lock_remove_from_lru_nolock(lock);
-	spin_unlock(&ns->ns_lock);
+	spin_unlock(&ls->ls_lock);
 	EXIT;
 	return rc;
 }
 
 /**
- * Adds LDLM lock \a lock to namespace LRU. Assumes LRU is already locked.
+ * Adds LDLM lock \a lock to namespace LRU. Assumes the LRU shard
+ * ldlm_lock::l_lru_shard is already locked.
  */
 void ldlm_lock_add_to_lru_nolock(struct ldlm_lock *lock)
 {
         struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+	struct ldlm_lru_shard *ls = &ns->ns_lru[lock->l_lru_shard];
 
         lock->l_last_used = cfs_time_current();
         LASSERT(cfs_list_empty(&lock->l_lru));
         LASSERT(lock->l_resource->lr_type != LDLM_FLOCK);
-        cfs_list_add_tail(&lock->l_lru, &ns->ns_unused_list);
-        LASSERT(ns->ns_nr_unused >= 0);
-        ns->ns_nr_unused++;
+	cfs_list_add_tail(&lock->l_lru, &ls->ls_list);
+	ls->ls_nr++;
+	cfs_atomic_inc(&ns->ns_nr_unused);
 }
 
 /**
- * Adds LDLM lock \a lock to namespace LRU. Obtains necessary LRU locks
- * first.
+ * Adds LDLM lock \a lock to the namespace LRU shard of the current CPU
+ * partition. Obtains necessary LRU locks first.
  */
 void ldlm_lock_add_to_lru(struct ldlm_lock *lock)
 {
 	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+	struct ldlm_lru_shard *ls;
 
 	ENTRY;
-	spin_lock(&ns->ns_lock);
+	LASSERT(cfs_list_empty(&lock->l_lru));
+	lock->l_lru_shard = cfs_cpt_current(cfs_cpt_table, 1) % ns->ns_lru_nr;
+	ls = &ns->ns_lru[lock->l_lru_shard];
+	spin_lock(&ls->ls_lock);
 	ldlm_lock_add_to_lru_nolock(lock);
-	spin_unlock(&ns->ns_lock);
+	spin_unlock(&ls->ls_lock);
 	EXIT;
 }
 
@@ -322,7 +353,7 @@ void ldlm_lock_add_to_lru(struct ldlm_lock *lock)
  */
 void ldlm_lock_touch_in_lru(struct ldlm_lock *lock)
 {
-	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+	struct ldlm_lru_shard *ls;
 
 	ENTRY;
 	if (lock->l_flags & LDLM_FL_NS_SRV) {
@@ -331,12 +362,14 @@ void ldlm_lock_touch_in_lru(struct ldlm_lock *lock)
 		return;
 	}
 
-	spin_lock(&ns->ns_lock);
+	/* the lock stays on its shard, only the shard lock is taken */
+	ls = ldlm_lock_lru_shard_lock(lock);
 	if (!cfs_list_empty(&lock->l_lru)) {
-		ldlm_lock_remove_from_lru_nolock(lock);
-		ldlm_lock_add_to_lru_nolock(lock);
+		lock->l_last_used = cfs_time_current();
+		lock->l_flags &= ~LDLM_FL_SKIPPED;
+		cfs_list_move_tail(&lock->l_lru, &ls->ls_list);
 	}
-	spin_unlock(&ns->ns_lock);
+	spin_unlock(&ls->ls_lock);
 	EXIT;
 }
 
@@ -486,7 +519,7 @@ static struct ldlm_lock *ldlm_lock_new(struct ldlm_resource *resource)
 	cfs_atomic_set(&lock->l_refc, 2);
 	CFS_INIT_LIST_HEAD(&lock->l_res_link);
 	CFS_INIT_LIST_HEAD(&lock->l_lru);
-	CFS_INIT_LIST_HEAD(&lock->l_pending_chain);
+	cfs_wheel_node_init(&lock->l_pending_node);
 	CFS_INIT_LIST_HEAD(&lock->l_bl_ast);
 	CFS_INIT_LIST_HEAD(&lock->l_cp_ast);
 	CFS_INIT_LIST_HEAD(&lock->l_rk_ast);
@@ -1164,6 +1197,25 @@ void ldlm_grant_lock(struct ldlm_lock *lock, cfs_list_t *work_list)
         EXIT;
 }
 
+/**
+ * Drops inodebits \a to_drop from granted IBITS \a lock in place.
+ *
+ * The lock is relinked into the granted queue, as the skip lists there group
+ * locks by mode and bits.
+ *
+ * \pre lr_lock is held
+ */
+void ldlm_inodebits_drop(struct ldlm_lock *lock, __u64 to_drop)
+{
+	check_res_locked(lock->l_resource);
+	LASSERT(lock->l_resource->lr_type == LDLM_IBITS);
+	LASSERT(lock->l_granted_mode == lock->l_req_mode);
+
+	ldlm_resource_unlink_lock(lock);
+	lock->l_policy_data.l_inodebits.bits &= ~to_drop;
+	ldlm_grant_lock_with_skiplist(lock);
+}
+
 /**
  * Search for a lock with given properties in a queue.
  *
@@ -1811,6 +1863,66 @@ int ldlm_reprocess_queue(struct ldlm_resource *res, cfs_list_t *queue,
 }
 #endif
 
+#ifdef HAVE_SERVER_SUPPORT
+/**
+ * Gather in arg->bl_batch the locks of the BL AST work list which can be
+ * notified by the same RPC as \a first: they are granted to the same client,
+ * which supports batched blocking ASTs, and conflict with the same lock.
+ *
+ * \retval number of locks in the batch, \a first included
+ */
+static int ldlm_bl_batch_collect(struct ldlm_cb_set_arg *arg,
+				 struct ldlm_lock *first)
+{
+	struct ldlm_lock *lock;
+	struct ldlm_lock *next;
+	__u64		  ast_flags;
+	int		  count = 1;
+	int		  scanned = 0;
+
+	arg->bl_batch[0] = first;
+	if (first->l_blocking_ast != ldlm_server_blocking_ast ||
+	    first->l_export == NULL || !exp_connect_bl_batch(first->l_export))
+		return 1;
+
+	lock_res_and_lock(first);
+	ast_flags = first->l_flags & LDLM_AST_FLAGS;
+	if (first->l_flags & LDLM_FL_CANCEL_ON_BLOCK) {
+		unlock_res_and_lock(first);
+		return 1;
+	}
+	unlock_res_and_lock(first);
+
+	cfs_list_for_each_entry_safe(lock, next, arg->list, l_bl_ast) {
+		if (count == LDLM_BL_BATCH_MAX ||
+		    ++scanned > LDLM_BL_BATCH_SCAN)
+			break;
+
+		if (lock->l_export != first->l_export ||
+		    lock->l_blocking_lock != first->l_blocking_lock ||
+		    lock->l_blocking_ast != first->l_blocking_ast)
+			continue;
+
+		lock_res_and_lock(lock);
+		if ((lock->l_flags & LDLM_FL_CANCEL_ON_BLOCK) ||
+		    (lock->l_flags & LDLM_AST_FLAGS) != ast_flags) {
+			unlock_res_and_lock(lock);
+			continue;
+		}
+		cfs_list_del_init(&lock->l_bl_ast);
+
+		LASSERT(lock->l_flags & LDLM_FL_AST_SENT);
+		LASSERT(lock->l_bl_ast_run == 0);
+		lock->l_bl_ast_run++;
+		unlock_res_and_lock(lock);
+
+		arg->bl_batch[count++] = lock;
+	}
+
+	return count;
+}
+#endif
+
 /**
  * Process a call to blocking AST callback for a lock in ast_work list
  */
@@ -1821,6 +1933,10 @@ ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 	struct ldlm_lock_desc   d;
 	int                     rc;
 	struct ldlm_lock       *lock;
+#ifdef HAVE_SERVER_SUPPORT
+	int			count;
+	int			i;
+#endif
 	ENTRY;
 
 	if (cfs_list_empty(arg->list))
@@ -1840,6 +1956,21 @@ ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 
 	ldlm_lock2desc(lock->l_blocking_lock, &d);
 
+#ifdef HAVE_SERVER_SUPPORT
+	count = ldlm_bl_batch_collect(arg, lock);
+	if (count > 1) {
+		rc = ldlm_server_blocking_ast_batch(arg->bl_batch, count, &d,
+						    arg);
+		for (i = 0; i < count; i++) {
+			lock = arg->bl_batch[i];
+			LDLM_LOCK_RELEASE(lock->l_blocking_lock);
+			lock->l_blocking_lock = NULL;
+			LDLM_LOCK_RELEASE(lock);
+		}
+		RETURN(rc);
+	}
+#endif
+
 	rc = lock->l_blocking_ast(lock, &d, (void *)arg, LDLM_CB_BLOCKING);
 	LDLM_LOCK_RELEASE(lock->l_blocking_lock);
 	lock->l_blocking_lock = NULL;
@@ -68,6 +68,9 @@ static int ldlm_refcount;
 struct ldlm_cb_async_args {
         struct ldlm_cb_set_arg *ca_set_arg;
         struct ldlm_lock       *ca_lock;
+	/* locks of a batched blocking AST, some may be NULL */
+	struct ldlm_lock      **ca_locks;
+	int			ca_count;
 };
 
 /* LDLM state */
@@ -131,23 +134,34 @@ struct ldlm_bl_work_item {
 #if defined(HAVE_SERVER_SUPPORT) && defined(__KERNEL__)
 
 /**
- * Protects both waiting_locks_list and expired_lock_thread.
+ * Protects both waiting_locks_wheel and expired_lock_thread.
  */
 static spinlock_t waiting_locks_spinlock;   /* BH lock (timer) */
 
 /**
- * List for contended locks.
+ * Timer wheel for contended locks.
  *
- * As soon as a lock is contended, it gets placed on this list and
- * expected time to get a response is filled in the lock. A special
- * thread walks the list looking for locks that should be released and
- * schedules client evictions for those that have not been released in
- * time.
+ * As soon as a lock is contended, it gets queued on the wheel for the second
+ * its callback timeout expires in, so that adding and removing a lock are
+ * O(1) however many locks are waiting.  When locks are due, the wheel timer
+ * runs waiting_locks_callback(), which schedules client evictions for the
+ * locks that have not been released in time.
  *
  * All access to it should be under waiting_locks_spinlock.
  */
-static cfs_list_t waiting_locks_list;
-static struct timer_list waiting_locks_timer;
+static cfs_wheel_t waiting_locks_wheel;
+
+/* the wall clock second (rounded up) a jiffies timeout expires in */
+static inline time_t ldlm_wait_wheel_sec(cfs_time_t timeout)
+{
+	cfs_time_t now = cfs_time_current();
+
+	if (!cfs_time_after(timeout, now))
+		return cfs_time_current_sec();
+	return cfs_time_current_sec() +
+	       cfs_duration_sec(cfs_time_sub(timeout, now) +
+				cfs_time_seconds(1) - 1);
+}
 
 static struct expired_lock_thread {
 	wait_queue_head_t	elt_waitq;
@@ -156,6 +170,15 @@ static struct expired_lock_thread {
 	cfs_list_t		elt_expired_locks;
 } expired_lock_thread;
 
+/* hand a lock over to the expired lock thread */
+static inline void waiting_locks_add_expired(struct ldlm_lock *lock)
+{
+	/* tells __ldlm_del_waiting_lock() the lock is off the wheel */
+	lock->l_pending_node.cwn_expiry = 0;
+	cfs_list_add(&lock->l_pending_chain,
+		     &expired_lock_thread.elt_expired_locks);
+}
+
 static inline int have_expired_locks(void)
 {
 	int need_to_run;
@@ -297,79 +320,74 @@ static int ldlm_lock_busy(struct ldlm_lock *lock)
 	RETURN(match);
 }
 
-/* This is called from within a timer interrupt and cannot schedule */
-static void waiting_locks_callback(unsigned long unused)
+/**
+ * Time out the locks handed out by the wheel, moving them to the expired
+ * lock thread. Locks still having a request in progress on the export, and
+ * group locks which are never timed out, go back on the wheel with a
+ * prolonged timeout.
+ */
+static int waiting_locks_expire(cfs_list_t *expired)
 {
 	struct ldlm_lock	*lock;
-	int			need_dump = 0;
-
-	spin_lock_bh(&waiting_locks_spinlock);
-        while (!cfs_list_empty(&waiting_locks_list)) {
-                lock = cfs_list_entry(waiting_locks_list.next, struct ldlm_lock,
-                                      l_pending_chain);
-                if (cfs_time_after(lock->l_callback_timeout,
-                                   cfs_time_current()) ||
-                    (lock->l_req_mode == LCK_GROUP))
-                        break;
-
-                /* Check if we need to prolong timeout */
-                if (!OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_HPREQ_TIMEOUT) &&
-                    ldlm_lock_busy(lock)) {
-                        int cont = 1;
-
-                        if (lock->l_pending_chain.next == &waiting_locks_list)
-                                cont = 0;
-
-                        LDLM_LOCK_GET(lock);
+	int			 need_dump = 0;
+
+	while (!cfs_list_empty(expired)) {
+		lock = cfs_list_entry(expired->next, struct ldlm_lock,
+				      l_pending_chain);
+		cfs_list_del_init(&lock->l_pending_chain);
+
+		if (cfs_time_after(lock->l_callback_timeout,
+				   cfs_time_current())) {
+			/* refreshed meanwhile, requeue as it is */
+			__ldlm_add_waiting_lock(lock, 0);
+			continue;
+		}
 
-			spin_unlock_bh(&waiting_locks_spinlock);
+		/* Check if we need to prolong timeout */
+		if (lock->l_req_mode == LCK_GROUP ||
+		    (!OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_HPREQ_TIMEOUT) &&
+		     ldlm_lock_busy(lock))) {
 			LDLM_DEBUG(lock, "prolong the busy lock");
-			ldlm_refresh_waiting_lock(lock,
-						  ldlm_get_enq_timeout(lock));
-			spin_lock_bh(&waiting_locks_spinlock);
-
-                        if (!cont) {
-                                LDLM_LOCK_RELEASE(lock);
-                                break;
-                        }
+			__ldlm_add_waiting_lock(lock,
+						ldlm_get_enq_timeout(lock));
+			continue;
+		}
 
-                        LDLM_LOCK_RELEASE(lock);
-                        continue;
-                }
-                ldlm_lock_to_ns(lock)->ns_timeouts++;
-                LDLM_ERROR(lock, "lock callback timer expired after %lds: "
-                           "evicting client at %s ",
-                           cfs_time_current_sec()- lock->l_last_activity,
-                           libcfs_nid2str(
-                                   lock->l_export->exp_connection->c_peer.nid));
-
-                /* no needs to take an extra ref on the lock since it was in
-                 * the waiting_locks_list and ldlm_add_waiting_lock()
-                 * already grabbed a ref */
-                cfs_list_del(&lock->l_pending_chain);
-                cfs_list_add(&lock->l_pending_chain,
-                             &expired_lock_thread.elt_expired_locks);
+		ldlm_lock_to_ns(lock)->ns_timeouts++;
+		LDLM_ERROR(lock, "lock callback timer expired after %lds: "
+			   "evicting client at %s ",
+			   cfs_time_current_sec() - lock->l_last_activity,
+			   libcfs_nid2str(
+				   lock->l_export->exp_connection->c_peer.nid));
+
+		/* no needs to take an extra ref on the lock since it was in
+		 * the waiting locks wheel and ldlm_add_waiting_lock()
+		 * already grabbed a ref */
+		waiting_locks_add_expired(lock);
 		need_dump = 1;
 	}
 
+	return need_dump;
+}
+
+/* This is called from within a timer interrupt and cannot schedule */
+static void waiting_locks_callback(cfs_wheel_t *wheel)
+{
+	CFS_LIST_HEAD	(expired);
+	int		need_dump;
+
+	spin_lock_bh(&waiting_locks_spinlock);
+	/* all the locks due are handed out at once, and the wheel re-arms
+	 * its timer for the rest */
+	cfs_wheel_expire(wheel, cfs_time_current_sec(), &expired);
+	need_dump = waiting_locks_expire(&expired);
+
 	if (!cfs_list_empty(&expired_lock_thread.elt_expired_locks)) {
 		if (obd_dump_on_timeout && need_dump)
 			expired_lock_thread.elt_dump = __LINE__;
 
 		wake_up(&expired_lock_thread.elt_waitq);
 	}
-
-        /*
-         * Make sure the timer will fire again if we have any locks
-         * left.
-         */
-        if (!cfs_list_empty(&waiting_locks_list)) {
-                cfs_time_t timeout_rounded;
-                lock = cfs_list_entry(waiting_locks_list.next, struct ldlm_lock,
-                                      l_pending_chain);
-                timeout_rounded = (cfs_time_t)round_timeout(lock->l_callback_timeout);
-                cfs_timer_arm(&waiting_locks_timer, timeout_rounded);
-        }
 	spin_unlock_bh(&waiting_locks_spinlock);
 }
 
@@ -377,9 +395,10 @@ static void waiting_locks_callback(unsigned long unused)
  * Add lock to the list of contended locks.
  *
  * Indicate that we're waiting for a client to call us back cancelling a given
- * lock.  We add it to the pending-callback chain, and schedule the lock-timeout
- * timer to fire appropriately.  (We round up to the next second, to avoid
- * floods of timer firings during periods of high lock contention and traffic).
+ * lock.  We queue it on the wheel for the second its timeout expires in (we
+ * round up to the next second, to avoid floods of timer firings during periods
+ * of high lock contention and traffic), and the wheel takes care of the
+ * lock-timeout timer.
  * As done by ldlm_add_waiting_lock(), the caller must grab a lock reference
  * if it has been added to the waiting list (1 is returned).
  *
@@ -387,32 +406,22 @@ static void waiting_locks_callback(unsigned long unused)
  */
 static int __ldlm_add_waiting_lock(struct ldlm_lock *lock, int seconds)
 {
-        cfs_time_t timeout;
-        cfs_time_t timeout_rounded;
-
-        if (!cfs_list_empty(&lock->l_pending_chain))
-                return 0;
+	cfs_time_t timeout;
 
-        if (OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_HPREQ_NOTIMEOUT) ||
-            OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_HPREQ_TIMEOUT))
-                seconds = 1;
+	if (cfs_wheel_node_is_queued(&lock->l_pending_node))
+		return 0;
 
-        timeout = cfs_time_shift(seconds);
-        if (likely(cfs_time_after(timeout, lock->l_callback_timeout)))
-                lock->l_callback_timeout = timeout;
+	if (OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_HPREQ_NOTIMEOUT) ||
+	    OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_HPREQ_TIMEOUT))
+		seconds = 1;
 
-        timeout_rounded = round_timeout(lock->l_callback_timeout);
+	timeout = cfs_time_shift(seconds);
+	if (likely(cfs_time_after(timeout, lock->l_callback_timeout)))
+		lock->l_callback_timeout = timeout;
 
-        if (cfs_time_before(timeout_rounded,
-                            cfs_timer_deadline(&waiting_locks_timer)) ||
-            !cfs_timer_is_armed(&waiting_locks_timer)) {
-                cfs_timer_arm(&waiting_locks_timer, timeout_rounded);
-        }
-        /* if the new lock has a shorter timeout than something earlier on
-           the list, we'll wait the longer amount of time; no big deal. */
-        /* FIFO */
-        cfs_list_add_tail(&lock->l_pending_chain, &waiting_locks_list);
-        return 1;
+	cfs_wheel_add(&waiting_locks_wheel, &lock->l_pending_node,
+		      ldlm_wait_wheel_sec(lock->l_callback_timeout));
+	return 1;
 }
 
 static int ldlm_add_waiting_lock(struct ldlm_lock *lock)
@@ -462,8 +471,8 @@ static int ldlm_add_waiting_lock(struct ldlm_lock *lock)
 
 /**
  * Remove a lock from the pending list, likely because it had its cancellation
- * callback arrive without incident.  This adjusts the lock-timeout timer if
- * needed.  Returns 0 if the lock wasn't pending after all, 1 if it was.
+ * callback arrive without incident.  Returns 0 if the lock wasn't pending
+ * after all, 1 if it was.
  * As done by ldlm_del_waiting_lock(), the caller must release the lock
  * reference when the lock is removed from any list (1 is returned).
  *
@@ -471,28 +480,15 @@ static int ldlm_add_waiting_lock(struct ldlm_lock *lock)
  */
 static int __ldlm_del_waiting_lock(struct ldlm_lock *lock)
 {
-        cfs_list_t *list_next;
-
-        if (cfs_list_empty(&lock->l_pending_chain))
-                return 0;
-
-        list_next = lock->l_pending_chain.next;
-        if (lock->l_pending_chain.prev == &waiting_locks_list) {
-                /* Removing the head of the list, adjust timer. */
-                if (list_next == &waiting_locks_list) {
-                        /* No more, just cancel. */
-                        cfs_timer_disarm(&waiting_locks_timer);
-                } else {
-                        struct ldlm_lock *next;
-                        next = cfs_list_entry(list_next, struct ldlm_lock,
-                                              l_pending_chain);
-                        cfs_timer_arm(&waiting_locks_timer,
-                                      round_timeout(next->l_callback_timeout));
-                }
-        }
-        cfs_list_del_init(&lock->l_pending_chain);
+	if (!cfs_wheel_node_is_queued(&lock->l_pending_node))
+		return 0;
 
-        return 1;
+	/* locks on the expired list have their expiry cleared */
+	if (lock->l_pending_node.cwn_expiry != 0)
+		cfs_wheel_del(&waiting_locks_wheel, &lock->l_pending_node);
+	else
+		cfs_list_del_init(&lock->l_pending_chain);
+	return 1;
 }
 
 int ldlm_del_waiting_lock(struct ldlm_lock *lock)
@@ -601,8 +597,7 @@ static void ldlm_failed_ast(struct ldlm_lock *lock, int rc,
 		/* the lock was not in any list, grab an extra ref before adding
 		 * the lock to the expired list */
 		LDLM_LOCK_GET(lock);
-	cfs_list_add(&lock->l_pending_chain,
-		     &expired_lock_thread.elt_expired_locks);
+	waiting_locks_add_expired(lock);
 	wake_up(&expired_lock_thread.elt_waitq);
 	spin_unlock_bh(&waiting_locks_spinlock);
 #else
@@ -874,6 +869,170 @@ int ldlm_server_blocking_ast(struct ldlm_lock *lock,
 }
 EXPORT_SYMBOL(ldlm_server_blocking_ast);
 
+static int ldlm_cb_batch_interpret(const struct lu_env *env,
+				   struct ptlrpc_request *req, void *data,
+				   int rc)
+{
+	struct ldlm_cb_async_args *ca  = data;
+	struct ldlm_cb_set_arg    *arg = ca->ca_set_arg;
+	struct ldlm_request	  *stale = NULL;
+	int			   i;
+	int			   j;
+	ENTRY;
+
+	LASSERT(arg->type == LDLM_BL_CALLBACK);
+
+	/* the reply lists the locks the client did not have anymore */
+	if (rc == 0) {
+		stale = req_capsule_server_get(&req->rq_pill, &RMF_DLM_REQ);
+		if (stale == NULL || stale->lock_count > ca->ca_count ||
+		    req_capsule_get_size(&req->rq_pill, &RMF_DLM_REQ,
+					 RCL_SERVER) <
+		    ldlm_request_bufsize(stale->lock_count, LDLM_BL_CALLBACK)) {
+			DEBUG_REQ(D_ERROR, req, "bad batched blocking AST "
+				  "reply");
+			rc = -EPROTO;
+		}
+	}
+
+	for (i = 0; i < ca->ca_count; i++) {
+		struct ldlm_lock *lock = ca->ca_locks[i];
+		int		  lock_rc = rc;
+
+		if (lock == NULL)
+			continue;
+
+		for (j = 0; lock_rc == 0 && j < stale->lock_count; j++)
+			if (stale->lock_handle[j].cookie ==
+			    lock->l_remote_handle.cookie)
+				lock_rc = -EINVAL;
+
+		if (lock_rc != 0)
+			lock_rc = ldlm_handle_ast_error(lock, req, lock_rc,
+							"blocking");
+		if (lock_rc == -ERESTART)
+			cfs_atomic_inc(&arg->restart);
+
+		/* release extra reference taken in
+		 * ldlm_server_blocking_ast_batch() */
+		LDLM_LOCK_RELEASE(lock);
+	}
+
+	OBD_FREE(ca->ca_locks, ca->ca_count * sizeof(*ca->ca_locks));
+	RETURN(0);
+}
+
+/**
+ * Blocking AST for several locks granted to the same client and conflicting
+ * with the same lock, so that they are all notified by a single
+ * LDLM_BL_CALLBACK RPC.  Only used for the clients connected with
+ * OBD_CONNECT_BL_BATCH, for locks whose l_blocking_ast is
+ * ldlm_server_blocking_ast() and are not LDLM_FL_CANCEL_ON_BLOCK.
+ *
+ * Each lock is handled as ldlm_server_blocking_ast() does: locks not granted
+ * or already destroyed are skipped, the other ones are added to the waiting
+ * locks and released by ldlm_cb_batch_interpret().
+ */
+int ldlm_server_blocking_ast_batch(struct ldlm_lock **locks, int count,
+				   struct ldlm_lock_desc *desc, void *data)
+{
+	struct ldlm_cb_async_args *ca;
+	struct ldlm_cb_set_arg	  *arg = data;
+	struct obd_export	  *exp = locks[0]->l_export;
+	struct ldlm_request	  *body;
+	struct ptlrpc_request	  *req;
+	struct ldlm_lock	 **batch;
+	int			   sent = 0;
+	int			   rc;
+	int			   i;
+	ENTRY;
+
+	LASSERT(count > 1 && exp != NULL);
+	if (exp->exp_obd->obd_recovering != 0)
+		LDLM_ERROR(locks[0], "BUG 6063: lock collide during recovery");
+
+	OBD_ALLOC(batch, count * sizeof(*batch));
+	if (batch == NULL)
+		RETURN(-ENOMEM);
+
+	req = ptlrpc_request_alloc(exp->exp_imp_reverse,
+				   &RQF_LDLM_BL_CALLBACK_BATCH);
+	if (req == NULL)
+		GOTO(out_free, rc = -ENOMEM);
+
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_CLIENT,
+			     ldlm_request_bufsize(count, LDLM_BL_CALLBACK));
+	rc = ptlrpc_request_pack(req, LUSTRE_DLM_VERSION, LDLM_BL_CALLBACK);
+	if (rc) {
+		ptlrpc_request_free(req);
+		GOTO(out_free, rc);
+	}
+
+	CLASSERT(sizeof(*ca) <= sizeof(req->rq_async_args));
+	ca = ptlrpc_req_async_args(req);
+	ca->ca_set_arg = arg;
+	ca->ca_lock = locks[0];
+	ca->ca_locks = batch;
+	ca->ca_count = count;
+
+	req->rq_interpret_reply = ldlm_cb_batch_interpret;
+	req->rq_no_resend = 1;
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_DLM_REQ);
+	body->lock_desc = *desc;
+
+	for (i = 0; i < count; i++) {
+		struct ldlm_lock *lock = locks[i];
+
+		ldlm_lock_reorder_req(lock);
+
+		lock_res_and_lock(lock);
+		if (lock->l_granted_mode != lock->l_req_mode ||
+		    lock->l_flags & LDLM_FL_DESTROYED) {
+			unlock_res_and_lock(lock);
+			LDLM_DEBUG(lock, "lock not granted or destroyed, not "
+				   "sending blocking AST");
+			continue;
+		}
+
+		body->lock_handle[sent++] = lock->l_remote_handle;
+		body->lock_flags |= ldlm_flags_to_wire(lock->l_flags &
+						       LDLM_AST_FLAGS);
+		ldlm_add_waiting_lock(lock);
+		unlock_res_and_lock(lock);
+
+		LDLM_DEBUG(lock, "server preparing batched blocking AST");
+		LDLM_LOCK_GET(lock);
+		batch[i] = lock;
+
+		if (exp->exp_nid_stats && exp->exp_nid_stats->nid_ldlm_stats)
+			lprocfs_counter_incr(exp->exp_nid_stats->nid_ldlm_stats,
+					     LDLM_BL_CALLBACK - LDLM_FIRST_OPC);
+	}
+
+	if (sent == 0) {
+		ptlrpc_req_finished(req);
+		GOTO(out_free, rc = 0);
+	}
+
+	body->lock_count = sent;
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_SERVER,
+			     ldlm_request_bufsize(sent, LDLM_BL_CALLBACK));
+	ptlrpc_request_set_replen(req);
+
+	req->rq_send_state = LUSTRE_IMP_FULL;
+	/* ptlrpc_request_pack already set timeout */
+	if (AT_OFF)
+		req->rq_timeout = ldlm_get_rq_timeout();
+
+	ptlrpc_set_add_req(arg->set, req);
+	RETURN(0);
+
+out_free:
+	OBD_FREE(batch, count * sizeof(*batch));
+	return rc;
+}
+
 /**
  * ->l_completion_ast callback for a remote lock in server namespace.
  *
@@ -1462,6 +1621,43 @@ int ldlm_handle_enqueue(struct ptlrpc_request *req,
 }
 EXPORT_SYMBOL(ldlm_handle_enqueue);
 
+/**
+ * Server side of ldlm_cli_dropbits(): the client keeps granted IBITS \a lock
+ * with the inodebits in \a new_bits only, so that the waiters that conflicted
+ * with the dropped bits may be granted on reprocess.
+ */
+static int ldlm_handle_dropbits(struct ptlrpc_request *req,
+				struct ldlm_lock *lock, __u64 new_bits)
+{
+	__u64 bits;
+
+	lock_res_and_lock(lock);
+	bits = lock->l_policy_data.l_inodebits.bits;
+	if (lock->l_export != req->rq_export ||
+	    lock->l_granted_mode != lock->l_req_mode ||
+	    (lock->l_flags & LDLM_FL_DESTROYED) ||
+	    new_bits == 0 || (new_bits & ~bits) != 0) {
+		unlock_res_and_lock(lock);
+		return -EINVAL;
+	}
+
+	/* the blocking AST is not sent yet, the client has to cancel */
+	if (lock->l_blocking_lock != NULL ||
+	    !cfs_list_empty(&lock->l_bl_ast)) {
+		unlock_res_and_lock(lock);
+		return -EAGAIN;
+	}
+
+	ldlm_inodebits_drop(lock, bits & ~new_bits);
+	/* the kept bits may conflict later, allow new blocking ASTs */
+	lock->l_flags &= ~LDLM_FL_AST_SENT;
+	unlock_res_and_lock(lock);
+
+	if (ldlm_del_waiting_lock(lock))
+		LDLM_DEBUG(lock, "dropped bits of waiting lock");
+	return 0;
+}
+
 /**
  * Main LDLM entry point for server code to process lock conversion requests.
  */
@@ -1488,6 +1684,21 @@ int ldlm_handle_convert0(struct ptlrpc_request *req,
         lock = ldlm_handle2lock(&dlm_req->lock_handle[0]);
         if (!lock) {
 		req->rq_status = LUSTRE_EINVAL;
+	} else if (lock->l_resource->lr_type == LDLM_IBITS &&
+		   dlm_req->lock_desc.l_req_mode == lock->l_granted_mode) {
+		/* same mode with fewer bits, see ldlm_cli_dropbits() */
+		LDLM_DEBUG(lock, "server-side dropbits to "LPX64,
+			   dlm_req->lock_desc.l_policy_data.l_inodebits.bits);
+
+		lock->l_last_activity = cfs_time_current_sec();
+		rc = ldlm_handle_dropbits(req, lock,
+			dlm_req->lock_desc.l_policy_data.l_inodebits.bits);
+		if (rc == 0)
+			req->rq_status = 0;
+		else if (rc == -EAGAIN)
+			req->rq_status = LUSTRE_EAGAIN;
+		else
+			req->rq_status = LUSTRE_EINVAL;
         } else {
                 void *res = NULL;
 
@@ -1660,6 +1871,10 @@ void ldlm_handle_bl_callback(struct ldlm_namespace *ns,
         if (lock->l_flags & LDLM_FL_CANCEL_ON_BLOCK)
                 lock->l_flags |= LDLM_FL_CANCEL;
 
+	/* remember which bits conflict, for ldlm_cli_dropbits() */
+	if (ld != NULL && lock->l_resource->lr_type == LDLM_IBITS)
+		lock->l_ibits_cancel |= ld->l_policy_data.l_inodebits.bits;
+
         do_ast = (!lock->l_readers && !lock->l_writers);
         unlock_res_and_lock(lock);
 
@@ -2075,6 +2290,103 @@ static int ldlm_handle_qc_callback(struct ptlrpc_request *req)
 	return 0;
 }
 
+/**
+ * Handle a blocking AST carrying several locks, as sent by
+ * ldlm_server_blocking_ast_batch().  Each lock is dealt with as if it got its
+ * own blocking AST, except that the single reply lists the handles of the
+ * locks this client does not have anymore.
+ */
+static int ldlm_handle_bl_callback_batch(struct ptlrpc_request *req,
+					 struct ldlm_namespace *ns,
+					 struct ldlm_request *dlm_req)
+{
+	struct ldlm_request	 *stale;
+	struct ldlm_lock	**locks;
+	int			  count = dlm_req->lock_count;
+	int			  nstale = 0;
+	int			  rc;
+	int			  i;
+	ENTRY;
+
+	req_capsule_extend(&req->rq_pill, &RQF_LDLM_BL_CALLBACK_BATCH);
+	/* lock_count comes from the wire, check it before sizing with it */
+	if (dlm_req->lock_count == 0 ||
+	    dlm_req->lock_count > LDLM_BL_BATCH_MAX ||
+	    req_capsule_get_size(&req->rq_pill, &RMF_DLM_REQ, RCL_CLIENT) <
+	    ldlm_request_bufsize(count, LDLM_BL_CALLBACK)) {
+		rc = ldlm_callback_reply(req, -EPROTO);
+		ldlm_callback_errmsg(req, "Operate with bad lock count", rc,
+				     NULL);
+		RETURN(0);
+	}
+
+	OBD_ALLOC(locks, count * sizeof(*locks));
+	if (locks == NULL) {
+		rc = ldlm_callback_reply(req, -ENOMEM);
+		ldlm_callback_errmsg(req, "Operate without memory", rc, NULL);
+		RETURN(0);
+	}
+
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_SERVER,
+			     ldlm_request_bufsize(count, LDLM_BL_CALLBACK));
+	rc = req_capsule_server_pack(&req->rq_pill);
+	if (rc) {
+		rc = ldlm_callback_reply(req, rc);
+		ldlm_callback_errmsg(req, "Operate without reply", rc, NULL);
+		GOTO(out, rc);
+	}
+	stale = req_capsule_server_get(&req->rq_pill, &RMF_DLM_REQ);
+
+	for (i = 0; i < count; i++) {
+		struct lustre_handle *lockh = &dlm_req->lock_handle[i];
+		struct ldlm_lock     *lock;
+
+		lock = ldlm_handle2lock_long(lockh, 0);
+		if (lock != NULL) {
+			/* see ldlm_callback_handler() for a single lock */
+			lock_res_and_lock(lock);
+			lock->l_flags |= ldlm_flags_from_wire(
+				dlm_req->lock_flags & LDLM_AST_FLAGS);
+			if (!((lock->l_flags & LDLM_FL_CANCELING) &&
+			      (lock->l_flags & LDLM_FL_BL_DONE)) &&
+			    !(lock->l_flags & LDLM_FL_FAILED)) {
+				ldlm_lock_remove_from_lru(lock);
+				lock->l_flags |= LDLM_FL_BL_AST;
+				unlock_res_and_lock(lock);
+				locks[i] = lock;
+				continue;
+			}
+			unlock_res_and_lock(lock);
+			LDLM_LOCK_RELEASE(lock);
+		}
+
+		CDEBUG(D_DLMTRACE, "callback on lock "LPX64" - lock "
+		       "disappeared\n", lockh->cookie);
+		stale->lock_handle[nstale++] = *lockh;
+	}
+	stale->lock_count = nstale;
+	req_capsule_shrink(&req->rq_pill, &RMF_DLM_REQ,
+			   ldlm_request_bufsize(nstale, LDLM_BL_CALLBACK),
+			   RCL_SERVER);
+
+	rc = ldlm_callback_reply(req, 0);
+	if (req->rq_no_reply || rc)
+		ldlm_callback_errmsg(req, "Normal process", rc,
+				     &dlm_req->lock_handle[0]);
+
+	for (i = 0; i < count; i++) {
+		if (locks[i] == NULL)
+			continue;
+		if (ldlm_bl_to_thread_lock(ns, &dlm_req->lock_desc, locks[i]))
+			ldlm_handle_bl_callback(ns, &dlm_req->lock_desc,
+						locks[i]);
+	}
+	EXIT;
+out:
+	OBD_FREE(locks, count * sizeof(*locks));
+	return 0;
+}
+
 /* TODO: handle requests in a similar way as MDT: see mdt_handle_common() */
 static int ldlm_callback_handler(struct ptlrpc_request *req)
 {
@@ -2178,6 +2490,10 @@ static int ldlm_callback_handler(struct ptlrpc_request *req)
                 RETURN(0);
         }
 
+	if (lustre_msg_get_opc(req->rq_reqmsg) == LDLM_BL_CALLBACK &&
+	    dlm_req->lock_count > 1)
+		RETURN(ldlm_handle_bl_callback_batch(req, ns, dlm_req));
+
         /* Force a known safe race, send a cancel to the server for a lock
          * which the server has already started a blocking callback on. */
         if (OBD_FAIL_CHECK(OBD_FAIL_LDLM_CANCEL_BL_CB_RACE) &&
@@ -2323,6 +2639,15 @@ static int ldlm_cancel_handler(struct ptlrpc_request *req)
                 if (rc)
                         break;
                 RETURN(0);
+	case LDLM_CONVERT:
+		/* inodebits drop on blocking AST, like a cancel it must not
+		 * wait behind the requests blocked by the lock */
+		req_capsule_set(&req->rq_pill, &RQF_LDLM_CONVERT);
+		CDEBUG(D_INODE, "convert\n");
+		rc = ldlm_handle_convert(req);
+		if (rc)
+			break;
+		RETURN(ptlrpc_reply(req));
         default:
                 CERROR("invalid opcode %d\n",
                        lustre_msg_get_opc(req->rq_reqmsg));
@@ -2414,6 +2739,9 @@ static int ldlm_hpreq_handler(struct ptlrpc_request *req)
         if (LDLM_CANCEL == lustre_msg_get_opc(req->rq_reqmsg)) {
                 req_capsule_set(&req->rq_pill, &RQF_LDLM_CANCEL);
                 req->rq_ops = &ldlm_cancel_hpreq_ops;
+	} else if (LDLM_CONVERT == lustre_msg_get_opc(req->rq_reqmsg)) {
+		req_capsule_set(&req->rq_pill, &RQF_LDLM_CONVERT);
+		req->rq_ops = &ldlm_cancel_hpreq_ops;
         }
         RETURN(0);
 }
@@ -2910,9 +3238,8 @@ static int ldlm_setup(void)
 	expired_lock_thread.elt_state = ELT_STOPPED;
 	init_waitqueue_head(&expired_lock_thread.elt_waitq);
 
-	CFS_INIT_LIST_HEAD(&waiting_locks_list);
 	spin_lock_init(&waiting_locks_spinlock);
-	cfs_timer_init(&waiting_locks_timer, waiting_locks_callback, 0);
+	cfs_wheel_init(&waiting_locks_wheel, waiting_locks_callback, NULL);
 
 	rc = PTR_ERR(kthread_run(expired_lock_main, NULL, "ldlm_elt"));
 	if (IS_ERR_VALUE(rc)) {
@@ -2989,6 +3316,7 @@ static int ldlm_cleanup(void)
 		wait_event(expired_lock_thread.elt_waitq,
 			       expired_lock_thread.elt_state == ELT_STOPPED);
 	}
+	cfs_wheel_fini(&waiting_locks_wheel);
 # endif
 #endif /* __KERNEL__ */
 
@@ -147,6 +147,20 @@
  */
 #define LDLM_POOL_SLV_SHIFT (10)
 
+/*
+ * Pool memory is accounted in 64 bytes units. This is about what the slab
+ * rounds lock and resource objects up to, and it lets an atomic_t count up
+ * to 128GB.
+ */
+#define LDLM_POOL_MEM_SHIFT (6)
+
+/*
+ * Nominal footprint of a lock owning its resource, used to turn the lock
+ * count limit into a memory budget when none is configured.
+ */
+#define LDLM_POOL_LOCK_MEM \
+	(sizeof(struct ldlm_lock) + sizeof(struct ldlm_resource))
+
 #ifdef __KERNEL__
 extern cfs_proc_dir_entry_t *ldlm_ns_proc_dir;
 #endif
@@ -223,6 +237,78 @@ static inline int ldlm_pool_t2gsp(unsigned int t)
                  (t >> LDLM_POOL_GSP_STEP_SHIFT));
 }
 
+static inline int ldlm_pool_mem_units(int bytes)
+{
+	return (bytes + (1 << LDLM_POOL_MEM_SHIFT) - 1) >> LDLM_POOL_MEM_SHIFT;
+}
+
+/**
+ * Charges \a bytes of lock, resource or LVB memory to pool \a pl.
+ */
+void ldlm_pool_mem_add(struct ldlm_pool *pl, int bytes)
+{
+	cfs_atomic_add(ldlm_pool_mem_units(bytes), &pl->pl_mem);
+}
+
+/**
+ * Releases \a bytes charged earlier with ldlm_pool_mem_add().
+ */
+void ldlm_pool_mem_del(struct ldlm_pool *pl, int bytes)
+{
+	cfs_atomic_sub(ldlm_pool_mem_units(bytes), &pl->pl_mem);
+}
+
+/**
+ * Memory pinned by granted \a lock itself, its resource and LVB are charged
+ * separately when the resource is created.
+ */
+static inline int ldlm_pool_lock_mem(struct ldlm_lock *lock)
+{
+	/* extent locks also own a node in the resource interval tree */
+	if (lock->l_resource->lr_type == LDLM_EXTENT)
+		return sizeof(*lock) + sizeof(struct ldlm_interval);
+	return sizeof(*lock);
+}
+
+static inline __u64 ldlm_pool_mem_bytes(struct ldlm_pool *pl)
+{
+	return (__u64)cfs_atomic_read(&pl->pl_mem) << LDLM_POOL_MEM_SHIFT;
+}
+
+/**
+ * Returns the number of locks fitting into the memory budget of \a pl,
+ * given the average memory used per granted lock so far. This is what the
+ * server SLV and grant plan are computed against, so that namespaces with
+ * large resources and LVBs shrink sooner and namespaces with many locks per
+ * resource may keep more of them.
+ *
+ * \pre ->pl_lock is locked.
+ */
+static __u32 ldlm_pool_mem_limit(struct ldlm_pool *pl)
+{
+	__u32 limit = ldlm_pool_get_limit(pl);
+	int granted = cfs_atomic_read(&pl->pl_granted);
+	__u64 budget = pl->pl_mem_budget;
+	__u64 avg = ldlm_pool_mem_bytes(pl);
+
+	if (granted <= 0 || avg == 0)
+		return limit;
+
+	if (budget == 0)
+		budget = (__u64)limit * LDLM_POOL_LOCK_MEM;
+
+	do_div(avg, granted);
+	if (avg == 0)
+		avg = 1;
+	else if (avg > ~0U)
+		avg = ~0U;
+	do_div(budget, (__u32)avg);
+
+	if (budget > LDLM_POOL_HOST_L)
+		return LDLM_POOL_HOST_L;
+	return max_t(__u32, budget, 1);
+}
+
 /**
  * Recalculates next grant limit on passed \a pl.
  *
@@ -232,7 +318,7 @@ static void ldlm_pool_recalc_grant_plan(struct ldlm_pool *pl)
 {
         int granted, grant_step, limit;
 
-        limit = ldlm_pool_get_limit(pl);
+	limit = ldlm_pool_mem_limit(pl);
         granted = cfs_atomic_read(&pl->pl_granted);
 
         grant_step = ldlm_pool_t2gsp(pl->pl_recalc_period);
@@ -260,7 +346,7 @@ static void ldlm_pool_recalc_slv(struct ldlm_pool *pl)
 
         slv = pl->pl_server_lock_volume;
         grant_plan = pl->pl_grant_plan;
-        limit = ldlm_pool_get_limit(pl);
+	limit = ldlm_pool_mem_limit(pl);
         granted = cfs_atomic_read(&pl->pl_granted);
         round_up = granted < limit;
 
@@ -546,9 +632,7 @@ static int ldlm_cli_pool_shrink(struct ldlm_pool *pl,
          */
         ldlm_cli_pool_pop_slv(pl);
 
-	spin_lock(&ns->ns_lock);
-	unused = ns->ns_nr_unused;
-	spin_unlock(&ns->ns_lock);
+	unused = cfs_atomic_read(&ns->ns_nr_unused);
 
         if (nr) {
 		canceled = ldlm_cancel_lru(ns, nr, LCF_ASYNC,
@@ -662,8 +746,8 @@ static int lprocfs_rd_pool_state(char *page, char **start, off_t off,
         int granted, grant_rate, cancel_rate, grant_step;
         int nr = 0, grant_speed, grant_plan, lvf;
         struct ldlm_pool *pl = data;
-        __u64 slv, clv;
-        __u32 limit;
+        __u64 slv, clv, mem;
+        __u32 limit, mem_limit;
 
 	spin_lock(&pl->pl_lock);
         slv = pl->pl_server_lock_volume;
@@ -676,6 +760,8 @@ static int lprocfs_rd_pool_state(char *page, char **start, off_t off,
         grant_speed = grant_rate - cancel_rate;
         lvf = cfs_atomic_read(&pl->pl_lock_volume_factor);
         grant_step = ldlm_pool_t2gsp(pl->pl_recalc_period);
+	mem = ldlm_pool_mem_bytes(pl);
+	mem_limit = ldlm_pool_mem_limit(pl);
 	spin_unlock(&pl->pl_lock);
 
         nr += snprintf(page + nr, count - nr, "LDLM pool state (%s):\n",
@@ -700,6 +786,10 @@ static int lprocfs_rd_pool_state(char *page, char **start, off_t off,
                        granted);
         nr += snprintf(page + nr, count - nr, "  L:   %d\n",
                        limit);
+	nr += snprintf(page + nr, count - nr, "  M:   "LPU64"\n", mem);
+	if (ns_is_server(ldlm_pl2ns(pl)))
+		nr += snprintf(page + nr, count - nr, "  ML:  %u\n",
+			       mem_limit);
         return nr;
 }
 
@@ -717,6 +807,43 @@ static int lprocfs_rd_grant_speed(char *page, char **start, off_t off,
 	return lprocfs_rd_uint(page, start, off, count, eof, &grant_speed);
 }
 
+static int lprocfs_rd_mem_used(char *page, char **start, off_t off,
+			       int count, int *eof, void *data)
+{
+	__u64 mem = ldlm_pool_mem_bytes(data);
+
+	return lprocfs_rd_u64(page, start, off, count, eof, &mem);
+}
+
+static int lprocfs_rd_mem_budget(char *page, char **start, off_t off,
+				 int count, int *eof, void *data)
+{
+	struct ldlm_pool *pl = data;
+	__u64		  budget;
+
+	spin_lock(&pl->pl_lock);
+	budget = pl->pl_mem_budget;
+	spin_unlock(&pl->pl_lock);
+	return lprocfs_rd_u64(page, start, off, count, eof, &budget);
+}
+
+static int lprocfs_wr_mem_budget(struct file *file, const char *buffer,
+				 unsigned long count, void *data)
+{
+	struct ldlm_pool *pl = data;
+	__u64		  budget;
+	int		  rc;
+
+	rc = lprocfs_write_u64_helper(buffer, count, &budget);
+	if (rc < 0)
+		return rc;
+
+	spin_lock(&pl->pl_lock);
+	pl->pl_mem_budget = budget;
+	spin_unlock(&pl->pl_lock);
+	return count;
+}
+
 LDLM_POOL_PROC_READER(grant_plan, int);
 LDLM_POOL_PROC_READER(recalc_period, int);
 LDLM_POOL_PROC_WRITER(recalc_period, int);
@@ -771,6 +898,21 @@ static int ldlm_pool_proc_init(struct ldlm_pool *pl)
         pool_vars[0].read_fptr = lprocfs_rd_atomic;
         lprocfs_add_vars(pl->pl_proc_dir, pool_vars, 0);
 
+	snprintf(var_name, MAX_STRING_SIZE, "mem_used");
+	pool_vars[0].data = pl;
+	pool_vars[0].read_fptr = lprocfs_rd_mem_used;
+	pool_vars[0].write_fptr = NULL;
+	lprocfs_add_vars(pl->pl_proc_dir, pool_vars, 0);
+
+	if (ns_is_server(ns)) {
+		snprintf(var_name, MAX_STRING_SIZE, "mem_budget");
+		pool_vars[0].data = pl;
+		pool_vars[0].read_fptr = lprocfs_rd_mem_budget;
+		pool_vars[0].write_fptr = lprocfs_wr_mem_budget;
+		lprocfs_add_vars(pl->pl_proc_dir, pool_vars, 0);
+		pool_vars[0].write_fptr = NULL;
+	}
+
         snprintf(var_name, MAX_STRING_SIZE, "grant_speed");
         pool_vars[0].data = pl;
         pool_vars[0].read_fptr = lprocfs_rd_grant_speed;
@@ -878,6 +1020,8 @@ int ldlm_pool_init(struct ldlm_pool *pl, struct ldlm_namespace *ns,
 
 	spin_lock_init(&pl->pl_lock);
         cfs_atomic_set(&pl->pl_granted, 0);
+	cfs_atomic_set(&pl->pl_mem, 0);
+	pl->pl_mem_budget = 0;
         pl->pl_recalc_time = cfs_time_current_sec();
         cfs_atomic_set(&pl->pl_lock_volume_factor, 1);
 
@@ -941,6 +1085,7 @@ void ldlm_pool_add(struct ldlm_pool *pl, struct ldlm_lock *lock)
 
         cfs_atomic_inc(&pl->pl_granted);
         cfs_atomic_inc(&pl->pl_grant_rate);
+	ldlm_pool_mem_add(pl, ldlm_pool_lock_mem(lock));
         lprocfs_counter_incr(pl->pl_stats, LDLM_POOL_GRANT_STAT);
         /*
          * Do not do pool recalc for client side as all locks which
@@ -967,6 +1112,7 @@ void ldlm_pool_del(struct ldlm_pool *pl, struct ldlm_lock *lock)
         LASSERT(cfs_atomic_read(&pl->pl_granted) > 0);
         cfs_atomic_dec(&pl->pl_granted);
         cfs_atomic_inc(&pl->pl_cancel_rate);
+	ldlm_pool_mem_del(pl, ldlm_pool_lock_mem(lock));
 
         lprocfs_counter_incr(pl->pl_stats, LDLM_POOL_CANCEL_STAT);
 
@@ -1512,6 +1658,16 @@ void ldlm_pool_add(struct ldlm_pool *pl, struct ldlm_lock *lock)
 }
 EXPORT_SYMBOL(ldlm_pool_add);
 
+void ldlm_pool_mem_add(struct ldlm_pool *pl, int bytes)
+{
+	return;
+}
+
+void ldlm_pool_mem_del(struct ldlm_pool *pl, int bytes)
+{
+	return;
+}
+
 void ldlm_pool_del(struct ldlm_pool *pl, struct ldlm_lock *lock)
 {
         return;
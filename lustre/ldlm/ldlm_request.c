@@ -1109,6 +1109,88 @@ int ldlm_cli_convert(struct lustre_handle *lockh, int new_mode, __u32 *flags)
 }
 EXPORT_SYMBOL(ldlm_cli_convert);
 
+/**
+ * Client side inodebits downgrade.
+ *
+ * Instead of cancelling an unused IBITS \a lock on a blocking AST, drop only
+ * the \a drop_bits conflicting with it and keep the lock cached with the other
+ * bits. The caller has already dropped whatever it cached under \a drop_bits,
+ * the lock bits are trimmed locally before the server is told, so that
+ * nothing can match them in the meantime.
+ *
+ * \retval 0 the lock is downgraded and stays in the LRU
+ * \retval negative the lock could not be downgraded, the caller is expected
+ *	   to cancel it as usual
+ */
+int ldlm_cli_dropbits(struct ldlm_lock *lock, __u64 drop_bits)
+{
+	struct obd_export     *exp = lock->l_conn_export;
+	struct ldlm_request   *body;
+	struct ptlrpc_request *req;
+	__u64		       bits;
+	int		       rc;
+	ENTRY;
+
+	if (exp == NULL || !exp_connect_lock_convert(exp))
+		RETURN(-EOPNOTSUPP);
+
+	lock_res_and_lock(lock);
+	bits = lock->l_policy_data.l_inodebits.bits;
+	if (lock->l_resource->lr_type != LDLM_IBITS ||
+	    lock->l_readers != 0 || lock->l_writers != 0 ||
+	    lock->l_granted_mode != lock->l_req_mode ||
+	    (lock->l_flags & (LDLM_FL_CANCELING | LDLM_FL_CANCEL |
+			      LDLM_FL_FAILED | LDLM_FL_LOCAL_ONLY)) ||
+	    drop_bits == 0 || (bits & ~drop_bits) == 0) {
+		unlock_res_and_lock(lock);
+		RETURN(-EINVAL);
+	}
+	ldlm_inodebits_drop(lock, drop_bits);
+	lock->l_ibits_cancel &= ~drop_bits;
+	unlock_res_and_lock(lock);
+
+	LDLM_DEBUG(lock, "client-side dropbits "LPX64, drop_bits);
+
+	req = ptlrpc_request_alloc_pack(class_exp2cliimp(exp),
+					&RQF_LDLM_CONVERT, LUSTRE_DLM_VERSION,
+					LDLM_CONVERT);
+	if (req == NULL)
+		RETURN(-ENOMEM);
+
+	/* sent on a blocking AST, so it goes where cancels go */
+	req->rq_request_portal = LDLM_CANCEL_REQUEST_PORTAL;
+	req->rq_reply_portal = LDLM_CANCEL_REPLY_PORTAL;
+	ptlrpc_at_set_req_timeout(req);
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_DLM_REQ);
+	ldlm_lock2desc(lock, &body->lock_desc);
+	body->lock_handle[0] = lock->l_remote_handle;
+	body->lock_count = 1;
+
+	ptlrpc_request_set_replen(req);
+	rc = ptlrpc_queue_wait(req);
+	ptlrpc_req_finished(req);
+	if (rc != 0) {
+		LDLM_DEBUG(lock, "dropbits failed: rc = %d", rc);
+		RETURN(rc > 0 ? -rc : rc);
+	}
+
+	/* Unless another blocking AST asked for more meanwhile, the lock is
+	 * usable again. */
+	lock_res_and_lock(lock);
+	if (lock->l_ibits_cancel == 0 &&
+	    !(lock->l_flags & (LDLM_FL_CANCELING | LDLM_FL_CANCEL))) {
+		lock->l_flags &= ~(LDLM_FL_CBPENDING | LDLM_FL_BL_AST);
+		if (lock->l_readers == 0 && lock->l_writers == 0 &&
+		    cfs_list_empty(&lock->l_lru))
+			ldlm_lock_add_to_lru(lock);
+	}
+	unlock_res_and_lock(lock);
+
+	RETURN(0);
+}
+EXPORT_SYMBOL(ldlm_cli_dropbits);
+
 /**
  * Cancel locks locally.
  * Returns:
@@ -1596,6 +1678,114 @@ ldlm_cancel_lru_policy(struct ldlm_namespace *ns, int flags)
         return ldlm_cancel_default_policy;
 }
 
+/**
+ * Keep value of the unused \a lock for the cost aware LRU policy: the cached
+ * data it covers and how much cached state enqueueing it again brings back,
+ * divided by the time it has not been used for. Among old locks, the ones
+ * with the lowest value are cancelled first.
+ */
+static __u64 ldlm_lru_lock_value(struct ldlm_namespace *ns,
+				 struct ldlm_lock *lock)
+{
+	__u64	value = 1;
+	__u64	bits;
+	long	age;
+
+	if (ns->ns_weigh != NULL)
+		value += ns->ns_weigh(lock);
+
+	/* each inode bit covers a different kind of cached metadata */
+	if (lock->l_resource->lr_type == LDLM_IBITS)
+		for (bits = lock->l_policy_data.l_inodebits.bits; bits != 0;
+		     bits &= bits - 1)
+			value <<= 1;
+
+	age = cfs_duration_sec(cfs_time_sub(cfs_time_current(),
+					    lock->l_last_used));
+	value *= LDLM_LRU_VALUE_SCALE;
+	do_div(value, age + 1);
+	return value;
+}
+
+/**
+ * Find the unused lock to pass to the LRU policy next: the oldest lock of all
+ * the LRU shards or, with the cost aware policy, the one with the lowest
+ * value among the LDLM_LRU_COST_WINDOW oldest locks of each shard.  Locks
+ * already being cancelled are dropped from the LRU on the way.
+ *
+ * \retval referenced lock
+ * \retval NULL if there is no lock left to consider
+ */
+static struct ldlm_lock *ldlm_lru_next_lock(struct ldlm_namespace *ns,
+					    int flags)
+{
+	struct ldlm_lock *best = NULL;
+	__u64		  best_value = 0;
+	int		  cost_aware;
+	int		  i;
+
+	cost_aware = ns->ns_lru_cost_aware && !(flags & LDLM_CANCEL_NO_WAIT);
+
+	for (i = 0; i < ns->ns_lru_nr; i++) {
+		struct ldlm_lru_shard *ls = &ns->ns_lru[i];
+		struct ldlm_lock      *cand = NULL;
+		struct ldlm_lock      *prev = NULL;
+		struct ldlm_lock      *lock;
+		struct ldlm_lock      *next;
+		__u64		       cand_value = 0;
+		int		       window = 0;
+
+		spin_lock(&ls->ls_lock);
+		cfs_list_for_each_entry_safe(lock, next, &ls->ls_list, l_lru) {
+			__u64 value;
+
+			/* No locks which got blocking requests. */
+			LASSERT(!(lock->l_flags & LDLM_FL_BL_AST));
+
+			if (flags & LDLM_CANCEL_NO_WAIT &&
+			    lock->l_flags & LDLM_FL_SKIPPED)
+				/* already processed */
+				continue;
+
+			/* Somebody is already doing CANCEL. No need for this
+			 * lock in LRU, do not traverse it again. */
+			if (lock->l_flags & LDLM_FL_CANCELING) {
+				ldlm_lock_remove_from_lru_nolock(lock);
+				continue;
+			}
+
+			if (!cost_aware) {
+				cand = lock;
+				break;
+			}
+
+			value = ldlm_lru_lock_value(ns, lock);
+			if (cand == NULL || value < cand_value) {
+				cand = lock;
+				cand_value = value;
+			}
+			if (++window >= LDLM_LRU_COST_WINDOW)
+				break;
+		}
+
+		if (cand != NULL &&
+		    (best == NULL ||
+		     (cost_aware ? cand_value < best_value :
+		      cfs_time_before(cand->l_last_used, best->l_last_used)))) {
+			LDLM_LOCK_GET(cand);
+			prev = best;
+			best = cand;
+			best_value = cand_value;
+		}
+		spin_unlock(&ls->ls_lock);
+
+		if (prev != NULL)
+			LDLM_LOCK_RELEASE(prev);
+	}
+
+	return best;
+}
+
 /**
  * - Free space in LRU for \a count new locks,
  *   redundant unused locks are canceled locally;
@@ -1628,58 +1818,41 @@ ldlm_cancel_lru_policy(struct ldlm_namespace *ns, int flags)
  *                               (typically before replaying locks) w/o
  *                               sending any RPCs or waiting for any
  *                               outstanding RPC to complete.
+ *
+ * The locks are passed to the policy in the order ldlm_lru_next_lock() finds
+ * them, i.e. oldest first unless the namespace has ns_lru_cost_aware set.
  */
 static int ldlm_prepare_lru_list(struct ldlm_namespace *ns, cfs_list_t *cancels,
                                  int count, int max, int flags)
 {
 	ldlm_cancel_lru_policy_t pf;
-	struct ldlm_lock *lock, *next;
+	struct ldlm_lock *lock;
 	int added = 0, unused, remained;
 	ENTRY;
 
-	spin_lock(&ns->ns_lock);
-        unused = ns->ns_nr_unused;
-        remained = unused;
+	unused = cfs_atomic_read(&ns->ns_nr_unused);
+	remained = unused;
 
-        if (!ns_connect_lru_resize(ns))
-                count += unused - ns->ns_max_unused;
+	if (!ns_connect_lru_resize(ns))
+		count += unused - ns->ns_max_unused;
 
-        pf = ldlm_cancel_lru_policy(ns, flags);
-        LASSERT(pf != NULL);
+	pf = ldlm_cancel_lru_policy(ns, flags);
+	LASSERT(pf != NULL);
 
-        while (!cfs_list_empty(&ns->ns_unused_list)) {
-                ldlm_policy_res_t result;
+	while (1) {
+		ldlm_policy_res_t result;
 
-                /* all unused locks */
-                if (remained-- <= 0)
-                        break;
-
-                /* For any flags, stop scanning if @max is reached. */
-                if (max && added >= max)
-                        break;
-
-                cfs_list_for_each_entry_safe(lock, next, &ns->ns_unused_list,
-					     l_lru) {
-                        /* No locks which got blocking requests. */
-                        LASSERT(!(lock->l_flags & LDLM_FL_BL_AST));
-
-                        if (flags & LDLM_CANCEL_NO_WAIT &&
-                            lock->l_flags & LDLM_FL_SKIPPED)
-                                /* already processed */
-                                continue;
-
-			/* Somebody is already doing CANCEL. No need for this
-			 * lock in LRU, do not traverse it again. */
-                        if (!(lock->l_flags & LDLM_FL_CANCELING))
-                                break;
+		/* all unused locks */
+		if (remained-- <= 0)
+			break;
 
-                        ldlm_lock_remove_from_lru_nolock(lock);
-                }
-                if (&lock->l_lru == &ns->ns_unused_list)
-                        break;
+		/* For any flags, stop scanning if @max is reached. */
+		if (max && added >= max)
+			break;
 
-		LDLM_LOCK_GET(lock);
-		spin_unlock(&ns->ns_lock);
+		lock = ldlm_lru_next_lock(ns, flags);
+		if (lock == NULL)
+			break;
 		lu_ref_add(&lock->l_reference, __FUNCTION__, current);
 
 		/* Pass the lock through the policy filter and see if it
@@ -1700,14 +1873,12 @@ static int ldlm_prepare_lru_list(struct ldlm_namespace *ns, cfs_list_t *cancels,
 			lu_ref_del(&lock->l_reference,
 				   __FUNCTION__, current);
 			LDLM_LOCK_RELEASE(lock);
-			spin_lock(&ns->ns_lock);
 			break;
 		}
 		if (result == LDLM_POLICY_SKIP_LOCK) {
 			lu_ref_del(&lock->l_reference,
 				   __func__, current);
 			LDLM_LOCK_RELEASE(lock);
-			spin_lock(&ns->ns_lock);
 			continue;
 		}
 
@@ -1723,7 +1894,6 @@ static int ldlm_prepare_lru_list(struct ldlm_namespace *ns, cfs_list_t *cancels,
 			lu_ref_del(&lock->l_reference,
 				   __FUNCTION__, current);
 			LDLM_LOCK_RELEASE(lock);
-			spin_lock(&ns->ns_lock);
 			continue;
 		}
 		LASSERT(!lock->l_readers && !lock->l_writers);
@@ -1753,11 +1923,9 @@ static int ldlm_prepare_lru_list(struct ldlm_namespace *ns, cfs_list_t *cancels,
 		cfs_list_add(&lock->l_bl_ast, cancels);
 		unlock_res_and_lock(lock);
 		lu_ref_del(&lock->l_reference, __FUNCTION__, current);
-		spin_lock(&ns->ns_lock);
 		added++;
 		unused--;
 	}
-	spin_unlock(&ns->ns_lock);
 	RETURN(added);
 }
 
@@ -2284,13 +2452,14 @@ static void ldlm_cancel_unused_locks_for_replay(struct ldlm_namespace *ns)
 
         CDEBUG(D_DLMTRACE, "Dropping as many unused locks as possible before"
                            "replay for namespace %s (%d)\n",
-                           ldlm_ns_name(ns), ns->ns_nr_unused);
+			   ldlm_ns_name(ns), cfs_atomic_read(&ns->ns_nr_unused));
 
         /* We don't need to care whether or not LRU resize is enabled
          * because the LDLM_CANCEL_NO_WAIT policy doesn't use the
          * count parameter */
-        canceled = ldlm_cancel_lru_local(ns, &cancels, ns->ns_nr_unused, 0,
-                                         LCF_LOCAL, LDLM_CANCEL_NO_WAIT);
+	canceled = ldlm_cancel_lru_local(ns, &cancels,
+					 cfs_atomic_read(&ns->ns_nr_unused), 0,
+					 LCF_LOCAL, LDLM_CANCEL_NO_WAIT);
 
         CDEBUG(D_DLMTRACE, "Canceled %d unused locks from namespace %s\n",
                            canceled, ldlm_ns_name(ns));
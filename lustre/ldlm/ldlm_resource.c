@@ -181,11 +181,11 @@ static int lprocfs_rd_lru_size(char *page, char **start, off_t off,
                                int count, int *eof, void *data)
 {
         struct ldlm_namespace *ns = data;
-        __u32 *nr = &ns->ns_max_unused;
+	__u32 nr = ns->ns_max_unused;
 
-        if (ns_connect_lru_resize(ns))
-                nr = &ns->ns_nr_unused;
-        return lprocfs_rd_uint(page, start, off, count, eof, nr);
+	if (ns_connect_lru_resize(ns))
+		nr = cfs_atomic_read(&ns->ns_nr_unused);
+	return lprocfs_rd_uint(page, start, off, count, eof, &nr);
 }
 
 static int lprocfs_wr_lru_size(struct file *file, const char *buffer,
@@ -205,7 +205,8 @@ static int lprocfs_wr_lru_size(struct file *file, const char *buffer,
                        "dropping all unused locks from namespace %s\n",
                        ldlm_ns_name(ns));
                 if (ns_connect_lru_resize(ns)) {
-                        int canceled, unused  = ns->ns_nr_unused;
+			int canceled;
+			int unused = cfs_atomic_read(&ns->ns_nr_unused);
 
                         /* Try to cancel all @ns_nr_unused locks. */
 			canceled = ldlm_cancel_lru(ns, unused, 0,
@@ -234,17 +235,18 @@ static int lprocfs_wr_lru_size(struct file *file, const char *buffer,
         lru_resize = (tmp == 0);
 
         if (ns_connect_lru_resize(ns)) {
+		unsigned int unused = cfs_atomic_read(&ns->ns_nr_unused);
+
                 if (!lru_resize)
                         ns->ns_max_unused = (unsigned int)tmp;
 
-                if (tmp > ns->ns_nr_unused)
-                        tmp = ns->ns_nr_unused;
-                tmp = ns->ns_nr_unused - tmp;
+		if (tmp > unused)
+			tmp = unused;
+		tmp = unused - tmp;
 
                 CDEBUG(D_DLMTRACE,
                        "changing namespace %s unused locks from %u to %u\n",
-                       ldlm_ns_name(ns), ns->ns_nr_unused,
-                       (unsigned int)tmp);
+                       ldlm_ns_name(ns), unused, (unsigned int)tmp);
 		ldlm_cancel_lru(ns, tmp, LCF_ASYNC, LDLM_CANCEL_PASSED);
 
                 if (!lru_resize) {
@@ -354,7 +356,7 @@ int ldlm_namespace_proc_register(struct ldlm_namespace *ns)
                 snprintf(lock_name, MAX_STRING_SIZE, "%s/lock_unused_count",
                          ldlm_ns_name(ns));
                 lock_vars[0].data = &ns->ns_nr_unused;
-                lock_vars[0].read_fptr = lprocfs_rd_uint;
+		lock_vars[0].read_fptr = lprocfs_rd_atomic;
                 lprocfs_add_vars(ldlm_ns_proc_dir, lock_vars, 0);
 
                 snprintf(lock_name, MAX_STRING_SIZE, "%s/lru_size",
@@ -371,6 +373,13 @@ int ldlm_namespace_proc_register(struct ldlm_namespace *ns)
                 lock_vars[0].write_fptr = lprocfs_wr_uint;
                 lprocfs_add_vars(ldlm_ns_proc_dir, lock_vars, 0);
 
+		snprintf(lock_name, MAX_STRING_SIZE, "%s/lru_cost_aware",
+			 ldlm_ns_name(ns));
+		lock_vars[0].data = &ns->ns_lru_cost_aware;
+		lock_vars[0].read_fptr = lprocfs_rd_uint;
+		lock_vars[0].write_fptr = lprocfs_wr_uint;
+		lprocfs_add_vars(ldlm_ns_proc_dir, lock_vars, 0);
+
 		snprintf(lock_name, MAX_STRING_SIZE, "%s/early_lock_cancel",
 			 ldlm_ns_name(ns));
 		lock_vars[0].data = ns;
@@ -645,6 +654,15 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
         if (ns->ns_rs_hash == NULL)
                 GOTO(out_ns, NULL);
 
+	ns->ns_lru_nr = cfs_cpt_number(cfs_cpt_table);
+	OBD_ALLOC(ns->ns_lru, ns->ns_lru_nr * sizeof(*ns->ns_lru));
+	if (ns->ns_lru == NULL)
+		GOTO(out_hash, NULL);
+	for (idx = 0; idx < ns->ns_lru_nr; idx++) {
+		spin_lock_init(&ns->ns_lru[idx].ls_lock);
+		CFS_INIT_LIST_HEAD(&ns->ns_lru[idx].ls_list);
+	}
+
         cfs_hash_for_each_bucket(ns->ns_rs_hash, &bd, idx) {
                 nsb = cfs_hash_bd_extra_get(ns->ns_rs_hash, &bd);
                 at_init(&nsb->nsb_at_estimate, ldlm_enqueue_min, 0);
@@ -656,7 +674,6 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
         ns->ns_client   = client;
 
 	CFS_INIT_LIST_HEAD(&ns->ns_list_chain);
-	CFS_INIT_LIST_HEAD(&ns->ns_unused_list);
 	spin_lock_init(&ns->ns_lock);
 	cfs_atomic_set(&ns->ns_bref, 0);
 	init_waitqueue_head(&ns->ns_waitq);
@@ -666,7 +683,7 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 	ns->ns_contended_locks    = NS_DEFAULT_CONTENDED_LOCKS;
 
         ns->ns_max_parallel_ast   = LDLM_DEFAULT_PARALLEL_AST_LIMIT;
-        ns->ns_nr_unused          = 0;
+	cfs_atomic_set(&ns->ns_nr_unused, 0);
         ns->ns_max_unused         = LDLM_DEFAULT_LRU_SIZE;
         ns->ns_max_age            = LDLM_DEFAULT_MAX_ALIVE;
         ns->ns_ctime_age_limit    = LDLM_CTIME_AGE_LIMIT;
@@ -693,6 +710,8 @@ out_proc:
         ldlm_namespace_proc_unregister(ns);
         ldlm_namespace_cleanup(ns, 0);
 out_hash:
+	if (ns->ns_lru != NULL)
+		OBD_FREE(ns->ns_lru, ns->ns_lru_nr * sizeof(*ns->ns_lru));
         cfs_hash_putref(ns->ns_rs_hash);
 out_ns:
         OBD_FREE_PTR(ns);
@@ -948,6 +967,7 @@ void ldlm_namespace_free_post(struct ldlm_namespace *ns)
 
 	ldlm_namespace_proc_unregister(ns);
 	cfs_hash_putref(ns->ns_rs_hash);
+	OBD_FREE(ns->ns_lru, ns->ns_lru_nr * sizeof(*ns->ns_lru));
 	/* Namespace \a ns should be not on list at this time, otherwise
 	 * this will cause issues related to using freed \a ns in poold
 	 * thread. */
@@ -1056,6 +1076,18 @@ struct ldlm_namespace *ldlm_namespace_first_locked(ldlm_side_t client)
 			    struct ldlm_namespace, ns_list_chain);
 }
 
+/**
+ * Releases the memory of \a res charged to the namespace pool, the LVB was
+ * charged once lvbo_init() had set it up and is kept until lvbo_free().
+ */
+static inline void ldlm_resource_mem_del(struct ldlm_namespace *ns,
+					 struct ldlm_resource *res)
+{
+	if (res->lr_lvb_len > 0)
+		ldlm_pool_mem_del(&ns->ns_pool, res->lr_lvb_len);
+	ldlm_pool_mem_del(&ns->ns_pool, sizeof(*res));
+}
+
 /** Create and initialize new resource. */
 static struct ldlm_resource *ldlm_resource_new(void)
 {
@@ -1177,6 +1209,7 @@ ldlm_resource_get(struct ldlm_namespace *ns, struct ldlm_resource *parent,
 		ns_refcount = ldlm_namespace_get_return(ns);
 
         cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
+	ldlm_pool_mem_add(&ns->ns_pool, sizeof(*res));
         if (ns->ns_lvbo && ns->ns_lvbo->lvbo_init) {
                 int rc;
 
@@ -1195,6 +1228,8 @@ ldlm_resource_get(struct ldlm_namespace *ns, struct ldlm_resource *parent,
 			ldlm_resource_putref(res);
 			return NULL;
 		}
+		if (res->lr_lvb_len > 0)
+			ldlm_pool_mem_add(&ns->ns_pool, res->lr_lvb_len);
 	}
 
 	/* We create resource with locked lr_lvb_mutex. */
@@ -1265,6 +1300,7 @@ int ldlm_resource_putref(struct ldlm_resource *res)
         if (cfs_hash_bd_dec_and_lock(ns->ns_rs_hash, &bd, &res->lr_refcount)) {
                 __ldlm_resource_putref_final(&bd, res);
                 cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
+		ldlm_resource_mem_del(ns, res);
                 if (ns->ns_lvbo && ns->ns_lvbo->lvbo_free)
                         ns->ns_lvbo->lvbo_free(res);
                 OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
@@ -1295,6 +1331,7 @@ int ldlm_resource_putref_locked(struct ldlm_resource *res)
                  * cfs_hash_for_each_nolock is the only case we can get
                  * here, which is safe to release cfs_hash_bd_lock.
                  */
+		ldlm_resource_mem_del(ns, res);
                 if (ns->ns_lvbo && ns->ns_lvbo->lvbo_free)
                         ns->ns_lvbo->lvbo_free(res);
                 OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
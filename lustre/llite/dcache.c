@@ -479,6 +479,10 @@ do_lock:
         if (!IS_POSIXACL(parent) || !exp_connect_umask(exp))
 		it->it_create_mode &= ~current_umask();
         it->it_create_mode |= M_CHECK_STALE;
+	/* a frequently opened file, let its handles be cached */
+	if ((it->it_op & IT_OPEN) && de->d_inode != NULL &&
+	    ll_opencache_want(de->d_inode))
+		it->it_flags |= MDS_OPEN_LOCK;
         rc = md_intent_lock(exp, op_data, NULL, 0, it,
                             lookup_flags,
                             &req, ll_md_blocking_ast, 0);
@@ -330,25 +330,19 @@ static struct page *ll_dir_page_locate(struct inode *dir, __u64 *hash,
         return page;
 }
 
-struct page *ll_get_dir_page(struct inode *dir, __u64 hash,
-                             struct ll_dir_chain *chain)
+/*
+ * Takes a PR UPDATE lock on \a dir, under which its cached pages stay valid,
+ * and returns it referenced in \a lockh.
+ */
+static int ll_dir_lock(struct inode *dir, struct lustre_handle *lockh)
 {
         ldlm_policy_data_t policy = {.l_inodebits = {MDS_INODELOCK_UPDATE} };
-        struct address_space *mapping = dir->i_mapping;
-        struct lustre_handle lockh;
-        struct lu_dirpage *dp;
-        struct page *page;
         ldlm_mode_t mode;
         int rc;
-        __u64 start = 0;
-        __u64 end = 0;
-        __u64 lhash = hash;
-        struct ll_inode_info *lli = ll_i2info(dir);
-        int hash64 = ll_i2sbi(dir)->ll_flags & LL_SBI_64BIT_HASH;
 
         mode = LCK_PR;
         rc = md_lock_match(ll_i2sbi(dir)->ll_md_exp, LDLM_FL_BLOCK_GRANTED,
-                           ll_inode2fid(dir), LDLM_IBITS, &policy, mode, &lockh);
+                           ll_inode2fid(dir), LDLM_IBITS, &policy, mode, lockh);
 	if (!rc) {
 		struct ldlm_enqueue_info einfo = {
 			.ei_type = LDLM_IBITS,
@@ -363,10 +357,10 @@ struct page *ll_get_dir_page(struct inode *dir, __u64 hash,
 		op_data = ll_prep_md_op_data(NULL, dir, dir, NULL, 0, 0,
 		LUSTRE_OPC_ANY, NULL);
 		if (IS_ERR(op_data))
-			return (void *)op_data;
+			return PTR_ERR(op_data);
 
 		rc = md_enqueue(ll_i2sbi(dir)->ll_md_exp, &einfo, &it,
-				op_data, &lockh, NULL, 0, NULL, 0);
+				op_data, lockh, NULL, 0, NULL, 0);
 
 		ll_finish_md_op_data(op_data);
 
@@ -374,9 +368,9 @@ struct page *ll_get_dir_page(struct inode *dir, __u64 hash,
 		if (request)
 			ptlrpc_req_finished(request);
 		if (rc < 0) {
-			CERROR("lock enqueue: "DFID" at "LPU64": rc %d\n",
-				PFID(ll_inode2fid(dir)), hash, rc);
-			return ERR_PTR(rc);
+			CERROR("lock enqueue: "DFID": rc %d\n",
+			       PFID(ll_inode2fid(dir)), rc);
+			return rc;
 		}
 
 		CDEBUG(D_INODE, "setting lr_lvb_inode to inode %p (%lu/%u)\n",
@@ -386,10 +380,27 @@ struct page *ll_get_dir_page(struct inode *dir, __u64 hash,
         } else {
                 /* for cross-ref object, l_ast_data of the lock may not be set,
                  * we reset it here */
-                md_set_lock_data(ll_i2sbi(dir)->ll_md_exp, &lockh.cookie,
+                md_set_lock_data(ll_i2sbi(dir)->ll_md_exp, &lockh->cookie,
                                  dir, NULL);
         }
-        ldlm_lock_dump_handle(D_OTHER, &lockh);
+        ldlm_lock_dump_handle(D_OTHER, lockh);
+	return 0;
+}
+
+/*
+ * Find or read in, and kmap the page of \a dir that contains \a hash. The
+ * caller holds a reference on a lock from ll_dir_lock().
+ */
+static struct page *ll_get_dir_page_locked(struct inode *dir, __u64 hash)
+{
+        struct address_space *mapping = dir->i_mapping;
+        struct lu_dirpage *dp;
+        struct page *page;
+        __u64 start = 0;
+        __u64 end = 0;
+        __u64 lhash = hash;
+        struct ll_inode_info *lli = ll_i2info(dir);
+        int hash64 = ll_i2sbi(dir)->ll_flags & LL_SBI_64BIT_HASH;
 
 	mutex_lock(&lli->lli_readdir_mutex);
         page = ll_dir_page_locate(dir, &lhash, &start, &end);
@@ -465,7 +476,6 @@ hash_collision:
         }
 out_unlock:
 	mutex_unlock(&lli->lli_readdir_mutex);
-        ldlm_lock_decref(&lockh, mode);
         return page;
 
 fail:
@@ -474,6 +484,50 @@ fail:
         goto out_unlock;
 }
 
+struct page *ll_get_dir_page(struct inode *dir, __u64 hash,
+                             struct ll_dir_chain *chain)
+{
+	struct lustre_handle lockh;
+	struct page *page;
+	int rc;
+
+	rc = ll_dir_lock(dir, &lockh);
+	if (rc < 0)
+		return ERR_PTR(rc);
+
+	page = ll_get_dir_page_locked(dir, hash);
+	ldlm_lock_decref(&lockh, LCK_PR);
+	return page;
+}
+
+/*
+ * Returns the page of a readdir stream that contains \a hash. The lock in
+ * \a lockh, kept by the caller from one page to the next without a
+ * reference, is used again as long as nobody waits for it; otherwise, or
+ * if there is none yet, a lock is found or enqueued as ll_get_dir_page()
+ * does. No reference is left on the lock, so that it can be cancelled
+ * while the entries of the page are handed to filldir().
+ */
+static struct page *ll_dir_read_page(struct inode *dir, __u64 hash,
+				     struct lustre_handle *lockh)
+{
+	struct page *page;
+	int rc;
+
+	if (!lustre_handle_is_used(lockh) ||
+	    ldlm_lock_addref_try(lockh, LCK_PR) != 0) {
+		rc = ll_dir_lock(dir, lockh);
+		if (rc < 0) {
+			lockh->cookie = 0ULL;
+			return ERR_PTR(rc);
+		}
+	}
+
+	page = ll_get_dir_page_locked(dir, hash);
+	ldlm_lock_decref(lockh, LCK_PR);
+	return page;
+}
+
 int ll_dir_read(struct inode *inode, __u64 *_pos, void *cookie,
 		filldir_t filldir)
 {
@@ -484,13 +538,16 @@ int ll_dir_read(struct inode *inode, __u64 *_pos, void *cookie,
         int                   hash64     = sbi->ll_flags & LL_SBI_64BIT_HASH;
         struct page          *page;
         struct ll_dir_chain   chain;
+	struct lustre_handle  lockh = { 0 };
 	int                   done = 0;
 	int                   rc = 0;
         ENTRY;
 
         ll_dir_chain_init(&chain);
 
-	page = ll_get_dir_page(inode, pos, &chain);
+	/* Use the same lock for all the pages as long as it is not wanted,
+	 * rather than matching a lock again for each of them. */
+	page = ll_dir_read_page(inode, pos, &lockh);
 
         while (rc == 0 && !done) {
                 struct lu_dirpage *dp;
@@ -564,8 +621,8 @@ int ll_dir_read(struct inode *inode, __u64 *_pos, void *cookie,
                                             le32_to_cpu(dp->ldp_flags) &
                                                         LDF_COLLIDE);
 					next = pos;
-					page = ll_get_dir_page(inode, pos,
-                                                               &chain);
+					page = ll_dir_read_page(inode, pos,
+								&lockh);
                                 } else {
                                         /*
                                          * go into overflow page.
@@ -213,12 +213,107 @@ out:
         return rc;
 }
 
+/*
+ * Open handle cache.
+ *
+ * Once a regular file has been opened ll_opencache_threshold times, further
+ * opens ask the MDS for an OPEN lock. While that lock is held, the last
+ * close of a mode keeps the MDS open handle instead of sending a close RPC,
+ * and the next open of the same mode reuses it without an open RPC. Inodes
+ * with such unused handles sit on a per-mount LRU, and the OPEN locks of the
+ * oldest ones are cancelled once there are more than ll_opencache_max; the
+ * blocking AST then closes the handles the usual way.
+ */
+int ll_opencache_want(struct inode *inode)
+{
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+
+	return S_ISREG(inode->i_mode) && sbi->ll_opencache_threshold > 0 &&
+	       ll_i2info(inode)->lli_opencache_opens >=
+	       sbi->ll_opencache_threshold;
+}
+
+/**
+ * Put \a inode to the tail of the LRU. Called under lli_och_mutex with the
+ * handle still present, so that it cannot race with ll_md_real_close().
+ *
+ * \retval 1 if the LRU has grown too long and needs ll_opencache_shrink()
+ */
+static int ll_opencache_add(struct inode *inode)
+{
+	struct ll_sb_info	*sbi = ll_i2sbi(inode);
+	struct ll_inode_info	*lli = ll_i2info(inode);
+	int			 shrink;
+
+	spin_lock(&sbi->ll_opencache_lock);
+	if (cfs_list_empty(&lli->lli_opencache_lru))
+		sbi->ll_opencache_count++;
+	cfs_list_move_tail(&lli->lli_opencache_lru, &sbi->ll_opencache_lru);
+	shrink = sbi->ll_opencache_count > sbi->ll_opencache_max;
+	spin_unlock(&sbi->ll_opencache_lock);
+
+	return shrink;
+}
+
+static void ll_opencache_del(struct inode *inode)
+{
+	struct ll_sb_info	*sbi = ll_i2sbi(inode);
+	struct ll_inode_info	*lli = ll_i2info(inode);
+
+	spin_lock(&sbi->ll_opencache_lock);
+	if (!cfs_list_empty(&lli->lli_opencache_lru)) {
+		cfs_list_del_init(&lli->lli_opencache_lru);
+		sbi->ll_opencache_count--;
+	}
+	spin_unlock(&sbi->ll_opencache_lock);
+}
+
+/**
+ * Cancel the OPEN locks of the least recently closed files until no more
+ * than ll_opencache_max of them keep cached open handles.
+ */
+void ll_opencache_shrink(struct ll_sb_info *sbi)
+{
+	ldlm_policy_data_t policy = {
+		.l_inodebits = { MDS_INODELOCK_OPEN } };
+	struct ll_inode_info	*lli;
+	struct inode		*inode;
+	ENTRY;
+
+	spin_lock(&sbi->ll_opencache_lock);
+	while (sbi->ll_opencache_count > sbi->ll_opencache_max) {
+		lli = cfs_list_entry(sbi->ll_opencache_lru.next,
+				     struct ll_inode_info, lli_opencache_lru);
+		cfs_list_del_init(&lli->lli_opencache_lru);
+		sbi->ll_opencache_count--;
+
+		/* being freed, ll_clear_inode() closes the handles */
+		inode = igrab(ll_info2i(lli));
+		if (inode == NULL)
+			continue;
+		spin_unlock(&sbi->ll_opencache_lock);
+
+		CDEBUG(D_INODE, "evict cached open handles of "DFID"\n",
+		       PFID(ll_inode2fid(inode)));
+		/* LCK_EX so that locks of every mode are cancelled */
+		md_cancel_unused(sbi->ll_md_exp, ll_inode2fid(inode), &policy,
+				 LCK_EX, LCF_ASYNC, NULL);
+		cfs_atomic_inc(&sbi->ll_opencache_evicted);
+		iput(inode);
+
+		spin_lock(&sbi->ll_opencache_lock);
+	}
+	spin_unlock(&sbi->ll_opencache_lock);
+	EXIT;
+}
+
 int ll_md_real_close(struct inode *inode, int flags)
 {
         struct ll_inode_info *lli = ll_i2info(inode);
         struct obd_client_handle **och_p;
         struct obd_client_handle *och;
         __u64 *och_usecount;
+	int cached;
         int rc = 0;
         ENTRY;
 
@@ -242,8 +337,14 @@ int ll_md_real_close(struct inode *inode, int flags)
         }
         och=*och_p;
         *och_p = NULL;
+	cached = lli->lli_mds_read_och != NULL ||
+		 lli->lli_mds_write_och != NULL ||
+		 lli->lli_mds_exec_och != NULL;
 	mutex_unlock(&lli->lli_och_mutex);
 
+	if (!cached)
+		ll_opencache_del(inode);
+
         if (och) { /* There might be a race and somebody have freed this och
                       already */
                 rc = ll_close_inode_openhandle(ll_i2sbi(inode)->ll_md_exp,
@@ -287,6 +388,9 @@ int ll_md_close(struct obd_export *md_exp, struct inode *inode,
            we can skip talking to MDS */
         if (file->f_dentry->d_inode) { /* Can this ever be false? */
                 int lockmode;
+		int shrink = 0;
+		struct obd_client_handle **och_p;
+		__u64 *och_usecount;
 		__u64 flags = LDLM_FL_BLOCK_GRANTED | LDLM_FL_TEST_LOCK;
                 struct lustre_handle lockh;
                 struct inode *inode = file->f_dentry->d_inode;
@@ -295,17 +399,19 @@ int ll_md_close(struct obd_export *md_exp, struct inode *inode,
 		mutex_lock(&lli->lli_och_mutex);
                 if (fd->fd_omode & FMODE_WRITE) {
                         lockmode = LCK_CW;
-                        LASSERT(lli->lli_open_fd_write_count);
-                        lli->lli_open_fd_write_count--;
+			och_p = &lli->lli_mds_write_och;
+			och_usecount = &lli->lli_open_fd_write_count;
                 } else if (fd->fd_omode & FMODE_EXEC) {
                         lockmode = LCK_PR;
-                        LASSERT(lli->lli_open_fd_exec_count);
-                        lli->lli_open_fd_exec_count--;
+			och_p = &lli->lli_mds_exec_och;
+			och_usecount = &lli->lli_open_fd_exec_count;
                 } else {
                         lockmode = LCK_CR;
-                        LASSERT(lli->lli_open_fd_read_count);
-                        lli->lli_open_fd_read_count--;
+			och_p = &lli->lli_mds_read_och;
+			och_usecount = &lli->lli_open_fd_read_count;
                 }
+		LASSERT(*och_usecount);
+		(*och_usecount)--;
 		mutex_unlock(&lli->lli_och_mutex);
 
                 if (!md_lock_match(md_exp, flags, ll_inode2fid(inode),
@@ -313,6 +419,15 @@ int ll_md_close(struct obd_export *md_exp, struct inode *inode,
                                    &lockh)) {
                         rc = ll_md_real_close(file->f_dentry->d_inode,
                                               fd->fd_omode);
+		} else if (S_ISREG(inode->i_mode)) {
+			/* the handle is kept under the OPEN lock, remember it
+			 * for eviction once it has no users */
+			mutex_lock(&lli->lli_och_mutex);
+			if (*och_p != NULL && *och_usecount == 0)
+				shrink = ll_opencache_add(inode);
+			mutex_unlock(&lli->lli_och_mutex);
+			if (shrink)
+				ll_opencache_shrink(ll_i2sbi(inode));
                 }
         } else {
                 CERROR("Releasing a file %p with negative dentry %p. Name %s",
@@ -628,6 +743,10 @@ restart:
                         }
 
                         ll_release_openhandle(file->f_dentry, it);
+		} else if (*och_usecount == 0 && S_ISREG(inode->i_mode)) {
+			/* reuse a handle cached by ll_md_close() */
+			cfs_atomic_inc(&ll_i2sbi(inode)->ll_opencache_hits);
+			ll_opencache_del(inode);
                 }
                 (*och_usecount)++;
 
@@ -675,6 +794,8 @@ restart:
                 if (rc)
                         GOTO(out_och_free, rc);
         }
+	if (S_ISREG(inode->i_mode))
+		lli->lli_opencache_opens++;
 	mutex_unlock(&lli->lli_och_mutex);
         fd = NULL;
 
@@ -1112,9 +1233,14 @@ void ll_io_init(struct cl_io *io, const struct file *file, int write)
                 io->ci_no_srvlock = 1;
         } else if (file->f_flags & O_APPEND) {
                 io->ci_lockreq = CILR_MANDATORY;
+	} else if (LUSTRE_FPRIVATE(file)->fd_flags & LL_FILE_LOCKLESS_IO) {
+		/* no client locks, the OST locks each BRW for us */
+		io->ci_lockreq = CILR_NEVER;
         }
 
 	io->ci_noatime = file_is_noatime(file);
+	io->ci_parallel_stripes = !!(LUSTRE_FPRIVATE(file)->fd_flags &
+				     LL_FILE_PARALLEL_IO);
 }
 
 static ssize_t
@@ -2281,6 +2407,25 @@ out:
 	RETURN(rc);
 }
 
+/**
+ * Whether the OSTs of \a inode lock lockless IO themselves, going by the
+ * connect flags they agreed to rather than those llite asked for.
+ */
+static int ll_srvlock_supported(struct inode *inode)
+{
+	struct lov_stripe_md	*lsm;
+	__u32			 vallen = sizeof(int);
+	int			 srvlock = 0;
+	int			 rc;
+
+	lsm = ccc_inode_lsm_get(inode);
+	rc = obd_get_info(NULL, ll_i2dtexp(inode), sizeof(KEY_SRVLOCK),
+			  KEY_SRVLOCK, &vallen, &srvlock, lsm);
+	ccc_inode_lsm_put(inode, lsm);
+
+	return rc == 0 && srvlock;
+}
+
 long ll_file_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
 	struct inode		*inode = file->f_dentry->d_inode;
@@ -2316,6 +2461,10 @@ long ll_file_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
                                        "non-O_DIRECT file\n", current->comm);
                                 RETURN(-EINVAL);
                         }
+			/* the OSTs have to lock lockless IO themselves */
+			if ((flags & LL_FILE_LOCKLESS_IO) &&
+			    !ll_srvlock_supported(inode))
+				RETURN(-EOPNOTSUPP);
 
                         fd->fd_flags |= flags;
                 } else {
@@ -2401,6 +2550,36 @@ long ll_file_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		RETURN(rc);
 	}
 
+	case LL_IOC_SYNC_RANGE: {
+		struct ll_sync_range	sr;
+		enum cl_fsync_mode	mode;
+		int			rc;
+
+		if (copy_from_user(&sr, (char *)arg, sizeof(sr)))
+			RETURN(-EFAULT);
+
+		if (!S_ISREG(inode->i_mode) || sr.sr_start > sr.sr_end ||
+		    (sr.sr_flags & ~(LL_SYNC_WAIT | LL_SYNC_COMMIT)))
+			RETURN(-EINVAL);
+
+		if (sr.sr_flags & LL_SYNC_COMMIT)
+			mode = CL_FSYNC_ALL;
+		else if (sr.sr_flags & LL_SYNC_WAIT)
+			mode = CL_FSYNC_LOCAL;
+		else
+			mode = CL_FSYNC_NONE;
+
+		/* pages dirtied through mmap are not in the osc cache yet */
+		rc = filemap_fdatawrite_range(inode->i_mapping, sr.sr_start,
+					      sr.sr_end == OBD_OBJECT_EOF ?
+					      LLONG_MAX : sr.sr_end);
+		if (rc != 0)
+			RETURN(rc);
+
+		rc = cl_sync_file_range(inode, sr.sr_start, sr.sr_end, mode, 0);
+		RETURN(rc < 0 ? rc : 0);
+	}
+
         case LL_IOC_GET_MDTIDX: {
                 int mdtidx;
 
@@ -128,6 +128,8 @@ enum lli_flags {
 	LLIF_FILE_RESTORING	= (1 << 7),
 	/* Xattr cache is attached to the file */
 	LLIF_XATTR_CACHE	= (1 << 8),
+	/* Xattr cache was reclaimed while the XATTR lock is still cached */
+	LLIF_XATTR_RECLAIMED	= (1 << 9),
 };
 
 struct ll_inode_info {
@@ -170,6 +172,11 @@ struct ll_inode_info {
         __u64                           lli_open_fd_exec_count;
         /* Protects access to och pointers and their usage counters */
 	struct mutex			lli_och_mutex;
+	/* # opens of this file, to decide whether its handles are cached */
+	unsigned int			lli_opencache_opens;
+	/* linkage into ll_sb_info::ll_opencache_lru while open handles
+	 * without users are kept under an OPEN lock, see file.c */
+	struct list_head		lli_opencache_lru;
 
 	struct inode			lli_vfs_inode;
 
@@ -283,7 +290,9 @@ struct ll_inode_info {
 
 	struct rw_semaphore		lli_xattrs_list_rwsem;
 	struct mutex			lli_xattrs_enq_lock;
-	struct list_head		lli_xattrs; /* ll_xattr_entry->xe_list */
+	struct ll_xattr_cache	       *lli_xattrs;
+	/* bumped each time the xattr cache is dropped */
+	__u32				lli_xattrs_gen;
 };
 
 int ll_xattr_cache_destroy(struct inode *inode);
@@ -293,6 +302,8 @@ int ll_xattr_cache_get(struct inode *inode,
 			char *buffer,
 			size_t size,
 			__u64 valid);
+void ll_xattr_cache_insert(struct inode *inode, const char *name,
+			   const char *buffer, size_t size, __u32 gen);
 
 /*
  * Locking to guarantee consistency of non-atomic updates to long long i_size,
@@ -487,7 +498,8 @@ struct ll_sb_info {
 
         int                       ll_flags;
 	unsigned int		  ll_umounting:1,
-				  ll_xattr_cache_enabled:1;
+				  ll_xattr_cache_enabled:1,
+				  ll_fast_fault:1; /* see ll_fault_cached() */
         cfs_list_t                ll_conn_chain; /* per-conn chain of SBs */
         struct lustre_client_ocd  ll_lco;
 
@@ -534,8 +546,35 @@ struct ll_sb_info {
                                                  * clustred nfs */
         struct rmtacl_ctl_table   ll_rct;
         struct eacl_table         ll_et;
+
+	/* xattr caches of all inodes in LRU order, see xattr_cache.c */
+	spinlock_t		  ll_xattr_lock;
+	struct list_head	  ll_xattr_lru;
+	unsigned int		  ll_xattr_cache_count;
+	unsigned long		  ll_xattr_cache_bytes;
+	unsigned long		  ll_xattr_cache_max;	/* bytes */
+	cfs_atomic_t		  ll_xattr_hits;
+	cfs_atomic_t		  ll_xattr_neg_hits;
+	cfs_atomic_t		  ll_xattr_misses;
+	cfs_atomic_t		  ll_xattr_reclaimed;
+
+	/* inodes with cached open handles in LRU order, see file.c */
+	spinlock_t		  ll_opencache_lock;
+	struct list_head	  ll_opencache_lru;
+	unsigned int		  ll_opencache_count;
+	unsigned int		  ll_opencache_max;
+	unsigned int		  ll_opencache_threshold;
+	cfs_atomic_t		  ll_opencache_hits;
+	cfs_atomic_t		  ll_opencache_evicted;
 };
 
+/* default value for ll_sb_info->ll_xattr_cache_max */
+#define SBI_DEFAULT_XATTR_CACHE_MAX	(64 << 20)
+
+/* default values for ll_sb_info->ll_opencache_{max,threshold} */
+#define SBI_DEFAULT_OPENCACHE_MAX	1024
+#define SBI_DEFAULT_OPENCACHE_THRESHOLD	5
+
 #define LL_DEFAULT_MAX_RW_CHUNK      (32 * 1024 * 1024)
 
 struct ll_ra_read {
@@ -783,6 +822,8 @@ int ll_release_openhandle(struct dentry *, struct lookup_intent *);
 int ll_md_close(struct obd_export *md_exp, struct inode *inode,
                 struct file *file);
 int ll_md_real_close(struct inode *inode, int flags);
+int ll_opencache_want(struct inode *inode);
+void ll_opencache_shrink(struct ll_sb_info *sbi);
 void ll_ioepoch_close(struct inode *inode, struct md_op_data *op_data,
                       struct obd_client_handle **och, unsigned long flags);
 void ll_done_writing_attr(struct inode *inode, struct md_op_data *op_data);
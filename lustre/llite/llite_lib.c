@@ -105,6 +105,8 @@ static struct ll_sb_info *ll_init_sbi(void)
 	cfs_atomic_set(&sbi->ll_cache.ccc_lru_left, lru_page_max);
 	spin_lock_init(&sbi->ll_cache.ccc_lru_lock);
 	CFS_INIT_LIST_HEAD(&sbi->ll_cache.ccc_lru);
+	cfs_atomic_set(&sbi->ll_cache.ccc_dirty_users, 0);
+	cfs_atomic_set(&sbi->ll_cache.ccc_dirty_idle, 0);
 
         sbi->ll_ra_info.ra_max_pages_per_file = min(pages / 32,
                                            SBI_DEFAULT_READAHEAD_MAX);
@@ -145,6 +147,16 @@ static struct ll_sb_info *ll_init_sbi(void)
         cfs_atomic_set(&sbi->ll_agl_total, 0);
         sbi->ll_flags |= LL_SBI_AGL_ENABLED;
 
+	spin_lock_init(&sbi->ll_xattr_lock);
+	CFS_INIT_LIST_HEAD(&sbi->ll_xattr_lru);
+	sbi->ll_xattr_cache_max = SBI_DEFAULT_XATTR_CACHE_MAX;
+
+	spin_lock_init(&sbi->ll_opencache_lock);
+	CFS_INIT_LIST_HEAD(&sbi->ll_opencache_lru);
+	sbi->ll_opencache_max = SBI_DEFAULT_OPENCACHE_MAX;
+	sbi->ll_opencache_threshold = SBI_DEFAULT_OPENCACHE_THRESHOLD;
+	sbi->ll_fast_fault = 1;
+
         RETURN(sbi);
 }
 
@@ -208,7 +220,8 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt,
 				  OBD_CONNECT_JOBSTATS | OBD_CONNECT_LVB_TYPE |
 				  OBD_CONNECT_LAYOUTLOCK | OBD_CONNECT_PINGLESS |
 				  OBD_CONNECT_MAX_EASIZE |
-				  OBD_CONNECT_FLOCK_DEAD;
+				  OBD_CONNECT_FLOCK_DEAD | OBD_CONNECT_BL_BATCH |
+				  OBD_CONNECT_LOCK_CONVERT | OBD_CONNECT_PING_AGG;
 
         if (sbi->ll_flags & LL_SBI_SOM_PREVIEW)
                 data->ocd_connect_flags |= OBD_CONNECT_SOM;
@@ -410,7 +423,8 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt,
                                   OBD_CONNECT_MAXBYTES |
 				  OBD_CONNECT_EINPROGRESS |
 				  OBD_CONNECT_JOBSTATS | OBD_CONNECT_LVB_TYPE |
-				  OBD_CONNECT_LAYOUTLOCK | OBD_CONNECT_PINGLESS;
+				  OBD_CONNECT_LAYOUTLOCK | OBD_CONNECT_PINGLESS |
+				  OBD_CONNECT_BL_BATCH | OBD_CONNECT_PING_AGG;
 
         if (sbi->ll_flags & LL_SBI_SOM_PREVIEW)
                 data->ocd_connect_flags |= OBD_CONNECT_SOM;
@@ -943,6 +957,8 @@ void ll_lli_init(struct ll_inode_info *lli)
         lli->lli_open_fd_write_count = 0;
         lli->lli_open_fd_exec_count = 0;
 	mutex_init(&lli->lli_och_mutex);
+	lli->lli_opencache_opens = 0;
+	CFS_INIT_LIST_HEAD(&lli->lli_opencache_lru);
 	spin_lock_init(&lli->lli_agl_lock);
 	lli->lli_has_smd = false;
 	lli->lli_layout_gen = LL_LAYOUT_GEN_NONE;
@@ -287,6 +287,99 @@ static inline int to_fault_error(int result)
 	return result;
 }
 
+/**
+ * Fast path of ll_fault() for a page that is cached already. A cached page
+ * is covered by a DLM lock, as pages are discarded when their lock is
+ * cancelled, and this happens under the page lock, so holding the page lock
+ * is enough to map it without a cl_io. The page is trylocked, pages under IO
+ * or being discarded are left to the slow path.
+ *
+ * Read-ahead pages are not uptodate until they are used, they are exported
+ * here as vvp_io_read_page() does, except for the last ones of the
+ * read-ahead window, which go through the slow path so that it reads the
+ * next window ahead.
+ *
+ * \retval 0 vmf->page is set to the locked page
+ * \retval -ENODATA the fault has to go through the slow path
+ */
+static int ll_fault_cached(struct vm_area_struct *vma, struct vm_fault *vmf)
+{
+	struct file		  *file  = vma->vm_file;
+	struct inode		  *inode = file->f_dentry->d_inode;
+	struct ll_sb_info	  *sbi   = ll_i2sbi(inode);
+	struct ll_file_data	  *fd    = LUSTRE_FPRIVATE(file);
+	struct ll_readahead_state *ras;
+	struct lu_env		  *env;
+	struct page		  *vmpage;
+	struct cl_page		  *page;
+	struct ccc_page		  *cp;
+	pgoff_t			   last_index;
+	int			   refcheck;
+	int			   rc = -ENODATA;
+
+	if (!sbi->ll_fast_fault || fd == NULL || ll_file_nolock(file))
+		return -ENODATA;
+
+	vmpage = find_get_page(inode->i_mapping, vmf->pgoff);
+	if (vmpage == NULL)
+		return -ENODATA;
+
+	if (!trylock_page(vmpage)) {
+		page_cache_release(vmpage);
+		return -ENODATA;
+	}
+
+	last_index = (i_size_read(inode) + PAGE_CACHE_SIZE - 1) >>
+		     PAGE_CACHE_SHIFT;
+	if (vmpage->mapping != inode->i_mapping || vmf->pgoff >= last_index)
+		goto out;
+
+	env = cl_env_get(&refcheck);
+	if (IS_ERR(env))
+		goto out;
+
+	page = cl_vmpage_page(vmpage, ll_i2info(inode)->lli_clob);
+	if (page == NULL)
+		goto out_env;
+
+	cp = cl2ccc_page(cl_page_at(page, &vvp_device_type));
+	if (PageUptodate(vmpage)) {
+		rc = 0;
+	} else if (cp->cpg_defer_uptodate && !cp->cpg_ra_used) {
+		unsigned long next;
+		unsigned long margin;
+
+		ras = &fd->fd_ras;
+		spin_lock(&ras->ras_lock);
+		next = ras->ras_next_readahead;
+		margin = ras->ras_window_len >> 2;
+		spin_unlock(&ras->ras_lock);
+
+		if (vmf->pgoff + margin < next) {
+			if (sbi->ll_ra_info.ra_max_pages_per_file &&
+			    sbi->ll_ra_info.ra_max_pages)
+				ras_update(sbi, inode, ras, vmf->pgoff, 1);
+			cp->cpg_ra_used = 1;
+			cl_page_export(env, page, 1);
+			rc = 0;
+		}
+	}
+	cl_page_put(env, page);
+out_env:
+	cl_env_put(env, &refcheck);
+out:
+	if (rc == 0) {
+		vmf->page = vmpage;
+		ll_stats_ops_tally(sbi, LPROC_LL_FAULT_CACHED, 1);
+	} else {
+		unlock_page(vmpage);
+		page_cache_release(vmpage);
+	}
+	CDEBUG(D_MMAP, "%s: page %lu cached: %d\n", current->comm,
+	       vmf->pgoff, rc);
+	return rc;
+}
+
 /**
  * Lustre implementation of a vm_operations_struct::fault() method, called by
  * VM to server page fault (both in kernel and user space).
@@ -349,6 +442,11 @@ static int ll_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 	int result;
 	sigset_t set;
 
+	ll_stats_ops_tally(ll_i2sbi(vma->vm_file->f_dentry->d_inode),
+			   LPROC_LL_FAULT, 1);
+	if (ll_fault_cached(vma, vmf) == 0)
+		return VM_FAULT_LOCKED;
+
 	/* Only SIGKILL and SIGTERM is allowed for fault/nopage/mkwrite
 	 * so that it can be killed by admin but not cause segfault by
 	 * other signals. */
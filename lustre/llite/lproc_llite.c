@@ -252,6 +252,174 @@ static int ll_wr_xattr_cache(struct file *file, const char *buffer,
 	return count;
 }
 
+static int ll_rd_fast_fault(char *page, char **start, off_t off,
+			    int count, int *eof, void *data)
+{
+	struct super_block *sb = data;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	*eof = 1;
+	return snprintf(page, count, "%u\n", sbi->ll_fast_fault);
+}
+
+static int ll_wr_fast_fault(struct file *file, const char *buffer,
+			    unsigned long count, void *data)
+{
+	struct super_block *sb = data;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+	int val, rc;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val != 0 && val != 1)
+		return -ERANGE;
+
+	sbi->ll_fast_fault = val;
+
+	return count;
+}
+
+static int ll_rd_max_xattr_cache_mb(char *page, char **start, off_t off,
+				    int count, int *eof, void *data)
+{
+	struct super_block *sb = data;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	return snprintf(page, count, "%lu\n", sbi->ll_xattr_cache_max >> 20);
+}
+
+static int ll_wr_max_xattr_cache_mb(struct file *file, const char *buffer,
+				    unsigned long count, void *data)
+{
+	struct super_block *sb = data;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+	int mult, rc, pages_number;
+
+	mult = 1 << (20 - PAGE_CACHE_SHIFT);
+	rc = lprocfs_write_frac_helper(buffer, count, &pages_number, mult);
+	if (rc)
+		return rc;
+
+	if (pages_number < 0 || pages_number > totalram_pages / 2) {
+		CERROR("can't set max xattr cache more than %lu MB\n",
+		       totalram_pages >> (20 - PAGE_CACHE_SHIFT + 1));
+		return -ERANGE;
+	}
+
+	/* caches above the new limit are reclaimed by the next getxattr */
+	sbi->ll_xattr_cache_max = (unsigned long)pages_number <<
+				  PAGE_CACHE_SHIFT;
+
+	return count;
+}
+
+static int ll_rd_xattr_cache_stats(char *page, char **start, off_t off,
+				   int count, int *eof, void *data)
+{
+	struct super_block *sb = data;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+	unsigned long bytes;
+	unsigned int caches;
+
+	spin_lock(&sbi->ll_xattr_lock);
+	bytes = sbi->ll_xattr_cache_bytes;
+	caches = sbi->ll_xattr_cache_count;
+	spin_unlock(&sbi->ll_xattr_lock);
+
+	return snprintf(page, count,
+			"hits: %u\n"
+			"negative hits: %u\n"
+			"misses: %u\n"
+			"reclaimed: %u\n"
+			"caches: %u\n"
+			"bytes: %lu\n",
+			cfs_atomic_read(&sbi->ll_xattr_hits),
+			cfs_atomic_read(&sbi->ll_xattr_neg_hits),
+			cfs_atomic_read(&sbi->ll_xattr_misses),
+			cfs_atomic_read(&sbi->ll_xattr_reclaimed),
+			caches, bytes);
+}
+
+static int ll_rd_opencache_threshold(char *page, char **start, off_t off,
+				     int count, int *eof, void *data)
+{
+	struct super_block *sb = data;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	return snprintf(page, count, "%u\n", sbi->ll_opencache_threshold);
+}
+
+static int ll_wr_opencache_threshold(struct file *file, const char *buffer,
+				     unsigned long count, void *data)
+{
+	struct super_block *sb = data;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+	int val, rc;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val < 0)
+		return -ERANGE;
+
+	/* 0 disables, handles cached so far stay until their lock goes */
+	sbi->ll_opencache_threshold = val;
+
+	return count;
+}
+
+static int ll_rd_opencache_max(char *page, char **start, off_t off,
+			       int count, int *eof, void *data)
+{
+	struct super_block *sb = data;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	return snprintf(page, count, "%u\n", sbi->ll_opencache_max);
+}
+
+static int ll_wr_opencache_max(struct file *file, const char *buffer,
+			       unsigned long count, void *data)
+{
+	struct super_block *sb = data;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+	int val, rc;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val < 0)
+		return -ERANGE;
+
+	sbi->ll_opencache_max = val;
+	ll_opencache_shrink(sbi);
+
+	return count;
+}
+
+static int ll_rd_opencache_stats(char *page, char **start, off_t off,
+				 int count, int *eof, void *data)
+{
+	struct super_block *sb = data;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+	unsigned int files;
+
+	spin_lock(&sbi->ll_opencache_lock);
+	files = sbi->ll_opencache_count;
+	spin_unlock(&sbi->ll_opencache_lock);
+
+	return snprintf(page, count,
+			"hits: %u\n"
+			"evicted: %u\n"
+			"files: %u\n",
+			cfs_atomic_read(&sbi->ll_opencache_hits),
+			cfs_atomic_read(&sbi->ll_opencache_evicted),
+			files);
+}
+
 static int ll_rd_site_stats(char *page, char **start, off_t off,
                             int count, int *eof, void *data)
 {
@@ -505,6 +673,39 @@ out:
 	return rc;
 }
 
+/* How the cache budget is spread over the OSCs of this mount: cached and
+ * busy pages, dirty bytes and the dirty limit each OSC may use right now. */
+static int ll_rd_cache_usage(char *page, char **start, off_t off,
+			     int count, int *eof, void *data)
+{
+	struct super_block     *sb    = data;
+	struct ll_sb_info      *sbi   = ll_s2sbi(sb);
+	struct cl_client_cache *cache = &sbi->ll_cache;
+	struct client_obd      *cli;
+	int			rc;
+
+	*eof = 1;
+	rc = snprintf(page, count, "dirty_users: %d dirty_idle: %d\n",
+		      cfs_atomic_read(&cache->ccc_dirty_users),
+		      cfs_atomic_read(&cache->ccc_dirty_idle));
+
+	spin_lock(&cache->ccc_lru_lock);
+	cfs_list_for_each_entry(cli, &cache->ccc_lru, cl_lru_osc) {
+		if (rc >= count)
+			break;
+		rc += snprintf(page + rc, count - rc,
+			       "%s: cached: %d busy: %d dirty: %ld "
+			       "dirty_max: %ld\n",
+			       cli->cl_import->imp_obd->obd_name,
+			       cfs_atomic_read(&cli->cl_lru_in_list),
+			       cfs_atomic_read(&cli->cl_lru_busy),
+			       cli->cl_dirty, ccc_dirty_max(cli));
+	}
+	spin_unlock(&cache->ccc_lru_lock);
+
+	return min(rc, count);
+}
+
 static int ll_rd_checksum(char *page, char **start, off_t off,
                           int count, int *eof, void *data)
 {
@@ -796,6 +997,8 @@ static struct lprocfs_vars lprocfs_llite_obd_vars[] = {
         { "max_read_ahead_whole_mb", ll_rd_max_read_ahead_whole_mb,
                                      ll_wr_max_read_ahead_whole_mb, 0 },
         { "max_cached_mb",    ll_rd_max_cached_mb, ll_wr_max_cached_mb, 0 },
+	{ "cache_usage",      ll_rd_cache_usage, 0, 0 },
+	{ "fast_fault",       ll_rd_fast_fault, ll_wr_fast_fault, 0 },
         { "checksum_pages",   ll_rd_checksum, ll_wr_checksum, 0 },
         { "max_rw_chunk",     ll_rd_max_rw_chunk, ll_wr_max_rw_chunk, 0 },
         { "stats_track_pid",  ll_rd_track_pid, ll_wr_track_pid, 0 },
@@ -808,6 +1011,13 @@ static struct lprocfs_vars lprocfs_llite_obd_vars[] = {
         { "max_easize",       ll_rd_maxea_size, 0, 0 },
 	{ "sbi_flags",        ll_rd_sbi_flags, 0, 0 },
 	{ "xattr_cache",      ll_rd_xattr_cache, ll_wr_xattr_cache, 0 },
+	{ "max_xattr_cache_mb", ll_rd_max_xattr_cache_mb,
+				ll_wr_max_xattr_cache_mb, 0 },
+	{ "xattr_cache_stats", ll_rd_xattr_cache_stats, 0, 0 },
+	{ "opencache_threshold", ll_rd_opencache_threshold,
+				 ll_wr_opencache_threshold, 0 },
+	{ "opencache_max", ll_rd_opencache_max, ll_wr_opencache_max, 0 },
+	{ "opencache_stats", ll_rd_opencache_stats, 0, 0 },
         { 0 }
 };
 
@@ -837,6 +1047,8 @@ struct llite_file_opcode {
         { LPROC_LL_OPEN,           LPROCFS_TYPE_REGS, "open" },
         { LPROC_LL_RELEASE,        LPROCFS_TYPE_REGS, "close" },
         { LPROC_LL_MAP,            LPROCFS_TYPE_REGS, "mmap" },
+	{ LPROC_LL_FAULT,          LPROCFS_TYPE_REGS, "fault" },
+	{ LPROC_LL_FAULT_CACHED,   LPROCFS_TYPE_REGS, "fault_cached" },
         { LPROC_LL_LLSEEK,         LPROCFS_TYPE_REGS, "seek" },
         { LPROC_LL_FSYNC,          LPROCFS_TYPE_REGS, "fsync" },
         { LPROC_LL_READDIR,        LPROCFS_TYPE_REGS, "readdir" },
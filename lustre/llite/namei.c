@@ -195,6 +195,121 @@ static void ll_invalidate_negative_children(struct inode *dir)
 	ll_unlock_dcache(dir);
 }
 
+/**
+ * Drops what the client caches under the inodebits \a to_cancel of \a lock,
+ * on cancel of the lock or when these bits only are given up.
+ */
+static void ll_lock_cancel_bits(struct ldlm_lock *lock, __u64 to_cancel)
+{
+	struct inode *inode = ll_inode_from_resource_lock(lock);
+	struct ll_inode_info *lli;
+	__u64 bits = to_cancel;
+	struct lu_fid *fid;
+	ldlm_mode_t mode = lock->l_req_mode;
+	int rc;
+
+	/* Inode is set to lock->l_resource->lr_lvb_inode
+	 * for mdc - bug 24555 */
+	LASSERT(lock->l_ast_data == NULL);
+
+	/* Invalidate all dentries associated with this inode */
+	if (inode == NULL)
+		return;
+
+	if (bits & MDS_INODELOCK_XATTR)
+		ll_xattr_cache_destroy(inode);
+
+	/* For OPEN locks we differentiate between lock modes
+	 * LCK_CR, LCK_CW, LCK_PR - bug 22891 */
+	if (bits & (MDS_INODELOCK_LOOKUP | MDS_INODELOCK_UPDATE |
+		    MDS_INODELOCK_LAYOUT | MDS_INODELOCK_PERM))
+		ll_have_md_lock(inode, &bits, LCK_MINMODE);
+
+	if (bits & MDS_INODELOCK_OPEN)
+		ll_have_md_lock(inode, &bits, mode);
+
+	fid = ll_inode2fid(inode);
+	if (!fid_res_name_eq(fid, &lock->l_resource->lr_name))
+		LDLM_ERROR(lock, "data mismatch with object "
+			   DFID" (%p)", PFID(fid), inode);
+
+	if (bits & MDS_INODELOCK_OPEN) {
+		int flags = 0;
+		switch (lock->l_req_mode) {
+		case LCK_CW:
+			flags = FMODE_WRITE;
+			break;
+		case LCK_PR:
+			flags = FMODE_EXEC;
+			break;
+		case LCK_CR:
+			flags = FMODE_READ;
+			break;
+		default:
+			CERROR("Unexpected lock mode for OPEN lock "
+			       "%d, inode %ld\n", lock->l_req_mode,
+			       inode->i_ino);
+		}
+		ll_md_real_close(inode, flags);
+	}
+
+	lli = ll_i2info(inode);
+	if (bits & MDS_INODELOCK_LAYOUT) {
+		struct cl_object_conf conf = { { 0 } };
+
+		conf.coc_opc = OBJECT_CONF_INVALIDATE;
+		conf.coc_inode = inode;
+		rc = ll_layout_conf(inode, &conf);
+		if (rc)
+			CDEBUG(D_INODE, "invaliding layout %d.\n", rc);
+	}
+
+	if (bits & MDS_INODELOCK_UPDATE) {
+		spin_lock(&lli->lli_lock);
+		lli->lli_flags &= ~LLIF_MDS_SIZE_LOCK;
+		spin_unlock(&lli->lli_lock);
+	}
+
+	if (S_ISDIR(inode->i_mode) &&
+	     (bits & MDS_INODELOCK_UPDATE)) {
+		CDEBUG(D_INODE, "invalidating inode %lu\n",
+		       inode->i_ino);
+		truncate_inode_pages(inode->i_mapping, 0);
+		ll_invalidate_negative_children(inode);
+	}
+
+	if (inode->i_sb->s_root &&
+	    inode != inode->i_sb->s_root->d_inode &&
+	    (bits & (MDS_INODELOCK_LOOKUP | MDS_INODELOCK_PERM)))
+		ll_invalidate_aliases(inode);
+	iput(inode);
+}
+
+/**
+ * Gives up the bits of \a lock that blocking ASTs asked for and keeps the
+ * lock with the other ones, if the server supports it.
+ *
+ * \retval 0 the lock was downgraded and must not be cancelled
+ */
+static int ll_md_lock_dropbits(struct ldlm_lock *lock)
+{
+	__u64 to_drop;
+	__u64 bits;
+
+	lock_res_and_lock(lock);
+	bits = lock->l_policy_data.l_inodebits.bits;
+	to_drop = lock->l_ibits_cancel & bits;
+	unlock_res_and_lock(lock);
+
+	/* OPEN locks go with the open handle, these are cancelled */
+	if (to_drop == 0 || to_drop == bits ||
+	    (bits & MDS_INODELOCK_OPEN))
+		return -EINVAL;
+
+	ll_lock_cancel_bits(lock, to_drop);
+	return ldlm_cli_dropbits(lock, to_drop);
+}
+
 int ll_md_blocking_ast(struct ldlm_lock *lock, struct ldlm_lock_desc *desc,
                        void *data, int flag)
 {
@@ -204,6 +319,9 @@ int ll_md_blocking_ast(struct ldlm_lock *lock, struct ldlm_lock_desc *desc,
 
         switch (flag) {
         case LDLM_CB_BLOCKING:
+		if (ll_md_lock_dropbits(lock) == 0)
+			break;
+
                 ldlm_lock2handle(lock, &lockh);
 		rc = ldlm_cli_cancel(&lockh, LCF_ASYNC);
                 if (rc < 0) {
@@ -211,92 +329,10 @@ int ll_md_blocking_ast(struct ldlm_lock *lock, struct ldlm_lock_desc *desc,
                         RETURN(rc);
                 }
                 break;
-        case LDLM_CB_CANCELING: {
-		struct inode *inode = ll_inode_from_resource_lock(lock);
-                struct ll_inode_info *lli;
-                __u64 bits = lock->l_policy_data.l_inodebits.bits;
-                struct lu_fid *fid;
-                ldlm_mode_t mode = lock->l_req_mode;
-
-		/* Inode is set to lock->l_resource->lr_lvb_inode
-		 * for mdc - bug 24555 */
-		LASSERT(lock->l_ast_data == NULL);
-
-		/* Invalidate all dentries associated with this inode */
-		if (inode == NULL)
-			break;
-
+	case LDLM_CB_CANCELING:
 		LASSERT(lock->l_flags & LDLM_FL_CANCELING);
-
-		if (bits & MDS_INODELOCK_XATTR)
-			ll_xattr_cache_destroy(inode);
-
-		/* For OPEN locks we differentiate between lock modes
-		 * LCK_CR, LCK_CW, LCK_PR - bug 22891 */
-		if (bits & (MDS_INODELOCK_LOOKUP | MDS_INODELOCK_UPDATE |
-			    MDS_INODELOCK_LAYOUT | MDS_INODELOCK_PERM))
-                        ll_have_md_lock(inode, &bits, LCK_MINMODE);
-
-                if (bits & MDS_INODELOCK_OPEN)
-                        ll_have_md_lock(inode, &bits, mode);
-
-		fid = ll_inode2fid(inode);
-		if (!fid_res_name_eq(fid, &lock->l_resource->lr_name))
-			LDLM_ERROR(lock, "data mismatch with object "
-				   DFID" (%p)", PFID(fid), inode);
-
-                if (bits & MDS_INODELOCK_OPEN) {
-                        int flags = 0;
-                        switch (lock->l_req_mode) {
-                        case LCK_CW:
-                                flags = FMODE_WRITE;
-                                break;
-                        case LCK_PR:
-                                flags = FMODE_EXEC;
-                                break;
-                        case LCK_CR:
-                                flags = FMODE_READ;
-                                break;
-                        default:
-                                CERROR("Unexpected lock mode for OPEN lock "
-                                       "%d, inode %ld\n", lock->l_req_mode,
-                                       inode->i_ino);
-                        }
-                        ll_md_real_close(inode, flags);
-                }
-
-		lli = ll_i2info(inode);
-		if (bits & MDS_INODELOCK_LAYOUT) {
-			struct cl_object_conf conf = { { 0 } };
-
-			conf.coc_opc = OBJECT_CONF_INVALIDATE;
-			conf.coc_inode = inode;
-			rc = ll_layout_conf(inode, &conf);
-			if (rc)
-				CDEBUG(D_INODE, "invaliding layout %d.\n", rc);
-		}
-
-		if (bits & MDS_INODELOCK_UPDATE) {
-			spin_lock(&lli->lli_lock);
-                        lli->lli_flags &= ~LLIF_MDS_SIZE_LOCK;
-			spin_unlock(&lli->lli_lock);
-		}
-
-                if (S_ISDIR(inode->i_mode) &&
-                     (bits & MDS_INODELOCK_UPDATE)) {
-                        CDEBUG(D_INODE, "invalidating inode %lu\n",
-                               inode->i_ino);
-                        truncate_inode_pages(inode->i_mapping, 0);
-			ll_invalidate_negative_children(inode);
-		}
-
-		if (inode->i_sb->s_root &&
-		    inode != inode->i_sb->s_root->d_inode &&
-		    (bits & (MDS_INODELOCK_LOOKUP | MDS_INODELOCK_PERM)))
-			ll_invalidate_aliases(inode);
-                iput(inode);
-                break;
-        }
+		ll_lock_cancel_bits(lock, lock->l_policy_data.l_inodebits.bits);
+		break;
         default:
                 LBUG();
         }
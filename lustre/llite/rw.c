@@ -496,66 +496,88 @@ static int cl_read_ahead_page(const struct lu_env *env, struct cl_io *io,
 }
 
 /**
- * Initiates read-ahead of a page with given index.
+ * Initiates read-ahead of the pages with the \a nr indices in \a index, with
+ * one cl_page_find_batch() for all of them.
  *
- * \retval     +ve: page was added to \a queue.
+ * \retval +ve: # of pages added to \a queue.
  *
- * \retval -ENOLCK: there is no extent lock for this part of a file, stop
- *                  read-ahead.
- *
- * \retval  -ve, 0: page wasn't added to \a queue for other reason.
+ * \retval -ENOLCK: there is no extent lock for page \a index[*\a nolck], stop
+ *		     read-ahead there. Pages after it which were grabbed
+ *		     already are still processed, and may be added to \a queue.
  */
-static int ll_read_ahead_page(const struct lu_env *env, struct cl_io *io,
-                              struct cl_page_list *queue,
-                              pgoff_t index, struct address_space *mapping)
+static int ll_read_ahead_batch(const struct lu_env *env, struct cl_io *io,
+			       struct cl_page_list *queue, pgoff_t *index,
+			       int nr, struct address_space *mapping,
+			       int *added, int *nolck)
 {
-        struct page      *vmpage;
-        struct cl_object *clob  = ll_i2info(mapping->host)->lli_clob;
-        struct cl_page   *page;
-        enum ra_stat      which = _NR_RA_STAT; /* keep gcc happy */
-        unsigned int      gfp_mask;
-        int               rc    = 0;
-        const char       *msg   = NULL;
+	struct cl_object *clob = ll_i2info(mapping->host)->lli_clob;
+	struct page	 *vmpages[CL_PAGE_BATCH_MAX];
+	struct cl_page	 *pages[CL_PAGE_BATCH_MAX];
+	int		  pos[CL_PAGE_BATCH_MAX];
+	struct page	 *vmpage;
+	enum ra_stat	  which = _NR_RA_STAT; /* keep gcc happy */
+	const char	 *msg;
+	int		  rc = 0;
+	int		  n = 0;
+	int		  i;
+	int		  ret;
+	ENTRY;
 
-        ENTRY;
+	LASSERT(nr <= CL_PAGE_BATCH_MAX);
+	*added = 0;
 
-        gfp_mask = GFP_HIGHUSER & ~__GFP_WAIT;
-#ifdef __GFP_NOWARN
-        gfp_mask |= __GFP_NOWARN;
-#endif
-        vmpage = grab_cache_page_nowait(mapping, index);
-        if (vmpage != NULL) {
-                /* Check if vmpage was truncated or reclaimed */
-                if (vmpage->mapping == mapping) {
-                        page = cl_page_find(env, clob, vmpage->index,
-                                            vmpage, CPT_CACHEABLE);
-                        if (!IS_ERR(page)) {
-                                rc = cl_read_ahead_page(env, io, queue,
-                                                        page, vmpage);
-                                if (rc == -ENOLCK) {
-                                        which = RA_STAT_FAILED_MATCH;
-                                        msg   = "lock match failed";
-                                }
-                        } else {
-                                which = RA_STAT_FAILED_GRAB_PAGE;
-                                msg   = "cl_page_find failed";
-                        }
-                } else {
-                        which = RA_STAT_WRONG_GRAB_PAGE;
-                        msg   = "g_c_p_n returned invalid page";
-                }
-                if (rc != 1)
-                        unlock_page(vmpage);
-                page_cache_release(vmpage);
-        } else {
-                which = RA_STAT_FAILED_GRAB_PAGE;
-                msg   = "g_c_p_n failed";
-        }
-        if (msg != NULL) {
-                ll_ra_stats_inc(mapping, which);
-                CDEBUG(D_READA, "%s\n", msg);
-        }
-        RETURN(rc);
+	for (i = 0; i < nr; i++) {
+		vmpage = grab_cache_page_nowait(mapping, index[i]);
+		if (vmpage == NULL) {
+			ll_ra_stats_inc(mapping, RA_STAT_FAILED_GRAB_PAGE);
+			CDEBUG(D_READA, "g_c_p_n failed\n");
+			continue;
+		}
+		/* Check if vmpage was truncated or reclaimed */
+		if (vmpage->mapping != mapping) {
+			ll_ra_stats_inc(mapping, RA_STAT_WRONG_GRAB_PAGE);
+			CDEBUG(D_READA, "g_c_p_n returned invalid page\n");
+			unlock_page(vmpage);
+			page_cache_release(vmpage);
+			continue;
+		}
+		pos[n] = i;
+		vmpages[n++] = vmpage;
+	}
+
+	cl_page_find_batch(env, clob, vmpages, n, pages);
+
+	for (i = 0; i < n; i++) {
+		msg = NULL;
+		ret = 0;
+		if (!IS_ERR(pages[i])) {
+			ret = cl_read_ahead_page(env, io, queue, pages[i],
+						 vmpages[i]);
+			if (ret == 1) {
+				(*added)++;
+			} else if (ret == -ENOLCK) {
+				which = RA_STAT_FAILED_MATCH;
+				msg   = "lock match failed";
+				if (rc == 0) {
+					rc = -ENOLCK;
+					*nolck = pos[i];
+				}
+			}
+		} else {
+			which = RA_STAT_FAILED_GRAB_PAGE;
+			msg   = "cl_page_find failed";
+		}
+		if (ret != 1)
+			unlock_page(vmpages[i]);
+		page_cache_release(vmpages[i]);
+
+		if (msg != NULL) {
+			ll_ra_stats_inc(mapping, which);
+			CDEBUG(D_READA, "%s\n", msg);
+		}
+	}
+
+	RETURN(rc != 0 ? rc : *added);
 }
 
 #define RIA_DEBUG(ria)                                                       \
@@ -665,22 +687,34 @@ static int ll_read_ahead_pages(const struct lu_env *env,
 {
         int rc, count = 0, stride_ria;
         unsigned long page_idx;
+	pgoff_t index[CL_PAGE_BATCH_MAX];
+	int nr = 0;
+	int added;
+	int nolck;
 
         LASSERT(ria != NULL);
         RIA_DEBUG(ria);
 
         stride_ria = ria->ria_length > ria->ria_pages && ria->ria_pages > 0;
         for (page_idx = ria->ria_start; page_idx <= ria->ria_end &&
-                        *reserved_pages > 0; page_idx++) {
+                        *reserved_pages > nr; page_idx++) {
                 if (ras_inside_ra_window(page_idx, ria)) {
-                        /* If the page is inside the read-ahead window*/
-                        rc = ll_read_ahead_page(env, io, queue,
-                                                page_idx, mapping);
-                        if (rc == 1) {
-                                (*reserved_pages)--;
-                                count ++;
-                        } else if (rc == -ENOLCK)
-                                break;
+			/* If the page is inside the read-ahead window, queue
+			 * it for the next batch */
+			index[nr++] = page_idx;
+			if (nr < CL_PAGE_BATCH_MAX && page_idx < ria->ria_end &&
+			    *reserved_pages > nr)
+				continue;
+
+			rc = ll_read_ahead_batch(env, io, queue, index, nr,
+						 mapping, &added, &nolck);
+			*reserved_pages -= added;
+			count += added;
+			nr = 0;
+			if (rc == -ENOLCK) {
+				page_idx = index[nolck];
+				break;
+			}
                 } else if (stride_ria) {
                         /* If it is not in the read-ahead window, and it is
                          * read-ahead mode, then check whether it should skip
@@ -703,6 +737,15 @@ static int ll_read_ahead_pages(const struct lu_env *env,
                         }
                 }
         }
+	if (nr > 0) {
+		/* the window or the reservation ended in a stride gap */
+		rc = ll_read_ahead_batch(env, io, queue, index, nr, mapping,
+					 &added, &nolck);
+		*reserved_pages -= added;
+		count += added;
+		if (rc == -ENOLCK)
+			page_idx = index[nolck];
+	}
         *ra_end = page_idx;
         return count;
 }
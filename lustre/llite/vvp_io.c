@@ -549,6 +549,9 @@ static int vvp_io_read_start(const struct lu_env *env,
         file_accessed(file);
         switch (vio->cui_io_subtype) {
         case IO_NORMAL:
+		/* the kernel reads the pages it misses one at a time through
+		 * ll_readpage(); the read-ahead that follows finds the pages
+		 * ahead of it in batches, see ll_read_ahead_batch() */
                  result = lustre_generic_file_read(file, cio, &pos);
                  break;
         case IO_SPLICE:
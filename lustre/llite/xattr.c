@@ -287,6 +287,8 @@ int ll_getxattr_common(struct inode *inode, const char *name,
         struct obd_capa *oc;
         struct rmtacl_ctl_entry *rce = NULL;
 	struct ll_inode_info *lli = ll_i2info(inode);
+	int cache_miss = 0;
+	__u32 xattr_gen = 0;
         ENTRY;
 
         CDEBUG(D_VFSTRACE, "VFS Op:inode=%lu/%u(%p)\n",
@@ -356,8 +358,12 @@ int ll_getxattr_common(struct inode *inode, const char *name,
 do_getxattr:
 	if (sbi->ll_xattr_cache_enabled && xattr_type != XATTR_ACL_ACCESS_T) {
 		rc = ll_xattr_cache_get(inode, name, buffer, size, valid);
-		if (rc == -EAGAIN)
+		if (rc == -EAGAIN) {
+			/* only the value of a single name can be cached */
+			cache_miss = (valid & OBD_MD_FLXATTR) && rce == NULL;
+			xattr_gen = lli->lli_xattrs_gen;
 			goto getxattr_nocache;
+		}
 		if (rc < 0)
 			GOTO(out_xattr, rc);
 
@@ -381,8 +387,12 @@ getxattr_nocache:
 				name, NULL, 0, size, 0, &req);
 		capa_put(oc);
 
-		if (rc < 0)
+		if (rc < 0) {
+			if (rc == -ENODATA && cache_miss)
+				ll_xattr_cache_insert(inode, name, NULL, 0,
+						      xattr_gen);
 			GOTO(out_xattr, rc);
+		}
 
 		body = req_capsule_server_get(&req->rq_pill, &RMF_MDT_BODY);
 		LASSERT(body);
@@ -408,6 +418,10 @@ getxattr_nocache:
 
 		memcpy(buffer, xdata, body->eadatasize);
 		rc = body->eadatasize;
+
+		if (cache_miss)
+			ll_xattr_cache_insert(inode, name, buffer, rc,
+					      xattr_gen);
 	}
 
 #ifdef CONFIG_FS_POSIX_ACL
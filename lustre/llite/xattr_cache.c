@@ -39,16 +39,45 @@
 #include <lustre_ver.h>
 #include "llite_internal.h"
 
-/* If we ever have hundreds of extended attributes, we might want to consider
- * using a hash or a tree structure instead of list for faster lookups.
- */
+#define LL_XATTR_HASH_BITS	4
+#define LL_XATTR_HASH_SIZE	(1 << LL_XATTR_HASH_BITS)
+#define LL_XATTR_HASH_MASK	(LL_XATTR_HASH_SIZE - 1)
+
 struct ll_xattr_entry {
 	struct list_head	xe_list;    /* protected with
 					     * lli_xattrs_list_rwsem */
+	struct list_head	xe_hash;    /* ll_xattr_cache::xc_hash[] */
 	char			*xe_name;   /* xattr name, \0-terminated */
 	char			*xe_value;  /* xattr value */
 	unsigned		xe_namelen; /* strlen(xe_name) + 1 */
 	unsigned		xe_vallen;  /* xattr value length */
+	unsigned		xe_negative:1; /* xattr is known not to exist */
+};
+
+/**
+ * Xattr cache of one inode.
+ *
+ * Normally the cache holds all xattrs of the inode, fetched at once by
+ * ll_xattr_cache_refill(), so a name which is not found does not exist.
+ * If the xattrs are too large to be fetched at once, the cache is partial:
+ * values and missing (negative) names are cached one by one as getxattr
+ * fetches them from the MDS. Either way, the cache lives as long as the
+ * XATTR ibits lock it was filled under.
+ */
+struct ll_xattr_cache {
+	/* entries hashed by name */
+	struct list_head	xc_hash[LL_XATTR_HASH_SIZE];
+	/* all entries, in the order of listxattr */
+	struct list_head	xc_list;
+	/* linkage into ll_sb_info::ll_xattr_lru */
+	struct list_head	xc_lru;
+	struct inode		*xc_inode;
+	/* memory used by the entries */
+	unsigned int		xc_size;
+	/* part of xc_size charged to ll_sb_info::ll_xattr_cache_bytes */
+	unsigned int		xc_charged;
+	/* only some names are cached, see above */
+	unsigned int		xc_partial:1;
 };
 
 static struct kmem_cache *xattr_kmem;
@@ -76,16 +105,45 @@ void ll_xattr_fini(void)
 /**
  * Initializes xattr cache for an inode.
  *
- * This initializes the xattr list and marks cache presence.
+ * This allocates the xattr hash and marks cache presence.
+ *
+ * \retval 0       success
+ * \retval -ENOMEM if no memory could be allocated for the cache
  */
-static void ll_xattr_cache_init(struct ll_inode_info *lli)
+static int ll_xattr_cache_init(struct ll_inode_info *lli, int partial)
 {
+	struct ll_xattr_cache *cache;
+	int i;
+
 	ENTRY;
 
 	LASSERT(lli != NULL);
+	LASSERT(!(lli->lli_flags & LLIF_XATTR_CACHE));
 
-	CFS_INIT_LIST_HEAD(&lli->lli_xattrs);
+	OBD_ALLOC_PTR(cache);
+	if (cache == NULL)
+		RETURN(-ENOMEM);
+
+	for (i = 0; i < LL_XATTR_HASH_SIZE; i++)
+		CFS_INIT_LIST_HEAD(&cache->xc_hash[i]);
+	CFS_INIT_LIST_HEAD(&cache->xc_list);
+	CFS_INIT_LIST_HEAD(&cache->xc_lru);
+	cache->xc_inode = ll_info2i(lli);
+	cache->xc_partial = !!partial;
+
+	lli->lli_xattrs = cache;
 	lli->lli_flags |= LLIF_XATTR_CACHE;
+	lli->lli_flags &= ~LLIF_XATTR_RECLAIMED;
+
+	RETURN(0);
+}
+
+static inline struct list_head *ll_xattr_hash(struct ll_xattr_cache *cache,
+					      const char *xattr_name)
+{
+	return &cache->xc_hash[cfs_hash_djb2_hash(xattr_name,
+						  strlen(xattr_name),
+						  LL_XATTR_HASH_MASK)];
 }
 
 /**
@@ -93,11 +151,12 @@ static void ll_xattr_cache_init(struct ll_inode_info *lli)
  *
  *  Find in @cache and return @xattr_name attribute in @xattr,
  *  for the NULL @xattr_name return the first cached @xattr.
+ *  Negative entries are returned as well.
  *
  *  \retval 0        success
  *  \retval -ENODATA if not found
  */
-static int ll_xattr_cache_find(struct list_head *cache,
+static int ll_xattr_cache_find(struct ll_xattr_cache *cache,
 			       const char *xattr_name,
 			       struct ll_xattr_entry **xattr)
 {
@@ -105,14 +164,22 @@ static int ll_xattr_cache_find(struct list_head *cache,
 
 	ENTRY;
 
-	list_for_each_entry(entry, cache, xe_list) {
-		/* xattr_name == NULL means look for any entry */
-		if (xattr_name == NULL ||
-		    strcmp(xattr_name, entry->xe_name) == 0) {
+	/* xattr_name == NULL means look for any entry */
+	if (xattr_name == NULL) {
+		if (list_empty(&cache->xc_list))
+			RETURN(-ENODATA);
+		*xattr = list_entry(cache->xc_list.next,
+				    struct ll_xattr_entry, xe_list);
+		RETURN(0);
+	}
+
+	list_for_each_entry(entry, ll_xattr_hash(cache, xattr_name), xe_hash) {
+		if (strcmp(xattr_name, entry->xe_name) == 0) {
 			*xattr = entry;
-			CDEBUG(D_CACHE, "find: [%s]=%.*s\n",
+			CDEBUG(D_CACHE, "find: [%s]=%.*s%s\n",
 			       entry->xe_name, entry->xe_vallen,
-			       entry->xe_value);
+			       entry->xe_value,
+			       entry->xe_negative ? " (negative)" : "");
 			RETURN(0);
 		}
 	}
@@ -129,10 +196,11 @@ static int ll_xattr_cache_find(struct list_head *cache,
  * \retval -ENOMEM if no memory could be allocated for the cached attr
  * \retval -EPROTO if duplicate xattr is being added
  */
-static int ll_xattr_cache_add(struct list_head *cache,
+static int ll_xattr_cache_add(struct ll_xattr_cache *cache,
 			      const char *xattr_name,
 			      const char *xattr_val,
-			      unsigned xattr_val_len)
+			      unsigned xattr_val_len,
+			      int negative)
 {
 	struct ll_xattr_entry *xattr;
 
@@ -157,20 +225,25 @@ static int ll_xattr_cache_add(struct list_head *cache,
 		       xattr->xe_namelen);
 		goto err_name;
 	}
-	OBD_ALLOC(xattr->xe_value, xattr_val_len);
-	if (!xattr->xe_value) {
-		CDEBUG(D_CACHE, "failed to alloc xattr value %d\n",
-		       xattr_val_len);
-		goto err_value;
+	if (xattr_val_len != 0) {
+		OBD_ALLOC(xattr->xe_value, xattr_val_len);
+		if (!xattr->xe_value) {
+			CDEBUG(D_CACHE, "failed to alloc xattr value %d\n",
+			       xattr_val_len);
+			goto err_value;
+		}
+		memcpy(xattr->xe_value, xattr_val, xattr_val_len);
 	}
 
 	memcpy(xattr->xe_name, xattr_name, xattr->xe_namelen);
-	memcpy(xattr->xe_value, xattr_val, xattr_val_len);
 	xattr->xe_vallen = xattr_val_len;
-	list_add(&xattr->xe_list, cache);
+	xattr->xe_negative = !!negative;
+	list_add(&xattr->xe_list, &cache->xc_list);
+	list_add(&xattr->xe_hash, ll_xattr_hash(cache, xattr_name));
+	cache->xc_size += sizeof(*xattr) + xattr->xe_namelen + xattr_val_len;
 
-	CDEBUG(D_CACHE, "set: [%s]=%.*s\n", xattr_name,
-		xattr_val_len, xattr_val);
+	CDEBUG(D_CACHE, "set: [%s]=%.*s%s\n", xattr_name,
+		xattr_val_len, xattr_val, negative ? " (negative)" : "");
 
 	RETURN(0);
 err_value:
@@ -189,7 +262,7 @@ err_name:
  * \retval 0        success
  * \retval -ENODATA if @xattr_name is not cached
  */
-static int ll_xattr_cache_del(struct list_head *cache,
+static int ll_xattr_cache_del(struct ll_xattr_cache *cache,
 			      const char *xattr_name)
 {
 	struct ll_xattr_entry *xattr;
@@ -200,8 +273,10 @@ static int ll_xattr_cache_del(struct list_head *cache,
 
 	if (ll_xattr_cache_find(cache, xattr_name, &xattr) == 0) {
 		list_del(&xattr->xe_list);
+		list_del(&xattr->xe_hash);
 		OBD_FREE(xattr->xe_name, xattr->xe_namelen);
-		OBD_FREE(xattr->xe_value, xattr->xe_vallen);
+		if (xattr->xe_vallen != 0)
+			OBD_FREE(xattr->xe_value, xattr->xe_vallen);
 		OBD_SLAB_FREE_PTR(xattr, xattr_kmem);
 
 		RETURN(0);
@@ -220,7 +295,7 @@ static int ll_xattr_cache_del(struct list_head *cache,
  * \retval >= 0     buffer list size
  * \retval -ENODATA if the list cannot fit @xld_size buffer
  */
-static int ll_xattr_cache_list(struct list_head *cache,
+static int ll_xattr_cache_list(struct ll_xattr_cache *cache,
 			       char *xld_buffer,
 			       int xld_size)
 {
@@ -229,7 +304,10 @@ static int ll_xattr_cache_list(struct list_head *cache,
 
 	ENTRY;
 
-	list_for_each_entry_safe(xattr, tmp, cache, xe_list) {
+	list_for_each_entry_safe(xattr, tmp, &cache->xc_list, xe_list) {
+		if (xattr->xe_negative)
+			continue;
+
 		CDEBUG(D_CACHE, "list: buffer=%p[%d] name=%s\n",
 			xld_buffer, xld_tail, xattr->xe_name);
 
@@ -269,18 +347,96 @@ int ll_xattr_cache_valid(struct ll_inode_info *lli)
  */
 static int ll_xattr_cache_destroy_locked(struct ll_inode_info *lli)
 {
+	struct ll_xattr_cache *cache;
+	struct ll_sb_info *sbi;
+
 	ENTRY;
 
 	if (!ll_xattr_cache_valid(lli))
 		RETURN(0);
 
-	while (ll_xattr_cache_del(&lli->lli_xattrs, NULL) == 0)
+	cache = lli->lli_xattrs;
+	sbi = ll_i2sbi(cache->xc_inode);
+
+	spin_lock(&sbi->ll_xattr_lock);
+	if (!list_empty(&cache->xc_lru)) {
+		list_del_init(&cache->xc_lru);
+		sbi->ll_xattr_cache_count--;
+	}
+	sbi->ll_xattr_cache_bytes -= cache->xc_charged;
+	spin_unlock(&sbi->ll_xattr_lock);
+
+	while (ll_xattr_cache_del(cache, NULL) == 0)
 		/* empty loop */ ;
+	OBD_FREE_PTR(cache);
+	lli->lli_xattrs = NULL;
 	lli->lli_flags &= ~LLIF_XATTR_CACHE;
+	/* values fetched before this point must not be cached */
+	lli->lli_xattrs_gen++;
 
 	RETURN(0);
 }
 
+/**
+ * Charges the memory of the @lli xattr cache to the per-mount total and
+ * moves it to the tail of the LRU. The caller holds lli_xattrs_list_rwsem.
+ */
+static void ll_xattr_cache_touch(struct ll_inode_info *lli)
+{
+	struct ll_xattr_cache *cache = lli->lli_xattrs;
+	struct ll_sb_info *sbi = ll_i2sbi(cache->xc_inode);
+
+	spin_lock(&sbi->ll_xattr_lock);
+	if (list_empty(&cache->xc_lru))
+		sbi->ll_xattr_cache_count++;
+	list_move_tail(&cache->xc_lru, &sbi->ll_xattr_lru);
+	sbi->ll_xattr_cache_bytes += cache->xc_size - cache->xc_charged;
+	cache->xc_charged = cache->xc_size;
+	spin_unlock(&sbi->ll_xattr_lock);
+}
+
+/**
+ * Drops the least recently used xattr caches until the total is below
+ * ll_sb_info::ll_xattr_cache_max. Caches in use are skipped, so this
+ * never waits for an inode.
+ *
+ * The XATTR lock stays cached, LLIF_XATTR_RECLAIMED makes the next getxattr
+ * enqueue a new one to get the data again.
+ */
+static void ll_xattr_cache_shrink(struct ll_sb_info *sbi)
+{
+	struct ll_xattr_cache *cache;
+	struct ll_inode_info *lli;
+	unsigned int count;
+
+	spin_lock(&sbi->ll_xattr_lock);
+	count = sbi->ll_xattr_cache_count;
+	while (sbi->ll_xattr_cache_bytes > sbi->ll_xattr_cache_max &&
+	       !list_empty(&sbi->ll_xattr_lru) && count-- > 0) {
+		cache = list_entry(sbi->ll_xattr_lru.next,
+				   struct ll_xattr_cache, xc_lru);
+		lli = ll_i2info(cache->xc_inode);
+		if (!down_write_trylock(&lli->lli_xattrs_list_rwsem)) {
+			list_move_tail(&cache->xc_lru, &sbi->ll_xattr_lru);
+			continue;
+		}
+		spin_unlock(&sbi->ll_xattr_lock);
+
+		ll_xattr_cache_destroy_locked(lli);
+		lli->lli_flags |= LLIF_XATTR_RECLAIMED;
+		up_write(&lli->lli_xattrs_list_rwsem);
+		cfs_atomic_inc(&sbi->ll_xattr_reclaimed);
+
+		spin_lock(&sbi->ll_xattr_lock);
+	}
+	spin_unlock(&sbi->ll_xattr_lock);
+}
+
+static inline int ll_xattr_cache_over(struct ll_sb_info *sbi)
+{
+	return sbi->ll_xattr_cache_bytes > sbi->ll_xattr_cache_max;
+}
+
 int ll_xattr_cache_destroy(struct inode *inode)
 {
 	struct ll_inode_info *lli = ll_i2info(inode);
@@ -325,8 +481,13 @@ static int ll_xattr_find_get_lock(struct inode *inode,
 	ENTRY;
 
 	mutex_lock(&lli->lli_xattrs_enq_lock);
-	/* Try matching first. */
-	mode = ll_take_md_lock(inode, MDS_INODELOCK_XATTR, &lockh, 0, LCK_PR);
+	/* Try matching first, unless the cache filled under the cached lock
+	 * has been reclaimed since. */
+	if (!(lli->lli_flags & LLIF_XATTR_RECLAIMED))
+		mode = ll_take_md_lock(inode, MDS_INODELOCK_XATTR, &lockh, 0,
+				       LCK_PR);
+	else
+		mode = 0;
 	if (mode != 0) {
 		/* fake oit in mdc_revalidate_lock() manner */
 		oit->d.lustre.it_lock_handle = lockh.cookie;
@@ -401,14 +562,22 @@ static int ll_xattr_cache_refill(struct inode *inode, struct lookup_intent *oit)
 		GOTO(out_maybe_drop, rc = -EIO);
 	}
 
+	cfs_atomic_inc(&sbi->ll_xattr_misses);
+
 	if (oit->d.lustre.it_status < 0) {
 		CDEBUG(D_CACHE, "getxattr intent returned %d for fid "DFID"\n",
 		       oit->d.lustre.it_status, PFID(ll_inode2fid(inode)));
 		rc = oit->d.lustre.it_status;
-		/* xattr data is so large that we don't want to cache it */
-		if (rc == -ERANGE)
-			rc = -EAGAIN;
-		GOTO(out_destroy, rc);
+		if (rc != -ERANGE)
+			GOTO(out_destroy, rc);
+
+		/* xattr data is so large that we don't want to cache it all,
+		 * cache names one by one as they are looked up instead */
+		rc = ll_xattr_cache_init(lli, 1);
+		if (rc != 0)
+			GOTO(out_destroy, rc = -EAGAIN);
+		ll_set_lock_data(sbi->ll_md_exp, inode, oit, NULL);
+		GOTO(out_maybe_drop, rc);
 	}
 
 	body = req_capsule_server_get(&req->rq_pill, &RMF_MDT_BODY);
@@ -433,7 +602,9 @@ static int ll_xattr_cache_refill(struct inode *inode, struct lookup_intent *oit)
 
 	CDEBUG(D_CACHE, "caching: xdata=%p xtail=%p\n", xdata, xtail);
 
-	ll_xattr_cache_init(lli);
+	rc = ll_xattr_cache_init(lli, 0);
+	if (rc != 0)
+		GOTO(out_destroy, rc);
 
 	for (i = 0; i < body->max_mdsize; i++) {
 		CDEBUG(D_CACHE, "caching [%s]=%.*s\n", xdata, *xsizes, xval);
@@ -452,8 +623,8 @@ static int ll_xattr_cache_refill(struct inode *inode, struct lookup_intent *oit)
 			       XATTR_NAME_ACL_ACCESS);
 			rc = 0;
 		} else {
-			rc = ll_xattr_cache_add(&lli->lli_xattrs, xdata, xval,
-						*xsizes);
+			rc = ll_xattr_cache_add(lli->lli_xattrs, xdata, xval,
+						*xsizes, 0);
 		}
 		if (rc < 0) {
 			ll_xattr_cache_destroy_locked(lli);
@@ -504,6 +675,8 @@ out_destroy:
  * \retval -ENOMEM  not enough memory for the cache
  * \retval -ERANGE  the buffer is not large enough
  * \retval -ENODATA no such attr or the list is empty
+ * \retval -EAGAIN  not cached, the caller should ask the MDS and pass the
+ *                  result to ll_xattr_cache_insert()
  */
 int ll_xattr_cache_get(struct inode *inode,
 			const char *name,
@@ -513,6 +686,8 @@ int ll_xattr_cache_get(struct inode *inode,
 {
 	struct lookup_intent oit = { .it_op = IT_GETXATTR };
 	struct ll_inode_info *lli = ll_i2info(inode);
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	struct ll_xattr_cache *cache;
 	int rc = 0;
 
 	ENTRY;
@@ -527,14 +702,19 @@ int ll_xattr_cache_get(struct inode *inode,
 			RETURN(rc);
 		downgrade_write(&lli->lli_xattrs_list_rwsem);
 	} else {
-		ll_stats_ops_tally(ll_i2sbi(inode), LPROC_LL_GETXATTR_HITS, 1);
+		ll_stats_ops_tally(sbi, LPROC_LL_GETXATTR_HITS, 1);
 	}
+	cache = lli->lli_xattrs;
 
 	if (valid & OBD_MD_FLXATTR) {
 		struct ll_xattr_entry *xattr;
 
-		rc = ll_xattr_cache_find(&lli->lli_xattrs, name, &xattr);
-		if (rc == 0) {
+		rc = ll_xattr_cache_find(cache, name, &xattr);
+		if (rc == 0 && xattr->xe_negative) {
+			cfs_atomic_inc(&sbi->ll_xattr_neg_hits);
+			rc = -ENODATA;
+		} else if (rc == 0) {
+			cfs_atomic_inc(&sbi->ll_xattr_hits);
 			rc = xattr->xe_vallen;
 			/* zero size means we are only requested size in rc */
 			if (size != 0) {
@@ -544,16 +724,65 @@ int ll_xattr_cache_get(struct inode *inode,
 				else
 					rc = -ERANGE;
 			}
+		} else if (cache->xc_partial) {
+			cfs_atomic_inc(&sbi->ll_xattr_misses);
+			rc = -EAGAIN;
+		} else {
+			/* the cache is complete, so the name does not exist */
+			cfs_atomic_inc(&sbi->ll_xattr_neg_hits);
 		}
 	} else if (valid & OBD_MD_FLXATTRLS) {
-		rc = ll_xattr_cache_list(&lli->lli_xattrs,
-					 size ? buffer : NULL, size);
+		if (cache->xc_partial)
+			rc = -EAGAIN;
+		else
+			rc = ll_xattr_cache_list(cache,
+						 size ? buffer : NULL, size);
 	}
+	ll_xattr_cache_touch(lli);
 
 	GOTO(out, rc);
 out:
 	up_read(&lli->lli_xattrs_list_rwsem);
 
+	if (ll_xattr_cache_over(sbi))
+		ll_xattr_cache_shrink(sbi);
+
 	return rc;
 }
 
+/**
+ * Cache a value fetched from the MDS after ll_xattr_cache_get() returned
+ * -EAGAIN for @name, or the absence of @name if @buffer is NULL.
+ *
+ * Nothing is cached unless the partial cache the lookup missed in is still
+ * there, i.e. lli_xattrs_gen is still @gen as sampled before the MDS was
+ * asked, so a value racing with a lock cancel is never cached.
+ */
+void ll_xattr_cache_insert(struct inode *inode, const char *name,
+			   const char *buffer, size_t size, __u32 gen)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	struct ll_xattr_entry *xattr;
+
+	ENTRY;
+
+	down_write(&lli->lli_xattrs_list_rwsem);
+	if (!ll_xattr_cache_valid(lli) || !lli->lli_xattrs->xc_partial ||
+	    lli->lli_xattrs_gen != gen)
+		GOTO(out, 0);
+
+	if (ll_xattr_cache_find(lli->lli_xattrs, name, &xattr) == 0)
+		GOTO(out, 0);
+
+	if (ll_xattr_cache_add(lli->lli_xattrs, name, buffer,
+			       buffer != NULL ? size : 0, buffer == NULL) == 0)
+		ll_xattr_cache_touch(lli);
+
+	EXIT;
+out:
+	up_write(&lli->lli_xattrs_list_rwsem);
+
+	if (ll_xattr_cache_over(sbi))
+		ll_xattr_cache_shrink(sbi);
+}
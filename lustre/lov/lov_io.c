@@ -592,6 +592,8 @@ static int lov_io_submit(const struct lu_env *env,
         struct cl_page *page;
         struct cl_page *tmp;
         int stripe;
+	int nr_stripes = 0;
+	int async = 0;
 
 #define QIN(stripe) lov_io_submit_qin(ld, stripes_qin, stripe, alloc)
 
@@ -639,9 +641,22 @@ static int lov_io_submit(const struct lu_env *env,
         cl_2queue_init(cl2q);
         cl_page_list_for_each_safe(page, tmp, qin) {
                 stripe = lov_page_stripe(page);
+		if (cfs_list_empty(&QIN(stripe)->pl_pages))
+			nr_stripes++;
                 cl_page_list_move(QIN(stripe), qin, page);
         }
 
+	/* Queue the pages of all stripes first and let ptlrpcd threads build
+	 * and send the RPCs, instead of doing that stripe by stripe here. Not
+	 * under memory pressure, where the pre-allocated resources are used
+	 * and the pages have to go out from this thread. A file opened with
+	 * LL_FILE_PARALLEL_IO does so whenever there are several stripes. */
+	if (alloc &&
+	    ((ios->cis_io->ci_parallel_stripes && nr_stripes > 1) ||
+	     (ld->ld_lov->lov_parallel_stripes > 0 &&
+	      nr_stripes >= ld->ld_lov->lov_parallel_stripes)))
+		async = 1;
+
         for (stripe = 0; stripe < lio->lis_nr_subios; stripe++) {
                 struct lov_io_sub   *sub;
                 struct cl_page_list *sub_qin = QIN(stripe);
@@ -652,8 +667,10 @@ static int lov_io_submit(const struct lu_env *env,
                 cl_page_list_splice(sub_qin, &cl2q->c2_qin);
                 sub = lov_sub_get(env, lio, stripe);
                 if (!IS_ERR(sub)) {
+			sub->sub_io->ci_async_rpc = async;
                         rc = cl_io_submit_rw(sub->sub_env, sub->sub_io,
 					     crt, cl2q);
+			sub->sub_io->ci_async_rpc = 0;
                         lov_sub_put(sub);
                 } else
                         rc = PTR_ERR(sub);
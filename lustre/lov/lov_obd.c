@@ -2586,6 +2586,32 @@ static int lov_get_info(const struct lu_env *env, struct obd_export *exp,
         } else if (KEY_IS(KEY_TGT_COUNT)) {
                 *((int *)val) = lov->desc.ld_tgt_count;
                 GOTO(out, rc = 0);
+	} else if (KEY_IS(KEY_SRVLOCK)) {
+		/* whether the OSTs of @lsm, or all of them, lock lockless IO
+		 * themselves */
+		struct lov_tgt_desc *tgt;
+		__u32 len = sizeof(int);
+		int srvlock = 1;
+		int count;
+		int idx;
+
+		LASSERT(*vallen == sizeof(int));
+		count = lsm != NULL ? lsm->lsm_stripe_count :
+				      lov->desc.ld_tgt_count;
+		for (i = 0; i < count && srvlock; i++) {
+			idx = lsm != NULL ? lsm->lsm_oinfo[i]->loi_ost_idx : i;
+			tgt = lov->lov_tgts[idx];
+			if (tgt == NULL || !tgt->ltd_active ||
+			    tgt->ltd_exp == NULL)
+				continue;
+
+			rc = obd_get_info(env, tgt->ltd_exp, keylen, key,
+					  &len, &srvlock, NULL);
+			if (rc != 0)
+				GOTO(out, rc);
+		}
+		*((int *)val) = srvlock;
+		GOTO(out, rc = 0);
         }
 
         rc = -EINVAL;
@@ -117,5 +117,6 @@ struct cl_thread_info {
 };
 
 struct cl_thread_info *cl_env_info(const struct lu_env *env);
+int cl_page_kmem_print(char *page, int count);
 
 #endif /* _CL_INTERNAL_H */
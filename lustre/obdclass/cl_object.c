@@ -487,6 +487,7 @@ int cl_site_stats_print(const struct cl_site *site, char *page, int count)
 pages: ...... ...... ...... ...... ...... [...... ...... ...... ......]
 locks: ...... ...... ...... ...... ...... [...... ...... ...... ...... ......]
   env: ...... ...... ...... ...... ......
+page_alloc ...: hits ...... misses ...... miss_usec ......
  */
         nob = lu_site_stats_print(&site->cs_lu, page, count);
         nob += cache_stats_print(&site->cs_pages, page + nob, count - nob, 1);
@@ -505,6 +506,7 @@ locks: ...... ...... ...... ...... ...... [...... ...... ...... ...... ......]
         nob += snprintf(page + nob, count - nob, "]\n");
         nob += cache_stats_print(&cl_env_stats, page + nob, count - nob, 0);
         nob += snprintf(page + nob, count - nob, "\n");
+	nob += cl_page_kmem_print(page + nob, count - nob);
         return nob;
 }
 EXPORT_SYMBOL(cl_site_stats_print);
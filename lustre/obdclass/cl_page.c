@@ -273,6 +273,232 @@ int cl_page_gang_lookup(const struct lu_env *env, struct cl_object *obj,
 }
 EXPORT_SYMBOL(cl_page_gang_lookup);
 
+/**
+ * \name page kmem
+ *
+ * cl_page's of each size (cl_page plus the slices of a given stack of layers)
+ * come from a slab of their own, fronted by per-CPT magazines of free pages,
+ * so that a streaming client neither goes to the generic allocator nor
+ * bounces a shared lock for every page.
+ * @{
+ */
+
+/** Max # of distinct cl_page sizes with a cache, others use OBD_ALLOC */
+#define CL_PAGE_KMEM_MAX	8
+/** # free pages kept per CPT */
+#define CL_PAGE_MAG_SIZE	32
+
+struct cl_page_mag {
+	spinlock_t		 cpm_lock;
+	int			 cpm_count;
+	/** allocations served from the magazine */
+	unsigned long		 cpm_hits;
+	/** allocations which went to the slab, and the time they took */
+	unsigned long		 cpm_misses;
+	unsigned long		 cpm_miss_usec;
+	void			*cpm_pages[CL_PAGE_MAG_SIZE];
+};
+
+struct cl_page_kmem {
+	unsigned int		 cpk_size;
+	struct kmem_cache	*cpk_cache;
+	struct cl_page_mag	**cpk_mags;
+	char			 cpk_name[24];
+};
+
+static struct cl_page_kmem cl_page_kmems[CL_PAGE_KMEM_MAX];
+/** # of initialized cl_page_kmems[], only grows until cl_page_fini() */
+static int cl_page_kmem_nr;
+static DEFINE_MUTEX(cl_page_kmem_mutex);
+
+/**
+ * Returns the size class of \a size, setting it up on first use, or NULL if
+ * pages of this size come from the generic allocator.
+ *
+ * A class which cannot be set up is published without a cache, so that the
+ * choice of allocator never changes for a given size: pages allocated by
+ * OBD_ALLOC() must not be freed into a cache created later on.
+ */
+static struct cl_page_kmem *cl_page_kmem_find(unsigned int size)
+{
+	struct cl_page_kmem	*kmem;
+	int			 nr = cl_page_kmem_nr;
+	int			 i;
+
+	smp_rmb();
+	for (i = 0; i < nr; i++) {
+		kmem = &cl_page_kmems[i];
+		if (kmem->cpk_size == size)
+			return kmem->cpk_cache != NULL ? kmem : NULL;
+	}
+
+	mutex_lock(&cl_page_kmem_mutex);
+	for (i = 0; i < cl_page_kmem_nr; i++) {
+		if (cl_page_kmems[i].cpk_size == size)
+			GOTO(out, kmem = &cl_page_kmems[i]);
+	}
+	/* the table never shrinks, so this size stays uncached */
+	if (cl_page_kmem_nr == CL_PAGE_KMEM_MAX)
+		GOTO(out_unlock, kmem = NULL);
+
+	kmem = &cl_page_kmems[cl_page_kmem_nr];
+	snprintf(kmem->cpk_name, sizeof(kmem->cpk_name), "cl_page_kmem-%u",
+		 size);
+	kmem->cpk_cache = kmem_cache_create(kmem->cpk_name, size, 0, 0, NULL);
+	if (kmem->cpk_cache != NULL) {
+		kmem->cpk_mags = cfs_percpt_alloc(cfs_cpt_table,
+						  sizeof(**kmem->cpk_mags));
+		if (kmem->cpk_mags == NULL) {
+			kmem_cache_destroy(kmem->cpk_cache);
+			kmem->cpk_cache = NULL;
+		} else {
+			struct cl_page_mag	*mag;
+
+			cfs_percpt_for_each(mag, i, kmem->cpk_mags)
+				spin_lock_init(&mag->cpm_lock);
+		}
+	}
+	if (kmem->cpk_cache == NULL)
+		CWARN("%s: cannot create page cache, using generic "
+		      "allocator\n", kmem->cpk_name);
+	kmem->cpk_size = size;
+	/* publish the entry only once it is complete */
+	smp_wmb();
+	cl_page_kmem_nr++;
+out:
+	if (kmem->cpk_cache == NULL)
+		kmem = NULL;
+out_unlock:
+	mutex_unlock(&cl_page_kmem_mutex);
+	return kmem;
+}
+
+static struct cl_page *cl_page_kmem_alloc(unsigned int size)
+{
+	struct cl_page_kmem	*kmem = cl_page_kmem_find(size);
+	struct cl_page_mag	*mag;
+	struct cl_page		*page = NULL;
+	struct timeval		 start;
+	struct timeval		 end;
+
+	if (kmem == NULL) {
+		OBD_ALLOC_GFP(page, size, __GFP_IO);
+		return page;
+	}
+
+	mag = kmem->cpk_mags[cfs_cpt_current(cfs_cpt_table, 1)];
+	spin_lock(&mag->cpm_lock);
+	if (mag->cpm_count > 0) {
+		page = mag->cpm_pages[--mag->cpm_count];
+		mag->cpm_hits++;
+	}
+	spin_unlock(&mag->cpm_lock);
+
+	if (page != NULL) {
+		memset(page, 0, size);
+		return page;
+	}
+
+	do_gettimeofday(&start);
+	OBD_SLAB_ALLOC_GFP(page, kmem->cpk_cache, size, __GFP_IO);
+	do_gettimeofday(&end);
+
+	spin_lock(&mag->cpm_lock);
+	mag->cpm_misses++;
+	mag->cpm_miss_usec += cfs_timeval_sub(&end, &start, NULL);
+	spin_unlock(&mag->cpm_lock);
+
+	return page;
+}
+
+static void cl_page_kmem_free(struct cl_page *page, unsigned int size)
+{
+	struct cl_page_kmem	*kmem = cl_page_kmem_find(size);
+	struct cl_page_mag	*mag;
+
+	if (kmem == NULL) {
+		OBD_FREE(page, size);
+		return;
+	}
+
+	mag = kmem->cpk_mags[cfs_cpt_current(cfs_cpt_table, 1)];
+	spin_lock(&mag->cpm_lock);
+	if (mag->cpm_count < CL_PAGE_MAG_SIZE) {
+		mag->cpm_pages[mag->cpm_count++] = page;
+		page = NULL;
+	}
+	spin_unlock(&mag->cpm_lock);
+
+	if (page != NULL)
+		OBD_SLAB_FREE(page, kmem->cpk_cache, size);
+}
+
+/**
+ * Outputs the cl_page allocation counters into a buffer, see
+ * cl_site_stats_print().
+ */
+int cl_page_kmem_print(char *page, int count)
+{
+	struct cl_page_kmem	*kmem;
+	struct cl_page_mag	*mag;
+	unsigned long		 hits;
+	unsigned long		 misses;
+	unsigned long		 usec;
+	int			 nr = cl_page_kmem_nr;
+	int			 nob = 0;
+	int			 i;
+	int			 j;
+
+	smp_rmb();
+	for (i = 0; i < nr; i++) {
+		if (nob >= count)
+			break;
+		kmem = &cl_page_kmems[i];
+		if (kmem->cpk_cache == NULL)
+			continue;
+		hits = misses = usec = 0;
+		cfs_percpt_for_each(mag, j, kmem->cpk_mags) {
+			spin_lock(&mag->cpm_lock);
+			hits += mag->cpm_hits;
+			misses += mag->cpm_misses;
+			usec += mag->cpm_miss_usec;
+			spin_unlock(&mag->cpm_lock);
+		}
+		nob += snprintf(page + nob, count - nob,
+				"page_alloc %u: hits %lu misses %lu "
+				"miss_usec %lu\n", kmem->cpk_size, hits,
+				misses, usec);
+	}
+	return nob;
+}
+
+static void cl_page_kmem_fini(void)
+{
+	struct cl_page_kmem	*kmem;
+	struct cl_page_mag	*mag;
+	int			 i;
+	int			 j;
+
+	for (i = 0; i < cl_page_kmem_nr; i++) {
+		kmem = &cl_page_kmems[i];
+		if (kmem->cpk_cache == NULL) {
+			memset(kmem, 0, sizeof(*kmem));
+			continue;
+		}
+		cfs_percpt_for_each(mag, j, kmem->cpk_mags) {
+			while (mag->cpm_count > 0)
+				OBD_SLAB_FREE(mag->cpm_pages[--mag->cpm_count],
+					      kmem->cpk_cache, kmem->cpk_size);
+		}
+		cfs_percpt_free(kmem->cpk_mags);
+		kmem_cache_destroy(kmem->cpk_cache);
+		memset(kmem, 0, sizeof(*kmem));
+	}
+	cl_page_kmem_nr = 0;
+}
+
+/** @} page kmem */
+
 static void cl_page_free(const struct lu_env *env, struct cl_page *page)
 {
         struct cl_object *obj  = page->cp_obj;
@@ -299,7 +525,7 @@ static void cl_page_free(const struct lu_env *env, struct cl_page *page)
 	lu_object_ref_del_at(&obj->co_lu, &page->cp_obj_ref, "cl_page", page);
         cl_object_put(env, obj);
         lu_ref_fini(&page->cp_reference);
-        OBD_FREE(page, pagesize);
+	cl_page_kmem_free(page, pagesize);
         EXIT;
 }
 
@@ -322,8 +548,7 @@ static struct cl_page *cl_page_alloc(const struct lu_env *env,
 	struct lu_object_header *head;
 
 	ENTRY;
-	OBD_ALLOC_GFP(page, cl_object_header(o)->coh_page_bufsize,
-			__GFP_IO);
+	page = cl_page_kmem_alloc(cl_object_header(o)->coh_page_bufsize);
 	if (page != NULL) {
 		int result = 0;
 		cfs_atomic_set(&page->cp_ref, 1);
@@ -497,6 +722,83 @@ struct cl_page *cl_page_find_sub(const struct lu_env *env, struct cl_object *o,
 }
 EXPORT_SYMBOL(cl_page_find_sub);
 
+/**
+ * Batched cl_page_find() for \a nr locked VM pages of \a o, usually
+ * consecutive ones.
+ *
+ * Pages already cached are looked up as cl_page_find() does, the others are
+ * allocated and then inserted into the radix tree of \a o under a single
+ * cl_object_header::coh_page_guard section.
+ *
+ * \param[out] pages	cl_page for each of \a vmpages, with a reference
+ *			held, or an ERR_PTR() for the ones which failed
+ */
+void cl_page_find_batch(const struct lu_env *env, struct cl_object *o,
+			struct page **vmpages, int nr, struct cl_page **pages)
+{
+	struct cl_object_header	*hdr = cl_object_header(o);
+	struct cl_page		*page;
+	int			 err[CL_PAGE_BATCH_MAX];
+	int			 nalloc = 0;
+	int			 i;
+	ENTRY;
+
+	LASSERT(nr <= CL_PAGE_BATCH_MAX);
+	might_sleep();
+
+	for (i = 0; i < nr; i++) {
+		KLASSERT(PageLocked(vmpages[i]));
+		CS_PAGE_INC(o, lookup);
+		/* not a new page, nothing to insert */
+		err[i] = 1;
+		page = cl_vmpage_page(vmpages[i], o);
+		if (page != NULL) {
+			CS_PAGE_INC(o, hit);
+			pages[i] = page;
+			continue;
+		}
+
+		pages[i] = cl_page_alloc(env, o, vmpages[i]->index, vmpages[i],
+					 CPT_CACHEABLE);
+		if (!IS_ERR(pages[i])) {
+			err[i] = 0;
+			nalloc++;
+		}
+	}
+
+	if (nalloc == 0) {
+		EXIT;
+		return;
+	}
+
+	spin_lock(&hdr->coh_page_guard);
+	for (i = 0; i < nr; i++) {
+		if (err[i] != 0)
+			continue;
+
+		err[i] = radix_tree_insert(&hdr->coh_tree, pages[i]->cp_index,
+					   pages[i]);
+		if (err[i] == 0)
+			hdr->coh_pages++;
+	}
+	spin_unlock(&hdr->coh_page_guard);
+
+	/* see cl_page_find0() on why this race is handled */
+	for (i = 0; i < nr; i++) {
+		if (err[i] >= 0)
+			continue;
+
+		page = pages[i];
+		CL_PAGE_DEBUG(D_ERROR, env, page,
+			      "fail to insert into radix tree: %d\n", err[i]);
+		cl_page_delete0(env, page, 0);
+		cl_page_free(env, page);
+		pages[i] = ERR_PTR(err[i]);
+	}
+	EXIT;
+}
+EXPORT_SYMBOL(cl_page_find_batch);
+
 static inline int cl_page_invariant(const struct cl_page *pg)
 {
         struct cl_object_header *header;
@@ -1624,4 +1926,5 @@ int  cl_page_init(void)
 
 void cl_page_fini(void)
 {
+	cl_page_kmem_fini();
 }
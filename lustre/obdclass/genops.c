@@ -1031,6 +1031,7 @@ struct obd_import *class_new_import(struct obd_device *obd)
 		return NULL;
 
 	CFS_INIT_LIST_HEAD(&imp->imp_pinger_chain);
+	CFS_INIT_LIST_HEAD(&imp->imp_ping_agg_chain);
 	CFS_INIT_LIST_HEAD(&imp->imp_zombie_chain);
 	CFS_INIT_LIST_HEAD(&imp->imp_replay_list);
 	CFS_INIT_LIST_HEAD(&imp->imp_sending_list);
@@ -629,6 +629,301 @@ int llog_cat_process(const struct lu_env *env, struct llog_handle *cat_llh,
 }
 EXPORT_SYMBOL(llog_cat_process);
 
+#ifdef __KERNEL__
+/**
+ * Plain log queued for processing by llog_cat_process_parallel().
+ */
+struct llog_par_log {
+	cfs_list_t		lpl_list;
+	struct llog_logid	lpl_id;
+	/** position of this log in the catalog walk */
+	int			lpl_seq;
+};
+
+/**
+ * State shared by all workers of one llog_cat_process_parallel() call.
+ */
+struct llog_par_process {
+	struct llog_handle	*lpp_cathandle;
+	llog_cb_t		 lpp_cb;
+	void			*lpp_data;
+	__u32			 lpp_flags;
+	__u32			 lpp_ctx_tags;
+	spinlock_t		 lpp_lock;
+	/** plain logs not yet picked up by a worker */
+	cfs_list_t		 lpp_logs;
+	int			 lpp_nr_logs;
+	/** sequence of the log allowed to run callbacks (ordered mode) */
+	int			 lpp_next_seq;
+	wait_queue_head_t	 lpp_waitq;
+	cfs_atomic_t		 lpp_running;
+	struct completion	 lpp_done;
+	/** first error or LLOG_PROC_BREAK returned by a worker */
+	int			 lpp_rc;
+	int			 lpp_stop;
+};
+
+static int llog_cat_par_collect_cb(const struct lu_env *env,
+				   struct llog_handle *cat_llh,
+				   struct llog_rec_hdr *rec, void *data)
+{
+	struct llog_par_process	*lpp = data;
+	struct llog_logid_rec	*lir = (struct llog_logid_rec *)rec;
+	struct llog_par_log	*lpl;
+
+	if (rec->lrh_type != LLOG_LOGID_MAGIC) {
+		CERROR("invalid record in catalog\n");
+		return -EINVAL;
+	}
+
+	OBD_ALLOC_PTR(lpl);
+	if (lpl == NULL)
+		return -ENOMEM;
+
+	lpl->lpl_id = lir->lid_id;
+	lpl->lpl_seq = lpp->lpp_nr_logs++;
+	cfs_list_add_tail(&lpl->lpl_list, &lpp->lpp_logs);
+	return 0;
+}
+
+/**
+ * Read the first blocks of a plain log while the worker waits for its
+ * turn in ordered mode, so that the blocks are already cached by the
+ * time llog_process_thread() asks for them.
+ */
+static void llog_cat_par_prefetch(const struct lu_env *env,
+				  struct llog_handle *llh, char *buf)
+{
+	__u64	cur_offset = LLOG_CHUNK_SIZE;
+	int	cur_idx = 0;
+	int	i, rc;
+
+	for (i = 0; i < LLOG_PAR_PREFETCH_BLOCKS; i++) {
+		if (cur_idx + 1 > llh->lgh_last_idx)
+			break;
+		rc = llog_next_block(env, llh, &cur_idx, cur_idx + 1,
+				     &cur_offset, buf, LLOG_CHUNK_SIZE);
+		if (rc)
+			break;
+	}
+}
+
+static int llog_cat_par_ordered_wait(struct llog_par_process *lpp, int seq)
+{
+	int rc;
+
+	spin_lock(&lpp->lpp_lock);
+	rc = lpp->lpp_stop || lpp->lpp_next_seq == seq;
+	spin_unlock(&lpp->lpp_lock);
+	return rc;
+}
+
+static void llog_cat_par_log_done(struct llog_par_process *lpp, int rc)
+{
+	spin_lock(&lpp->lpp_lock);
+	if (rc != 0 && lpp->lpp_rc == 0) {
+		lpp->lpp_rc = rc;
+		lpp->lpp_stop = 1;
+	}
+	lpp->lpp_next_seq++;
+	spin_unlock(&lpp->lpp_lock);
+
+	if (lpp->lpp_flags & LLOG_PAR_ORDERED || rc != 0)
+		wake_up_all(&lpp->lpp_waitq);
+}
+
+static int llog_cat_par_thread(void *arg)
+{
+	struct llog_par_process	*lpp = arg;
+	struct llog_par_log	*lpl;
+	struct llog_handle	*llh;
+	struct lu_env		 env;
+	char			*buf = NULL;
+	int			 rc;
+
+	unshare_fs_struct();
+
+	rc = lu_env_init(&env, lpp->lpp_ctx_tags);
+	if (rc) {
+		llog_cat_par_log_done(lpp, rc);
+		goto out;
+	}
+
+	if (lpp->lpp_flags & LLOG_PAR_ORDERED)
+		OBD_ALLOC(buf, LLOG_CHUNK_SIZE);
+
+	while (1) {
+		spin_lock(&lpp->lpp_lock);
+		if (lpp->lpp_stop || cfs_list_empty(&lpp->lpp_logs)) {
+			spin_unlock(&lpp->lpp_lock);
+			break;
+		}
+		lpl = cfs_list_entry(lpp->lpp_logs.next, struct llog_par_log,
+				     lpl_list);
+		cfs_list_del(&lpl->lpl_list);
+		spin_unlock(&lpp->lpp_lock);
+
+		rc = llog_cat_id2handle(&env, lpp->lpp_cathandle, &llh,
+					&lpl->lpl_id);
+		if (rc) {
+			CERROR("%s: cannot find handle for llog "DOSTID": %d\n",
+			       lpp->lpp_cathandle->lgh_ctxt->loc_obd->obd_name,
+			       POSTID(&lpl->lpl_id.lgl_oi), rc);
+		} else {
+			if (lpp->lpp_flags & LLOG_PAR_ORDERED) {
+				if (buf != NULL)
+					llog_cat_par_prefetch(&env, llh, buf);
+				wait_event(lpp->lpp_waitq,
+					   llog_cat_par_ordered_wait(lpp,
+							lpl->lpl_seq));
+			}
+			if (!lpp->lpp_stop)
+				rc = llog_process_or_fork(&env, llh,
+							  lpp->lpp_cb,
+							  lpp->lpp_data,
+							  NULL, false);
+			llog_handle_put(llh);
+		}
+
+		llog_cat_par_log_done(lpp, rc);
+		OBD_FREE_PTR(lpl);
+	}
+
+	if (buf != NULL)
+		OBD_FREE(buf, LLOG_CHUNK_SIZE);
+	lu_env_fini(&env);
+out:
+	if (cfs_atomic_dec_and_test(&lpp->lpp_running))
+		complete(&lpp->lpp_done);
+	return 0;
+}
+
+/**
+ * Process all plain logs of a catalog with a pool of worker threads.
+ *
+ * The catalog itself is scanned first in the caller's context and the
+ * plain logs found there are handed out to \a nthreads workers, each
+ * processing whole plain logs with llog_process_or_fork(). Records of one
+ * plain log are always passed to \a cb in index order. Without
+ * LLOG_PAR_ORDERED the callbacks for different plain logs run
+ * concurrently, so \a cb must be safe to call from several threads at
+ * once. With LLOG_PAR_ORDERED the callbacks are issued in catalog order,
+ * the workers only open the next logs and prefetch their first blocks
+ * ahead of the callback.
+ *
+ * Callbacks cancelling records through the catalog must serialize catalog
+ * header updates themselves in unordered mode.
+ *
+ * \param[in] env	execution environment, its context tags are used
+ *			for the workers' environments
+ * \param[in] cat_llh	catalog handle
+ * \param[in] cb	per-record callback
+ * \param[in] data	callback data
+ * \param[in] nthreads	number of workers, capped to the number of logs
+ * \param[in] flags	LLOG_PAR_* flags
+ *
+ * \retval 0		all records processed
+ * \retval LLOG_PROC_BREAK	a callback stopped processing
+ * \retval negative	error from the catalog walk or a callback
+ */
+int llog_cat_process_parallel(const struct lu_env *env,
+			      struct llog_handle *cat_llh, llog_cb_t cb,
+			      void *data, int nthreads, __u32 flags)
+{
+	struct llog_par_process		*lpp;
+	struct llog_par_log		*lpl, *tmp;
+	struct llog_log_hdr		*llh = cat_llh->lgh_hdr;
+	struct llog_process_cat_data	 cd;
+	int				 i, rc;
+
+	ENTRY;
+
+	LASSERT(llh->llh_flags & LLOG_F_IS_CAT);
+
+	/* workers inherit the caller's context tags, no env - no workers */
+	if (nthreads <= 1 || env == NULL)
+		RETURN(llog_cat_process(env, cat_llh, cb, data, 0, 0));
+
+	OBD_ALLOC_PTR(lpp);
+	if (lpp == NULL)
+		RETURN(-ENOMEM);
+
+	lpp->lpp_cathandle = cat_llh;
+	lpp->lpp_cb = cb;
+	lpp->lpp_data = data;
+	lpp->lpp_flags = flags;
+	lpp->lpp_ctx_tags = env->le_ctx.lc_tags;
+	spin_lock_init(&lpp->lpp_lock);
+	CFS_INIT_LIST_HEAD(&lpp->lpp_logs);
+	init_waitqueue_head(&lpp->lpp_waitq);
+	init_completion(&lpp->lpp_done);
+
+	if (llh->llh_cat_idx > cat_llh->lgh_last_idx) {
+		CWARN("catlog "DOSTID" crosses index zero\n",
+		      POSTID(&cat_llh->lgh_id.lgl_oi));
+
+		cd.lpcd_first_idx = llh->llh_cat_idx;
+		cd.lpcd_last_idx = 0;
+		rc = llog_process_or_fork(env, cat_llh,
+					  llog_cat_par_collect_cb, lpp, &cd,
+					  false);
+		if (rc == 0) {
+			cd.lpcd_first_idx = 0;
+			cd.lpcd_last_idx = cat_llh->lgh_last_idx;
+			rc = llog_process_or_fork(env, cat_llh,
+						  llog_cat_par_collect_cb,
+						  lpp, &cd, false);
+		}
+	} else {
+		rc = llog_process_or_fork(env, cat_llh,
+					  llog_cat_par_collect_cb, lpp, NULL,
+					  false);
+	}
+	if (rc != 0 || lpp->lpp_nr_logs == 0)
+		GOTO(out, rc);
+
+	nthreads = min(nthreads, lpp->lpp_nr_logs);
+	cfs_atomic_set(&lpp->lpp_running, nthreads);
+	for (i = 0; i < nthreads; i++) {
+		struct task_struct *task;
+
+		task = kthread_run(llog_cat_par_thread, lpp, "llog_par_%02d",
+				   i);
+		if (IS_ERR(task)) {
+			rc = PTR_ERR(task);
+			CERROR("%s: cannot start llog worker %d: rc = %d\n",
+			       cat_llh->lgh_ctxt->loc_obd->obd_name, i, rc);
+			/* the workers already started will finish the job */
+			if (cfs_atomic_sub_and_test(nthreads - i,
+						    &lpp->lpp_running))
+				complete(&lpp->lpp_done);
+			if (i == 0)
+				GOTO(out, rc);
+			rc = 0;
+			break;
+		}
+	}
+	wait_for_completion(&lpp->lpp_done);
+	rc = lpp->lpp_rc;
+	EXIT;
+out:
+	cfs_list_for_each_entry_safe(lpl, tmp, &lpp->lpp_logs, lpl_list) {
+		cfs_list_del(&lpl->lpl_list);
+		OBD_FREE_PTR(lpl);
+	}
+	OBD_FREE_PTR(lpp);
+	return rc;
+}
+#else
+int llog_cat_process_parallel(const struct lu_env *env,
+			      struct llog_handle *cat_llh, llog_cb_t cb,
+			      void *data, int nthreads, __u32 flags)
+{
+	return llog_cat_process(env, cat_llh, cb, data, 0, 0);
+}
+#endif
+EXPORT_SYMBOL(llog_cat_process_parallel);
+
 static int llog_cat_reverse_process_cb(const struct lu_env *env,
 				       struct llog_handle *cat_llh,
 				       struct llog_rec_hdr *rec, void *data)
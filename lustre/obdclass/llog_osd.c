@@ -202,6 +202,52 @@ out:
 	RETURN(rc);
 }
 
+/**
+ * Write only the parts of the llog header changed by adding record \a idx:
+ * the fixed header fields holding llh_count, the bitmap word with the bit
+ * for \a idx and the header tail. Every append used to rewrite the whole
+ * LLOG_CHUNK_SIZE header, which dominated the cost of small records like
+ * changelogs. The on-disk image is the same as with a full header write
+ * since the rest of the header was written by earlier updates.
+ *
+ * Must be called only when the header already exists on disk.
+ */
+static int llog_osd_write_hdr_idx(const struct lu_env *env,
+				  struct dt_object *o,
+				  struct llog_log_hdr *llh, int idx,
+				  struct thandle *th)
+{
+	struct llog_thread_info	*lgi = llog_info(env);
+	int			 rc;
+
+	ENTRY;
+
+	lgi->lgi_off = 0;
+	lgi->lgi_buf.lb_buf = llh;
+	lgi->lgi_buf.lb_len = offsetof(struct llog_log_hdr, llh_reserved);
+	rc = dt_record_write(env, o, &lgi->lgi_buf, &lgi->lgi_off, th);
+	if (rc)
+		GOTO(out, rc);
+
+	lgi->lgi_off = offsetof(struct llog_log_hdr, llh_bitmap) +
+		       (idx / 32) * sizeof(__u32);
+	lgi->lgi_buf.lb_buf = &llh->llh_bitmap[idx / 32];
+	lgi->lgi_buf.lb_len = sizeof(__u32);
+	rc = dt_record_write(env, o, &lgi->lgi_buf, &lgi->lgi_off, th);
+	if (rc)
+		GOTO(out, rc);
+
+	lgi->lgi_off = offsetof(struct llog_log_hdr, llh_tail);
+	lgi->lgi_buf.lb_buf = &llh->llh_tail;
+	lgi->lgi_buf.lb_len = sizeof(llh->llh_tail);
+	rc = dt_record_write(env, o, &lgi->lgi_buf, &lgi->lgi_off, th);
+out:
+	if (rc)
+		CERROR("%s: error writing log header: rc = %d\n",
+		       o->do_lu.lo_dev->ld_obd->obd_name, rc);
+	RETURN(rc);
+}
+
 static int llog_osd_read_header(const struct lu_env *env,
 				struct llog_handle *handle)
 {
@@ -460,9 +506,14 @@ static int llog_osd_write_rec(const struct lu_env *env,
 	old_tail_idx = llh->llh_tail.lrt_index;
 	llh->llh_tail.lrt_index = index;
 
-	lgi->lgi_off = 0;
-	rc = llog_osd_write_blob(env, o, &llh->llh_hdr, NULL, &lgi->lgi_off,
-				 th);
+	if (lgi->lgi_attr.la_size >= LLOG_CHUNK_SIZE) {
+		rc = llog_osd_write_hdr_idx(env, o, llh, index, th);
+	} else {
+		/* first record, the header isn't on disk yet */
+		lgi->lgi_off = 0;
+		rc = llog_osd_write_blob(env, o, &llh->llh_hdr, NULL,
+					 &lgi->lgi_off, th);
+	}
 	if (rc)
 		GOTO(out, rc);
 
@@ -898,6 +898,189 @@ out:
 	RETURN(rc);
 }
 
+/* number of records written for the parallel processing benchmark, this
+ * spreads them over three plain logs */
+#define LLOG_TEST_PAR_RECNUM	(LLOG_TEST_RECNUM * 2)
+#define LLOG_TEST_PAR_THREADS	4
+
+static cfs_atomic_t par_counter;
+
+static int test_8_count_cb(const struct lu_env *env, struct llog_handle *llh,
+			   struct llog_rec_hdr *rec, void *data)
+{
+	cfs_atomic_inc(&par_counter);
+	return 0;
+}
+
+static struct llog_handle *test_8_last_llh;
+static int test_8_last_idx;
+static int test_8_switches;
+
+static int test_8_ordered_cb(const struct lu_env *env, struct llog_handle *llh,
+			     struct llog_rec_hdr *rec, void *data)
+{
+	if (llh != test_8_last_llh) {
+		test_8_last_llh = llh;
+		test_8_last_idx = 0;
+		test_8_switches++;
+	}
+	if (rec->lrh_index <= test_8_last_idx) {
+		CERROR("8d: record %d processed after %d\n",
+		       rec->lrh_index, test_8_last_idx);
+		return -EINVAL;
+	}
+	test_8_last_idx = rec->lrh_index;
+	cfs_atomic_inc(&par_counter);
+	return 0;
+}
+
+static int test_8_cancel_cb(const struct lu_env *env, struct llog_handle *llh,
+			    struct llog_rec_hdr *rec, void *data)
+{
+	struct llog_cookie cookie;
+
+	cookie.lgc_lgl = llh->lgh_id;
+	cookie.lgc_index = rec->lrh_index;
+	cfs_atomic_inc(&par_counter);
+	return llog_cat_cancel_records(env, llh->u.phd.phd_cat_handle, 1,
+				       &cookie);
+}
+
+/* report processing rate in records per second */
+static void test_8_report(char *test, struct timeval *start, int count)
+{
+	struct timeval	end;
+	long		usec;
+
+	do_gettimeofday(&end);
+	usec = max_t(long, cfs_timeval_sub(&end, start, NULL), 1);
+	CWARN("%s: processed %d records in %ld usec, "LPU64" recs/sec\n",
+	      test, count, usec, (__u64)count * 1000000 / usec);
+}
+
+/* Test and benchmark parallel catalog processing */
+static int llog_test_8(const struct lu_env *env, struct obd_device *obd)
+{
+	struct llog_handle	*cath;
+	struct llog_ctxt	*ctxt;
+	struct llog_mini_rec	 lmr;
+	struct timeval		 start;
+	char			 name[10];
+	int			 rc, rc2, i;
+
+	ENTRY;
+
+	ctxt = llog_get_context(obd, LLOG_TEST_ORIG_CTXT);
+	LASSERT(ctxt);
+
+	lmr.lmr_hdr.lrh_len = lmr.lmr_tail.lrt_len = LLOG_MIN_REC_SIZE;
+	lmr.lmr_hdr.lrh_type = 0xf00f00;
+
+	sprintf(name, "%x", llog_test_rand + 2);
+	CWARN("8a: create a catalog log with name: %s\n", name);
+	rc = llog_open_create(env, ctxt, &cath, NULL, name);
+	if (rc) {
+		CERROR("8a: llog_create with name %s failed: %d\n", name, rc);
+		GOTO(ctxt_release, rc);
+	}
+	rc = llog_init_handle(env, cath, LLOG_F_IS_CAT, &uuid);
+	if (rc) {
+		CERROR("8a: can't init llog handle: %d\n", rc);
+		GOTO(out, rc);
+	}
+
+	CWARN("8a: write %d log records\n", LLOG_TEST_PAR_RECNUM);
+	for (i = 0; i < LLOG_TEST_PAR_RECNUM; i++) {
+		rc = llog_cat_add(env, cath, &lmr.lmr_hdr, NULL, NULL);
+		if (rc) {
+			CERROR("8a: write %d records failed at #%d: %d\n",
+			       LLOG_TEST_PAR_RECNUM, i + 1, rc);
+			GOTO(out, rc);
+		}
+	}
+
+	CWARN("8b: process catalog sequentially\n");
+	cfs_atomic_set(&par_counter, 0);
+	do_gettimeofday(&start);
+	rc = llog_cat_process(env, cath, test_8_count_cb, NULL, 0, 0);
+	test_8_report("8b", &start, cfs_atomic_read(&par_counter));
+	if (rc) {
+		CERROR("8b: process with test_8_count_cb failed: %d\n", rc);
+		GOTO(out, rc);
+	}
+	if (cfs_atomic_read(&par_counter) != LLOG_TEST_PAR_RECNUM) {
+		CERROR("8b: found %d records\n", cfs_atomic_read(&par_counter));
+		GOTO(out, rc = -EINVAL);
+	}
+
+	CWARN("8c: process catalog with %d unordered workers\n",
+	      LLOG_TEST_PAR_THREADS);
+	cfs_atomic_set(&par_counter, 0);
+	do_gettimeofday(&start);
+	rc = llog_cat_process_parallel(env, cath, test_8_count_cb, NULL,
+				       LLOG_TEST_PAR_THREADS, 0);
+	test_8_report("8c", &start, cfs_atomic_read(&par_counter));
+	if (rc) {
+		CERROR("8c: parallel process failed: %d\n", rc);
+		GOTO(out, rc);
+	}
+	if (cfs_atomic_read(&par_counter) != LLOG_TEST_PAR_RECNUM) {
+		CERROR("8c: found %d records\n", cfs_atomic_read(&par_counter));
+		GOTO(out, rc = -EINVAL);
+	}
+
+	CWARN("8d: process catalog with %d ordered workers\n",
+	      LLOG_TEST_PAR_THREADS);
+	cfs_atomic_set(&par_counter, 0);
+	test_8_last_llh = NULL;
+	test_8_switches = 0;
+	do_gettimeofday(&start);
+	rc = llog_cat_process_parallel(env, cath, test_8_ordered_cb, NULL,
+				       LLOG_TEST_PAR_THREADS,
+				       LLOG_PAR_ORDERED);
+	test_8_report("8d", &start, cfs_atomic_read(&par_counter));
+	if (rc) {
+		CERROR("8d: ordered parallel process failed: %d\n", rc);
+		GOTO(out, rc);
+	}
+	if (cfs_atomic_read(&par_counter) != LLOG_TEST_PAR_RECNUM ||
+	    test_8_switches != cath->lgh_hdr->llh_count - 1) {
+		CERROR("8d: found %d records in %d logs\n",
+		       cfs_atomic_read(&par_counter), test_8_switches);
+		GOTO(out, rc = -EINVAL);
+	}
+
+	CWARN("8e: cancel all records\n");
+	cfs_atomic_set(&par_counter, 0);
+	rc = llog_cat_process(env, cath, test_8_cancel_cb, NULL, 0, 0);
+	if (rc) {
+		CERROR("8e: cancel failed: %d\n", rc);
+		GOTO(out, rc);
+	}
+	if (cfs_atomic_read(&par_counter) != LLOG_TEST_PAR_RECNUM) {
+		CERROR("8e: cancelled %d records\n",
+		       cfs_atomic_read(&par_counter));
+		GOTO(out, rc = -EINVAL);
+	}
+out:
+	CWARN("8f: close and erase the catalog\n");
+	rc2 = llog_cat_close(env, cath);
+	if (rc2) {
+		CERROR("8f: close log %s failed: %d\n", name, rc2);
+		if (rc == 0)
+			rc = rc2;
+	}
+	rc2 = llog_erase(env, ctxt, NULL, name);
+	if (rc2) {
+		CERROR("8f: erase log %s failed: %d\n", name, rc2);
+		if (rc == 0)
+			rc = rc2;
+	}
+ctxt_release:
+	llog_ctxt_put(ctxt);
+	RETURN(rc);
+}
+
 /* -------------------------------------------------------------------------
  * Tests above, boring obd functions below
  * ------------------------------------------------------------------------- */
@@ -942,6 +1125,10 @@ static int llog_run_tests(const struct lu_env *env, struct obd_device *obd)
 	if (rc)
 		GOTO(cleanup, rc);
 
+	rc = llog_test_8(env, obd);
+	if (rc)
+		GOTO(cleanup, rc);
+
 cleanup:
 	err = llog_destroy(env, llh);
 	if (err)
@@ -879,6 +879,9 @@ static const char *obd_connect_names[] = {
 	"short_io",
 	"pingless",
 	"flock_deadlock",
+	"bl_ast_batch",
+	"lock_convert",
+	"ping_aggregate",
 	"unknown",
         NULL
 };
@@ -2474,6 +2477,7 @@ int lprocfs_obd_rd_recovery_status(char *page, char **start, off_t off,
                                    int count, int *eof, void *data)
 {
         struct obd_device *obd = data;
+	struct target_recovery_data *trd = &obd->obd_recovery_data;
         int len = 0, size;
 
         LASSERT(obd != NULL);
@@ -2541,6 +2545,19 @@ int lprocfs_obd_rd_recovery_status(char *page, char **start, off_t off,
 					 obd->obd_no_ir ?
 					 "DISABLED" : "ENABLED") <= 0)
                         goto out;
+		if (lprocfs_obd_snprintf(&page, size, &len,
+					 "replayed_locks: %d\n",
+					 obd->obd_replayed_locks) <= 0)
+			goto out;
+		if (lprocfs_obd_snprintf(&page, size, &len,
+					 "phase_duration_ms: connect %u, "
+					 "req_replay %u, lock_replay %u, "
+					 "final %u\n",
+					 trd->trd_phase_ms[TRD_PHASE_CONNECT],
+					 trd->trd_phase_ms[TRD_PHASE_REQ_REPLAY],
+					 trd->trd_phase_ms[TRD_PHASE_LOCK_REPLAY],
+					 trd->trd_phase_ms[TRD_PHASE_FINAL]) <= 0)
+			goto out;
                 goto fclose;
         }
 
@@ -151,8 +151,7 @@ static int osc_wr_max_dirty_mb(struct file *file, const char *buffer,
 		return -ERANGE;
 
 	client_obd_list_lock(&cli->cl_loi_list_lock);
-	cli->cl_dirty_max = (obd_count)(pages_number << PAGE_CACHE_SHIFT);
-	osc_wake_cache_waiters(cli);
+	osc_dirty_max_set(cli, (obd_count)(pages_number << PAGE_CACHE_SHIFT));
 	client_obd_list_unlock(&cli->cl_loi_list_lock);
 
 	return count;
@@ -435,6 +434,33 @@ static int osc_wr_contention_seconds(struct file *file, const char *buffer,
                 count;
 }
 
+static int osc_rd_contention_revokes(char *page, char **start, off_t off,
+				     int count, int *eof, void *data)
+{
+	struct obd_device *obd = data;
+	struct osc_device *od  = obd2osc_dev(obd);
+
+	return snprintf(page, count, "%u\n", od->od_contention_revokes);
+}
+
+static int osc_wr_contention_revokes(struct file *file, const char *buffer,
+				     unsigned long count, void *data)
+{
+	struct obd_device *obd = data;
+	struct osc_device *od  = obd2osc_dev(obd);
+	int val, rc;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val < 0)
+		return -ERANGE;
+
+	od->od_contention_revokes = val;
+	return count;
+}
+
 static int osc_rd_lockless_truncate(char *page, char **start, off_t off,
                                     int count, int *eof, void *data)
 {
@@ -530,6 +556,8 @@ static struct lprocfs_vars lprocfs_osc_obd_vars[] = {
         { "timeouts",        lprocfs_rd_timeouts,      0, 0 },
         { "contention_seconds", osc_rd_contention_seconds,
                                 osc_wr_contention_seconds, 0 },
+	{ "contention_revokes", osc_rd_contention_revokes,
+				osc_wr_contention_revokes, 0 },
         { "lockless_truncate",  osc_rd_lockless_truncate,
                                 osc_wr_lockless_truncate, 0 },
         { "import",          lprocfs_rd_import,        lprocfs_wr_import, 0 },
@@ -678,6 +706,12 @@ static int osc_stats_seq_show(struct seq_file *seq, void *v)
 		   stats->os_lockless_reads);
 	seq_printf(seq, "lockless_truncate\t\t"LPU64"\n",
 		   stats->os_lockless_truncates);
+	seq_printf(seq, "lock_revokes\t\t\t"LPU64"\n",
+		   stats->os_lock_revokes);
+	seq_printf(seq, "contended\t\t\t"LPU64"\n",
+		   stats->os_contended);
+	seq_printf(seq, "sync_skipped\t\t\t"LPU64"\n",
+		   stats->os_sync_skipped);
 	return 0;
 }
 
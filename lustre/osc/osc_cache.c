@@ -1328,6 +1328,56 @@ static int osc_completion(const struct lu_env *env, struct osc_async_page *oap,
 	       cfs_atomic_read(&__tmp->cl_lru_shrinkers), ##args);	      \
 } while (0)
 
+/* Account \a bytes more dirty bytes to \a cli. An OSC which starts writing
+ * stops lending its max_dirty_mb to the others and shares theirs instead,
+ * see ccc_dirty_max(). Caller holds loi_list_lock. */
+static void osc_dirty_add(struct client_obd *cli, long bytes)
+{
+	if (cli->cl_dirty == 0 && cli->cl_cache != NULL) {
+		cfs_atomic_sub(cli->cl_dirty_max >> PAGE_CACHE_SHIFT,
+			       &cli->cl_cache->ccc_dirty_idle);
+		cfs_atomic_inc(&cli->cl_cache->ccc_dirty_users);
+	}
+	cli->cl_dirty += bytes;
+}
+
+static void osc_dirty_sub(struct client_obd *cli, long bytes)
+{
+	cli->cl_dirty -= bytes;
+	if (cli->cl_dirty == 0 && cli->cl_cache != NULL) {
+		cfs_atomic_dec(&cli->cl_cache->ccc_dirty_users);
+		cfs_atomic_add(cli->cl_dirty_max >> PAGE_CACHE_SHIFT,
+			       &cli->cl_cache->ccc_dirty_idle);
+	}
+}
+
+/* Start (\a join != 0) or stop sharing the dirty limit of \a cli with the
+ * other OSCs of cl_cache. Caller holds loi_list_lock. */
+void osc_dirty_share(struct client_obd *cli, int join)
+{
+	struct cl_client_cache *cache = cli->cl_cache;
+	int			sign  = join ? 1 : -1;
+
+	LASSERT(cache != NULL);
+	if (cli->cl_dirty == 0)
+		cfs_atomic_add(sign * (cli->cl_dirty_max >> PAGE_CACHE_SHIFT),
+			       &cache->ccc_dirty_idle);
+	else
+		cfs_atomic_add(sign, &cache->ccc_dirty_users);
+}
+
+/* Set max_dirty_mb of \a cli, updating what it lends while idle. Caller
+ * holds loi_list_lock. */
+void osc_dirty_max_set(struct client_obd *cli, long bytes)
+{
+	if (cli->cl_dirty == 0 && cli->cl_cache != NULL)
+		cfs_atomic_add((bytes >> PAGE_CACHE_SHIFT) -
+			       (cli->cl_dirty_max >> PAGE_CACHE_SHIFT),
+			       &cli->cl_cache->ccc_dirty_idle);
+	cli->cl_dirty_max = bytes;
+	osc_wake_cache_waiters(cli);
+}
+
 /* caller must hold loi_list_lock */
 static void osc_consume_write_grant(struct client_obd *cli,
 				    struct brw_page *pga)
@@ -1335,7 +1385,7 @@ static void osc_consume_write_grant(struct client_obd *cli,
 	LASSERT(spin_is_locked(&cli->cl_loi_list_lock.lock));
 	LASSERT(!(pga->flag & OBD_BRW_FROM_GRANT));
 	cfs_atomic_inc(&obd_dirty_pages);
-	cli->cl_dirty += PAGE_CACHE_SIZE;
+	osc_dirty_add(cli, PAGE_CACHE_SIZE);
 	pga->flag |= OBD_BRW_FROM_GRANT;
 	CDEBUG(D_CACHE, "using %lu grant credits for brw %p page %p\n",
 	       PAGE_CACHE_SIZE, pga, pga->pg);
@@ -1357,7 +1407,7 @@ static void osc_release_write_grant(struct client_obd *cli,
 
 	pga->flag &= ~OBD_BRW_FROM_GRANT;
 	cfs_atomic_dec(&obd_dirty_pages);
-	cli->cl_dirty -= PAGE_CACHE_SIZE;
+	osc_dirty_sub(cli, PAGE_CACHE_SIZE);
 	if (pga->flag & OBD_BRW_NOCACHE) {
 		pga->flag &= ~OBD_BRW_NOCACHE;
 		cfs_atomic_dec(&obd_dirty_transit_pages);
@@ -1430,7 +1480,7 @@ static void osc_free_grant(struct client_obd *cli, unsigned int nr_pages,
 
 	client_obd_list_lock(&cli->cl_loi_list_lock);
 	cfs_atomic_sub(nr_pages, &obd_dirty_pages);
-	cli->cl_dirty -= nr_pages << PAGE_CACHE_SHIFT;
+	osc_dirty_sub(cli, nr_pages << PAGE_CACHE_SHIFT);
 	cli->cl_lost_grant += lost_grant;
 	if (cli->cl_avail_grant < grant && cli->cl_lost_grant >= grant) {
 		/* borrow some grant from truncate to avoid the case that
@@ -1472,7 +1522,7 @@ static int osc_enter_cache_try(struct client_obd *cli,
 	if (rc < 0)
 		return 0;
 
-	if (cli->cl_dirty + PAGE_CACHE_SIZE <= cli->cl_dirty_max &&
+	if (cli->cl_dirty + PAGE_CACHE_SIZE <= ccc_dirty_max(cli) &&
 	    cfs_atomic_read(&obd_dirty_pages) + 1 <= obd_max_dirty_pages) {
 		osc_consume_write_grant(cli, &oap->oap_brw_page);
 		if (transient) {
@@ -1605,12 +1655,12 @@ void osc_wake_cache_waiters(struct client_obd *cli)
 
 		ocw->ocw_rc = -EDQUOT;
 		/* we can't dirty more */
-		if ((cli->cl_dirty + PAGE_CACHE_SIZE > cli->cl_dirty_max) ||
+		if ((cli->cl_dirty + PAGE_CACHE_SIZE > ccc_dirty_max(cli)) ||
 		    (cfs_atomic_read(&obd_dirty_pages) + 1 >
 		     obd_max_dirty_pages)) {
 			CDEBUG(D_CACHE, "no dirty room: dirty: %ld "
 			       "osc max %ld, sys max %d\n", cli->cl_dirty,
-			       cli->cl_dirty_max, obd_max_dirty_pages);
+			       ccc_dirty_max(cli), obd_max_dirty_pages);
 			goto wakeup;
 		}
 
@@ -2561,7 +2611,7 @@ int osc_cancel_async_page(const struct lu_env *env, struct osc_page *ops)
 }
 
 int osc_queue_sync_pages(const struct lu_env *env, struct osc_object *obj,
-			 cfs_list_t *list, int cmd, int brw_flags)
+			 cfs_list_t *list, int cmd, int brw_flags, int async)
 {
 	struct client_obd     *cli = osc_cli(obj);
 	struct osc_extent     *ext;
@@ -2613,7 +2663,10 @@ int osc_queue_sync_pages(const struct lu_env *env, struct osc_object *obj,
 	}
 	osc_object_unlock(obj);
 
-	osc_io_unplug(env, cli, obj, PDL_POLICY_ROUND);
+	/* the writeback work may be running already and miss this object,
+	 * send the RPC from here then */
+	if (!async || osc_io_unplug_async(env, cli, obj) != 0)
+		osc_io_unplug(env, cli, obj, PDL_POLICY_ROUND);
 	RETURN(0);
 }
 
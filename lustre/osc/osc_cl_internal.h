@@ -85,6 +85,7 @@ struct osc_io {
 	struct osc_async_cbargs {
 		bool		  opc_rpc_sent;
 		int               opc_rc;
+		__u64		  opc_transno;
 		struct completion	opc_sync;
 	} oi_cbarg;
 };
@@ -123,6 +124,23 @@ struct osc_object {
          */
         int                oo_contended;
         cfs_time_t         oo_contention_time;
+	/**
+	 * # locks on this stripe revoked by other clients since
+	 * oo_revoke_start, see osc_object_lock_revoked().
+	 */
+	int		   oo_revokes;
+	cfs_time_t	   oo_revoke_start;
+	/**
+	 * Highest transno of the writes, punches and setattrs of this stripe
+	 * replied since the object was set up, 0 if unknown. Protected by
+	 * oo_lock.
+	 */
+	__u64		   oo_write_transno;
+	/**
+	 * # of punches and setattrs sent and not replied yet, whose transno
+	 * is not known. Protected by oo_lock.
+	 */
+	int		   oo_modify_inflight;
 #ifdef CONFIG_LUSTRE_DEBUG_EXPENSIVE_CHECK
         /**
          * IO context used for invariant checks in osc_lock_has_pages().
@@ -448,7 +466,7 @@ int osc_teardown_async_page(const struct lu_env *env, struct osc_object *obj,
 int osc_flush_async_page(const struct lu_env *env, struct cl_io *io,
 			 struct osc_page *ops);
 int osc_queue_sync_pages(const struct lu_env *env, struct osc_object *obj,
-			 cfs_list_t *list, int cmd, int brw_flags);
+			 cfs_list_t *list, int cmd, int brw_flags, int async);
 int osc_cache_truncate_start(const struct lu_env *env, struct osc_io *oio,
 			     struct osc_object *obj, __u64 size);
 void osc_cache_truncate_end(const struct lu_env *env, struct osc_io *oio,
@@ -463,6 +481,11 @@ void osc_io_unplug(const struct lu_env *env, struct client_obd *cli,
 void osc_object_set_contended  (struct osc_object *obj);
 void osc_object_clear_contended(struct osc_object *obj);
 int  osc_object_is_contended   (struct osc_object *obj);
+void osc_object_lock_revoked   (struct osc_object *obj);
+void osc_object_write_replied  (struct osc_object *obj, __u64 transno);
+void osc_object_modify_sent    (struct osc_object *obj);
+void osc_object_modify_replied (struct osc_object *obj, __u64 transno);
+int  osc_object_is_committed   (struct osc_object *obj);
 
 int  osc_lock_is_lockless      (const struct osc_lock *olck);
 
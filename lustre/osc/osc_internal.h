@@ -91,6 +91,8 @@ int osc_create(const struct lu_env *env, struct obd_export *exp,
 int osc_real_create(struct obd_export *exp, struct obdo *oa,
                     struct lov_stripe_md **ea, struct obd_trans_info *oti);
 void osc_wake_cache_waiters(struct client_obd *cli);
+void osc_dirty_share(struct client_obd *cli, int join);
+void osc_dirty_max_set(struct client_obd *cli, long bytes);
 int osc_shrink_grant_to_target(struct client_obd *cli, __u64 target_bytes);
 void osc_update_next_shrink(struct client_obd *cli);
 
@@ -118,10 +120,10 @@ int osc_match_base(struct obd_export *exp, struct ldlm_res_id *res_id,
 int osc_setattr_async_base(struct obd_export *exp, struct obd_info *oinfo,
                            struct obd_trans_info *oti,
                            obd_enqueue_update_f upcall, void *cookie,
-                           struct ptlrpc_request_set *rqset);
+			   __u64 *transno, struct ptlrpc_request_set *rqset);
 int osc_punch_base(struct obd_export *exp, struct obd_info *oinfo,
                    obd_enqueue_update_f upcall, void *cookie,
-                   struct ptlrpc_request_set *rqset);
+		   __u64 *transno, struct ptlrpc_request_set *rqset);
 int osc_sync_base(struct obd_export *exp, struct obd_info *oinfo,
 		  obd_enqueue_update_f upcall, void *cookie,
 		  struct ptlrpc_request_set *rqset);
@@ -130,6 +132,12 @@ int osc_process_config_base(struct obd_device *obd, struct lustre_cfg *cfg);
 int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 		  cfs_list_t *ext_list, int cmd, pdl_policy_t p);
 int osc_lru_shrink(struct client_obd *cli, int target);
+int osc_cache_shrinker_init(void);
+void osc_cache_shrinker_fini(void);
+#ifdef __KERNEL__
+extern cfs_list_t osc_shrink_list;
+extern struct mutex osc_shrink_lock;
+#endif
 
 extern spinlock_t osc_ast_guard;
 
@@ -174,11 +182,17 @@ struct osc_device {
                 uint64_t     os_lockless_writes;          /* by bytes */
                 uint64_t     os_lockless_reads;           /* by bytes */
                 uint64_t     os_lockless_truncates;       /* by times */
+		uint64_t     os_lock_revokes;		  /* by times */
+		uint64_t     os_contended;		  /* by times */
+		uint64_t     os_sync_skipped;		  /* by times */
         } od_stats;
 
         /* configuration item(s) */
         int                 od_contention_time;
         int                 od_lockless_truncate;
+	/* # revoked locks within od_contention_time seconds that make an
+	 * object contended, 0 to only rely on the server */
+	int		    od_contention_revokes;
 };
 
 static inline struct osc_device *obd2osc_dev(const struct obd_device *d)
@@ -187,6 +201,7 @@ static inline struct osc_device *obd2osc_dev(const struct obd_device *d)
 }
 
 int osc_dlm_lock_pageref(struct ldlm_lock *dlm);
+unsigned long osc_ldlm_weigh_ast(struct ldlm_lock *dlmlock);
 
 extern struct kmem_cache *osc_quota_kmem;
 struct osc_quota_info {
@@ -114,6 +114,7 @@ static int osc_io_submit(const struct lu_env *env,
 	int cmd;
 	int brw_flags;
 	int max_pages;
+	int async = ios->cis_io->ci_async_rpc;
 
 	LASSERT(qin->pl_nr > 0);
 
@@ -174,14 +175,15 @@ static int osc_io_submit(const struct lu_env *env,
 		if (++queued == max_pages) {
 			queued = 0;
 			result = osc_queue_sync_pages(env, osc, &list, cmd,
-						      brw_flags);
+						      brw_flags, async);
 			if (result < 0)
 				break;
 		}
 	}
 
 	if (queued > 0)
-		result = osc_queue_sync_pages(env, osc, &list, cmd, brw_flags);
+		result = osc_queue_sync_pages(env, osc, &list, cmd, brw_flags,
+					      async);
 
 	CDEBUG(D_INFO, "%d/%d %d\n", qin->pl_nr, qout->pl_nr, result);
 	return qout->pl_nr > 0 ? 0 : result;
@@ -473,17 +475,26 @@ static int osc_io_setattr_start(const struct lu_env *env,
                 oinfo.oi_oa = oa;
                 oinfo.oi_capa = io->u.ci_setattr.sa_capa;
 		init_completion(&cbargs->opc_sync);
+		cbargs->opc_transno = 0;
 
+		/* an fsync may skip OST_SYNC only once this change is known
+		 * to be committed as well */
+		osc_object_modify_sent(cl2osc(obj));
                 if (ia_valid & ATTR_SIZE)
                         result = osc_punch_base(osc_export(cl2osc(obj)),
 						&oinfo, osc_async_upcall,
-                                                cbargs, PTLRPCD_SET);
+						cbargs, &cbargs->opc_transno,
+						PTLRPCD_SET);
                 else
                         result = osc_setattr_async_base(osc_export(cl2osc(obj)),
                                                         &oinfo, NULL,
 							osc_async_upcall,
-                                                        cbargs, PTLRPCD_SET);
+							cbargs,
+							&cbargs->opc_transno,
+							PTLRPCD_SET);
 		cbargs->opc_rpc_sent = result == 0;
+		if (result != 0)
+			osc_object_modify_replied(cl2osc(obj), 0);
         }
         return result;
 }
@@ -500,6 +511,7 @@ static void osc_io_setattr_end(const struct lu_env *env,
 	if (cbargs->opc_rpc_sent) {
 		wait_for_completion(&cbargs->opc_sync);
 		result = io->ci_result = cbargs->opc_rc;
+		osc_object_modify_replied(cl2osc(obj), cbargs->opc_transno);
 	}
         if (result == 0) {
                 if (oio->oi_lockless) {
@@ -604,6 +616,7 @@ static int osc_io_fsync_start(const struct lu_env *env,
 	struct cl_fsync_io *fio = &io->u.ci_fsync;
 	struct cl_object   *obj = slice->cis_obj;
 	struct osc_object  *osc = cl2osc(obj);
+	struct osc_async_cbargs *cbargs = &cl2osc_io(env, slice)->oi_cbarg;
 	pgoff_t start  = cl_index(obj, fio->fi_start);
 	pgoff_t end    = cl_index(obj, fio->fi_end);
 	int     result = 0;
@@ -629,6 +642,16 @@ static int osc_io_fsync_start(const struct lu_env *env,
 		rc = osc_cache_wait_range(env, osc, start, end);
 		if (result == 0)
 			result = rc;
+		if (osc_object_is_committed(osc)) {
+			/* nothing of this stripe is left to commit, no need
+			 * to make the OST flush its journal for us */
+			init_completion(&cbargs->opc_sync);
+			cbargs->opc_rc = 0;
+			complete(&cbargs->opc_sync);
+			/* XXX: Need a lock. */
+			lu2osc_dev(obj->co_lu.lo_dev)->od_stats.os_sync_skipped++;
+			RETURN(result);
+		}
 		rc = osc_fsync_ost(env, osc, fio);
 		if (result == 0)
 			result = rc;
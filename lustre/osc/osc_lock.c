@@ -679,6 +679,10 @@ static int osc_dlm_blocking_ast0(const struct lu_env *env,
                          *       for locks that were granted.
                          */
                         LASSERT(data == olck);
+			if (flag == LDLM_CB_BLOCKING &&
+			    olck->ols_state == OLS_GRANTED)
+				osc_object_lock_revoked(
+					cl2osc(olck->ols_cl.cls_obj));
                         osc_lock_blocking(env, dlmlock,
                                           olck, flag == LDLM_CB_BLOCKING);
                 } else
@@ -1701,4 +1705,21 @@ int osc_dlm_lock_pageref(struct ldlm_lock *dlm)
 	return rc;
 }
 
+/**
+ * Weigh an unused dlm lock for the cost aware LRU policy: the number of
+ * pages cached for the object, as osc_lock_weigh() estimates it.
+ */
+unsigned long osc_ldlm_weigh_ast(struct ldlm_lock *dlmlock)
+{
+	struct osc_lock *olck;
+	unsigned long    weight = 0;
+
+	spin_lock(&osc_ast_guard);
+	olck = dlmlock->l_ast_data;
+	if (olck != NULL)
+		weight = cl_object_header(olck->ols_cl.cls_obj)->coh_pages;
+	spin_unlock(&osc_ast_guard);
+	return weight;
+}
+
 /** @} osc */
@@ -239,6 +239,110 @@ int osc_object_is_contended(struct osc_object *obj)
         return 1;
 }
 
+/**
+ * Called when a granted lock on \a obj is revoked by a conflicting enqueue.
+ *
+ * Locks of a stripe written by several clients at once keep bouncing
+ * between them, and each round trip costs a blocking AST, a cancel with a
+ * flush and a new enqueue. Once od_contention_revokes locks have been
+ * revoked within od_contention_time seconds, the object is marked contended
+ * as if the server had refused a lock with -EUSERS, and its IO is done
+ * lockless with server-side locking until the contention expires.
+ */
+void osc_object_lock_revoked(struct osc_object *obj)
+{
+	struct osc_device *dev = lu2osc_dev(obj->oo_cl.co_lu.lo_dev);
+	cfs_time_t	   now = cfs_time_current();
+
+	/* XXX: Need a lock, the counters are only a heuristic. */
+	dev->od_stats.os_lock_revokes++;
+	if (dev->od_contention_revokes <= 0)
+		return;
+
+	if (obj->oo_revokes == 0 ||
+	    cfs_time_after(now, cfs_time_add(obj->oo_revoke_start,
+				cfs_time_seconds(dev->od_contention_time)))) {
+		obj->oo_revoke_start = now;
+		obj->oo_revokes = 0;
+	}
+
+	if (++obj->oo_revokes >= dev->od_contention_revokes) {
+		CDEBUG(D_DLMTRACE, "%p: %d locks revoked, go lockless\n",
+		       obj, obj->oo_revokes);
+		obj->oo_revokes = 0;
+		if (!obj->oo_contended)
+			dev->od_stats.os_contended++;
+		osc_object_set_contended(obj);
+	}
+}
+
+/**
+ * Records the transno the OST assigned to a write of \a obj.
+ */
+void osc_object_write_replied(struct osc_object *obj, __u64 transno)
+{
+	if (transno == 0)
+		return;
+
+	spin_lock(&obj->oo_lock);
+	if (transno > obj->oo_write_transno)
+		obj->oo_write_transno = transno;
+	spin_unlock(&obj->oo_lock);
+}
+
+/**
+ * Called before an OST_PUNCH or OST_SETATTR of \a obj is sent: until it is
+ * replied, its transno is unknown and the object is not committed.
+ */
+void osc_object_modify_sent(struct osc_object *obj)
+{
+	spin_lock(&obj->oo_lock);
+	obj->oo_modify_inflight++;
+	spin_unlock(&obj->oo_lock);
+}
+
+/**
+ * Records the transno of a punch or setattr of \a obj, 0 if it failed.
+ */
+void osc_object_modify_replied(struct osc_object *obj, __u64 transno)
+{
+	spin_lock(&obj->oo_lock);
+	LASSERT(obj->oo_modify_inflight > 0);
+	obj->oo_modify_inflight--;
+	if (transno > obj->oo_write_transno)
+		obj->oo_write_transno = transno;
+	spin_unlock(&obj->oo_lock);
+}
+
+/**
+ * Whether all the replied writes, punches and setattrs of \a obj are
+ * committed on the OST, so that an OST_SYNC would have nothing to do for it.
+ *
+ * Transnos grow for every change of an object, so the last one being
+ * committed implies the earlier ones are. Changes from before the object
+ * was set up are not tracked, an object without a transno of its own, or
+ * with a punch or setattr in flight, is never considered committed.
+ */
+int osc_object_is_committed(struct osc_object *obj)
+{
+	struct obd_import *imp = class_exp2cliimp(osc_export(obj));
+	__u64		   transno;
+	int		   committed;
+
+	spin_lock(&obj->oo_lock);
+	transno = obj->oo_modify_inflight > 0 ? 0 : obj->oo_write_transno;
+	spin_unlock(&obj->oo_lock);
+
+	if (transno == 0 || imp == NULL)
+		return 0;
+
+	spin_lock(&imp->imp_lock);
+	committed = transno <= imp->imp_peer_committed_transno;
+	spin_unlock(&imp->imp_lock);
+
+	return committed;
+}
+
 static const struct cl_object_operations osc_ops = {
         .coo_page_init = osc_page_init,
         .coo_lock_init = osc_lock_init,
@@ -878,6 +878,80 @@ static int osc_lru_reclaim(struct client_obd *cli)
 	return rc;
 }
 
+#ifdef __KERNEL__
+/* All OSCs caching pages, for the memory pressure shrinker. Unlike
+ * cl_client_cache::ccc_lru this covers the OSCs of every mount. */
+CFS_LIST_HEAD(osc_shrink_list);
+DEFINE_MUTEX(osc_shrink_lock);
+
+/**
+ * Memory pressure shrinker for the OSC page caches. The LRU budget is only
+ * enforced when pages are added, so without this, clean pages stay cached up
+ * to max_cached_mb no matter how much memory the rest of the system needs.
+ * Pages are dropped from each OSC in turn, so that the pressure is spread
+ * over all OSCs by the size of their LRU rather than taken from the first.
+ */
+static int osc_cache_shrink(SHRINKER_ARGS(sc, nr_to_scan, gfp_mask))
+{
+	struct client_obd *cli;
+	struct client_obd *tmp;
+	int remain = shrink_param(sc, nr_to_scan);
+	int cached = 0;
+	int rc;
+	CFS_LIST_HEAD(splice);
+
+	if (!(shrink_param(sc, gfp_mask) & __GFP_FS))
+		/* osc_lru_shrink() may have to block on page locks */
+		return remain != 0 ? -1 : 0;
+
+	mutex_lock(&osc_shrink_lock);
+	cfs_list_for_each_entry_safe(cli, tmp, &osc_shrink_list,
+				     cl_shrink_list) {
+		if (remain > 0) {
+			rc = osc_lru_shrink(cli, min(remain,
+						     max_to_shrink(cli)));
+			if (rc > 0)
+				remain -= rc;
+			/* start from the next OSC on the next call */
+			cfs_list_move_tail(&cli->cl_shrink_list, &splice);
+		}
+		cached += cfs_atomic_read(&cli->cl_lru_in_list) -
+			  cfs_atomic_read(&cli->cl_lru_busy);
+	}
+	cfs_list_splice(&splice, osc_shrink_list.prev);
+	mutex_unlock(&osc_shrink_lock);
+
+	cached = (max(cached, 0) / 100) * sysctl_vfs_cache_pressure;
+	CDEBUG(D_CACHE, "%d pages cached, %d to shrink left\n", cached, remain);
+	return cached;
+}
+
+static struct shrinker *osc_cache_shrinker;
+
+int osc_cache_shrinker_init(void)
+{
+	osc_cache_shrinker = set_shrinker(DEFAULT_SEEKS, osc_cache_shrink);
+	return osc_cache_shrinker == NULL ? -ENOMEM : 0;
+}
+
+void osc_cache_shrinker_fini(void)
+{
+	if (osc_cache_shrinker != NULL) {
+		remove_shrinker(osc_cache_shrinker);
+		osc_cache_shrinker = NULL;
+	}
+}
+#else
+int osc_cache_shrinker_init(void)
+{
+	return 0;
+}
+
+void osc_cache_shrinker_fini(void)
+{
+}
+#endif /* __KERNEL__ */
+
 static int osc_lru_reserve(const struct lu_env *env, struct osc_object *obj,
 			   struct osc_page *opg)
 {
@@ -363,6 +363,8 @@ static int osc_setattr_interpret(const struct lu_env *env,
 
 	lustre_get_wire_obdo(&req->rq_import->imp_connect_data, sa->sa_oa,
 			     &body->oa);
+	if (sa->sa_transno != NULL)
+		*sa->sa_transno = req->rq_transno;
 out:
         rc = sa->sa_upcall(sa->sa_cookie, rc);
         RETURN(rc);
@@ -371,7 +373,7 @@ out:
 int osc_setattr_async_base(struct obd_export *exp, struct obd_info *oinfo,
                            struct obd_trans_info *oti,
                            obd_enqueue_update_f upcall, void *cookie,
-                           struct ptlrpc_request_set *rqset)
+			   __u64 *transno, struct ptlrpc_request_set *rqset)
 {
         struct ptlrpc_request   *req;
         struct osc_setattr_args *sa;
@@ -409,6 +411,7 @@ int osc_setattr_async_base(struct obd_export *exp, struct obd_info *oinfo,
                 sa->sa_oa = oinfo->oi_oa;
                 sa->sa_upcall = upcall;
                 sa->sa_cookie = cookie;
+		sa->sa_transno = transno;
 
                 if (rqset == PTLRPCD_SET)
                         ptlrpcd_add_req(req, PDL_POLICY_ROUND, -1);
@@ -424,7 +427,7 @@ static int osc_setattr_async(struct obd_export *exp, struct obd_info *oinfo,
                              struct ptlrpc_request_set *rqset)
 {
         return osc_setattr_async_base(exp, oinfo, oti,
-                                      oinfo->oi_cb_up, oinfo, rqset);
+				      oinfo->oi_cb_up, oinfo, NULL, rqset);
 }
 
 int osc_real_create(struct obd_export *exp, struct obdo *oa,
@@ -514,7 +517,7 @@ out:
 
 int osc_punch_base(struct obd_export *exp, struct obd_info *oinfo,
                    obd_enqueue_update_f upcall, void *cookie,
-                   struct ptlrpc_request_set *rqset)
+		   __u64 *transno, struct ptlrpc_request_set *rqset)
 {
         struct ptlrpc_request   *req;
         struct osc_setattr_args *sa;
@@ -549,6 +552,7 @@ int osc_punch_base(struct obd_export *exp, struct obd_info *oinfo,
         sa->sa_oa     = oinfo->oi_oa;
         sa->sa_upcall = upcall;
         sa->sa_cookie = cookie;
+	sa->sa_transno = transno;
         if (rqset == PTLRPCD_SET)
                 ptlrpcd_add_req(req, PDL_POLICY_ROUND, -1);
         else
@@ -565,7 +569,7 @@ static int osc_punch(const struct lu_env *env, struct obd_export *exp,
         oinfo->oi_oa->o_blocks = oinfo->oi_policy.l_extent.end;
         oinfo->oi_oa->o_valid |= OBD_MD_FLSIZE | OBD_MD_FLBLOCKS;
         return osc_punch_base(exp, oinfo,
-                              oinfo->oi_cb_up, oinfo, rqset);
+			      oinfo->oi_cb_up, oinfo, NULL, rqset);
 }
 
 static int osc_sync_interpret(const struct lu_env *env,
@@ -827,16 +831,21 @@ static void osc_announce_cached(struct client_obd *cli, struct obdo *oa,
                                 long writing_bytes)
 {
         obd_flag bits = OBD_MD_FLBLOCKS|OBD_MD_FLGRANT;
+	long dirty_max;
 
         LASSERT(!(oa->o_valid & bits));
 
         oa->o_valid |= bits;
         client_obd_list_lock(&cli->cl_loi_list_lock);
         oa->o_dirty = cli->cl_dirty;
-	if (unlikely(cli->cl_dirty - cli->cl_dirty_transit >
-		     cli->cl_dirty_max)) {
-		CERROR("dirty %lu - %lu > dirty_max %lu\n",
-		       cli->cl_dirty, cli->cl_dirty_transit, cli->cl_dirty_max);
+	/* ask for grant according to the dirty limit this OSC may use now,
+	 * including its share of the limits of the idle OSCs */
+	dirty_max = ccc_dirty_max(cli);
+	if (cli->cl_dirty - cli->cl_dirty_transit > dirty_max) {
+		/* the share shrinks as more OSCs start writing, so this OSC
+		 * may be over it until its dirty pages are written out */
+		CDEBUG(D_CACHE, "dirty %lu - %lu > dirty_max %lu\n",
+		       cli->cl_dirty, cli->cl_dirty_transit, dirty_max);
 		oa->o_undirty = 0;
 	} else if (unlikely(cfs_atomic_read(&obd_dirty_pages) -
 			    cfs_atomic_read(&obd_dirty_transit_pages) >
@@ -849,15 +858,15 @@ static void osc_announce_cached(struct client_obd *cli, struct obdo *oa,
 		       cfs_atomic_read(&obd_dirty_transit_pages),
 		       obd_max_dirty_pages);
 		oa->o_undirty = 0;
-	} else if (unlikely(cli->cl_dirty_max - cli->cl_dirty > 0x7fffffff)) {
+	} else if (unlikely(dirty_max - cli->cl_dirty > 0x7fffffff)) {
 		CERROR("dirty %lu - dirty_max %lu too big???\n",
-		       cli->cl_dirty, cli->cl_dirty_max);
+		       cli->cl_dirty, dirty_max);
 		oa->o_undirty = 0;
 	} else {
 		long max_in_flight = (cli->cl_max_pages_per_rpc <<
 				      PAGE_CACHE_SHIFT) *
 				     (cli->cl_max_rpcs_in_flight + 1);
-                oa->o_undirty = max(cli->cl_dirty_max, max_in_flight);
+                oa->o_undirty = max(dirty_max, max_in_flight);
         }
 	oa->o_grant = cli->cl_avail_grant + cli->cl_reserved_grant;
         oa->o_dropped = cli->cl_lost_grant;
@@ -1994,6 +2003,10 @@ static int brw_interpret(const struct lu_env *env,
 			cl_object_get(obj);
 		}
 
+		if (rc == 0 &&
+		    lustre_msg_get_opc(req->rq_reqmsg) == OST_WRITE)
+			osc_object_write_replied(ext->oe_obj, req->rq_transno);
+
 		cfs_list_del_init(&ext->oe_link);
 		osc_extent_finish(env, ext, 1, rc);
 	}
@@ -3034,6 +3047,15 @@ static int osc_get_info(const struct lu_env *env, struct obd_export *exp,
                 *vallen = sizeof(*stripe);
                 *stripe = 0;
                 RETURN(0);
+	} else if (KEY_IS(KEY_SRVLOCK)) {
+		struct obd_import *imp = class_exp2cliimp(exp);
+
+		/* what the OST agreed to, as osc_lock_to_lockless() sees it */
+		*((int *)val) = imp != NULL &&
+				(imp->imp_connect_data.ocd_connect_flags &
+				 OBD_CONNECT_SRVLOCK);
+		*vallen = sizeof(int);
+		RETURN(0);
         } else if (KEY_IS(KEY_LAST_ID)) {
                 struct ptlrpc_request *req;
                 obd_id                *reply;
@@ -3200,6 +3222,14 @@ static int osc_set_info_async(const struct lu_env *env, struct obd_export *exp,
 		spin_lock(&cli->cl_cache->ccc_lru_lock);
 		cfs_list_add(&cli->cl_lru_osc, &cli->cl_cache->ccc_lru);
 		spin_unlock(&cli->cl_cache->ccc_lru_lock);
+		client_obd_list_lock(&cli->cl_loi_list_lock);
+		osc_dirty_share(cli, 1);
+		client_obd_list_unlock(&cli->cl_loi_list_lock);
+#ifdef __KERNEL__
+		mutex_lock(&osc_shrink_lock);
+		cfs_list_add_tail(&cli->cl_shrink_list, &osc_shrink_list);
+		mutex_unlock(&osc_shrink_lock);
+#endif
 
 		RETURN(0);
 	}
@@ -3526,6 +3556,7 @@ int osc_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 
 	CFS_INIT_LIST_HEAD(&cli->cl_grant_shrink_list);
 	ns_register_cancel(obd->obd_namespace, osc_cancel_for_recovery);
+	ns_register_weigh(obd->obd_namespace, osc_ldlm_weigh_ast);
 	RETURN(rc);
 
 out_ptlrpcd_work:
@@ -3595,7 +3626,15 @@ int osc_cleanup(struct obd_device *obd)
 		spin_lock(&cli->cl_cache->ccc_lru_lock);
 		cfs_list_del_init(&cli->cl_lru_osc);
 		spin_unlock(&cli->cl_cache->ccc_lru_lock);
+#ifdef __KERNEL__
+		mutex_lock(&osc_shrink_lock);
+		cfs_list_del_init(&cli->cl_shrink_list);
+		mutex_unlock(&osc_shrink_lock);
+#endif
 		cli->cl_lru_left = NULL;
+		client_obd_list_lock(&cli->cl_loi_list_lock);
+		osc_dirty_share(cli, 0);
+		client_obd_list_unlock(&cli->cl_loi_list_lock);
 		cfs_atomic_dec(&cli->cl_cache->ccc_users);
 		cli->cl_cache = NULL;
 	}
@@ -3700,6 +3739,13 @@ int __init osc_init(void)
                 RETURN(rc);
         }
 
+	rc = osc_cache_shrinker_init();
+	if (rc) {
+		class_unregister_type(LUSTRE_OSC_NAME);
+		lu_kmem_fini(osc_caches);
+		RETURN(rc);
+	}
+
 	spin_lock_init(&osc_ast_guard);
 	lockdep_set_class(&osc_ast_guard, &osc_ast_guard_class);
 
@@ -3709,6 +3755,7 @@ int __init osc_init(void)
 #ifdef __KERNEL__
 static void /*__exit*/ osc_exit(void)
 {
+	osc_cache_shrinker_fini();
 	class_unregister_type(LUSTRE_OSC_NAME);
 	lu_kmem_fini(osc_caches);
 }
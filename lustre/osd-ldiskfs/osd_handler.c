@@ -1781,6 +1781,7 @@ static int osd_attr_set(const struct lu_env *env,
 		rc = iam_update(oh->ot_handle, bag, (const struct iam_key *)fid1,
 				(const struct iam_rec *)id, ipd);
 		osd_ipd_put(env, bag, ipd);
+		osd_oi_cache_invalidate(osd_dev(dt->do_lu.lo_dev), fid0);
 		return(rc > 0 ? 0 : rc);
 	}
 
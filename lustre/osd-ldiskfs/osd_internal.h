@@ -231,6 +231,8 @@ struct osd_device {
         struct osd_oi           **od_oi_table;
         /* total number of OI containers */
         int                       od_oi_count;
+	/* cache of hot OI mappings, see osd_oi_cache_slot */
+	struct osd_oi_cache_slot *od_oi_cache;
         /*
          * Fid Capability
          */
@@ -79,6 +79,79 @@ static struct dt_index_features oi_feat = {
 
 #define OSD_OI_NAME_BASE        "oi.16"
 
+static void osd_oi_cache_fini(struct osd_device *osd)
+{
+	if (osd->od_oi_cache == NULL)
+		return;
+
+	OBD_FREE_LARGE(osd->od_oi_cache,
+		       sizeof(*osd->od_oi_cache) * OSD_OI_CACHE_SIZE);
+	osd->od_oi_cache = NULL;
+}
+
+static inline struct osd_oi_cache_slot *
+osd_oi_cache_slot(struct osd_device *osd, const struct lu_fid *fid)
+{
+	return &osd->od_oi_cache[fid_hash(fid, OSD_OI_CACHE_BITS)];
+}
+
+/* lock-free lookup of \a fid in the cache of hot OI mappings */
+static bool osd_oi_cache_lookup(struct osd_device *osd,
+				const struct lu_fid *fid,
+				struct osd_inode_id *id, __u32 *gen)
+{
+	struct osd_oi_cache_slot *slot = osd_oi_cache_slot(osd, fid);
+	unsigned int		  seq;
+	bool			  hit;
+
+	do {
+		seq = read_seqbegin(&slot->oocs_lock);
+		*gen = slot->oocs_gen;
+		hit = lu_fid_eq(&slot->oocs_fid, fid);
+		if (hit)
+			*id = slot->oocs_id;
+	} while (read_seqretry(&slot->oocs_lock, seq));
+
+	return hit;
+}
+
+/* cache mapping read from the OI unless the slot was invalidated meanwhile */
+static void osd_oi_cache_fill(struct osd_device *osd, const struct lu_fid *fid,
+			      const struct osd_inode_id *id, __u32 gen)
+{
+	struct osd_oi_cache_slot *slot = osd_oi_cache_slot(osd, fid);
+
+	write_seqlock(&slot->oocs_lock);
+	if (slot->oocs_gen == gen) {
+		slot->oocs_fid = *fid;
+		slot->oocs_id = *id;
+	}
+	write_sequnlock(&slot->oocs_lock);
+}
+
+/*
+ * Drop the cached mapping of \a fid, called once the OI has been changed. A
+ * lookup which read the old mapping from the OI either filled the slot
+ * before this, and the mapping is dropped here, or sampled the generation
+ * before this, and osd_oi_cache_fill() ignores it. Invalidating before the
+ * change would let a lookup sample the new generation, read the old mapping
+ * and keep it cached.
+ */
+void osd_oi_cache_invalidate(struct osd_device *osd, const struct lu_fid *fid)
+{
+	struct osd_oi_cache_slot *slot;
+
+	if (osd->od_oi_cache == NULL)
+		return;
+
+	slot = osd_oi_cache_slot(osd, fid);
+	write_seqlock(&slot->oocs_lock);
+	if (lu_fid_eq(&slot->oocs_fid, fid))
+		fid_zero(&slot->oocs_fid);
+	slot->oocs_gen++;
+	write_sequnlock(&slot->oocs_lock);
+}
+
 static void osd_oi_table_put(struct osd_thread_info *info,
 			     struct osd_oi **oi_table, unsigned oi_count)
 {
@@ -342,12 +415,22 @@ int osd_oi_init(struct osd_thread_info *info, struct osd_device *osd)
 	struct scrub_file *sf = &scrub->os_file;
 	struct osd_oi    **oi;
 	int		   rc;
+	int		   i;
 	ENTRY;
 
 	OBD_ALLOC(oi, sizeof(*oi) * OSD_OI_FID_NR_MAX);
 	if (oi == NULL)
 		RETURN(-ENOMEM);
 
+	OBD_ALLOC_LARGE(osd->od_oi_cache,
+			sizeof(*osd->od_oi_cache) * OSD_OI_CACHE_SIZE);
+	if (osd->od_oi_cache == NULL) {
+		OBD_FREE(oi, sizeof(*oi) * OSD_OI_FID_NR_MAX);
+		RETURN(-ENOMEM);
+	}
+	for (i = 0; i < OSD_OI_CACHE_SIZE; i++)
+		seqlock_init(&osd->od_oi_cache[i].oocs_lock);
+
 	mutex_lock(&oi_init_lock);
 	/* try to open existing multiple OIs first */
 	rc = osd_oi_table_open(info, osd, oi, sf->sf_oi_count, false);
@@ -391,8 +474,6 @@ int osd_oi_init(struct osd_thread_info *info, struct osd_device *osd)
 	}
 
 	if (sf->sf_oi_count > 0) {
-		int i;
-
 		memset(sf->sf_oi_bitmap, 0, SCRUB_OI_BITMAP_SIZE);
 		for (i = 0; i < osd_oi_count; i++)
 			ldiskfs_set_bit(i, sf->sf_oi_bitmap);
@@ -418,6 +499,7 @@ create:
 out:
 	if (rc < 0) {
 		OBD_FREE(oi, sizeof(*oi) * OSD_OI_FID_NR_MAX);
+		osd_oi_cache_fini(osd);
 	} else {
 		LASSERT((rc & (rc - 1)) == 0);
 		osd->od_oi_table = oi;
@@ -428,6 +510,8 @@ out:
 			if (rc < 0) {
 				osd_oi_table_put(info, oi, sf->sf_oi_count);
 				OBD_FREE(oi, sizeof(*oi) * OSD_OI_FID_NR_MAX);
+				osd->od_oi_table = NULL;
+				osd_oi_cache_fini(osd);
 			}
 		} else {
 			rc = 0;
@@ -440,6 +524,7 @@ out:
 
 void osd_oi_fini(struct osd_thread_info *info, struct osd_device *osd)
 {
+	osd_oi_cache_fini(osd);
 	if (unlikely(osd->od_oi_table == NULL))
 		return;
 
@@ -519,13 +604,18 @@ static int __osd_oi_lookup(struct osd_thread_info *info, struct osd_device *osd,
 			   const struct lu_fid *fid, struct osd_inode_id *id)
 {
 	struct lu_fid *oi_fid = &info->oti_fid2;
+	__u32	       gen;
 	int	       rc;
 
+	if (osd_oi_cache_lookup(osd, fid, id, &gen))
+		return 0;
+
 	fid_cpu_to_be(oi_fid, fid);
 	rc = osd_oi_iam_lookup(info, osd_fid2oi(osd, fid), (struct dt_rec *)id,
 			       (const struct dt_key *)oi_fid);
 	if (rc > 0) {
 		osd_id_unpack(id, id);
+		osd_oi_cache_fill(osd, fid, id, gen);
 		rc = 0;
 	} else if (rc == 0) {
 		rc = -ENOENT;
@@ -593,20 +683,14 @@ static int osd_oi_iam_refresh(struct osd_thread_info *oti, struct osd_oi *oi,
 	RETURN(rc);
 }
 
-int osd_oi_insert(struct osd_thread_info *info, struct osd_device *osd,
-		  const struct lu_fid *fid, const struct osd_inode_id *id,
-		  struct thandle *th, enum oi_check_flags flags)
+static int __osd_oi_insert(struct osd_thread_info *info, struct osd_device *osd,
+			   const struct lu_fid *fid,
+			   const struct osd_inode_id *id, struct thandle *th)
 {
 	struct lu_fid	    *oi_fid = &info->oti_fid2;
 	struct osd_inode_id *oi_id  = &info->oti_id2;
 	int		     rc     = 0;
 
-	if (unlikely(fid_is_last_id(fid)))
-		return osd_obj_spec_insert(info, osd, fid, id, th);
-
-	if (fid_is_on_ost(info, osd, fid, flags) || fid_is_llog(fid))
-		return osd_obj_map_insert(info, osd, fid, id, th);
-
 	fid_cpu_to_be(oi_fid, fid);
 	osd_id_pack(oi_id, id);
 	rc = osd_oi_iam_refresh(info, osd_fid2oi(osd, fid),
@@ -658,10 +742,30 @@ update:
 		rc = osd_oi_iam_refresh(info, osd_fid2oi(osd, fid),
 					(const struct dt_rec *)oi_id,
 					(const struct dt_key *)oi_fid, th, false);
-		if (rc != 0)
-			return rc;
 	}
 
+	return rc;
+}
+
+int osd_oi_insert(struct osd_thread_info *info, struct osd_device *osd,
+		  const struct lu_fid *fid, const struct osd_inode_id *id,
+		  struct thandle *th, enum oi_check_flags flags)
+{
+	int rc;
+
+	if (unlikely(fid_is_last_id(fid)))
+		return osd_obj_spec_insert(info, osd, fid, id, th);
+
+	if (fid_is_on_ost(info, osd, fid, flags) || fid_is_llog(fid))
+		return osd_obj_map_insert(info, osd, fid, id, th);
+
+	rc = __osd_oi_insert(info, osd, fid, id, th);
+	/* only once the OI is changed, this also drops the old mapping cached
+	 * by the lookup in __osd_oi_insert() */
+	osd_oi_cache_invalidate(osd, fid);
+	if (rc != 0)
+		return rc;
+
 	if (unlikely(fid_seq(fid) == FID_SEQ_LOCAL_FILE))
 		rc = osd_obj_spec_insert(info, osd, fid, id, th);
 	return rc;
@@ -700,6 +804,7 @@ int osd_oi_delete(struct osd_thread_info *info,
 		  struct thandle *th, enum oi_check_flags flags)
 {
 	struct lu_fid *oi_fid = &info->oti_fid2;
+	int	       rc;
 
 	/* clear idmap cache */
 	if (lu_fid_eq(fid, &info->oti_cache.oic_fid))
@@ -712,8 +817,10 @@ int osd_oi_delete(struct osd_thread_info *info,
 		return osd_obj_map_delete(info, osd, fid, th);
 
 	fid_cpu_to_be(oi_fid, fid);
-	return osd_oi_iam_delete(info, osd_fid2oi(osd, fid),
-				 (const struct dt_key *)oi_fid, th);
+	rc = osd_oi_iam_delete(info, osd_fid2oi(osd, fid),
+			       (const struct dt_key *)oi_fid, th);
+	osd_oi_cache_invalidate(osd, fid);
+	return rc;
 }
 
 int osd_oi_update(struct osd_thread_info *info, struct osd_device *osd,
@@ -735,6 +842,7 @@ int osd_oi_update(struct osd_thread_info *info, struct osd_device *osd,
 	rc = osd_oi_iam_refresh(info, osd_fid2oi(osd, fid),
 			       (const struct dt_rec *)oi_id,
 			       (const struct dt_key *)oi_fid, th, false);
+	osd_oi_cache_invalidate(osd, fid);
 	if (rc != 0)
 		return rc;
 
@@ -53,6 +53,8 @@
 
 /* struct rw_semaphore */
 #include <linux/rwsem.h>
+/* seqlock_t */
+#include <linux/seqlock.h>
 #include <lustre_fid.h>
 #include <lu_object.h>
 #include <md_object.h>
@@ -132,6 +134,23 @@ static inline int osd_id_eq_strict(const struct osd_inode_id *id0,
 	return (id0->oii_ino == id1->oii_ino && id0->oii_gen == id1->oii_gen);
 }
 
+/*
+ * Cache of hot FID to inode mappings held in the OI containers. Lookups do
+ * not take any lock, they only check the slot sequence. Any change to the OI
+ * is followed by invalidating the slot and bumping its generation, so that a
+ * lookup which raced with the change does not fill the slot with a stale
+ * mapping.
+ */
+#define OSD_OI_CACHE_BITS	12
+#define OSD_OI_CACHE_SIZE	(1 << OSD_OI_CACHE_BITS)
+
+struct osd_oi_cache_slot {
+	seqlock_t		oocs_lock;
+	__u32			oocs_gen;
+	struct lu_fid		oocs_fid;
+	struct osd_inode_id	oocs_id;
+};
+
 enum oi_check_flags {
 	OI_CHECK_FLD	= 0x00000001,
 	OI_KNOWN_ON_OST	= 0x00000002,
@@ -155,5 +174,6 @@ int  osd_oi_update(struct osd_thread_info *info, struct osd_device *osd,
 
 int fid_is_on_ost(struct osd_thread_info *info, struct osd_device *osd,
 		  const struct lu_fid *fid, enum oi_check_flags flags);
+void osd_oi_cache_invalidate(struct osd_device *osd, const struct lu_fid *fid);
 #endif /* __KERNEL__ */
 #endif /* _OSD_OI_H */
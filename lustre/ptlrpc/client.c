@@ -410,6 +410,15 @@ struct ptlrpc_request *ptlrpc_request_cache_alloc(int flags)
 	return req;
 }
 
+struct ptlrpc_request *ptlrpc_request_cache_cpt_alloc(struct cfs_cpt_table *cptab,
+						      int cpt, int flags)
+{
+	struct ptlrpc_request *req;
+
+	OBD_SLAB_CPT_ALLOC_PTR_GFP(req, request_cache, cptab, cpt, flags);
+	return req;
+}
+
 void ptlrpc_request_cache_free(struct ptlrpc_request *req)
 {
 	OBD_SLAB_FREE_PTR(req, request_cache);
@@ -621,7 +630,7 @@ static int __ptlrpc_request_bufs_pack(struct ptlrpc_request *request,
 
 	spin_lock_init(&request->rq_lock);
 	CFS_INIT_LIST_HEAD(&request->rq_list);
-	CFS_INIT_LIST_HEAD(&request->rq_timed_list);
+	cfs_wheel_node_init(&request->rq_timed_node);
 	CFS_INIT_LIST_HEAD(&request->rq_replay_list);
 	CFS_INIT_LIST_HEAD(&request->rq_ctx_chain);
 	CFS_INIT_LIST_HEAD(&request->rq_set_chain);
@@ -319,7 +319,7 @@ void request_in_callback(lnet_event_t *ev)
                         /* We moaned above already... */
                         return;
                 }
-		req = ptlrpc_request_cache_alloc(ALLOC_ATOMIC_TRY);
+		req = ptlrpc_server_req_alloc(svcpt);
                 if (req == NULL) {
                         CERROR("Can't allocate incoming request descriptor: "
                                "Dropping %s RPC from %s\n",
@@ -342,7 +342,7 @@ void request_in_callback(lnet_event_t *ev)
 	req->rq_rqbd = rqbd;
         req->rq_phase = RQ_PHASE_NEW;
 	spin_lock_init(&req->rq_lock);
-        CFS_INIT_LIST_HEAD(&req->rq_timed_list);
+	cfs_wheel_node_init(&req->rq_timed_node);
 	CFS_INIT_LIST_HEAD(&req->rq_exp_list);
         cfs_atomic_set(&req->rq_refcount, 1);
         if (ev->type == LNET_EVENT_PUT)
@@ -376,6 +376,7 @@ void request_in_callback(lnet_event_t *ev)
 
 	cfs_list_add_tail(&req->rq_list, &svcpt->scp_req_incoming);
 	svcpt->scp_nreqs_incoming++;
+	svcpt->scp_nreqs_arrived++;
 
 	/* NB everything can disappear under us once the request
 	 * has been queued and we unlock, so do the wake now... */
@@ -82,6 +82,16 @@ static const struct req_msg_field *empty[] = {
         &RMF_PTLRPC_BODY
 };
 
+static const struct req_msg_field *obd_ping_agg_client[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_PING_HANDLES
+};
+
+static const struct req_msg_field *obd_ping_agg_server[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_PING_STALE
+};
+
 static const struct req_msg_field *mgs_target_info_only[] = {
         &RMF_PTLRPC_BODY,
         &RMF_MGS_TARGET_INFO
@@ -364,6 +374,12 @@ static const struct req_msg_field *ldlm_enqueue_lvb_server[] = {
         &RMF_DLM_LVB
 };
 
+/* handles of the batched locks the client no longer has */
+static const struct req_msg_field *ldlm_bl_batch_server[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_DLM_REQ
+};
+
 static const struct req_msg_field *ldlm_cp_callback_client[] = {
         &RMF_PTLRPC_BODY,
         &RMF_DLM_REQ,
@@ -680,6 +696,7 @@ static const struct req_msg_field *mdt_hsm_request[] = {
 
 static struct req_format *req_formats[] = {
         &RQF_OBD_PING,
+	&RQF_OBD_PING_AGG,
         &RQF_OBD_SET_INFO,
 	&RQF_OBD_IDX_READ,
         &RQF_SEC_CTX,
@@ -754,6 +771,7 @@ static struct req_format *req_formats[] = {
         &RQF_LDLM_CALLBACK,
         &RQF_LDLM_CP_CALLBACK,
         &RQF_LDLM_BL_CALLBACK,
+	&RQF_LDLM_BL_CALLBACK_BATCH,
         &RQF_LDLM_GL_CALLBACK,
 	&RQF_LDLM_GL_DESC_CALLBACK,
         &RQF_LDLM_INTENT,
@@ -1019,6 +1037,17 @@ struct req_msg_field RMF_DLM_LVB =
 	DEFINE_MSGF("dlm_lvb", 0, -1, NULL, NULL);
 EXPORT_SYMBOL(RMF_DLM_LVB);
 
+/* export handles are opaque cookies, never swabbed */
+struct req_msg_field RMF_PING_HANDLES =
+	DEFINE_MSGF("ping_handles", 0, -1, NULL, NULL);
+EXPORT_SYMBOL(RMF_PING_HANDLES);
+
+/* indices of the handles an aggregated ping did not refresh */
+struct req_msg_field RMF_PING_STALE =
+	DEFINE_MSGF("ping_stale", RMF_F_STRUCT_ARRAY, sizeof(__u32),
+		    lustre_swab_generic_32s, NULL);
+EXPORT_SYMBOL(RMF_PING_STALE);
+
 struct req_msg_field RMF_DLM_GL_DESC =
 	DEFINE_MSGF("dlm_gl_desc", 0, sizeof(union ldlm_gl_desc),
 		    lustre_swab_gl_desc, NULL);
@@ -1208,6 +1237,11 @@ struct req_format RQF_OBD_PING =
         DEFINE_REQ_FMT0("OBD_PING", empty, empty);
 EXPORT_SYMBOL(RQF_OBD_PING);
 
+struct req_format RQF_OBD_PING_AGG =
+	DEFINE_REQ_FMT0("OBD_PING_AGG", obd_ping_agg_client,
+			obd_ping_agg_server);
+EXPORT_SYMBOL(RQF_OBD_PING_AGG);
+
 struct req_format RQF_OBD_SET_INFO =
         DEFINE_REQ_FMT0("OBD_SET_INFO", obd_set_info_client, empty);
 EXPORT_SYMBOL(RQF_OBD_SET_INFO);
@@ -1409,6 +1443,11 @@ struct req_format RQF_LDLM_BL_CALLBACK =
         DEFINE_REQ_FMT0("LDLM_BL_CALLBACK", ldlm_enqueue_client, empty);
 EXPORT_SYMBOL(RQF_LDLM_BL_CALLBACK);
 
+struct req_format RQF_LDLM_BL_CALLBACK_BATCH =
+	DEFINE_REQ_FMT0("LDLM_BL_CALLBACK_BATCH", ldlm_enqueue_client,
+			ldlm_bl_batch_server);
+EXPORT_SYMBOL(RQF_LDLM_BL_CALLBACK_BATCH);
+
 struct req_format RQF_LDLM_GL_CALLBACK =
         DEFINE_REQ_FMT0("LDLM_GL_CALLBACK", ldlm_enqueue_client,
                         ldlm_gl_callback_server);
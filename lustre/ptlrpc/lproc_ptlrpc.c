@@ -414,6 +414,98 @@ ptlrpc_lprocfs_wr_threads_max(struct file *file, const char *buffer,
 	return count;
 }
 
+static int
+ptlrpc_lprocfs_rd_threads_idle_timeout(char *page, char **start, off_t off,
+				       int count, int *eof, void *data)
+{
+	struct ptlrpc_service *svc = data;
+
+	return snprintf(page, count, "%d\n", svc->srv_thr_idle_timeout);
+}
+
+static int
+ptlrpc_lprocfs_wr_threads_idle_timeout(struct file *file, const char *buffer,
+				       unsigned long count, void *data)
+{
+	struct ptlrpc_service *svc = data;
+	int	val;
+	int	rc = lprocfs_write_helper(buffer, count, &val);
+
+	if (rc < 0)
+		return rc;
+
+	if (val < 0)
+		return -ERANGE;
+
+	svc->srv_thr_idle_timeout = val;
+
+	return count;
+}
+
+/* decisions of the per-partition thread controller */
+static int
+ptlrpc_lprocfs_rd_threads_control(char *page, char **start, off_t off,
+				  int count, int *eof, void *data)
+{
+	struct ptlrpc_service		*svc = data;
+	struct ptlrpc_service_part	*svcpt;
+	int				rc = 0;
+	int				i;
+
+	*eof = 1;
+	ptlrpc_service_for_each_part(svcpt, i, svc) {
+		rc += snprintf(page + rc, count - rc,
+			       "cpt %d: running %d want %d req_rate %d "
+			       "svc_time_p90_us %u prespawned %lu reaped %lu\n",
+			       svcpt->scp_cpt, svcpt->scp_nthrs_running,
+			       svcpt->scp_nthrs_want, svcpt->scp_req_rate,
+			       svcpt->scp_svc_time_p90,
+			       svcpt->scp_nthrs_prespawned,
+			       svcpt->scp_nthrs_reaped);
+		if (rc >= count)
+			return count;
+	}
+
+	return rc;
+}
+
+static int
+ptlrpc_lprocfs_rd_reply_stats(char *page, char **start, off_t off,
+			      int count, int *eof, void *data)
+{
+	struct ptlrpc_service		*svc = data;
+	struct ptlrpc_service_part	*svcpt;
+	unsigned long			handled;
+	unsigned long			wakeups;
+	int				rc = 0;
+	int				i;
+
+	*eof = 1;
+	ptlrpc_service_for_each_part(svcpt, i, svc) {
+		ptlrpc_hr_stats(svc->srv_cptable, svcpt->scp_cpt,
+				&handled, &wakeups);
+
+		spin_lock(&svcpt->scp_rep_lock);
+		rc += snprintf(page + rc, count - rc,
+			       "cpt %d: rs_cached %u rs_cache_hits %lu "
+			       "rs_cache_misses %lu difficult %d "
+			       "commit_replies %lu commit_batches %lu "
+			       "hr_handled %lu hr_wakeups %lu\n",
+			       svcpt->scp_cpt, svcpt->scp_rep_cache_count,
+			       svcpt->scp_rep_cache_hits,
+			       svcpt->scp_rep_cache_misses,
+			       cfs_atomic_read(&svcpt->scp_nreps_difficult),
+			       svcpt->scp_rep_commit_replies,
+			       svcpt->scp_rep_commit_batches,
+			       handled, wakeups);
+		spin_unlock(&svcpt->scp_rep_lock);
+		if (rc >= count)
+			return count;
+	}
+
+	return rc;
+}
+
 /**
  * \addtogoup nrs
  * @{
@@ -1112,6 +1204,16 @@ void ptlrpc_lprocfs_register_service(struct proc_dir_entry *entry,
                 {.name       = "threads_started",
                  .read_fptr  = ptlrpc_lprocfs_rd_threads_started,
                  .data       = svc},
+		{.name	     = "threads_idle_timeout",
+		 .read_fptr  = ptlrpc_lprocfs_rd_threads_idle_timeout,
+		 .write_fptr = ptlrpc_lprocfs_wr_threads_idle_timeout,
+		 .data	     = svc},
+		{.name	     = "threads_control",
+		 .read_fptr  = ptlrpc_lprocfs_rd_threads_control,
+		 .data	     = svc},
+		{.name	     = "reply_stats",
+		 .read_fptr  = ptlrpc_lprocfs_rd_reply_stats,
+		 .data	     = svc},
                 {.name       = "timeouts",
                  .read_fptr  = ptlrpc_lprocfs_rd_timeouts,
                  .data       = svc},
@@ -322,11 +322,125 @@ void lustre_put_emerg_rs(struct ptlrpc_reply_state *rs)
 	struct ptlrpc_service_part *svcpt = rs->rs_svcpt;
 
 	spin_lock(&svcpt->scp_rep_lock);
+	if (svcpt->scp_rep_idle_excess > 0) {
+		/* the thread which added it to the pool is gone */
+		svcpt->scp_rep_idle_excess--;
+		spin_unlock(&svcpt->scp_rep_lock);
+		OBD_FREE_LARGE(rs, svcpt->scp_service->srv_max_reply_size);
+		return;
+	}
 	cfs_list_add(&rs->rs_list, &svcpt->scp_rep_idle);
 	spin_unlock(&svcpt->scp_rep_lock);
 	wake_up(&svcpt->scp_rep_waitq);
 }
 
+static int rs_cache_max = 256;
+CFS_MODULE_PARM(rs_cache_max, "i", int, 0644,
+		"Max # of free reply states cached per service partition");
+
+/**
+ * Get a reply state of at least \a size bytes from the cache of \a svcpt,
+ * or allocate one on the CPT of \a svcpt which will go to the cache when it
+ * is freed. Returns NULL if \a size does not fit the cache.
+ */
+struct ptlrpc_reply_state *
+lustre_get_cached_rs(struct ptlrpc_service_part *svcpt, int size)
+{
+	struct ptlrpc_service		*svc = svcpt->scp_service;
+	struct ptlrpc_reply_state	*rs = NULL;
+
+	if (size > svc->srv_max_reply_size || rs_cache_max <= 0)
+		return NULL;
+
+	spin_lock(&svcpt->scp_rep_lock);
+	if (!cfs_list_empty(&svcpt->scp_rep_cache)) {
+		rs = cfs_list_entry(svcpt->scp_rep_cache.next,
+				    struct ptlrpc_reply_state, rs_list);
+		cfs_list_del(&rs->rs_list);
+		svcpt->scp_rep_cache_count--;
+		svcpt->scp_rep_cache_hits++;
+	} else {
+		svcpt->scp_rep_cache_misses++;
+	}
+	spin_unlock(&svcpt->scp_rep_lock);
+
+	if (rs != NULL) {
+		/* only what is used goes on the wire */
+		memset(rs, 0, size);
+	} else {
+		OBD_CPT_ALLOC_LARGE(rs, svc->srv_cptable, svcpt->scp_cpt,
+				    svc->srv_max_reply_size);
+		if (rs == NULL)
+			return NULL;
+	}
+
+	rs->rs_size = svc->srv_max_reply_size;
+	rs->rs_svcpt = svcpt;
+	rs->rs_cached = 1;
+	return rs;
+}
+
+/**
+ * Return the \a count reply states on \a list, all from the cache of
+ * \a svcpt, to that cache under a single lock, and free those beyond
+ * rs_cache_max.
+ */
+static void lustre_put_cached_rs_list(struct ptlrpc_service_part *svcpt,
+				      cfs_list_t *list, int count)
+{
+	struct ptlrpc_reply_state *rs;
+
+	spin_lock(&svcpt->scp_rep_lock);
+	if (svcpt->scp_rep_cache_count + count <= rs_cache_max) {
+		cfs_list_splice_init(list, &svcpt->scp_rep_cache);
+		svcpt->scp_rep_cache_count += count;
+	} else {
+		while (!cfs_list_empty(list) &&
+		       svcpt->scp_rep_cache_count < rs_cache_max) {
+			cfs_list_move(list->next, &svcpt->scp_rep_cache);
+			svcpt->scp_rep_cache_count++;
+		}
+	}
+	spin_unlock(&svcpt->scp_rep_lock);
+
+	while (!cfs_list_empty(list)) {
+		rs = cfs_list_entry(list->next, struct ptlrpc_reply_state,
+				    rs_list);
+		cfs_list_del(&rs->rs_list);
+		OBD_FREE_LARGE(rs, rs->rs_size);
+	}
+}
+
+void lustre_put_cached_rs(struct ptlrpc_reply_state *rs)
+{
+	CFS_LIST_HEAD(list);
+
+	cfs_list_add(&rs->rs_list, &list);
+	lustre_put_cached_rs_list(rs->rs_svcpt, &list, 1);
+}
+
+/**
+ * Free all reply states in the cache of \a svcpt, when the service stops.
+ */
+void lustre_purge_cached_rs(struct ptlrpc_service_part *svcpt)
+{
+	struct ptlrpc_reply_state *rs;
+
+	spin_lock(&svcpt->scp_rep_lock);
+	while (!cfs_list_empty(&svcpt->scp_rep_cache)) {
+		rs = cfs_list_entry(svcpt->scp_rep_cache.next,
+				    struct ptlrpc_reply_state, rs_list);
+		cfs_list_del(&rs->rs_list);
+		svcpt->scp_rep_cache_count--;
+		spin_unlock(&svcpt->scp_rep_lock);
+
+		OBD_FREE_LARGE(rs, rs->rs_size);
+		spin_lock(&svcpt->scp_rep_lock);
+	}
+	LASSERT(svcpt->scp_rep_cache_count == 0);
+	spin_unlock(&svcpt->scp_rep_lock);
+}
+
 int lustre_pack_reply_v2(struct ptlrpc_request *req, int count,
                          __u32 *lens, char **bufs, int flags)
 {
@@ -507,7 +621,11 @@ int lustre_shrink_msg(struct lustre_msg *msg, int segment,
 }
 EXPORT_SYMBOL(lustre_shrink_msg);
 
-void lustre_free_reply_state(struct ptlrpc_reply_state *rs)
+/**
+ * Release \a rs, returns 1 if it came from the cache and the caller has to
+ * give it back there.
+ */
+static int lustre_release_reply_state(struct ptlrpc_reply_state *rs)
 {
         PTLRPC_RS_DEBUG_LRU_DEL(rs);
 
@@ -520,10 +638,50 @@ void lustre_free_reply_state(struct ptlrpc_reply_state *rs)
         LASSERT (cfs_list_empty(&rs->rs_exp_list));
         LASSERT (cfs_list_empty(&rs->rs_obd_list));
 
-        sptlrpc_svc_free_rs(rs);
+	return sptlrpc_svc_release_rs(rs);
+}
+
+void lustre_free_reply_state(struct ptlrpc_reply_state *rs)
+{
+	if (lustre_release_reply_state(rs))
+		lustre_put_cached_rs(rs);
 }
 EXPORT_SYMBOL(lustre_free_reply_state);
 
+/**
+ * Free the reply states on \a list, linked by rs_list, giving the cached
+ * ones back to their service partition once per run of the same partition
+ * instead of once per reply state.
+ */
+void lustre_free_reply_states(cfs_list_t *list)
+{
+	struct ptlrpc_service_part	*svcpt = NULL;
+	struct ptlrpc_reply_state	*rs;
+	CFS_LIST_HEAD			(cached);
+	int				 count = 0;
+
+	while (!cfs_list_empty(list)) {
+		rs = cfs_list_entry(list->next, struct ptlrpc_reply_state,
+				    rs_list);
+		cfs_list_del_init(&rs->rs_list);
+
+		if (!lustre_release_reply_state(rs))
+			continue;
+
+		if (rs->rs_svcpt != svcpt && count > 0) {
+			lustre_put_cached_rs_list(svcpt, &cached, count);
+			count = 0;
+		}
+		svcpt = rs->rs_svcpt;
+		cfs_list_add(&rs->rs_list, &cached);
+		count++;
+	}
+
+	if (count > 0)
+		lustre_put_cached_rs_list(svcpt, &cached, count);
+}
+EXPORT_SYMBOL(lustre_free_reply_states);
+
 static int lustre_unpack_msg_v2(struct lustre_msg_v2 *m, int len)
 {
         int swabbed, required_len, i;
@@ -54,6 +54,28 @@ CFS_MODULE_PARM(suppress_pings, "i", int, 0644, "Suppress pings");
 struct mutex pinger_mutex;
 static CFS_LIST_HEAD(pinger_imports);
 static cfs_list_t timeout_list = CFS_LIST_HEAD_INIT(timeout_list);
+/* when the timeout items are due, protected by pinger_mutex */
+static cfs_wheel_t pinger_wheel;
+
+static void ptlrpc_pinger_wheel_notify(cfs_wheel_t *wheel)
+{
+#ifdef __KERNEL__
+	ptlrpc_pinger_wake_up();
+#endif
+}
+
+void ptlrpc_pinger_init(void)
+{
+	mutex_init(&pinger_mutex);
+	cfs_wheel_init(&pinger_wheel, ptlrpc_pinger_wheel_notify, NULL);
+}
+
+/* the timeout callbacks run at least as often as the pings are checked */
+static inline time_t ptlrpc_timeout_expiry(struct timeout_item *item)
+{
+	return cfs_time_current_sec() +
+	       min_t(cfs_time_t, item->ti_timeout, PING_INTERVAL);
+}
 
 int ptlrpc_pinger_suppress_pings()
 {
@@ -150,25 +172,34 @@ static inline int ptlrpc_next_reconnect(struct obd_import *imp)
 
 cfs_duration_t pinger_check_timeout(cfs_time_t time)
 {
-        struct timeout_item *item;
-        cfs_time_t timeout = PING_INTERVAL;
-
-        /* The timeout list is a increase order sorted list */
-	mutex_lock(&pinger_mutex);
-        cfs_list_for_each_entry(item, &timeout_list, ti_chain) {
-                int ti_timeout = item->ti_timeout;
-                if (timeout > ti_timeout)
-                        timeout = ti_timeout;
-                break;
-        }
-	mutex_unlock(&pinger_mutex);
-
-        return cfs_time_sub(cfs_time_add(time, cfs_time_seconds(timeout)),
-                                         cfs_time_current());
+	/* the timeout items wake the pinger up through pinger_wheel */
+	return cfs_time_sub(cfs_time_add(time,
+					 cfs_time_seconds(PING_INTERVAL)),
+			    cfs_time_current());
 }
 
 #ifdef __KERNEL__
 
+/* Run the callbacks of the timeout items which are due, and requeue them */
+static void ptlrpc_pinger_run_timeouts(void)
+{
+	struct timeout_item	*item;
+	CFS_LIST_HEAD		(expired);
+
+	LASSERT(mutex_is_locked(&pinger_mutex));
+
+	cfs_wheel_expire(&pinger_wheel, cfs_time_current_sec(), &expired);
+	while (!cfs_list_empty(&expired)) {
+		item = cfs_list_entry(expired.next, struct timeout_item,
+				      ti_node.cwn_link);
+		cfs_list_del_init(&item->ti_node.cwn_link);
+
+		item->ti_cb(item, item->ti_cb_data);
+		cfs_wheel_add(&pinger_wheel, &item->ti_node,
+			      ptlrpc_timeout_expiry(item));
+	}
+}
+
 static bool ir_up;
 
 void ptlrpc_pinger_ir_up(void)
@@ -185,13 +216,190 @@ void ptlrpc_pinger_ir_down(void)
 }
 EXPORT_SYMBOL(ptlrpc_pinger_ir_down);
 
+static int ping_aggregate = 1;
+CFS_MODULE_PARM(ping_aggregate, "i", int, 0644,
+		"Send a single ping per server node");
+
+struct ping_agg_args {
+	struct obd_import	**paa_imps;
+	int			  paa_count;
+};
+
+static int ptlrpc_ping_agg_interpret(const struct lu_env *env,
+				     struct ptlrpc_request *req,
+				     void *args, int rc)
+{
+	struct ping_agg_args	*aa = args;
+	struct obd_import	*imp;
+	__u32			*stale = NULL;
+	int			 nstale = 0;
+	int			 i;
+
+	if (rc == 0) {
+		nstale = req_capsule_get_size(&req->rq_pill, &RMF_PING_STALE,
+					      RCL_SERVER) / sizeof(*stale);
+		if (nstale > 0)
+			stale = req_capsule_server_sized_get(&req->rq_pill,
+						&RMF_PING_STALE,
+						nstale * sizeof(*stale));
+		if (stale == NULL)
+			nstale = 0;
+	}
+
+	/* The node did not answer for everybody, let each import ping on its
+	 * own so that its health is tracked as usual. */
+	for (i = 0; i < aa->paa_count; i++) {
+		if (rc != 0) {
+			imp = aa->paa_imps[i];
+			spin_lock(&imp->imp_lock);
+			imp->imp_force_verify = 1;
+			spin_unlock(&imp->imp_lock);
+		}
+	}
+
+	/* only these targets were not refreshed by the node */
+	for (i = 0; i < nstale; i++) {
+		if (stale[i] >= aa->paa_count) {
+			DEBUG_REQ(D_ERROR, req, "bad stale index %u/%d",
+				  stale[i], aa->paa_count);
+			continue;
+		}
+		imp = aa->paa_imps[stale[i]];
+		CDEBUG(D_HA, "%s: target %s not refreshed by aggregated ping\n",
+		       imp->imp_obd->obd_name, obd2cli_tgt(imp->imp_obd));
+		spin_lock(&imp->imp_lock);
+		imp->imp_force_verify = 1;
+		spin_unlock(&imp->imp_lock);
+	}
+
+	for (i = 0; i < aa->paa_count; i++)
+		class_import_put(aa->paa_imps[i]);
+	OBD_FREE(aa->paa_imps, aa->paa_count * sizeof(*aa->paa_imps));
+
+	if (rc != 0)
+		DEBUG_REQ(D_HA, req, "aggregated ping failed: rc = %d", rc);
+	if (rc != 0 || nstale > 0)
+		ptlrpc_pinger_wake_up();
+	return 0;
+}
+
+/**
+ * Ping the server node of \a imp once for \a imp and all the imports on
+ * \a list, which go to other targets on the same node.
+ */
+static int ptlrpc_ping_agg(struct obd_import *imp, cfs_list_t *list,
+			   int count)
+{
+	struct ptlrpc_request	 *req;
+	struct ping_agg_args	 *aa;
+	struct lustre_handle	 *handles;
+	struct obd_import	**imps;
+	struct obd_import	 *tmp;
+	int			  i = 0;
+	int			  rc;
+	ENTRY;
+
+	req = ptlrpc_request_alloc(imp, &RQF_OBD_PING_AGG);
+	if (req == NULL)
+		RETURN(-ENOMEM);
+
+	req_capsule_set_size(&req->rq_pill, &RMF_PING_HANDLES, RCL_CLIENT,
+			     count * sizeof(*handles));
+	/* room for the indices of all the handles, in case none is fresh */
+	req_capsule_set_size(&req->rq_pill, &RMF_PING_STALE, RCL_SERVER,
+			     count * sizeof(__u32));
+	rc = ptlrpc_request_pack(req, LUSTRE_OBD_VERSION, OBD_PING);
+	if (rc) {
+		ptlrpc_request_free(req);
+		RETURN(rc);
+	}
+	ptlrpc_request_set_replen(req);
+	req->rq_no_resend = req->rq_no_delay = 1;
+
+	OBD_ALLOC(imps, count * sizeof(*imps));
+	if (imps == NULL) {
+		ptlrpc_req_finished(req);
+		RETURN(-ENOMEM);
+	}
+
+	handles = req_capsule_client_get(&req->rq_pill, &RMF_PING_HANDLES);
+	while (!cfs_list_empty(list)) {
+		tmp = cfs_list_entry(list->next, struct obd_import,
+				     imp_ping_agg_chain);
+		cfs_list_del_init(&tmp->imp_ping_agg_chain);
+
+		handles[i] = tmp->imp_remote_handle;
+		imps[i++] = class_import_get(tmp);
+		/* as if the ping was sent on this import */
+		ptlrpc_update_next_ping(tmp, 0);
+	}
+	LASSERT(i == count);
+
+	CLASSERT(sizeof(*aa) <= sizeof(req->rq_async_args));
+	aa = ptlrpc_req_async_args(req);
+	aa->paa_imps = imps;
+	aa->paa_count = count;
+	req->rq_interpret_reply = ptlrpc_ping_agg_interpret;
+
+	DEBUG_REQ(D_INFO, req, "pinging %s->%s and %d more targets",
+		  imp->imp_obd->obd_uuid.uuid, obd2cli_tgt(imp->imp_obd),
+		  count);
+	ptlrpcd_add_req(req, PDL_POLICY_ROUND, -1);
+
+	RETURN(0);
+}
+
+/**
+ * Send the pings of the imports on \a agg, one per server node.
+ */
+static void ptlrpc_pinger_ping_agg(cfs_list_t *agg)
+{
+	struct obd_import	*imp;
+	struct obd_import	*tmp;
+	struct obd_import	*next;
+	CFS_LIST_HEAD		(node);
+	int			 count;
+
+	LASSERT(mutex_is_locked(&pinger_mutex));
+
+	while (!cfs_list_empty(agg)) {
+		imp = cfs_list_entry(agg->next, struct obd_import,
+				     imp_ping_agg_chain);
+		cfs_list_del_init(&imp->imp_ping_agg_chain);
+
+		count = 0;
+		cfs_list_for_each_entry_safe(tmp, next, agg,
+					     imp_ping_agg_chain) {
+			if (tmp->imp_ping_agg_nid != imp->imp_ping_agg_nid)
+				continue;
+			cfs_list_move_tail(&tmp->imp_ping_agg_chain, &node);
+			if (++count == PING_AGG_MAX_HANDLES)
+				break;
+		}
+
+		if (count > 0 && ptlrpc_ping_agg(imp, &node, count) == 0)
+			continue;
+
+		/* alone on its node, or out of memory */
+		ptlrpc_ping(imp);
+		while (!cfs_list_empty(&node)) {
+			tmp = cfs_list_entry(node.next, struct obd_import,
+					     imp_ping_agg_chain);
+			cfs_list_del_init(&tmp->imp_ping_agg_chain);
+			ptlrpc_ping(tmp);
+		}
+	}
+}
+
 static void ptlrpc_pinger_process_import(struct obd_import *imp,
-                                         unsigned long this_ping)
+					 unsigned long this_ping,
+					 cfs_list_t *agg)
 {
 	int level;
 	int force;
 	int force_next;
 	int suppress;
+	lnet_nid_t nid = LNET_NID_ANY;
 
 	spin_lock(&imp->imp_lock);
 
@@ -202,6 +410,9 @@ static void ptlrpc_pinger_process_import(struct obd_import *imp,
 	 * This will be used below only if the import is "FULL".
 	 */
 	suppress = ir_up && OCD_HAS_FLAG(&imp->imp_connect_data, PINGLESS);
+	if (ping_aggregate && imp->imp_connection != NULL &&
+	    OCD_HAS_FLAG(&imp->imp_connect_data, PING_AGG))
+		nid = imp->imp_connection->c_peer.nid;
 
 	imp->imp_force_verify = 0;
 
@@ -234,7 +445,13 @@ static void ptlrpc_pinger_process_import(struct obd_import *imp,
 		       imp->imp_obd->obd_uuid.uuid, obd2cli_tgt(imp->imp_obd),
 		       ptlrpc_import_state_name(level));
 	} else if ((imp->imp_pingable && !suppress) || force_next || force) {
-		ptlrpc_ping(imp);
+		/* forced pings verify this very import, never carry them */
+		if (nid != LNET_NID_ANY && !force && !force_next) {
+			imp->imp_ping_agg_nid = nid;
+			cfs_list_add_tail(&imp->imp_ping_agg_chain, agg);
+		} else {
+			ptlrpc_ping(imp);
+		}
 	}
 }
 
@@ -252,19 +469,17 @@ static int ptlrpc_pinger_main(void *arg)
 		cfs_time_t this_ping = cfs_time_current();
 		struct l_wait_info lwi;
 		cfs_duration_t time_to_next_wake;
-		struct timeout_item *item;
 		cfs_list_t *iter;
+		CFS_LIST_HEAD(agg);
 
 		mutex_lock(&pinger_mutex);
-                cfs_list_for_each_entry(item, &timeout_list, ti_chain) {
-                        item->ti_cb(item, item->ti_cb_data);
-                }
+		ptlrpc_pinger_run_timeouts();
                 cfs_list_for_each(iter, &pinger_imports) {
                         struct obd_import *imp =
                                 cfs_list_entry(iter, struct obd_import,
                                                imp_pinger_chain);
 
-                        ptlrpc_pinger_process_import(imp, this_ping);
+                        ptlrpc_pinger_process_import(imp, this_ping, &agg);
                         /* obd_timeout might have changed */
                         if (imp->imp_pingable && imp->imp_next_ping &&
                             cfs_time_after(imp->imp_next_ping,
@@ -272,6 +487,7 @@ static int ptlrpc_pinger_main(void *arg)
                                                         cfs_time_seconds(PING_INTERVAL))))
                                 ptlrpc_update_next_ping(imp, 0);
                 }
+		ptlrpc_pinger_ping_agg(&agg);
 		mutex_unlock(&pinger_mutex);
                 /* update memory usage info */
                 obd_update_maxusage();
@@ -454,6 +670,7 @@ struct timeout_item* ptlrpc_new_timeout(int time, enum timeout_event event,
 
         CFS_INIT_LIST_HEAD(&ti->ti_obd_list);
         CFS_INIT_LIST_HEAD(&ti->ti_chain);
+	cfs_wheel_node_init(&ti->ti_node);
         ti->ti_timeout = time;
         ti->ti_event = event;
         ti->ti_cb = cb;
@@ -464,13 +681,14 @@ struct timeout_item* ptlrpc_new_timeout(int time, enum timeout_event event,
 
 /**
  * Register timeout event on the the pinger thread.
- * Note: the timeout list is an sorted list with increased timeout value.
+ * Note: the items are queued on pinger_wheel for when they are due, the
+ * timeout list is only used to look them up by event.
  */
 static struct timeout_item*
 ptlrpc_pinger_register_timeout(int time, enum timeout_event event,
                                timeout_cb_t cb, void *data)
 {
-	struct timeout_item *item, *tmp;
+	struct timeout_item *item;
 
 	LASSERT(mutex_is_locked(&pinger_mutex));
 
@@ -478,18 +696,14 @@ ptlrpc_pinger_register_timeout(int time, enum timeout_event event,
 		if (item->ti_event == event)
 			goto out;
 
-        item = ptlrpc_new_timeout(time, event, cb, data);
-        if (item) {
-                cfs_list_for_each_entry_reverse(tmp, &timeout_list, ti_chain) {
-                        if (tmp->ti_timeout < time) {
-                                cfs_list_add(&item->ti_chain, &tmp->ti_chain);
-                                goto out;
-                        }
-                }
-                cfs_list_add(&item->ti_chain, &timeout_list);
-        }
+	item = ptlrpc_new_timeout(time, event, cb, data);
+	if (item) {
+		cfs_list_add_tail(&item->ti_chain, &timeout_list);
+		cfs_wheel_add(&pinger_wheel, &item->ti_node,
+			      ptlrpc_timeout_expiry(item));
+	}
 out:
-        return item;
+	return item;
 }
 
 /* Add a client_obd to the timeout event list, when timeout(@time)
@@ -535,6 +749,7 @@ int ptlrpc_del_timeout_client(cfs_list_t *obd_list,
         LASSERTF(ti != NULL, "ti is NULL ! \n");
         if (cfs_list_empty(&ti->ti_obd_list)) {
                 cfs_list_del(&ti->ti_chain);
+		cfs_wheel_del(&pinger_wheel, &ti->ti_node);
                 OBD_FREE_PTR(ti);
         }
 	mutex_unlock(&pinger_mutex);
@@ -550,6 +765,7 @@ int ptlrpc_pinger_remove_timeouts(void)
         cfs_list_for_each_entry_safe(item, tmp, &timeout_list, ti_chain) {
                 LASSERT(cfs_list_empty(&item->ti_obd_list));
                 cfs_list_del(&item->ti_chain);
+		cfs_wheel_del(&pinger_wheel, &item->ti_node);
                 OBD_FREE_PTR(item);
         }
 	mutex_unlock(&pinger_mutex);
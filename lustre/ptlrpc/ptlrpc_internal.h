@@ -49,6 +49,7 @@ extern int test_req_buffer_pressure;
 extern struct mutex ptlrpc_all_services_mutex;
 
 int ptlrpc_start_thread(struct ptlrpc_service_part *svcpt, int wait);
+struct ptlrpc_request *ptlrpc_server_req_alloc(struct ptlrpc_service_part *svcpt);
 /* ptlrpcd.c */
 int ptlrpcd_start(int index, int max, const char *name, struct ptlrpcd_ctl *pc);
 
@@ -58,6 +59,8 @@ struct ptlrpc_bulk_desc *ptlrpc_new_bulk(unsigned npages, unsigned max_brw,
 int ptlrpc_request_cache_init(void);
 void ptlrpc_request_cache_fini(void);
 struct ptlrpc_request *ptlrpc_request_cache_alloc(int flags);
+struct ptlrpc_request *ptlrpc_request_cache_cpt_alloc(struct cfs_cpt_table *cptab,
+						      int cpt, int flags);
 void ptlrpc_request_cache_free(struct ptlrpc_request *req);
 void ptlrpc_init_xid(void);
 
@@ -243,8 +246,13 @@ void ptlrpc_add_bulk_page(struct ptlrpc_bulk_desc *desc, struct page *page,
 struct ptlrpc_reply_state *
 lustre_get_emerg_rs(struct ptlrpc_service_part *svcpt);
 void lustre_put_emerg_rs(struct ptlrpc_reply_state *rs);
+struct ptlrpc_reply_state *
+lustre_get_cached_rs(struct ptlrpc_service_part *svcpt, int size);
+void lustre_put_cached_rs(struct ptlrpc_reply_state *rs);
+void lustre_purge_cached_rs(struct ptlrpc_service_part *svcpt);
 
 /* pinger.c */
+void ptlrpc_pinger_init(void);
 int ptlrpc_start_pinger(void);
 int ptlrpc_stop_pinger(void);
 void ptlrpc_pinger_sending_on_import(struct obd_import *imp);
@@ -51,7 +51,6 @@ extern spinlock_t ptlrpc_last_xid_lock;
 #if RS_DEBUG
 extern spinlock_t ptlrpc_rs_debug_lock;
 #endif
-extern struct mutex pinger_mutex;
 extern struct mutex ptlrpcd_mutex;
 
 __init int ptlrpc_init(void)
@@ -64,7 +63,7 @@ __init int ptlrpc_init(void)
 	spin_lock_init(&ptlrpc_rs_debug_lock);
 #endif
 	mutex_init(&ptlrpc_all_services_mutex);
-	mutex_init(&pinger_mutex);
+	ptlrpc_pinger_init();
 	mutex_init(&ptlrpcd_mutex);
         ptlrpc_init_xid();
 
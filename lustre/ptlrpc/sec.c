@@ -2151,12 +2151,17 @@ int sptlrpc_svc_wrap_reply(struct ptlrpc_request *req)
 }
 
 /**
- * Used by ptlrpc server, to free reply_state.
+ * Used by ptlrpc server, to release the security part of reply_state.
+ *
+ * \retval 1	\a rs came from the reply state cache, and its memory is left
+ *		to the caller, see lustre_free_reply_states()
+ * \retval 0	\a rs has been freed
  */
-void sptlrpc_svc_free_rs(struct ptlrpc_reply_state *rs)
+int sptlrpc_svc_release_rs(struct ptlrpc_reply_state *rs)
 {
         struct ptlrpc_sec_policy *policy;
         unsigned int prealloc;
+	unsigned int cached;
         ENTRY;
 
         LASSERT(rs->rs_svc_ctx);
@@ -2166,11 +2171,21 @@ void sptlrpc_svc_free_rs(struct ptlrpc_reply_state *rs)
         LASSERT(policy->sp_sops->free_rs);
 
         prealloc = rs->rs_prealloc;
+	cached = rs->rs_cached;
         policy->sp_sops->free_rs(rs);
 
         if (prealloc)
                 lustre_put_emerg_rs(rs);
-        EXIT;
+	RETURN(cached);
+}
+
+/**
+ * Used by ptlrpc server, to free reply_state.
+ */
+void sptlrpc_svc_free_rs(struct ptlrpc_reply_state *rs)
+{
+	if (sptlrpc_svc_release_rs(rs))
+		lustre_put_cached_rs(rs);
 }
 
 void sptlrpc_svc_ctx_addref(struct ptlrpc_request *req)
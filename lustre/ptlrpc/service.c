@@ -62,6 +62,21 @@ CFS_MODULE_PARM(at_extra, "i", int, 0644,
                 "How much extra time to give with each early reply");
 
 
+/*
+ * Incoming request descriptors are preallocated per service partition so
+ * request_in_callback() doesn't have to go to the slab with GFP_ATOMIC for
+ * every message.  The pool and the low watermark of posted request buffers
+ * both follow the arrival rate: enough to absorb 1/PTLRPC_REQ_RATE_DIV
+ * second of incoming requests.
+ */
+#define PTLRPC_REQ_RATE_DIV	10
+#define PTLRPC_REQ_POOL_MIN	16
+#define PTLRPC_REQ_POOL_MAX	1024
+/* max # of request descriptors allocated by one refill */
+#define PTLRPC_REQ_POOL_BATCH	64
+/* the rate driven rqbd low watermark is capped at this many groups */
+#define PTLRPC_RQBD_GROUPS_MAX	8
+
 /* forward ref */
 static int ptlrpc_server_post_idle_rqbds(struct ptlrpc_service_part *svcpt);
 static void ptlrpc_server_hpreq_fini(struct ptlrpc_request *req);
@@ -119,12 +134,92 @@ ptlrpc_free_rqbd(struct ptlrpc_request_buffer_desc *rqbd)
 	OBD_FREE_PTR(rqbd);
 }
 
+static int ptlrpc_req_pool_target(struct ptlrpc_service_part *svcpt)
+{
+	int target = svcpt->scp_req_rate / PTLRPC_REQ_RATE_DIV;
+
+	return min(max(target, PTLRPC_REQ_POOL_MIN), PTLRPC_REQ_POOL_MAX);
+}
+
+/**
+ * Get a zeroed request descriptor for an incoming message, called from
+ * request_in_callback() so we mustn't sleep here.
+ */
+struct ptlrpc_request *ptlrpc_server_req_alloc(struct ptlrpc_service_part *svcpt)
+{
+	struct ptlrpc_request *req = NULL;
+
+	spin_lock(&svcpt->scp_lock);
+	if (!cfs_list_empty(&svcpt->scp_req_idle)) {
+		req = cfs_list_entry(svcpt->scp_req_idle.next,
+				     struct ptlrpc_request, rq_list);
+		cfs_list_del(&req->rq_list);
+		svcpt->scp_nreqs_idle--;
+	}
+	spin_unlock(&svcpt->scp_lock);
+
+	if (req != NULL) {
+		memset(req, 0, sizeof(*req));
+		return req;
+	}
+
+	return ptlrpc_request_cache_cpt_alloc(svcpt->scp_service->srv_cptable,
+					      svcpt->scp_cpt, ALLOC_ATOMIC_TRY);
+}
+
+static void ptlrpc_server_req_free(struct ptlrpc_service_part *svcpt,
+				   struct ptlrpc_request *req)
+{
+	spin_lock(&svcpt->scp_lock);
+	if (svcpt->scp_nreqs_idle < ptlrpc_req_pool_target(svcpt)) {
+		cfs_list_add(&req->rq_list, &svcpt->scp_req_idle);
+		svcpt->scp_nreqs_idle++;
+		req = NULL;
+	}
+	spin_unlock(&svcpt->scp_lock);
+
+	if (req != NULL)
+		ptlrpc_request_cache_free(req);
+}
+
+static void ptlrpc_server_req_pool_purge(struct ptlrpc_service_part *svcpt)
+{
+	struct ptlrpc_request *req;
+
+	while (!cfs_list_empty(&svcpt->scp_req_idle)) {
+		req = cfs_list_entry(svcpt->scp_req_idle.next,
+				     struct ptlrpc_request, rq_list);
+		cfs_list_del(&req->rq_list);
+		svcpt->scp_nreqs_idle--;
+		ptlrpc_request_cache_free(req);
+	}
+	LASSERT(svcpt->scp_nreqs_idle == 0);
+}
+
+/**
+ * Number of posted request buffers needed to absorb the current arrival
+ * rate, at least \a srv_nbuf_per_group / 2.
+ */
+static int ptlrpc_rqbd_low_water(struct ptlrpc_service_part *svcpt)
+{
+	struct ptlrpc_service	*svc = svcpt->scp_service;
+	int			reqs_per_buf;
+	int			want;
+
+	reqs_per_buf = max(svc->srv_buf_size / svc->srv_max_req_size, 1);
+	want = svcpt->scp_req_rate / PTLRPC_REQ_RATE_DIV / reqs_per_buf;
+	want = min(want, PTLRPC_RQBD_GROUPS_MAX * svc->srv_nbuf_per_group);
+
+	return max(want, svc->srv_nbuf_per_group / 2);
+}
+
 int
 ptlrpc_grow_req_bufs(struct ptlrpc_service_part *svcpt, int post)
 {
 	struct ptlrpc_service		  *svc = svcpt->scp_service;
         struct ptlrpc_request_buffer_desc *rqbd;
         int                                rc = 0;
+	int				   target;
         int                                i;
 
 	if (svcpt->scp_rqbd_allocating)
@@ -142,11 +237,13 @@ ptlrpc_grow_req_bufs(struct ptlrpc_service_part *svcpt, int post)
 	svcpt->scp_rqbd_allocating++;
 	spin_unlock(&svcpt->scp_lock);
 
-
-        for (i = 0; i < svc->srv_nbuf_per_group; i++) {
+	/* grow to twice the low watermark, i.e. one group when idle */
+	target = max(2 * ptlrpc_rqbd_low_water(svcpt),
+		     svc->srv_nbuf_per_group);
+	for (i = 0; i < target; i++) {
                 /* NB: another thread might have recycled enough rqbds, we
 		 * need to make sure it wouldn't over-allocate, see LU-1212. */
-		if (svcpt->scp_nrqbds_posted >= svc->srv_nbuf_per_group)
+		if (svcpt->scp_nrqbds_posted >= target)
 			break;
 
 		rqbd = ptlrpc_alloc_rqbd(svcpt);
@@ -214,6 +311,10 @@ struct ptlrpc_hr_thread {
 	wait_queue_head_t		hrt_waitq;
 	cfs_list_t			hrt_queue;	/* RS queue */
 	struct ptlrpc_hr_partition	*hrt_partition;
+	/* # replies handled, and # of wakeups it took, only written by
+	 * the thread itself */
+	unsigned long			hrt_handled;
+	unsigned long			hrt_wakeups;
 };
 
 struct ptlrpc_hr_partition {
@@ -314,6 +415,9 @@ static void rs_batch_dispatch(struct rs_batch *b)
 		spin_unlock(&hrt->hrt_lock);
 
 		wake_up(&hrt->hrt_waitq);
+		/* rsb_svcpt->scp_rep_lock is held */
+		b->rsb_svcpt->scp_rep_commit_replies += b->rsb_n_replies;
+		b->rsb_svcpt->scp_rep_commit_batches++;
 		b->rsb_n_replies = 0;
 	}
 }
@@ -496,11 +600,9 @@ ptlrpc_server_post_idle_rqbds(struct ptlrpc_service_part *svcpt)
 	return -1;
 }
 
-static void ptlrpc_at_timer(unsigned long castmeharder)
+static void ptlrpc_at_timer(cfs_wheel_t *wheel)
 {
-	struct ptlrpc_service_part *svcpt;
-
-	svcpt = (struct ptlrpc_service_part *)castmeharder;
+	struct ptlrpc_service_part *svcpt = wheel->cw_private;
 
 	svcpt->scp_at_check = 1;
 	svcpt->scp_at_checktime = cfs_time_current();
@@ -618,9 +720,6 @@ static int
 ptlrpc_service_part_init(struct ptlrpc_service *svc,
 			 struct ptlrpc_service_part *svcpt, int cpt)
 {
-	struct ptlrpc_at_array	*array;
-	int			size;
-	int			index;
 	int			rc;
 
 	svcpt->scp_cpt = cpt;
@@ -631,6 +730,8 @@ ptlrpc_service_part_init(struct ptlrpc_service *svc,
 	CFS_INIT_LIST_HEAD(&svcpt->scp_rqbd_idle);
 	CFS_INIT_LIST_HEAD(&svcpt->scp_rqbd_posted);
 	CFS_INIT_LIST_HEAD(&svcpt->scp_req_incoming);
+	CFS_INIT_LIST_HEAD(&svcpt->scp_req_idle);
+	svcpt->scp_req_rate_time = cfs_time_current();
 	init_waitqueue_head(&svcpt->scp_waitq);
 	/* history request & rqbd list */
 	CFS_INIT_LIST_HEAD(&svcpt->scp_hist_reqs);
@@ -648,31 +749,11 @@ ptlrpc_service_part_init(struct ptlrpc_service *svc,
 	CFS_INIT_LIST_HEAD(&svcpt->scp_rep_idle);
 	init_waitqueue_head(&svcpt->scp_rep_waitq);
 	cfs_atomic_set(&svcpt->scp_nreps_difficult, 0);
+	CFS_INIT_LIST_HEAD(&svcpt->scp_rep_cache);
 
 	/* adaptive timeout */
 	spin_lock_init(&svcpt->scp_at_lock);
-	array = &svcpt->scp_at_array;
-
-	size = at_est2timeout(at_max);
-	array->paa_size     = size;
-	array->paa_count    = 0;
-	array->paa_deadline = -1;
-
-	/* allocate memory for scp_at_array (ptlrpc_at_array) */
-	OBD_CPT_ALLOC(array->paa_reqs_array,
-		      svc->srv_cptable, cpt, sizeof(cfs_list_t) * size);
-	if (array->paa_reqs_array == NULL)
-		return -ENOMEM;
-
-	for (index = 0; index < size; index++)
-		CFS_INIT_LIST_HEAD(&array->paa_reqs_array[index]);
-
-	OBD_CPT_ALLOC(array->paa_reqs_count,
-		      svc->srv_cptable, cpt, sizeof(__u32) * size);
-	if (array->paa_reqs_count == NULL)
-		goto failed;
-
-	cfs_timer_init(&svcpt->scp_at_timer, ptlrpc_at_timer, svcpt);
+	cfs_wheel_init(&svcpt->scp_at_wheel, ptlrpc_at_timer, svcpt);
 	/* At SOW, service time should be quick; 10s seems generous. If client
 	 * timeout is less than this, we'll be sending an early reply. */
 	at_init(&svcpt->scp_at_estimate, 10, 0);
@@ -684,23 +765,9 @@ ptlrpc_service_part_init(struct ptlrpc_service *svc,
 	/* We shouldn't be under memory pressure at startup, so
 	 * fail if we can't allocate all our buffers at this time. */
 	if (rc != 0)
-		goto failed;
+		return -ENOMEM;
 
 	return 0;
-
- failed:
-	if (array->paa_reqs_count != NULL) {
-		OBD_FREE(array->paa_reqs_count, sizeof(__u32) * size);
-		array->paa_reqs_count = NULL;
-	}
-
-	if (array->paa_reqs_array != NULL) {
-		OBD_FREE(array->paa_reqs_array,
-			 sizeof(cfs_list_t) * array->paa_size);
-		array->paa_reqs_array = NULL;
-	}
-
-	return -ENOMEM;
 }
 
 /**
@@ -800,6 +867,7 @@ ptlrpc_register_service(struct ptlrpc_service_conf *conf,
 	service->srv_thread_name	= conf->psc_thr.tc_thr_name;
 	service->srv_ctx_tags		= conf->psc_thr.tc_ctx_tags;
 	service->srv_hpreq_ratio	= PTLRPC_SVC_HP_RATIO;
+	service->srv_thr_idle_timeout	= PTLRPC_THR_IDLE_TIMEOUT;
 	service->srv_ops		= conf->psc_ops;
 
 	for (i = 0; i < ncpts; i++) {
@@ -872,7 +940,7 @@ static void ptlrpc_server_free_request(struct ptlrpc_request *req)
 		/* NB request buffers use an embedded
 		 * req if the incoming req unlinked the
 		 * MD; this isn't one of them! */
-		ptlrpc_request_cache_free(req);
+		ptlrpc_server_req_free(req->rq_rqbd->rqbd_svcpt, req);
 	}
 }
 
@@ -1029,6 +1097,23 @@ static void ptlrpc_server_finish_request(struct ptlrpc_service_part *svcpt,
  * to finish a active request: stop sending more early replies, and release
  * the request. should be called after we finished handling the request.
  */
+/**
+ * Account the time a service thread spent on a request, the thread
+ * controller sizes the thread pool from the percentiles of these.
+ */
+static void ptlrpc_svc_time_tally(struct ptlrpc_service_part *svcpt,
+				  long usec)
+{
+	int	bucket = 0;
+
+	for (; usec > 1 && bucket < PTLRPC_SVC_TIME_BUCKETS - 1; usec >>= 1)
+		bucket++;
+
+	spin_lock(&svcpt->scp_req_lock);
+	svcpt->scp_svc_time_hist[bucket]++;
+	spin_unlock(&svcpt->scp_req_lock);
+}
+
 static void ptlrpc_server_finish_active_request(
 					struct ptlrpc_service_part *svcpt,
 					struct ptlrpc_request *req)
@@ -1053,7 +1138,7 @@ static void ptlrpc_server_finish_active_request(
  * This function is only called when some export receives a message (i.e.,
  * the network is up.)
  */
-static void ptlrpc_update_export_timer(struct obd_export *exp, long extra_delay)
+void ptlrpc_update_export_timer(struct obd_export *exp, long extra_delay)
 {
         struct obd_export *oldest_exp;
         time_t oldest_time, new_time;
@@ -1131,6 +1216,7 @@ static void ptlrpc_update_export_timer(struct obd_export *exp, long extra_delay)
 
         EXIT;
 }
+EXPORT_SYMBOL(ptlrpc_update_export_timer);
 
 /**
  * Sanity check request \a req.
@@ -1178,78 +1264,29 @@ static int ptlrpc_check_req(struct ptlrpc_request *req)
         return rc;
 }
 
-static void ptlrpc_at_set_timer(struct ptlrpc_service_part *svcpt)
-{
-	struct ptlrpc_at_array *array = &svcpt->scp_at_array;
-	__s32 next;
-
-	if (array->paa_count == 0) {
-		cfs_timer_disarm(&svcpt->scp_at_timer);
-		return;
-	}
-
-	/* Set timer for closest deadline */
-	next = (__s32)(array->paa_deadline - cfs_time_current_sec() -
-		       at_early_margin);
-	if (next <= 0) {
-		ptlrpc_at_timer((unsigned long)svcpt);
-	} else {
-		cfs_timer_arm(&svcpt->scp_at_timer, cfs_time_shift(next));
-		CDEBUG(D_INFO, "armed %s at %+ds\n",
-		       svcpt->scp_service->srv_name, next);
-	}
-}
-
 /* Add rpc to early reply check list */
 static int ptlrpc_at_add_timed(struct ptlrpc_request *req)
 {
 	struct ptlrpc_service_part *svcpt = req->rq_rqbd->rqbd_svcpt;
-	struct ptlrpc_at_array *array = &svcpt->scp_at_array;
-        struct ptlrpc_request *rq = NULL;
-        __u32 index;
 
-        if (AT_OFF)
-                return(0);
+	if (AT_OFF)
+		return(0);
 
-        if (req->rq_no_reply)
-                return 0;
+	if (req->rq_no_reply)
+		return 0;
 
-        if ((lustre_msghdr_get_flags(req->rq_reqmsg) & MSGHDR_AT_SUPPORT) == 0)
-                return(-ENOSYS);
+	if ((lustre_msghdr_get_flags(req->rq_reqmsg) & MSGHDR_AT_SUPPORT) == 0)
+		return(-ENOSYS);
 
 	spin_lock(&svcpt->scp_at_lock);
-        LASSERT(cfs_list_empty(&req->rq_timed_list));
-
-        index = (unsigned long)req->rq_deadline % array->paa_size;
-        if (array->paa_reqs_count[index] > 0) {
-                /* latest rpcs will have the latest deadlines in the list,
-                 * so search backward. */
-                cfs_list_for_each_entry_reverse(rq,
-                                                &array->paa_reqs_array[index],
-                                                rq_timed_list) {
-                        if (req->rq_deadline >= rq->rq_deadline) {
-                                cfs_list_add(&req->rq_timed_list,
-                                             &rq->rq_timed_list);
-                                break;
-                        }
-                }
-        }
-
-        /* Add the request at the head of the list */
-        if (cfs_list_empty(&req->rq_timed_list))
-                cfs_list_add(&req->rq_timed_list,
-                             &array->paa_reqs_array[index]);
+	/* the wheel fires at_early_margin ahead of the deadline, which is
+	 * when an early reply has to be sent */
+	cfs_wheel_add(&svcpt->scp_at_wheel, &req->rq_timed_node,
+		      req->rq_deadline - at_early_margin);
 
 	spin_lock(&req->rq_lock);
 	req->rq_at_linked = 1;
 	spin_unlock(&req->rq_lock);
-	req->rq_at_index = index;
-	array->paa_reqs_count[index]++;
-	array->paa_count++;
-	if (array->paa_count == 1 || array->paa_deadline > req->rq_deadline) {
-		array->paa_deadline = req->rq_deadline;
-		ptlrpc_at_set_timer(svcpt);
-	}
 	spin_unlock(&svcpt->scp_at_lock);
 
 	return 0;
@@ -1258,20 +1295,14 @@ static int ptlrpc_at_add_timed(struct ptlrpc_request *req)
 static void
 ptlrpc_at_remove_timed(struct ptlrpc_request *req)
 {
-	struct ptlrpc_at_array *array;
-
-	array = &req->rq_rqbd->rqbd_svcpt->scp_at_array;
+	struct ptlrpc_service_part *svcpt = req->rq_rqbd->rqbd_svcpt;
 
 	/* NB: must call with hold svcpt::scp_at_lock */
-	LASSERT(!cfs_list_empty(&req->rq_timed_list));
-	cfs_list_del_init(&req->rq_timed_list);
+	cfs_wheel_del(&svcpt->scp_at_wheel, &req->rq_timed_node);
 
 	spin_lock(&req->rq_lock);
 	req->rq_at_linked = 0;
 	spin_unlock(&req->rq_lock);
-
-	array->paa_reqs_count[req->rq_at_index]--;
-	array->paa_count--;
 }
 
 static int ptlrpc_at_send_early_reply(struct ptlrpc_request *req)
@@ -1413,15 +1444,13 @@ out_free:
    asking for at_extra time */
 static int ptlrpc_at_check_timed(struct ptlrpc_service_part *svcpt)
 {
-	struct ptlrpc_at_array *array = &svcpt->scp_at_array;
-        struct ptlrpc_request *rq, *n;
-        cfs_list_t work_list;
-        __u32  index, count;
-        time_t deadline;
-        time_t now = cfs_time_current_sec();
-        cfs_duration_t delay;
-        int first, counter = 0;
-        ENTRY;
+	struct ptlrpc_request *rq;
+	cfs_list_t expired;
+	cfs_list_t work_list;
+	time_t now = cfs_time_current_sec();
+	cfs_duration_t delay;
+	int first = 0, counter = 0;
+	ENTRY;
 
 	spin_lock(&svcpt->scp_at_lock);
 	if (svcpt->scp_at_check == 0) {
@@ -1431,56 +1460,39 @@ static int ptlrpc_at_check_timed(struct ptlrpc_service_part *svcpt)
 	delay = cfs_time_sub(cfs_time_current(), svcpt->scp_at_checktime);
 	svcpt->scp_at_check = 0;
 
-	if (array->paa_count == 0) {
+	/* We're close to a timeout, and we don't know how much longer the
+	   server will take. Send early replies to everyone expiring soon,
+	   the wheel hands them all out at once and restarts its timer for
+	   the next earliest deadline. */
+	CFS_INIT_LIST_HEAD(&expired);
+	CFS_INIT_LIST_HEAD(&work_list);
+	if (cfs_wheel_expire(&svcpt->scp_at_wheel, now, &expired) == 0) {
+		/* The timer went off, but the nearest rpc already
+		 * completed. */
 		spin_unlock(&svcpt->scp_at_lock);
 		RETURN(0);
 	}
 
-	/* The timer went off, but maybe the nearest rpc already completed. */
-	first = array->paa_deadline - now;
-	if (first > at_early_margin) {
-		/* We've still got plenty of time.  Reset the timer. */
-		ptlrpc_at_set_timer(svcpt);
-		spin_unlock(&svcpt->scp_at_lock);
-		RETURN(0);
-	}
+	while (!cfs_list_empty(&expired)) {
+		rq = cfs_list_entry(expired.next, struct ptlrpc_request,
+				    rq_timed_list);
+		cfs_list_del_init(&rq->rq_timed_list);
 
-        /* We're close to a timeout, and we don't know how much longer the
-           server will take. Send early replies to everyone expiring soon. */
-        CFS_INIT_LIST_HEAD(&work_list);
-        deadline = -1;
-        index = (unsigned long)array->paa_deadline % array->paa_size;
-        count = array->paa_count;
-        while (count > 0) {
-                count -= array->paa_reqs_count[index];
-                cfs_list_for_each_entry_safe(rq, n,
-                                             &array->paa_reqs_array[index],
-                                             rq_timed_list) {
-			if (rq->rq_deadline > now + at_early_margin) {
-				/* update the earliest deadline */
-				if (deadline == -1 ||
-				    rq->rq_deadline < deadline)
-					deadline = rq->rq_deadline;
-				break;
-			}
+		spin_lock(&rq->rq_lock);
+		rq->rq_at_linked = 0;
+		spin_unlock(&rq->rq_lock);
 
-			ptlrpc_at_remove_timed(rq);
-			/**
-			 * ptlrpc_server_drop_request() may drop
-			 * refcount to 0 already. Let's check this and
-			 * don't add entry to work_list
-			 */
-			if (likely(cfs_atomic_inc_not_zero(&rq->rq_refcount)))
-				cfs_list_add(&rq->rq_timed_list, &work_list);
-			counter++;
-                }
-
-                if (++index >= array->paa_size)
-                        index = 0;
-        }
-        array->paa_deadline = deadline;
-	/* we have a new earliest deadline, restart the timer */
-	ptlrpc_at_set_timer(svcpt);
+		if (counter == 0 || rq->rq_deadline - now < first)
+			first = rq->rq_deadline - now;
+		/**
+		 * ptlrpc_server_drop_request() may drop
+		 * refcount to 0 already. Let's check this and
+		 * don't add entry to work_list
+		 */
+		if (likely(cfs_atomic_inc_not_zero(&rq->rq_refcount)))
+			cfs_list_add(&rq->rq_timed_list, &work_list);
+		counter++;
+	}
 
 	spin_unlock(&svcpt->scp_at_lock);
 
@@ -2033,6 +2045,7 @@ put_conn:
 
 	do_gettimeofday(&work_end);
 	timediff = cfs_timeval_sub(&work_end, &work_start, NULL);
+	ptlrpc_svc_time_tally(svcpt, timediff);
 	CDEBUG(D_RPCTRACE, "Handled RPC pname:cluuid+ref:pid:xid:nid:opc "
 	       "%s:%s+%d:%d:x"LPU64":%s:%d Request procesed in "
 	       "%ldus (%ldus total) trans "LPU64" rc %d/%d\n",
@@ -2080,9 +2093,13 @@ out_req:
 
 /**
  * An internal function to process a single reply state object.
+ *
+ * If this drops the last reference on \a rs, it is queued on \a freed for
+ * the caller to free along with others, or freed right away if \a freed is
+ * NULL.
  */
 static int
-ptlrpc_handle_rs(struct ptlrpc_reply_state *rs)
+ptlrpc_handle_rs(struct ptlrpc_reply_state *rs, cfs_list_t *freed)
 {
 	struct ptlrpc_service_part *svcpt = rs->rs_svcpt;
 	struct ptlrpc_service     *svc = svcpt->scp_service;
@@ -2171,7 +2188,13 @@ ptlrpc_handle_rs(struct ptlrpc_reply_state *rs)
 
                 class_export_put (exp);
                 rs->rs_export = NULL;
-                ptlrpc_rs_decref (rs);
+		if (freed == NULL) {
+			ptlrpc_rs_decref(rs);
+		} else {
+			LASSERT(cfs_atomic_read(&rs->rs_refcount) > 0);
+			if (cfs_atomic_dec_and_test(&rs->rs_refcount))
+				cfs_list_add_tail(&rs->rs_list, freed);
+		}
 		if (cfs_atomic_dec_and_test(&svcpt->scp_nreps_difficult) &&
 		    svc->srv_is_stopping)
 			wake_up_all(&svcpt->scp_waitq);
@@ -2208,7 +2231,7 @@ ptlrpc_server_handle_reply(struct ptlrpc_service_part *svcpt)
 	}
 	spin_unlock(&svcpt->scp_rep_lock);
 	if (rs != NULL)
-		ptlrpc_handle_rs(rs);
+		ptlrpc_handle_rs(rs, NULL);
 	RETURN(rs != NULL);
 }
 
@@ -2259,12 +2282,51 @@ liblustre_check_services (void *arg)
 
 #else /* __KERNEL__ */
 
+/**
+ * Top up the request descriptor pool from a service thread, so the
+ * descriptors are allocated in process context, where the allocation may
+ * sleep and reclaim memory, and on the local CPT.
+ */
+static void ptlrpc_server_req_pool_fill(struct ptlrpc_service_part *svcpt)
+{
+	struct ptlrpc_service	*svc = svcpt->scp_service;
+	struct ptlrpc_request	*req;
+	CFS_LIST_HEAD		(reqs);
+	int			target = ptlrpc_req_pool_target(svcpt);
+	int			nr;
+
+	/* NB I'm not locking; just looking. */
+	if (svcpt->scp_nreqs_idle >= target / 2)
+		return;
+
+	for (nr = 0; nr < PTLRPC_REQ_POOL_BATCH &&
+		     svcpt->scp_nreqs_idle + nr < target; nr++) {
+		req = ptlrpc_request_cache_cpt_alloc(svc->srv_cptable,
+						     svcpt->scp_cpt, GFP_NOFS);
+		if (req == NULL)
+			break;
+		cfs_list_add(&req->rq_list, &reqs);
+	}
+
+	if (nr == 0)
+		return;
+
+	spin_lock(&svcpt->scp_lock);
+	cfs_list_splice(&reqs, &svcpt->scp_req_idle);
+	svcpt->scp_nreqs_idle += nr;
+	spin_unlock(&svcpt->scp_lock);
+}
+
 static void
 ptlrpc_check_rqbd_pool(struct ptlrpc_service_part *svcpt)
 {
-	int avail = svcpt->scp_nrqbds_posted;
-	int low_water = test_req_buffer_pressure ? 0 :
-			svcpt->scp_service->srv_nbuf_per_group / 2;
+	int	avail = svcpt->scp_nrqbds_posted;
+	int	low_water;
+
+	low_water = test_req_buffer_pressure ? 0 :
+		    ptlrpc_rqbd_low_water(svcpt);
+
+	ptlrpc_server_req_pool_fill(svcpt);
 
         /* NB I'm not locking; just looking. */
 
@@ -2282,6 +2344,70 @@ ptlrpc_check_rqbd_pool(struct ptlrpc_service_part *svcpt)
 	}
 }
 
+/**
+ * Sample the load of a service partition about once a second: the request
+ * arrival rate, and the 90th percentile of the service time since the last
+ * sample.  By Little's law, rate * service time is the number of requests
+ * in service on average, so that many threads plus the spare ones
+ * ptlrpc_threads_enough() wants are started ahead of the load, and threads
+ * above it are allowed to be reaped when idle.
+ */
+static void
+ptlrpc_svcpt_sample_load(struct ptlrpc_service_part *svcpt)
+{
+	struct ptlrpc_service	*svc = svcpt->scp_service;
+	cfs_time_t		now = cfs_time_current();
+	cfs_duration_t		elapsed;
+	unsigned int		total = 0;
+	unsigned int		sum = 0;
+	unsigned int		p90 = 0;
+	__u64			busy;
+	int			want;
+	int			i;
+
+	/* NB I'm not locking; just looking. */
+	elapsed = cfs_time_sub(now, svcpt->scp_req_rate_time);
+	if (elapsed < cfs_time_seconds(1))
+		return;
+
+	spin_lock(&svcpt->scp_lock);
+	/* check again with lock, another thread may have sampled */
+	elapsed = cfs_time_sub(now, svcpt->scp_req_rate_time);
+	if (elapsed < cfs_time_seconds(1)) {
+		spin_unlock(&svcpt->scp_lock);
+		return;
+	}
+	svcpt->scp_req_rate = svcpt->scp_nreqs_arrived /
+			      cfs_duration_sec(elapsed);
+	svcpt->scp_nreqs_arrived = 0;
+	svcpt->scp_req_rate_time = now;
+	spin_unlock(&svcpt->scp_lock);
+
+	spin_lock(&svcpt->scp_req_lock);
+	for (i = 0; i < PTLRPC_SVC_TIME_BUCKETS; i++)
+		total += svcpt->scp_svc_time_hist[i];
+
+	for (i = 0; i < PTLRPC_SVC_TIME_BUCKETS && total > 0; i++) {
+		sum += svcpt->scp_svc_time_hist[i];
+		if (sum * 10 >= total * 9) {
+			/* upper bound of the bucket */
+			p90 = 2 << i;
+			break;
+		}
+	}
+	memset(svcpt->scp_svc_time_hist, 0, sizeof(svcpt->scp_svc_time_hist));
+	spin_unlock(&svcpt->scp_req_lock);
+
+	svcpt->scp_svc_time_p90 = p90;
+
+	busy = (__u64)svcpt->scp_req_rate * p90 + ONE_MILLION - 1;
+	do_div(busy, ONE_MILLION);
+	want = min_t(__u64, busy, svc->srv_nthrs_cpt_limit);
+	want += 1 + (svc->srv_ops.so_hpreq_handler != NULL);
+	svcpt->scp_nthrs_want = min(max(want, svc->srv_nthrs_cpt_init),
+				    svc->srv_nthrs_cpt_limit);
+}
+
 static int
 ptlrpc_retry_rqbds(void *arg)
 {
@@ -2313,19 +2439,97 @@ ptlrpc_threads_increasable(struct ptlrpc_service_part *svcpt)
 }
 
 /**
- * too many requests and allowed to create more threads
+ * fewer threads than the predicted load needs
+ */
+static inline int
+ptlrpc_threads_wanted(struct ptlrpc_service_part *svcpt)
+{
+	return svcpt->scp_nthrs_running + svcpt->scp_nthrs_starting <
+	       svcpt->scp_nthrs_want;
+}
+
+/**
+ * too many requests or predicted load, and allowed to create more threads
  */
 static inline int
 ptlrpc_threads_need_create(struct ptlrpc_service_part *svcpt)
 {
-	return !ptlrpc_threads_enough(svcpt) &&
+	return (!ptlrpc_threads_enough(svcpt) ||
+		ptlrpc_threads_wanted(svcpt)) &&
 		ptlrpc_threads_increasable(svcpt);
 }
 
+/**
+ * more threads than the load needs, and no thread is starting or being
+ * reaped.  Caller must hold ptlrpc_service_part::scp_lock.
+ */
+static inline int
+ptlrpc_threads_reapable(struct ptlrpc_service_part *svcpt)
+{
+	struct ptlrpc_service *svc = svcpt->scp_service;
+
+	if (svc->srv_is_stopping || svc->srv_thr_idle_timeout == 0)
+		return 0;
+
+	if (svcpt->scp_nthrs_starting != 0 || svcpt->scp_nthrs_stopping != 0)
+		return 0;
+
+	if (svcpt->scp_nthrs_running <= svc->srv_nthrs_cpt_init ||
+	    !ptlrpc_threads_enough(svcpt))
+		return 0;
+
+	return svcpt->scp_nthrs_running > svcpt->scp_nthrs_want ||
+	       svcpt->scp_nthrs_running > svc->srv_nthrs_cpt_limit;
+}
+
+/**
+ * Called by a thread that has been idle for srv_thr_idle_timeout. Marks
+ * the running thread with the highest id for reaping, so that thread ids
+ * stay contiguous, and returns 1 if that is the caller.
+ */
+static int
+ptlrpc_thread_reap(struct ptlrpc_service_part *svcpt,
+		   struct ptlrpc_thread *thread)
+{
+	struct ptlrpc_thread	*victim = NULL;
+	struct ptlrpc_thread	*tmp;
+
+	spin_lock(&svcpt->scp_lock);
+	if (!ptlrpc_threads_reapable(svcpt)) {
+		spin_unlock(&svcpt->scp_lock);
+		return 0;
+	}
+
+	/* new threads are added at the head of the list */
+	list_for_each_entry(tmp, &svcpt->scp_threads, t_link) {
+		if (thread_is_running(tmp) && !thread_is_stopping(tmp)) {
+			victim = tmp;
+			break;
+		}
+	}
+
+	if (victim == NULL) {
+		spin_unlock(&svcpt->scp_lock);
+		return 0;
+	}
+
+	CDEBUG(D_RPCTRACE, "%s: reaping idle thread %s\n",
+	       svcpt->scp_service->srv_name, victim->t_name);
+	thread_add_flags(victim, SVC_REAPING);
+	svcpt->scp_nthrs_stopping++;
+	spin_unlock(&svcpt->scp_lock);
+
+	if (victim == thread)
+		return 1;
+
+	wake_up_all(&svcpt->scp_waitq);
+	return 0;
+}
+
 static inline int
 ptlrpc_thread_stopping(struct ptlrpc_thread *thread)
 {
-	return thread_is_stopping(thread) ||
+	return thread_is_stopping(thread) || thread_is_reaping(thread) ||
 	       thread->t_svcpt->scp_service->srv_is_stopping;
 }
 
@@ -2357,15 +2561,28 @@ static __attribute__((__noinline__)) int
 ptlrpc_wait_event(struct ptlrpc_service_part *svcpt,
 		  struct ptlrpc_thread *thread)
 {
+	struct ptlrpc_service *svc = svcpt->scp_service;
 	/* Don't exit while there are replies to be handled */
 	struct l_wait_info lwi = LWI_TIMEOUT(svcpt->scp_rqbd_timeout,
 					     ptlrpc_retry_rqbds, svcpt);
+	int idle = 0;
+	int rc;
+
+	/* Threads above the minimum wake up once in a while to check
+	 * whether they are still needed.  The waitq is LIFO, so the threads
+	 * which time out are the ones the load doesn't need. */
+	if (svcpt->scp_rqbd_timeout == 0 && svc->srv_thr_idle_timeout > 0 &&
+	    svcpt->scp_nthrs_running > svc->srv_nthrs_cpt_init) {
+		lwi = LWI_TIMEOUT(cfs_time_seconds(svc->srv_thr_idle_timeout),
+				  NULL, NULL);
+		idle = 1;
+	}
 
 	lc_watchdog_disable(thread->t_watchdog);
 
 	cond_resched();
 
-	l_wait_event_exclusive_head(svcpt->scp_waitq,
+	rc = l_wait_event_exclusive_head(svcpt->scp_waitq,
 				ptlrpc_thread_stopping(thread) ||
 				ptlrpc_server_request_incoming(svcpt) ||
 				ptlrpc_server_request_pending(svcpt, false) ||
@@ -2375,6 +2592,9 @@ ptlrpc_wait_event(struct ptlrpc_service_part *svcpt,
 	if (ptlrpc_thread_stopping(thread))
 		return -EINTR;
 
+	if (idle && rc == -ETIMEDOUT && ptlrpc_thread_reap(svcpt, thread))
+		return -EINTR;
+
 	lc_watchdog_touch(thread->t_watchdog,
 			  ptlrpc_server_get_timeout(svcpt));
 	return 0;
@@ -2495,12 +2715,19 @@ static int ptlrpc_main(void *arg)
 		if (ptlrpc_wait_event(svcpt, thread))
 			break;
 
+		ptlrpc_svcpt_sample_load(svcpt);
 		ptlrpc_check_rqbd_pool(svcpt);
 
 		if (ptlrpc_threads_need_create(svcpt)) {
-			/* Ignore return code - we tried... */
-			ptlrpc_start_thread(svcpt, 0);
-                }
+			int prespawn = ptlrpc_threads_enough(svcpt);
+
+			/* Ignore failures - we tried... */
+			if (ptlrpc_start_thread(svcpt, 0) == 0 && prespawn) {
+				spin_lock(&svcpt->scp_lock);
+				svcpt->scp_nthrs_prespawned++;
+				spin_unlock(&svcpt->scp_lock);
+			}
+		}
 
 		/* Process all incoming reqs before handling any */
 		if (ptlrpc_server_request_incoming(svcpt)) {
@@ -2538,6 +2765,25 @@ static int ptlrpc_main(void *arg)
         lc_watchdog_delete(thread->t_watchdog);
         thread->t_watchdog = NULL;
 
+	if (thread_is_reaping(thread)) {
+		/* drop the reply state this thread added to the pool, or
+		 * the next one to come back if they are all in use */
+		rs = NULL;
+		spin_lock(&svcpt->scp_rep_lock);
+		if (!cfs_list_empty(&svcpt->scp_rep_idle)) {
+			rs = cfs_list_entry(svcpt->scp_rep_idle.next,
+					    struct ptlrpc_reply_state,
+					    rs_list);
+			cfs_list_del(&rs->rs_list);
+		} else {
+			svcpt->scp_rep_idle_excess++;
+		}
+		spin_unlock(&svcpt->scp_rep_lock);
+
+		if (rs != NULL)
+			OBD_FREE_LARGE(rs, svc->srv_max_reply_size);
+	}
+
 out_srv_fini:
         /*
          * deconstruct service specific state created by ptlrpc_start_thread()
@@ -2562,6 +2808,24 @@ out:
 		svcpt->scp_nthrs_running--;
 	}
 
+	if (thread_test_and_clear_flags(thread, SVC_REAPING)) {
+		svcpt->scp_nthrs_stopping--;
+		/* unless ptlrpc_svcpt_stop_threads() is already waiting for
+		 * us, nobody else references this thread */
+		if (!thread_is_stopping(thread)) {
+			svcpt->scp_nthrs_reaped++;
+			if (thread->t_id == svcpt->scp_thr_nextid - 1)
+				svcpt->scp_thr_nextid--;
+			cfs_list_del(&thread->t_link);
+			spin_unlock(&svcpt->scp_lock);
+
+			CDEBUG(D_RPCTRACE, "%s: idle thread %s reaped\n",
+			       svc->srv_name, thread->t_name);
+			OBD_FREE_PTR(thread);
+			return rc;
+		}
+	}
+
 	thread->t_id = rc;
 	thread_add_flags(thread, SVC_STOPPED);
 
@@ -2594,6 +2858,7 @@ static int ptlrpc_hr_main(void *arg)
 	struct ptlrpc_hr_thread		*hrt = (struct ptlrpc_hr_thread *)arg;
 	struct ptlrpc_hr_partition	*hrp = hrt->hrt_partition;
 	CFS_LIST_HEAD			(replies);
+	CFS_LIST_HEAD			(freed);
 	char				threadname[20];
 	int				rc;
 
@@ -2612,6 +2877,7 @@ static int ptlrpc_hr_main(void *arg)
 
 	while (!ptlrpc_hr.hr_stopping) {
 		l_wait_condition(hrt->hrt_waitq, hrt_dont_sleep(hrt, &replies));
+		hrt->hrt_wakeups++;
 
                 while (!cfs_list_empty(&replies)) {
                         struct ptlrpc_reply_state *rs;
@@ -2620,8 +2886,11 @@ static int ptlrpc_hr_main(void *arg)
                                             struct ptlrpc_reply_state,
                                             rs_list);
                         cfs_list_del_init(&rs->rs_list);
-                        ptlrpc_handle_rs(rs);
+			ptlrpc_handle_rs(rs, &freed);
+			hrt->hrt_handled++;
                 }
+		/* a commit usually frees a whole batch at once */
+		lustre_free_reply_states(&freed);
         }
 
 	cfs_atomic_inc(&hrp->hrp_nstopped);
@@ -2964,6 +3233,34 @@ void ptlrpc_hr_fini(void)
 	ptlrpc_hr.hr_partitions = NULL;
 }
 
+/**
+ * Sum up the statistics of the reply handling threads serving partition
+ * \a cpt of \a cptab, or of all of them if the table is not the one of the
+ * HR threads or \a cpt is CFS_CPT_ANY.
+ */
+void ptlrpc_hr_stats(struct cfs_cpt_table *cptab, int cpt,
+		     unsigned long *handled, unsigned long *wakeups)
+{
+	struct ptlrpc_hr_partition	*hrp;
+	int				i;
+	int				j;
+
+	*handled = 0;
+	*wakeups = 0;
+	if (ptlrpc_hr.hr_partitions == NULL)
+		return;
+
+	cfs_percpt_for_each(hrp, i, ptlrpc_hr.hr_partitions) {
+		if (cptab == ptlrpc_hr.hr_cpt_table && cpt >= 0 && cpt != i)
+			continue;
+
+		for (j = 0; j < hrp->hrp_nthrs; j++) {
+			*handled += hrp->hrp_thrs[j].hrt_handled;
+			*wakeups += hrp->hrp_thrs[j].hrt_wakeups;
+		}
+	}
+}
+
 #endif /* __KERNEL__ */
 
 /**
@@ -2994,7 +3291,7 @@ ptlrpc_service_del_atimer(struct ptlrpc_service *svc)
 	/* early disarm AT timer... */
 	ptlrpc_service_for_each_part(svcpt, i, svc) {
 		if (svcpt->scp_service != NULL)
-			cfs_timer_disarm(&svcpt->scp_at_timer);
+			cfs_wheel_stop(&svcpt->scp_at_wheel);
 	}
 }
 
@@ -3112,6 +3409,7 @@ ptlrpc_service_purge_all(struct ptlrpc_service *svc)
 			ptlrpc_free_rqbd(rqbd);
 		}
 		ptlrpc_wait_replies(svcpt);
+		ptlrpc_server_req_pool_purge(svcpt);
 
 		while (!cfs_list_empty(&svcpt->scp_rep_idle)) {
 			rs = cfs_list_entry(svcpt->scp_rep_idle.next,
@@ -3120,6 +3418,7 @@ ptlrpc_service_purge_all(struct ptlrpc_service *svc)
 			cfs_list_del(&rs->rs_list);
 			OBD_FREE_LARGE(rs, svc->srv_max_reply_size);
 		}
+		lustre_purge_cached_rs(svcpt);
 	}
 }
 
@@ -3127,7 +3426,6 @@ static void
 ptlrpc_service_free(struct ptlrpc_service *svc)
 {
 	struct ptlrpc_service_part	*svcpt;
-	struct ptlrpc_at_array		*array;
 	int				i;
 
 	ptlrpc_service_for_each_part(svcpt, i, svc) {
@@ -3135,20 +3433,7 @@ ptlrpc_service_free(struct ptlrpc_service *svc)
 			break;
 
 		/* In case somebody rearmed this in the meantime */
-		cfs_timer_disarm(&svcpt->scp_at_timer);
-		array = &svcpt->scp_at_array;
-
-		if (array->paa_reqs_array != NULL) {
-			OBD_FREE(array->paa_reqs_array,
-				 sizeof(cfs_list_t) * array->paa_size);
-			array->paa_reqs_array = NULL;
-		}
-
-		if (array->paa_reqs_count != NULL) {
-			OBD_FREE(array->paa_reqs_count,
-				 sizeof(__u32) * array->paa_size);
-			array->paa_reqs_count = NULL;
-		}
+		cfs_wheel_fini(&svcpt->scp_at_wheel);
 	}
 
 	ptlrpc_service_for_each_part(svcpt, i, svc)
@@ -319,4 +319,78 @@ struct file_operations lprocfs_quota_seq_fops = {
 	.llseek		= seq_lseek,
 	.release	= lprocfs_quota_seq_release,
 };
+
+/* allocate the counters of quota requests issued by a slave */
+struct lprocfs_stats *lprocfs_quota_stats_alloc(void)
+{
+	struct lprocfs_stats *stats;
+
+	stats = lprocfs_alloc_stats(LQUOTA_LAST_STAT, LPROCFS_STATS_FLAG_NONE);
+	if (stats == NULL)
+		return NULL;
+
+	lprocfs_counter_init(stats, LQUOTA_DQACQ_STAT, 0, "dqacq", "reqs");
+	lprocfs_counter_init(stats, LQUOTA_DQREL_STAT, 0, "dqrel", "reqs");
+	lprocfs_counter_init(stats, LQUOTA_INTENT_STAT, 0, "intent", "reqs");
+	lprocfs_counter_init(stats, LQUOTA_PREFETCH_STAT,
+			     LPROCFS_CNTR_AVGMINMAX, "prefetch", "units");
+	lprocfs_counter_init(stats, LQUOTA_WB_TRANS_STAT, 0, "wb_trans",
+			     "trans");
+	lprocfs_counter_init(stats, LQUOTA_WB_REC_STAT, 0, "wb_rec", "recs");
+	return stats;
+}
+
+#define pct(a, b) (b ? a * 100 / b : 0)
+
+/* display a log2 histogram of request latencies in milliseconds */
+static int lprocfs_quota_hist_seq_show(struct seq_file *seq, void *v)
+{
+	struct obd_histogram	*oh = seq->private;
+	unsigned long		 tot, cum = 0, cnt;
+	int			 i;
+
+	tot = lprocfs_oh_sum(oh);
+	seq_printf(seq, "%-22s %-5s %% cum %%\n", "latency (ms)", "reqs");
+	for (i = 0; i < OBD_HIST_MAX; i++) {
+		cnt = oh->oh_buckets[i];
+		cum += cnt;
+		if (cum == 0)
+			continue;
+		seq_printf(seq, "%u:\t\t%10lu %3lu %3lu\n", 1 << i, cnt,
+			   pct(cnt, tot), pct(cum, tot));
+		if (cum == tot)
+			break;
+	}
+	return 0;
+}
+
+static int lprocfs_quota_hist_seq_open(struct inode *inode, struct file *file)
+{
+	struct proc_dir_entry *dp = PDE(inode);
+
+	if (LPROCFS_ENTRY_CHECK(dp))
+		return -ENOENT;
+
+	return single_open(file, lprocfs_quota_hist_seq_show, dp->data);
+}
+
+/* any write clears the histogram */
+static ssize_t lprocfs_quota_hist_seq_write(struct file *file,
+					    const char *buffer, size_t len,
+					    loff_t *off)
+{
+	struct seq_file *seq = file->private_data;
+
+	lprocfs_oh_clear(seq->private);
+	return len;
+}
+
+struct file_operations lprocfs_quota_hist_fops = {
+	.owner		= THIS_MODULE,
+	.open		= lprocfs_quota_hist_seq_open,
+	.read		= seq_read,
+	.write		= lprocfs_quota_hist_seq_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
 #endif  /* LPROCFS */
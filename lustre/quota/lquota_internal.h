@@ -89,6 +89,9 @@ struct lquota_mst_entry {
 
 	/* quota space that may be released after glimpse */
 	__u64			lme_may_rel;
+
+	/* when this entry was queued for rebalancing, for latency stats */
+	cfs_time_t		lme_reba_time;
 };
 
 /* Per-ID information specific to the quota slave */
@@ -129,6 +132,18 @@ struct lquota_slv_entry {
 
 	/* when latest acquire RPC completed */
 	__u64			lse_acq_time;
+
+	/* when the in-flight acquire request was issued, for latency stats */
+	cfs_time_t		lse_acq_start;
+
+	/* quota space consumed since lse_rate_time, in inodes or kbytes */
+	__u64			lse_rate_used;
+
+	/* estimated consumption rate, in inodes or kbytes per second */
+	__u64			lse_rate;
+
+	/* start of the current consumption sampling window, in seconds */
+	__u64			lse_rate_time;
 };
 
 /* In-memory entry for each enforced quota id
@@ -195,6 +210,7 @@ struct lquota_site {
 #define lqe_revoke_time		u.me.lme_revoke_time
 #define lqe_sem			u.me.lme_sem
 #define lqe_may_rel		u.me.lme_may_rel
+#define lqe_reba_time		u.me.lme_reba_time
 
 #define lqe_qtune		u.se.lse_qtune
 #define lqe_pending_write	u.se.lse_pending_write
@@ -208,6 +224,10 @@ struct lquota_site {
 #define lqe_lockh		u.se.lse_lockh
 #define lqe_acq_rc		u.se.lse_acq_rc
 #define lqe_acq_time		u.se.lse_acq_time
+#define lqe_acq_start		u.se.lse_acq_start
+#define lqe_rate_used		u.se.lse_rate_used
+#define lqe_rate		u.se.lse_rate
+#define lqe_rate_time		u.se.lse_rate_time
 
 #define LQUOTA_BUMP_VER 0x1
 #define LQUOTA_SET_VER  0x2
@@ -412,6 +432,20 @@ void qmt_glb_fini(void);
 
 /* lproc_quota.c */
 extern struct file_operations lprocfs_quota_seq_fops;
+extern struct file_operations lprocfs_quota_hist_fops;
+
+/* counters of quota requests and index updates issued by a slave */
+enum {
+	LQUOTA_DQACQ_STAT = 0,	/* DQACQ RPCs acquiring space */
+	LQUOTA_DQREL_STAT,	/* DQACQ RPCs releasing space */
+	LQUOTA_INTENT_STAT,	/* per-ID lock enqueues with DQACQ intent */
+	LQUOTA_PREFETCH_STAT,	/* space asked for ahead of demand */
+	LQUOTA_WB_TRANS_STAT,	/* slave index writeback transactions */
+	LQUOTA_WB_REC_STAT,	/* slave index records written back */
+	LQUOTA_LAST_STAT
+};
+
+struct lprocfs_stats *lprocfs_quota_stats_alloc(void);
 
 /* qsd_lib.c */
 int qsd_glb_init(void);
@@ -106,8 +106,11 @@ static struct lu_device *qmt_device_fini(const struct lu_env *env,
 		qmt->qmt_proc = NULL;
 	}
 
-	/* stop rebalance thread */
-	qmt_stop_reba_thread(qmt);
+	/* stop rebalance threads */
+	qmt_stop_reba_threads(qmt);
+
+	if (qmt->qmt_stats != NULL)
+		lprocfs_free_stats(&qmt->qmt_stats);
 
 	/* disconnect from OSD */
 	if (qmt->qmt_child_exp != NULL) {
@@ -202,7 +205,7 @@ static int qmt_device_init0(const struct lu_env *env, struct qmt_device *qmt,
 	struct lu_device	*ld = qmt2lu_dev(qmt);
 	struct obd_device	*obd, *mdt_obd;
 	struct obd_type		*type;
-	int			 rc;
+	int			 rc, i;
 	ENTRY;
 
 	/* record who i am, it might be useful ... */
@@ -234,14 +237,20 @@ static int qmt_device_init0(const struct lu_env *env, struct qmt_device *qmt,
 	if (rc)
 		GOTO(out, rc);
 
-	/* set up and start rebalance thread */
-	thread_set_flags(&qmt->qmt_reba_thread, SVC_STOPPED);
-	init_waitqueue_head(&qmt->qmt_reba_thread.t_ctl_waitq);
-	CFS_INIT_LIST_HEAD(&qmt->qmt_reba_list);
-	spin_lock_init(&qmt->qmt_reba_lock);
-	rc = qmt_start_reba_thread(qmt);
+	/* set up and start rebalance threads */
+	for (i = 0; i < QMT_REBA_THREADS_NR; i++) {
+		struct qmt_reba_thread *qrt = &qmt->qmt_reba[i];
+
+		thread_set_flags(&qrt->qrt_thread, SVC_STOPPED);
+		init_waitqueue_head(&qrt->qrt_thread.t_ctl_waitq);
+		CFS_INIT_LIST_HEAD(&qrt->qrt_urgent_list);
+		CFS_INIT_LIST_HEAD(&qrt->qrt_list);
+		spin_lock_init(&qrt->qrt_lock);
+	}
+	spin_lock_init(&qmt->qmt_reba_hist.oh_lock);
+	rc = qmt_start_reba_threads(qmt);
 	if (rc) {
-		CERROR("%s: failed to start rebalance thread (%d)\n",
+		CERROR("%s: failed to start rebalance threads (%d)\n",
 		       qmt->qmt_svname, rc);
 		GOTO(out, rc);
 	}
@@ -261,6 +270,34 @@ static int qmt_device_init0(const struct lu_env *env, struct qmt_device *qmt,
 		GOTO(out, rc);
 	}
 
+	qmt->qmt_stats = lprocfs_alloc_stats(QMT_LAST_STAT,
+					     LPROCFS_STATS_FLAG_NONE);
+	if (qmt->qmt_stats == NULL)
+		GOTO(out, rc = -ENOMEM);
+	lprocfs_counter_init(qmt->qmt_stats, QMT_REBA_ID_STAT, 0,
+			     "reba_id", "ids");
+	lprocfs_counter_init(qmt->qmt_stats, QMT_REBA_URGENT_STAT, 0,
+			     "reba_urgent", "ids");
+	lprocfs_counter_init(qmt->qmt_stats, QMT_REBA_GLIMPSE_STAT, 0,
+			     "reba_glimpse", "reqs");
+	lprocfs_counter_init(qmt->qmt_stats, QMT_REBA_BATCH_STAT,
+			     LPROCFS_CNTR_AVGMINMAX, "reba_batch", "ids");
+
+	rc = lprocfs_register_stats(qmt->qmt_proc, "stats", qmt->qmt_stats);
+	if (rc) {
+		CERROR("%s: can't add procfs entry for qmt stats (%d)\n",
+		       qmt->qmt_svname, rc);
+		GOTO(out, rc);
+	}
+
+	rc = lprocfs_seq_create(qmt->qmt_proc, "rebalance_latency", 0644,
+				&lprocfs_quota_hist_fops, &qmt->qmt_reba_hist);
+	if (rc) {
+		CERROR("%s: can't add procfs entry for rebalance latency "
+		       "(%d)\n", qmt->qmt_svname, rc);
+		GOTO(out, rc);
+	}
+
 	/* initialize pool configuration */
 	rc = qmt_pool_init(env, qmt);
 	if (rc)
@@ -30,6 +30,50 @@
 
 #include "lquota_internal.h"
 
+/* Number of rebalance threads. IDs are spread across the threads by hashing
+ * the quota identifier, so that glimpses for a given lqe are always issued by
+ * the same thread. */
+#define QMT_REBA_THREADS_NR	4
+
+/* Max number of IDs whose glimpse callbacks are sent together in a single
+ * request set by a rebalance thread */
+#define QMT_REBA_BATCH_MAX	16
+
+/* An ID is considered close to its limit, and thus rebalanced ahead of the
+ * others, when less than this number of qunits is left to grant */
+#define QMT_REBA_URGENT_QUNITS	4
+
+struct qmt_device;
+
+/* A rebalance thread with its own queue of lquota entries */
+struct qmt_reba_thread {
+	struct ptlrpc_thread	 qrt_thread;
+
+	/* back pointer to master target */
+	struct qmt_device	*qrt_qmt;
+
+	/* lqe entries close to their limit, processed first */
+	cfs_list_t		 qrt_urgent_list;
+
+	/* other lqe entries which need space rebalancing */
+	cfs_list_t		 qrt_list;
+
+	/* lock protecting both lists */
+	spinlock_t		 qrt_lock;
+
+	/* index of this thread in qmt_reba[] */
+	int			 qrt_idx;
+};
+
+/* rebalancing counters maintained by the quota master */
+enum {
+	QMT_REBA_ID_STAT = 0,	/* IDs rebalanced */
+	QMT_REBA_URGENT_STAT,	/* IDs queued ahead because close to limit */
+	QMT_REBA_GLIMPSE_STAT,	/* glimpse callbacks sent on per-ID locks */
+	QMT_REBA_BATCH_STAT,	/* IDs glimpsed together in a request set */
+	QMT_LAST_STAT
+};
+
 /*
  * The Quota Master Target Device.
  * The qmt is responsible for:
@@ -73,14 +117,15 @@ struct qmt_device {
 	/* procfs root directory for this qmt */
 	cfs_proc_dir_entry_t	*qmt_proc;
 
-	/* dedicated thread in charge of space rebalancing */
-	struct ptlrpc_thread	 qmt_reba_thread;
+	/* threads in charge of space rebalancing */
+	struct qmt_reba_thread	 qmt_reba[QMT_REBA_THREADS_NR];
 
-	/* list of lqe entry which need space rebalancing */
-	cfs_list_t		 qmt_reba_list;
+	/* rebalancing counters */
+	struct lprocfs_stats	*qmt_stats;
 
-	/* lock protecting rebalancing list */
-	spinlock_t		 qmt_reba_lock;
+	/* delay between an ID being queued for rebalancing and the glimpse
+	 * callbacks completing, in milliseconds */
+	struct obd_histogram	 qmt_reba_hist;
 
 	unsigned long		 qmt_stopping:1; /* qmt is stopping */
 
@@ -313,8 +358,8 @@ int qmt_lvbo_update(struct lu_device *, struct ldlm_resource *,
 int qmt_lvbo_size(struct lu_device *, struct ldlm_lock *);
 int qmt_lvbo_fill(struct lu_device *, struct ldlm_lock *, void *, int);
 int qmt_lvbo_free(struct lu_device *, struct ldlm_resource *);
-int qmt_start_reba_thread(struct qmt_device *);
-void qmt_stop_reba_thread(struct qmt_device *);
+int qmt_start_reba_threads(struct qmt_device *);
+void qmt_stop_reba_threads(struct qmt_device *);
 void qmt_glb_lock_notify(const struct lu_env *, struct lquota_entry *, __u64);
 void qmt_id_lock_notify(struct qmt_device *, struct lquota_entry *);
 #endif /* _QMT_INTERNAL_H */
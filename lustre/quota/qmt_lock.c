@@ -441,25 +441,28 @@ typedef int (*qmt_glimpse_cb_t)(const struct lu_env *, struct qmt_device *,
 				struct obd_uuid *, union ldlm_gl_desc *,
 				void *);
 /*
- * Send glimpse callback to slaves holding a lock on resource \res.
- * This is used to notify slaves of new quota settings or to claim quota space
- * back.
+ * Collect glimpse work items for slaves holding a lock on resource \res.
  *
- * \param env  - is the environment passed by the caller
- * \param qmt  - is the quota master target
- * \param res  - is the dlm resource associated with the quota object
- * \param desc - is the glimpse descriptor to pack in glimpse callback
- * \param cb   - is the callback function called on every lock and determine
- *               whether a glimpse should be issued
- * \param arg  - is an opaq parameter passed to the callback function
+ * \param env     - is the environment passed by the caller
+ * \param qmt     - is the quota master target
+ * \param res     - is the dlm resource associated with the quota object
+ * \param desc    - is the glimpse descriptor to pack in glimpse callback
+ * \param cb      - is the callback function called on every lock and
+ *                  determine whether a glimpse should be issued
+ * \param arg     - is an opaq parameter passed to the callback function
+ * \param gl_list - is the list where glimpse work items are added
+ *
+ * \retval - number of glimpse work items added to \gl_list
  */
-static int qmt_glimpse_lock(const struct lu_env *env, struct qmt_device *qmt,
-			    struct ldlm_resource *res, union ldlm_gl_desc *desc,
-			    qmt_glimpse_cb_t cb, void *arg)
+static int qmt_glimpse_lock_collect(const struct lu_env *env,
+				    struct qmt_device *qmt,
+				    struct ldlm_resource *res,
+				    union ldlm_gl_desc *desc,
+				    qmt_glimpse_cb_t cb, void *arg,
+				    cfs_list_t *gl_list)
 {
-	cfs_list_t	*tmp, *pos;
-	CFS_LIST_HEAD(gl_list);
-	int		 rc = 0;
+	cfs_list_t	*pos;
+	int		 rc, count = 0;
 	ENTRY;
 
 	lock_res(res);
@@ -493,23 +496,41 @@ static int qmt_glimpse_lock(const struct lu_env *env, struct qmt_device *qmt,
 			continue;
 		}
 
-		cfs_list_add_tail(&work->gl_list, &gl_list);
+		cfs_list_add_tail(&work->gl_list, gl_list);
 		work->gl_lock  = LDLM_LOCK_GET(lock);
 		work->gl_flags = 0;
 		work->gl_desc  = desc;
-
+		count++;
 	}
 	unlock_res(res);
 
-	if (cfs_list_empty(&gl_list)) {
-		CDEBUG(D_QUOTA, "%s: nobody to notify\n", qmt->qmt_svname);
-		RETURN(0);
-	}
+	RETURN(count);
+}
+
+/*
+ * Issue glimpse callbacks collected by qmt_glimpse_lock_collect().
+ * Work items may be related to different resources, each carrying its own
+ * glimpse descriptor. They are all sent in parallel through the ptlrpc
+ * request set set up by ldlm_glimpse_locks(), which only uses \res to find
+ * the namespace (glimpse callbacks never ask for the resource to be
+ * reprocessed).
+ *
+ * \param qmt     - is the quota master target
+ * \param res     - is one of the dlm resources the glimpses are sent for
+ * \param gl_list - is the list of glimpse work items
+ */
+static int qmt_glimpse_lock_send(struct qmt_device *qmt,
+				 struct ldlm_resource *res,
+				 cfs_list_t *gl_list)
+{
+	cfs_list_t	*tmp, *pos;
+	int		 rc;
+	ENTRY;
 
 	/* issue glimpse callbacks to all connected slaves */
-	rc = ldlm_glimpse_locks(res, &gl_list);
+	rc = ldlm_glimpse_locks(res, gl_list);
 
-	cfs_list_for_each_safe(pos, tmp, &gl_list) {
+	cfs_list_for_each_safe(pos, tmp, gl_list) {
 		struct ldlm_glimpse_work *work;
 
 		work = cfs_list_entry(pos, struct ldlm_glimpse_work, gl_list);
@@ -525,6 +546,35 @@ static int qmt_glimpse_lock(const struct lu_env *env, struct qmt_device *qmt,
 	RETURN(rc);
 }
 
+/*
+ * Send glimpse callback to slaves holding a lock on resource \res.
+ * This is used to notify slaves of new quota settings or to claim quota space
+ * back.
+ *
+ * \param env  - is the environment passed by the caller
+ * \param qmt  - is the quota master target
+ * \param res  - is the dlm resource associated with the quota object
+ * \param desc - is the glimpse descriptor to pack in glimpse callback
+ * \param cb   - is the callback function called on every lock and determine
+ *               whether a glimpse should be issued
+ * \param arg  - is an opaq parameter passed to the callback function
+ */
+static int qmt_glimpse_lock(const struct lu_env *env, struct qmt_device *qmt,
+			    struct ldlm_resource *res, union ldlm_gl_desc *desc,
+			    qmt_glimpse_cb_t cb, void *arg)
+{
+	CFS_LIST_HEAD(gl_list);
+	ENTRY;
+
+	if (qmt_glimpse_lock_collect(env, qmt, res, desc, cb, arg,
+				     &gl_list) == 0) {
+		CDEBUG(D_QUOTA, "%s: nobody to notify\n", qmt->qmt_svname);
+		RETURN(0);
+	}
+
+	RETURN(qmt_glimpse_lock_send(qmt, res, &gl_list));
+}
+
 /*
  * Send glimpse request to all global quota locks to push new quota setting to
  * slaves.
@@ -584,33 +634,56 @@ static int qmt_id_lock_cb(const struct lu_env *env, struct qmt_device *qmt,
 	RETURN(+1);
 }
 
+/* Per-ID glimpse handled by a rebalance thread */
+struct qmt_reba_work {
+	/* lquota entry to be rebalanced */
+	struct lquota_entry	*qrw_lqe;
+
+	/* ldlm resource of the per-ID lock, NULL if nothing to glimpse */
+	struct ldlm_resource	*qrw_res;
+
+	/* when the entry was queued for rebalancing */
+	cfs_time_t		 qrw_queued;
+
+	/* glimpse descriptor packed in callbacks for this ID */
+	union ldlm_gl_desc	 qrw_desc;
+};
+
 /*
- * Send glimpse request on per-ID lock to push new qunit value to slave.
+ * Prepare glimpse request on per-ID lock to push new qunit value to slave.
+ * Glimpse work items are only added to \gl_list, the caller is responsible
+ * for sending them, possibly along with the ones of other IDs, and for
+ * calling qmt_id_lock_glimpse_fini() once done.
  *
- * \param env  - is the environment passed by the caller
- * \param qmt  - is the quota master target device
- * \param lqe  - is the lquota entry with the new qunit value
- * \param uuid - is the uuid of the slave acquiring space, if any
+ * \param env     - is the environment passed by the caller
+ * \param qmt     - is the quota master target device
+ * \param qrw     - is the rebalance work of the lquota entry with the new
+ *                  qunit value
+ * \param uuid    - is the uuid of the slave acquiring space, if any
+ * \param gl_list - is the list where glimpse work items are added
+ *
+ * \retval - number of glimpse callbacks added to \gl_list
  */
-static void qmt_id_lock_glimpse(const struct lu_env *env,
-				struct qmt_device *qmt,
-				struct lquota_entry *lqe, struct obd_uuid *uuid)
+static int qmt_id_lock_glimpse_prep(const struct lu_env *env,
+				    struct qmt_device *qmt,
+				    struct qmt_reba_work *qrw,
+				    struct obd_uuid *uuid, cfs_list_t *gl_list)
 {
 	struct qmt_thread_info	*qti = qmt_info(env);
+	struct lquota_entry	*lqe = qrw->qrw_lqe;
 	struct qmt_pool_info	*pool = lqe2qpi(lqe);
-	struct ldlm_resource	*res = NULL;
-	int			 rc;
 	ENTRY;
 
+	qrw->qrw_res = NULL;
 	if (!lqe->lqe_enforced)
-		RETURN_EXIT;
+		RETURN(0);
 
 	lquota_generate_fid(&qti->qti_fid, pool->qpi_key & 0x0000ffff,
 			    pool->qpi_key >> 16, lqe->lqe_site->lqs_qtype);
 	fid_build_quota_res_name(&qti->qti_fid, &lqe->lqe_id, &qti->qti_resid);
-	res = ldlm_resource_get(qmt->qmt_ns, NULL, &qti->qti_resid, LDLM_PLAIN,
-				0);
-	if (res == NULL) {
+	qrw->qrw_res = ldlm_resource_get(qmt->qmt_ns, NULL, &qti->qti_resid,
+					 LDLM_PLAIN, 0);
+	if (qrw->qrw_res == NULL) {
 		/* this might legitimately happens if slaves haven't had the
 		 * opportunity to enqueue quota lock yet. */
 		LQUOTA_DEBUG(lqe, "failed to lookup ldlm resource for per-ID "
@@ -620,7 +693,7 @@ static void qmt_id_lock_glimpse(const struct lu_env *env,
 		    lqe->lqe_qunit == pool->qpi_least_qunit)
 			lqe->lqe_revoke_time = cfs_time_current_64();
 		lqe_write_unlock(lqe);
-		RETURN_EXIT;
+		RETURN(0);
 	}
 
 	lqe_write_lock(lqe);
@@ -631,30 +704,48 @@ static void qmt_id_lock_glimpse(const struct lu_env *env,
 	 *   need to send acquire request any more until further notice */
 
 	/* fill glimpse descriptor with lqe settings */
+	memset(&qrw->qrw_desc, 0, sizeof(qrw->qrw_desc));
+	qrw->qrw_desc.lquota_desc.gl_id = lqe->lqe_id;
 	if (lqe->lqe_edquot)
-		qti->qti_gl_desc.lquota_desc.gl_flags = LQUOTA_FL_EDQUOT;
-	else
-		qti->qti_gl_desc.lquota_desc.gl_flags = 0;
-	qti->qti_gl_desc.lquota_desc.gl_qunit = lqe->lqe_qunit;
+		qrw->qrw_desc.lquota_desc.gl_flags = LQUOTA_FL_EDQUOT;
+	qrw->qrw_desc.lquota_desc.gl_qunit = lqe->lqe_qunit;
 
 	if (lqe->lqe_revoke_time == 0 &&
-	    qti->qti_gl_desc.lquota_desc.gl_qunit == pool->qpi_least_qunit)
+	    qrw->qrw_desc.lquota_desc.gl_qunit == pool->qpi_least_qunit)
 		/* reset lqe_may_rel, it will be updated on glimpse callback
 		 * replies if needed */
 		lqe->lqe_may_rel = 0;
 
-	/* The rebalance thread is the only thread which can issue glimpses */
+	/* Only the rebalance thread the lqe is hashed to can issue glimpses */
 	LASSERT(!lqe->lqe_gl);
 	lqe->lqe_gl = true;
 	lqe_write_unlock(lqe);
 
-	/* issue glimpse callback to slaves */
-	rc = qmt_glimpse_lock(env, qmt, res, &qti->qti_gl_desc,
-			      uuid ? qmt_id_lock_cb : NULL, (void *)uuid);
+	RETURN(qmt_glimpse_lock_collect(env, qmt, qrw->qrw_res, &qrw->qrw_desc,
+					uuid ? qmt_id_lock_cb : NULL,
+					(void *)uuid, gl_list));
+}
+
+/*
+ * Update lqe state once glimpse callbacks prepared by
+ * qmt_id_lock_glimpse_prep() have been sent.
+ *
+ * \param qmt - is the quota master target device
+ * \param qrw - is the rebalance work of the lquota entry
+ */
+static void qmt_id_lock_glimpse_fini(struct qmt_device *qmt,
+				     struct qmt_reba_work *qrw)
+{
+	struct lquota_entry	*lqe = qrw->qrw_lqe;
+	struct qmt_pool_info	*pool = lqe2qpi(lqe);
+	ENTRY;
+
+	if (qrw->qrw_res == NULL)
+		RETURN_EXIT;
 
 	lqe_write_lock(lqe);
 	if (lqe->lqe_revoke_time == 0 &&
-	    qti->qti_gl_desc.lquota_desc.gl_qunit == pool->qpi_least_qunit &&
+	    qrw->qrw_desc.lquota_desc.gl_qunit == pool->qpi_least_qunit &&
 	    lqe->lqe_qunit == pool->qpi_least_qunit) {
 		lqe->lqe_revoke_time = cfs_time_current_64();
 		qmt_adjust_edquot(lqe, cfs_time_current_sec());
@@ -663,39 +754,163 @@ static void qmt_id_lock_glimpse(const struct lu_env *env,
 	lqe->lqe_gl = false;
 	lqe_write_unlock(lqe);
 
-	ldlm_resource_putref(res);
+	ldlm_resource_putref(qrw->qrw_res);
+	qrw->qrw_res = NULL;
 	EXIT;
 }
 
+/*
+ * Check whether an ID is close enough to its limit for rebalancing to be
+ * handled ahead of other IDs. Called with lqe write lock held.
+ */
+static bool qmt_reba_urgent(struct lquota_entry *lqe)
+{
+	__u64	limit = lqe->lqe_hardlimit;
+
+	if (lqe->lqe_edquot)
+		return true;
+
+	if (lqe->lqe_softlimit != 0 &&
+	    (limit == 0 || lqe->lqe_softlimit < limit))
+		limit = lqe->lqe_softlimit;
+	if (limit == 0)
+		return false;
+
+	return lqe->lqe_granted + QMT_REBA_URGENT_QUNITS * lqe->lqe_qunit >=
+	       limit;
+}
+
 /*
  * Schedule a glimpse request on per-ID locks to push new qunit value or
  * edquot flag to quota slaves.
+ * IDs close to their limit are queued on the urgent list of the rebalance
+ * thread, which is always drained first.
  *
  * \param qmt  - is the quota master target device
  * \param lqe  - is the lquota entry with the new qunit value
  */
 void qmt_id_lock_notify(struct qmt_device *qmt, struct lquota_entry *lqe)
 {
-	bool	added = false;
+	struct qmt_reba_thread	*qrt;
+	bool			 added = false;
+	bool			 urgent;
 	ENTRY;
 
+	qrt = &qmt->qmt_reba[(unsigned int)lqe->lqe_id.qid_uid %
+			     QMT_REBA_THREADS_NR];
+	urgent = qmt_reba_urgent(lqe);
+
 	lqe_getref(lqe);
-	spin_lock(&qmt->qmt_reba_lock);
+	spin_lock(&qrt->qrt_lock);
 	if (!qmt->qmt_stopping && cfs_list_empty(&lqe->lqe_link)) {
-		cfs_list_add_tail(&lqe->lqe_link, &qmt->qmt_reba_list);
+		cfs_list_add_tail(&lqe->lqe_link, urgent ?
+				  &qrt->qrt_urgent_list : &qrt->qrt_list);
+		lqe->lqe_reba_time = cfs_time_current();
 		added = true;
 	}
-	spin_unlock(&qmt->qmt_reba_lock);
+	spin_unlock(&qrt->qrt_lock);
 
-	if (added)
-		wake_up(&qmt->qmt_reba_thread.t_ctl_waitq);
-	else
+	if (added) {
+		if (urgent && qmt->qmt_stats != NULL)
+			lprocfs_counter_incr(qmt->qmt_stats,
+					     QMT_REBA_URGENT_STAT);
+		wake_up(&qrt->qrt_thread.t_ctl_waitq);
+	} else {
 		lqe_putref(lqe);
+	}
 	EXIT;
 }
 
+static inline bool qmt_reba_list_empty(struct qmt_reba_thread *qrt)
+{
+	return cfs_list_empty(&qrt->qrt_urgent_list) &&
+	       cfs_list_empty(&qrt->qrt_list);
+}
+
+/*
+ * Dequeue up to QMT_REBA_BATCH_MAX lquota entries, urgent ones first.
+ * The reference taken in qmt_id_lock_notify() is transferred to \qrw.
+ *
+ * \retval - number of entries dequeued
+ */
+static int qmt_reba_dequeue(struct qmt_reba_thread *qrt,
+			    struct qmt_reba_work *qrw)
+{
+	cfs_list_t	*lists[] = { &qrt->qrt_urgent_list, &qrt->qrt_list };
+	int		 i, nr = 0;
+
+	spin_lock(&qrt->qrt_lock);
+	for (i = 0; i < ARRAY_SIZE(lists); i++) {
+		while (nr < QMT_REBA_BATCH_MAX && !cfs_list_empty(lists[i])) {
+			struct lquota_entry *lqe;
+
+			lqe = cfs_list_entry(lists[i]->next,
+					     struct lquota_entry, lqe_link);
+			cfs_list_del_init(&lqe->lqe_link);
+			qrw[nr].qrw_lqe = lqe;
+			qrw[nr].qrw_queued = lqe->lqe_reba_time;
+			nr++;
+		}
+	}
+	spin_unlock(&qrt->qrt_lock);
+	return nr;
+}
+
 /*
- * The rebalance thread is in charge of sending glimpse callbacks on per-ID
+ * Send glimpse callbacks for a batch of IDs. Callbacks for all the IDs and
+ * all the slaves are issued in parallel through a single request set.
+ *
+ * \param env - is the environment passed by the caller
+ * \param qrt - is the rebalance thread
+ * \param qrw - is the array of rebalance work
+ * \param nr  - is the number of entries in \qrw
+ */
+static void qmt_reba_batch(const struct lu_env *env,
+			   struct qmt_reba_thread *qrt,
+			   struct qmt_reba_work *qrw, int nr)
+{
+	struct qmt_device	*qmt = qrt->qrt_qmt;
+	struct ldlm_resource	*res = NULL;
+	CFS_LIST_HEAD(gl_list);
+	int			 i, count = 0;
+	ENTRY;
+
+	for (i = 0; i < nr; i++) {
+		count += qmt_id_lock_glimpse_prep(env, qmt, &qrw[i], NULL,
+						  &gl_list);
+		if (res == NULL)
+			res = qrw[i].qrw_res;
+	}
+
+	if (count > 0) {
+		LASSERT(res != NULL);
+		qmt_glimpse_lock_send(qmt, res, &gl_list);
+	}
+
+	for (i = 0; i < nr; i++) {
+		struct timeval	tv;
+
+		qmt_id_lock_glimpse_fini(qmt, &qrw[i]);
+
+		cfs_duration_usec(cfs_time_sub(cfs_time_current(),
+					       qrw[i].qrw_queued), &tv);
+		lprocfs_oh_tally_log2(&qmt->qmt_reba_hist,
+				      tv.tv_sec * 1000 + tv.tv_usec / 1000);
+		lqe_putref(qrw[i].qrw_lqe);
+		qrw[i].qrw_lqe = NULL;
+	}
+
+	if (qmt->qmt_stats != NULL) {
+		lprocfs_counter_add(qmt->qmt_stats, QMT_REBA_ID_STAT, nr);
+		lprocfs_counter_add(qmt->qmt_stats, QMT_REBA_GLIMPSE_STAT,
+				    count);
+		lprocfs_counter_add(qmt->qmt_stats, QMT_REBA_BATCH_STAT, nr);
+	}
+	EXIT;
+}
+
+/*
+ * The rebalance threads are in charge of sending glimpse callbacks on per-ID
  * quota locks owned by slaves in order to notify them of:
  * - a qunit shrink in which case slaves might release quota space back in
  *   glimpse reply.
@@ -703,24 +918,33 @@ void qmt_id_lock_notify(struct qmt_device *qmt, struct lquota_entry *lqe)
  *   master. When the flag is set, slaves know that there is no need to
  *   try to acquire quota from the master since this latter has already
  *   distributed all the space.
+ * Each thread serves its own subset of IDs and glimpses several IDs at once.
  */
 static int qmt_reba_thread(void *arg)
 {
-	struct qmt_device	*qmt = (struct qmt_device *)arg;
-	struct ptlrpc_thread	*thread = &qmt->qmt_reba_thread;
+	struct qmt_reba_thread	*qrt = (struct qmt_reba_thread *)arg;
+	struct qmt_device	*qmt = qrt->qrt_qmt;
+	struct ptlrpc_thread	*thread = &qrt->qrt_thread;
 	struct l_wait_info	 lwi = { 0 };
+	struct qmt_reba_work	*qrw;
 	struct lu_env		*env;
-	struct lquota_entry	*lqe, *tmp;
-	int			 rc;
+	int			 rc, nr, i;
 	ENTRY;
 
 	OBD_ALLOC_PTR(env);
 	if (env == NULL)
 		RETURN(-ENOMEM);
 
+	OBD_ALLOC(qrw, sizeof(*qrw) * QMT_REBA_BATCH_MAX);
+	if (qrw == NULL) {
+		OBD_FREE_PTR(env);
+		RETURN(-ENOMEM);
+	}
+
 	rc = lu_env_init(env, LCT_MD_THREAD);
 	if (rc) {
 		CERROR("%s: failed to init env.", qmt->qmt_svname);
+		OBD_FREE(qrw, sizeof(*qrw) * QMT_REBA_BATCH_MAX);
 		OBD_FREE_PTR(env);
 		RETURN(rc);
 	}
@@ -730,27 +954,23 @@ static int qmt_reba_thread(void *arg)
 
 	while (1) {
 		l_wait_event(thread->t_ctl_waitq,
-			     !cfs_list_empty(&qmt->qmt_reba_list) ||
+			     !qmt_reba_list_empty(qrt) ||
 			     !thread_is_running(thread), &lwi);
 
-		spin_lock(&qmt->qmt_reba_lock);
-		cfs_list_for_each_entry_safe(lqe, tmp, &qmt->qmt_reba_list,
-					     lqe_link) {
-			cfs_list_del_init(&lqe->lqe_link);
-			spin_unlock(&qmt->qmt_reba_lock);
-
-			if (thread_is_running(thread))
-				qmt_id_lock_glimpse(env, qmt, lqe, NULL);
-
-			lqe_putref(lqe);
-			spin_lock(&qmt->qmt_reba_lock);
+		while ((nr = qmt_reba_dequeue(qrt, qrw)) > 0) {
+			if (thread_is_running(thread)) {
+				qmt_reba_batch(env, qrt, qrw, nr);
+				continue;
+			}
+			for (i = 0; i < nr; i++)
+				lqe_putref(qrw[i].qrw_lqe);
 		}
-		spin_unlock(&qmt->qmt_reba_lock);
 
 		if (!thread_is_running(thread))
 			break;
 	}
 	lu_env_fini(env);
+	OBD_FREE(qrw, sizeof(*qrw) * QMT_REBA_BATCH_MAX);
 	OBD_FREE_PTR(env);
 	thread_set_flags(thread, SVC_STOPPED);
 	wake_up(&thread->t_ctl_waitq);
@@ -758,46 +978,59 @@ static int qmt_reba_thread(void *arg)
 }
 
 /*
- * Start rebalance thread. Called when the QMT is being setup
+ * Start rebalance threads. Called when the QMT is being setup
  */
-int qmt_start_reba_thread(struct qmt_device *qmt)
+int qmt_start_reba_threads(struct qmt_device *qmt)
 {
-	struct ptlrpc_thread	*thread = &qmt->qmt_reba_thread;
-	struct l_wait_info	 lwi    = { 0 };
-	struct task_struct		*task;
+	struct l_wait_info	 lwi = { 0 };
+	int			 i;
 	ENTRY;
 
-	task = kthread_run(qmt_reba_thread, (void *)qmt,
-			       "qmt_reba_%s", qmt->qmt_svname);
-	if (IS_ERR(task)) {
-		CERROR("%s: failed to start rebalance thread (%ld)\n",
-		       qmt->qmt_svname, PTR_ERR(task));
-		thread_set_flags(thread, SVC_STOPPED);
-		RETURN(PTR_ERR(task));
-	}
+	for (i = 0; i < QMT_REBA_THREADS_NR; i++) {
+		struct qmt_reba_thread	*qrt = &qmt->qmt_reba[i];
+		struct ptlrpc_thread	*thread = &qrt->qrt_thread;
+		struct task_struct	*task;
+
+		qrt->qrt_qmt = qmt;
+		qrt->qrt_idx = i;
+		task = kthread_run(qmt_reba_thread, (void *)qrt,
+				   "qmt_reba%02d_%s", i, qmt->qmt_svname);
+		if (IS_ERR(task)) {
+			CERROR("%s: failed to start rebalance thread %d (%ld)\n",
+			       qmt->qmt_svname, i, PTR_ERR(task));
+			thread_set_flags(thread, SVC_STOPPED);
+			qmt_stop_reba_threads(qmt);
+			RETURN(PTR_ERR(task));
+		}
 
-	l_wait_event(thread->t_ctl_waitq,
-		     thread_is_running(thread) || thread_is_stopped(thread),
-		     &lwi);
+		l_wait_event(thread->t_ctl_waitq,
+			     thread_is_running(thread) ||
+			     thread_is_stopped(thread), &lwi);
+	}
 
 	RETURN(0);
 }
 
 /*
- * Stop rebalance thread. Called when the QMT is about to shutdown.
+ * Stop rebalance threads. Called when the QMT is about to shutdown.
  */
-void qmt_stop_reba_thread(struct qmt_device *qmt)
+void qmt_stop_reba_threads(struct qmt_device *qmt)
 {
-	struct ptlrpc_thread *thread = &qmt->qmt_reba_thread;
+	int	i;
 
-	if (!thread_is_stopped(thread)) {
-		struct l_wait_info lwi = { 0 };
+	for (i = 0; i < QMT_REBA_THREADS_NR; i++) {
+		struct qmt_reba_thread	*qrt = &qmt->qmt_reba[i];
+		struct ptlrpc_thread	*thread = &qrt->qrt_thread;
 
-		thread_set_flags(thread, SVC_STOPPING);
-		wake_up(&thread->t_ctl_waitq);
+		if (!thread_is_stopped(thread)) {
+			struct l_wait_info lwi = { 0 };
 
-		l_wait_event(thread->t_ctl_waitq, thread_is_stopped(thread),
-			     &lwi);
+			thread_set_flags(thread, SVC_STOPPING);
+			wake_up(&thread->t_ctl_waitq);
+
+			l_wait_event(thread->t_ctl_waitq,
+				     thread_is_stopped(thread), &lwi);
+		}
+		LASSERT(qmt_reba_list_empty(qrt));
 	}
-	LASSERT(cfs_list_empty(&qmt->qmt_reba_list));
 }
@@ -51,6 +51,7 @@ static inline int qsd_request_enter(struct lquota_entry *lqe)
 	}
 
 	lqe->lqe_pending_req++;
+	lqe->lqe_acq_start = cfs_time_current();
 	return 0;
 }
 
@@ -403,9 +404,17 @@ static void qsd_req_completion(const struct lu_env *env,
 		lqe->lqe_nopreacq = true;
 out:
 	adjust = qsd_adjust_needed(lqe);
-	if (reqbody && req_is_acq(reqbody->qb_flags) && ret != -EDQUOT) {
-		lqe->lqe_acq_rc = ret;
-		lqe->lqe_acq_time = cfs_time_current_64();
+	if (reqbody && req_is_acq(reqbody->qb_flags)) {
+		struct timeval	tv;
+
+		cfs_duration_usec(cfs_time_sub(cfs_time_current(),
+					       lqe->lqe_acq_start), &tv);
+		lprocfs_oh_tally_log2(&qqi->qqi_qsd->qsd_acq_hist,
+				      tv.tv_sec * 1000 + tv.tv_usec / 1000);
+		if (ret != -EDQUOT) {
+			lqe->lqe_acq_rc = ret;
+			lqe->lqe_acq_time = cfs_time_current_64();
+		}
 	}
 out_noadjust:
 	qsd_request_exit(lqe);
@@ -430,6 +439,29 @@ out_noadjust:
 	EXIT;
 }
 
+/**
+ * Account \a space consumed by \a lqe to estimate its consumption rate.
+ * The rate is averaged over sampling windows of at least one second and
+ * forgotten when the ID stays idle for QSD_WB_INTERVAL.
+ * Must be called with the lqe write lock held.
+ */
+static void qsd_rate_update(struct lquota_entry *lqe, __u64 space)
+{
+	__u64	now = cfs_time_current_sec();
+	__u64	elapsed = now - lqe->lqe_rate_time;
+
+	if (elapsed > 0) {
+		if (elapsed > QSD_WB_INTERVAL)
+			lqe->lqe_rate = 0;
+		else
+			lqe->lqe_rate = (lqe->lqe_rate +
+					 lqe->lqe_rate_used / elapsed) / 2;
+		lqe->lqe_rate_used = 0;
+		lqe->lqe_rate_time = now;
+	}
+	lqe->lqe_rate_used += space;
+}
+
 /**
  * Try to consume local quota space.
  *
@@ -460,6 +492,7 @@ static int qsd_acquire_local(struct lquota_entry *lqe, __u64 space)
 		/* Yay! we got enough space */
 		lqe->lqe_pending_write += space;
 		lqe->lqe_waiting_write -= space;
+		qsd_rate_update(lqe, space);
 		rc = 0;
 	} else if (lqe->lqe_edquot) {
 		rc = -EDQUOT;
@@ -502,10 +535,21 @@ static inline bool qsd_calc_acquire(struct lquota_entry *lqe,
 		granted = lqe->lqe_usage;
 	}
 
-	/* acquire as much as needed, but not more */
+	/* acquire as much as needed, plus what this ID is expected to consume
+	 * shortly so that a busy ID doesn't need one request per write. The
+	 * master shrinks qunit when the limit gets close, which turns the
+	 * prefetch off */
 	if (usage > granted) {
-		qbody->qb_count  = usage - granted;
+		__u64	prefetch = 0;
+
+		if (!lqe->lqe_edquot && lqe->lqe_qunit != 0)
+			prefetch = min(lqe->lqe_rate * QSD_PREFETCH_SEC,
+				       lqe->lqe_qunit);
+		qbody->qb_count  = usage - granted + prefetch;
 		qbody->qb_flags |= QUOTA_DQACQ_FL_ACQ;
+		if (prefetch != 0)
+			lprocfs_counter_add(lqe2qqi(lqe)->qqi_qsd->qsd_stats,
+					    LQUOTA_PREFETCH_STAT, prefetch);
 	}
 
 	return qbody->qb_flags != 0;
@@ -107,6 +107,13 @@ struct qsd_instance {
 	 * enforced here (via procfs) */
 	int			 qsd_timeout;
 
+	/* counters of quota requests sent to the master and of slave index
+	 * updates, see LQUOTA_*_STAT */
+	struct lprocfs_stats	*qsd_stats;
+
+	/* latency of acquire requests, in milliseconds */
+	struct obd_histogram	 qsd_acq_hist;
+
 	unsigned long		 qsd_is_md:1,    /* managing quota for mdt */
 				 qsd_started:1,  /* instance is now started */
 				 qsd_prepared:1, /* qsd_prepare() successfully
@@ -319,6 +326,13 @@ static inline void qsd_set_qunit(struct lquota_entry *lqe, __u64 qunit)
 
 #define QSD_WB_INTERVAL	60 /* 60 seconds */
 
+/* maximum number of slave index updates written back in one transaction */
+#define QSD_WB_BATCH_MAX	32
+
+/* an ID consuming quota space acquires on top of what is needed the space it
+ * is expected to consume in this many seconds, but never more than qunit */
+#define QSD_PREFETCH_SEC	2
+
 /* helper function calculating how long a service thread should be waiting for
  * quota space */
 static inline int qsd_wait_timeout(struct qsd_instance *qsd)
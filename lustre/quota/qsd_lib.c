@@ -504,6 +504,9 @@ void qsd_fini(const struct lu_env *env, struct qsd_instance *qsd)
 		qsd->qsd_dev = NULL;
 	}
 
+	if (qsd->qsd_stats != NULL)
+		lprocfs_free_stats(&qsd->qsd_stats);
+
 	CDEBUG(D_QUOTA, "%s: QSD shutdown completed\n", qsd->qsd_svname);
 	OBD_FREE_PTR(qsd);
 	EXIT;
@@ -550,6 +553,7 @@ struct qsd_instance *qsd_init(const struct lu_env *env, char *svname,
 	CFS_INIT_LIST_HEAD(&qsd->qsd_upd_list);
 	spin_lock_init(&qsd->qsd_adjust_lock);
 	CFS_INIT_LIST_HEAD(&qsd->qsd_adjust_list);
+	spin_lock_init(&qsd->qsd_acq_hist.oh_lock);
 	qsd->qsd_prepared = false;
 	qsd->qsd_started = false;
 
@@ -597,6 +601,25 @@ struct qsd_instance *qsd_init(const struct lu_env *env, char *svname,
 		       svname, rc);
 		GOTO(out, rc);
         }
+
+	qsd->qsd_stats = lprocfs_quota_stats_alloc();
+	if (qsd->qsd_stats == NULL)
+		GOTO(out, rc = -ENOMEM);
+
+	rc = lprocfs_register_stats(qsd->qsd_proc, "stats", qsd->qsd_stats);
+	if (rc) {
+		CERROR("%s: can't add procfs entry for quota stats %d\n",
+		       svname, rc);
+		GOTO(out, rc);
+	}
+
+	rc = lprocfs_seq_create(qsd->qsd_proc, "acquire_latency", 0644,
+				&lprocfs_quota_hist_fops, &qsd->qsd_acq_hist);
+	if (rc) {
+		CERROR("%s: can't add procfs entry for acquire latency %d\n",
+		       svname, rc);
+		GOTO(out, rc);
+	}
 	EXIT;
 out:
 	if (rc) {
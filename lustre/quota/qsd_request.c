@@ -118,6 +118,10 @@ int qsd_send_dqacq(const struct lu_env *env, struct obd_export *exp,
 
 	ptlrpc_request_set_replen(req);
 
+	lprocfs_counter_incr(qqi->qqi_qsd->qsd_stats,
+			     req_is_rel(qbody->qb_flags) ? LQUOTA_DQREL_STAT :
+							   LQUOTA_DQACQ_STAT);
+
 	CLASSERT(sizeof(*aa) <= sizeof(req->rq_async_args));
 	aa = ptlrpc_req_async_args(req);
 	aa->aa_exp = exp;
@@ -255,6 +259,8 @@ int qsd_intent_lock(const struct lu_env *env, struct obd_export *exp,
 		flags |= LDLM_FL_NO_LRU;
 		break;
 	case IT_QUOTA_DQACQ:
+		lprocfs_counter_incr(qqi->qqi_qsd->qsd_stats,
+				     LQUOTA_INTENT_STAT);
 		/* build resource name associated for per-ID quota lock */
 		fid_build_quota_res_name(&qbody->qb_fid, &qbody->qb_id,
 					 &qti->qti_resid);
@@ -303,6 +303,12 @@ static int qsd_process_upd(const struct lu_env *env, struct qsd_upd_rec *upd)
 
 	rc = qsd_update_index(env, qqi, &upd->qur_qid, upd->qur_global,
 			      upd->qur_ver, &upd->qur_rec);
+	if (rc == 0) {
+		lprocfs_counter_incr(qqi->qqi_qsd->qsd_stats,
+				     LQUOTA_WB_TRANS_STAT);
+		lprocfs_counter_incr(qqi->qqi_qsd->qsd_stats,
+				     LQUOTA_WB_REC_STAT);
+	}
 out:
 	if (lqe && !IS_ERR(lqe)) {
 		lqe_putref(lqe);
@@ -311,6 +317,103 @@ out:
 	RETURN(rc);
 }
 
+/* unversioned slave index updates are issued on DQACQ completion and can be
+ * written back together */
+static inline bool qsd_upd_batchable(struct qsd_upd_rec *upd)
+{
+	return !upd->qur_global && upd->qur_ver == 0;
+}
+
+/*
+ * Write back a run of unversioned slave index updates from the head of
+ * \a queue in a single transaction. The run stops at the first update which
+ * is versioned, for a global index or for another quota type, so ordering
+ * against those is preserved. When the same ID shows up several times in
+ * the run, only the latest record is written.
+ *
+ * \param env   - the environment passed by the caller
+ * \param queue - is the list of pending updates, the head of which must be
+ *                batchable
+ */
+static int qsd_process_upd_batch(const struct lu_env *env, cfs_list_t *queue)
+{
+	struct qsd_upd_rec	*upd, *tmp, *n;
+	struct qsd_qtype_info	*qqi;
+	struct qsd_instance	*qsd;
+	struct thandle		*th;
+	cfs_list_t		 batch;
+	int			 nr = 0, rc;
+	ENTRY;
+
+	upd = cfs_list_entry(queue->next, struct qsd_upd_rec, qur_link);
+	qqi = upd->qur_qqi;
+	qsd = qqi->qqi_qsd;
+	CFS_INIT_LIST_HEAD(&batch);
+
+	cfs_list_for_each_entry_safe(upd, n, queue, qur_link) {
+		if (!qsd_upd_batchable(upd) || upd->qur_qqi != qqi ||
+		    nr == QSD_WB_BATCH_MAX)
+			break;
+
+		/* a later update of the same ID supersedes the earlier one */
+		cfs_list_for_each_entry(tmp, &batch, qur_link) {
+			if (tmp->qur_qid.qid_uid == upd->qur_qid.qid_uid) {
+				cfs_list_del_init(&tmp->qur_link);
+				qsd_upd_free(tmp);
+				nr--;
+				break;
+			}
+		}
+		cfs_list_move_tail(&upd->qur_link, &batch);
+		nr++;
+	}
+
+	th = dt_trans_create(env, qsd->qsd_dev);
+	if (IS_ERR(th))
+		GOTO(out, rc = PTR_ERR(th));
+
+	cfs_list_for_each_entry(upd, &batch, qur_link) {
+		rc = lquota_disk_declare_write(env, th, qqi->qqi_slv_obj,
+					       &upd->qur_qid);
+		if (rc)
+			GOTO(out_stop, rc);
+	}
+
+	rc = dt_trans_start_local(env, qsd->qsd_dev, th);
+	if (rc)
+		GOTO(out_stop, rc);
+
+	cfs_list_for_each_entry(upd, &batch, qur_link) {
+		CDEBUG(D_QUOTA, "%s: update granted to "LPU64" for id "LPU64
+		       "\n", qsd->qsd_svname,
+		       upd->qur_rec.lqr_slv_rec.qsr_granted,
+		       upd->qur_qid.qid_uid);
+
+		rc = lquota_disk_write(env, th, qqi->qqi_slv_obj,
+				       &upd->qur_qid,
+				       (struct dt_rec *)&upd->qur_rec, 0, NULL);
+		if (rc)
+			break;
+	}
+	if (rc == 0) {
+		lprocfs_counter_incr(qsd->qsd_stats, LQUOTA_WB_TRANS_STAT);
+		lprocfs_counter_add(qsd->qsd_stats, LQUOTA_WB_REC_STAT, nr);
+	}
+	EXIT;
+out_stop:
+	dt_trans_stop(env, qsd->qsd_dev, th);
+out:
+	if (rc)
+		CERROR("%s: failed to update slave index copy for %d ids, rc:"
+		       "%d\n", qsd->qsd_svname, nr, rc);
+
+	cfs_list_for_each_entry_safe(upd, n, &batch, qur_link) {
+		cfs_list_del_init(&upd->qur_link);
+		qsd_upd_free(upd);
+	}
+	return rc;
+}
+
 void qsd_adjust_schedule(struct lquota_entry *lqe, bool defer, bool cancel)
 {
 	struct qsd_instance	*qsd = lqe2qqi(lqe)->qqi_qsd;
@@ -415,7 +518,7 @@ static int qsd_upd_thread(void *arg)
 	struct ptlrpc_thread	*thread = &qsd->qsd_upd_thread;
 	struct l_wait_info	 lwi;
 	cfs_list_t		 queue;
-	struct qsd_upd_rec	*upd, *n;
+	struct qsd_upd_rec	*upd;
 	struct lu_env		*env;
 	int			 qtype, rc = 0;
 	bool			 uptodate;
@@ -444,7 +547,13 @@ static int qsd_upd_thread(void *arg)
 			     qsd_job_pending(qsd, &queue, &uptodate) ||
 			     !thread_is_running(thread), &lwi);
 
-		cfs_list_for_each_entry_safe(upd, n, &queue, qur_link) {
+		while (!cfs_list_empty(&queue)) {
+			upd = cfs_list_entry(queue.next, struct qsd_upd_rec,
+					     qur_link);
+			if (qsd_upd_batchable(upd)) {
+				qsd_process_upd_batch(env, &queue);
+				continue;
+			}
 			cfs_list_del_init(&upd->qur_link);
 			qsd_process_upd(env, upd);
 			qsd_upd_free(upd);
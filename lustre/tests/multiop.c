@@ -77,6 +77,7 @@ char usage[] =
 "	 f  statfs\n"
 "	 F  print FID\n"
 "	 H[num] create HSM released file with num stripes\n"
+"	 J[num] set file flags with LL_IOC_SETFLAGS\n"
 "	 G gid get grouplock\n"
 "	 g gid put grouplock\n"
 "	 K  link path to filename\n"
@@ -396,6 +397,14 @@ int main(int argc, char **argv)
 				exit(save_errno);
 			}
 			break;
+		case 'J':
+			len = atoi(commands+1);
+			if (ioctl(fd, LL_IOC_SETFLAGS, &len) == -1) {
+				save_errno = errno;
+				perror("ioctl(SETFLAGS)");
+				exit(save_errno);
+			}
+			break;
 		case 'K':
 			oldpath = POP_ARG();
 			if (oldpath == NULL)
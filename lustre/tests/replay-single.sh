@@ -1701,6 +1701,42 @@ test_65b() #bug 3055
 }
 run_test 65b "AT: verify early replies on packed reply / bulk"
 
+test_65c()
+{
+	remote_mds_nodsh && skip "remote MDS with nodsh" && return 0
+
+	at_start || return 0
+	local nr=10
+
+	mkdir -p $DIR/$tdir
+	$LCTL dk > /dev/null
+	debugsave
+	$LCTL set_param debug="other"
+	REQ_DELAY=$(lctl get_param -n mdc.${FSNAME}-MDT0000-mdc-*.timeouts |
+		    awk '/portal 12/ {print $5}')
+	REQ_DELAY=$((REQ_DELAY + REQ_DELAY / 4 + 5))
+
+	do_facet $SINGLEMDS $LCTL set_param fail_val=$((REQ_DELAY * 1000))
+	# pause every request, so that they all wait for early replies at once
+#define OBD_FAIL_PTLRPC_PAUSE_REQ        0x50a
+	do_facet $SINGLEMDS $LCTL set_param fail_loc=0x50a
+	for i in $(seq $nr); do
+		touch $DIR/$tdir/$tfile-$i &
+	done
+	wait
+	do_facet $SINGLEMDS $LCTL set_param fail_loc=0
+	do_facet $SINGLEMDS $LCTL set_param fail_val=0
+
+	local count=$($LCTL dk | grep -c "Early reply #")
+	debugrestore
+	[ $count -ge $nr ] || error "only $count early replies for $nr requests"
+	for i in $(seq $nr); do
+		[ -f $DIR/$tdir/$tfile-$i ] || error "$tfile-$i not created"
+	done
+	rm -rf $DIR/$tdir
+}
+run_test 65c "AT: early replies for many concurrent slow requests"
+
 test_66a() #bug 3055
 {
     remote_ost_nodsh && skip "remote OST with nodsh" && return 0
@@ -2806,6 +2842,33 @@ test_90() { # bug 19494
 }
 run_test 90 "lfs find identifies the missing striped file segments"
 
+test_91() {
+	local param="mdt.${FSNAME}-MDT0000.recovery_status"
+	local i
+
+	mkdir -p $DIR/$tdir
+	replay_barrier $SINGLEMDS
+	for i in $(seq 1 20); do
+		touch $DIR/$tdir/f$i || error "touch $DIR/$tdir/f$i failed"
+	done
+	# hold some locks across the failover so lock replay has work to do
+	ls -l $DIR/$tdir > /dev/null
+	fail $SINGLEMDS
+
+	do_facet $SINGLEMDS $LCTL get_param -n $param
+	do_facet $SINGLEMDS $LCTL get_param -n $param |
+		grep -q "phase_duration_ms" ||
+		error "recovery phase durations not reported"
+	do_facet $SINGLEMDS $LCTL get_param -n $param |
+		grep -q "replayed_locks" ||
+		error "replayed lock count not reported"
+	for i in $(seq 1 20); do
+		$CHECKSTAT -t file $DIR/$tdir/f$i ||
+			error "$DIR/$tdir/f$i missing after recovery"
+	done
+}
+run_test 91 "recovery reports replayed locks and phase durations"
+
 complete $SECONDS
 check_and_cleanup_lustre
 exit_status
@@ -2310,6 +2310,74 @@ test_36() {
 }
 run_test 36 "Migrate old admin files into new global indexes"
 
+test_37() {
+	local blimit=$((1024 * 100)) # 100M
+	local TESTFILE="$DIR/$tdir/$tfile"
+	local param="osd-$(facet_fstype ost1).$FSNAME-OST0000"
+	local dqacq
+
+	setup_quota_test
+	trap cleanup_quota_test EXIT
+
+	set_ost_qtype "u" || error "enable ost quota failed"
+
+	$LFS setstripe -i 0 -c 1 $TESTFILE
+	chown $TSTUSR.$TSTUSR $TESTFILE
+
+	$LFS setquota -u $TSTUSR -b 0 -B $blimit -i 0 -I 0 $DIR ||
+		error "set quota failed"
+
+	do_facet ost1 $LCTL set_param $param.quota_slave.acquire_latency=0
+	$RUNAS $DD of=$TESTFILE count=50 oflag=sync ||
+		error "write failure, expect success"
+
+	do_facet ost1 $LCTL get_param $param.quota_slave.stats
+	do_facet ost1 $LCTL get_param $param.quota_slave.acquire_latency
+	dqacq=$(do_facet ost1 $LCTL get_param -n \
+		$param.quota_slave.stats | awk '/^(dqacq|intent) / { n += $2 }
+		END { print n + 0 }')
+	[ $dqacq -gt 0 ] || error "no acquire request accounted"
+
+	cleanup_quota_test
+	resetquota -u $TSTUSR
+}
+run_test 37 "Quota slave request statistics"
+
+test_38() {
+	local blimit=10 # 10M
+	local TESTFILE="$DIR/$tdir/$tfile"
+	local param="qmt.$FSNAME-QMT0000"
+	local reba
+
+	setup_quota_test
+	trap cleanup_quota_test EXIT
+
+	set_ost_qtype "u" || error "enable ost quota failed"
+
+	$LFS setstripe -i 0 -c 1 $TESTFILE
+	chown $TSTUSR.$TSTUSR $TESTFILE
+
+	do_facet $SINGLEMDS $LCTL set_param $param.stats=clear
+	do_facet $SINGLEMDS $LCTL set_param $param.rebalance_latency=0
+
+	$LFS setquota -u $TSTUSR -b 0 -B ${blimit}M -i 0 -I 0 $DIR ||
+		error "set quota failed"
+
+	# exceed the limit so that qunit shrinks and edquot is broadcast
+	$RUNAS $DD of=$TESTFILE count=$((blimit * 2)) oflag=sync &&
+		quota_error u $TSTUSR "write success, but expect EDQUOT"
+
+	do_facet $SINGLEMDS $LCTL get_param $param.stats
+	do_facet $SINGLEMDS $LCTL get_param $param.rebalance_latency
+	reba=$(do_facet $SINGLEMDS $LCTL get_param -n $param.stats |
+		awk '/^reba_id / { print $2 }')
+	[ ${reba:-0} -gt 0 ] || error "no rebalancing accounted"
+
+	cleanup_quota_test
+	resetquota -u $TSTUSR
+}
+run_test 38 "Quota master rebalancing statistics"
+
 quota_fini()
 {
         do_nodes $(comma_list $(nodes_list)) "lctl set_param debug=-quota"
@@ -6043,6 +6043,40 @@ test_101f() {
 }
 run_test 101f "check read-ahead for max_read_ahead_whole_mb"
 
+page_alloc_hits() {
+	$LCTL get_param -n llite.*.site |
+		awk '/^page_alloc/ { sum += $4 } END { print sum + 0 }'
+}
+
+test_101g() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	$LCTL get_param -n llite.*.site | grep -q "^page_alloc" ||
+		{ skip "no cl_page allocation stats"; return; }
+
+	local file=$DIR/$tfile
+	local before
+	local hits
+
+	dd if=/dev/zero of=$file bs=1M count=32 || error "dd write failed"
+	cancel_lru_locks osc
+	$LCTL set_param -n llite.*.read_ahead_stats 0
+
+	before=$(page_alloc_hits)
+	dd if=$file of=/dev/null bs=1M || error "dd read failed"
+	cancel_lru_locks osc
+	dd if=$file of=/dev/null bs=1M || error "dd read failed"
+	hits=$(($(page_alloc_hits) - before))
+
+	$LCTL get_param -n llite.*.site | grep "^page_alloc"
+	$LCTL get_param -n llite.*.read_ahead_stats
+	# pages freed by the lock cancel are reused by the second read
+	[ $hits -gt 0 ] || error "no cl_page reused from the magazines"
+	cmp $file /dev/zero -n $((32 * 1048576)) ||
+		error "data mismatch after batched read-ahead"
+	rm -f $file
+}
+run_test 101g "read-ahead pages come from the cl_page magazines"
+
 setup_test102() {
 	test_mkdir -p $DIR/$tdir
 	chown $RUNAS_ID $DIR/$tdir
@@ -6614,6 +6648,101 @@ test_115() {
 }
 run_test 115 "verify dynamic thread creation===================="
 
+ost_io_reaped() {
+	do_facet ost1 $LCTL get_param -n ost.OSS.ost_io.threads_control |
+		awk '{ for (i = 1; i < NF; i++)
+			if ($i == "reaped") sum += $(i + 1) }
+		     END { print sum + 0 }'
+}
+
+test_115b() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	remote_ost_nodsh && skip "remote OST with nodsh" && return
+
+	local param="ost.OSS.ost_io"
+	local timeout=$(do_facet ost1 $LCTL get_param -n \
+			$param.threads_idle_timeout)
+	local tmin=$(do_facet ost1 $LCTL get_param -n $param.threads_min)
+	local burst
+	local started
+	local reaped
+	local i
+
+	[ -z "$timeout" ] && skip "no idle thread reaping on ost1" && return
+
+	do_facet ost1 $LCTL set_param $param.threads_idle_timeout=$timeout
+	reaped=$(ost_io_reaped)
+
+	# a burst of slow writes keeps all threads busy, more are started
+	mkdir -p $DIR/$tdir || error "mkdir $DIR/$tdir failed"
+	$SETSTRIPE -c 1 -i 0 $DIR/$tdir || error "setstripe failed"
+	#define OBD_FAIL_OST_BRW_PAUSE_PACK	0x224
+	do_facet ost1 $LCTL set_param fail_val=2 fail_loc=0x224
+	for i in $(seq 64); do
+		dd if=/dev/zero of=$DIR/$tdir/f$i bs=4k count=1 \
+			oflag=direct 2>/dev/null &
+	done
+	sleep 3
+	burst=$(do_facet ost1 $LCTL get_param -n $param.threads_started)
+	wait
+	do_facet ost1 $LCTL set_param fail_loc=0 fail_val=0
+	rm -rf $DIR/$tdir
+
+	echo "threads started during the burst $burst, min $tmin"
+	if [ $burst -le $tmin ]; then
+		skip "the burst started no extra threads"
+		return 0
+	fi
+
+	# idle threads above the minimum go away one per idle timeout
+	do_facet ost1 $LCTL set_param $param.threads_idle_timeout=1
+	for i in $(seq 60); do
+		started=$(do_facet ost1 $LCTL get_param -n \
+			  $param.threads_started)
+		[ $started -lt $burst ] && break
+		sleep 1
+	done
+	do_facet ost1 $LCTL get_param -n $param.threads_control
+	do_facet ost1 $LCTL set_param $param.threads_idle_timeout=$timeout
+
+	echo "threads started $started after idling, was $burst"
+	[ $started -lt $burst ] || error "no idle thread was reaped"
+	(( $(ost_io_reaped) > reaped )) || error "reaped count did not rise"
+	[ $started -ge $tmin ] || error "reaped below threads_min $tmin"
+}
+run_test 115b "idle service threads are reaped down to threads_min"
+
+reply_cache_hits() {
+	do_facet $SINGLEMDS $LCTL get_param -n mds.MDS.mdt.reply_stats |
+		awk '{ for (i = 1; i < NF; i++)
+			if ($i == "rs_cache_hits") sum += $(i + 1) }
+		     END { print sum + 0 }'
+}
+
+test_115c() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	remote_mds_nodsh && skip "remote MDS with nodsh" && return
+	do_facet $SINGLEMDS $LCTL get_param -n mds.MDS.mdt.reply_stats ||
+		{ skip "no reply state cache on $SINGLEMDS"; return; }
+
+	local count=2000
+	local before=$(reply_cache_hits)
+	local hits
+
+	test_mkdir -p $DIR/$tdir
+	createmany -o $DIR/$tdir/f $count || error "createmany failed"
+	sync
+	unlinkmany $DIR/$tdir/f $count || error "unlinkmany failed"
+
+	do_facet $SINGLEMDS $LCTL get_param -n mds.MDS.mdt.reply_stats
+	hits=$(($(reply_cache_hits) - before))
+	echo "$hits reply states reused for $((count * 2)) requests"
+	[ $hits -ge $count ] ||
+		error "only $hits reply states reused for $((count * 2)) requests"
+	rm -rf $DIR/$tdir
+}
+run_test 115c "reply states are reused from the per-CPT cache"
+
 free_min_max () {
 	wait_delete_completed
 	AVAIL=($(lctl get_param -n osc.*[oO][sS][cC]-[^M]*.kbytesavail))
@@ -7435,6 +7564,56 @@ test_120g() {
 }
 run_test 120g "Early Lock Cancel: performance test"
 
+test_120h() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	[ -z "$(lctl get_param -n osc.*.connect_flags | grep bl_ast_batch)" ] &&
+		skip "no batched blocking AST on server" && return 0
+	local nlocks=64
+	local i
+
+	test_mkdir -p $DIR/$tdir
+	$SETSTRIPE -c 1 -i 0 $DIR/$tdir/$tfile || error "setstripe failed"
+	lru_resize_disable osc
+	cancel_lru_locks osc
+
+	# grant the extents as requested, each write below gets its own lock
+	#define OBD_FAIL_LDLM_NO_EXPANSION	 0x31d
+	do_facet ost1 lctl set_param fail_loc=0x31d
+	for ((i = 0; i < $nlocks; i++)); do
+		dd if=/dev/zero of=$DIR/$tdir/$tfile bs=4k count=1 \
+			seek=$((i * 2)) conv=notrunc 2>/dev/null ||
+			{ do_facet ost1 lctl set_param fail_loc=0;
+			  error "write $i failed"; }
+	done
+	do_facet ost1 lctl set_param fail_loc=0
+
+	local granted=$(lctl get_param -n \
+		ldlm.namespaces.*-OST0000-osc-[^M]*.lock_count)
+	[ $granted -ge $nlocks ] || {
+		lru_resize_enable osc
+		error "only $granted locks granted for $nlocks writes"; }
+
+	local blk1=$(lctl get_param -n ldlm.services.ldlm_cbd.stats |
+		     awk '/ldlm_bl_callback/ {print $2}')
+	# the truncate lock conflicts with all the write locks of the client
+	$TRUNCATE $DIR/$tdir/$tfile 0 || error "truncate failed"
+	local blk2=$(lctl get_param -n ldlm.services.ldlm_cbd.stats |
+		     awk '/ldlm_bl_callback/ {print $2}')
+	local left=$(lctl get_param -n \
+		ldlm.namespaces.*-OST0000-osc-[^M]*.lock_count)
+	lru_resize_enable osc
+
+	local revoked=$((granted - left))
+	local rpcs=$((${blk2:-0} - ${blk1:-0}))
+	echo "$revoked locks revoked by $rpcs blocking AST RPCs"
+	[ $rpcs -gt 0 ] || error "no blocking AST received"
+	[ $rpcs -lt $revoked ] ||
+		error "$rpcs blocking AST RPCs for $revoked locks, not batched"
+	$CHECKSTAT -s 0 $DIR/$tdir/$tfile || error "wrong size after truncate"
+	rm -rf $DIR/$tdir
+}
+run_test 120h "Batched blocking AST on a conflict with many locks"
+
 test_121() { #bug #10589
 	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
 	rm -rf $DIR/$tfile
@@ -7717,6 +7896,112 @@ test_124b() {
 }
 run_test 124b "lru resize (performance test) ======================="
 
+# replay the same trace with both LRU cancel policies and report the cost
+lru_policy_run() {
+	local dir=$1
+	local nr=$2
+	local stime
+	local enq
+
+	cancel_lru_locks mdc
+	cancel_lru_locks osc
+	$LCTL set_param -n mdc.*.stats=0 osc.*.stats=0
+	stime=$(date +%s)
+	# metadata trace: revisit a hot subset while streaming the cold files
+	for i in 1 2 3; do
+		ls -la $dir/md > /dev/null
+		stat $dir/md/f0 $dir/md/f1 $dir/md/f2 > /dev/null
+	done
+	# I/O trace: data locks covering cached pages compete with cold ones
+	for i in $(seq 0 $((nr / 10))); do
+		cat $dir/io/f$i > /dev/null
+	done
+	for i in $(seq 0 $((nr / 10))); do
+		cat $dir/io/f$((i % 4)) > /dev/null
+	done
+	enq=$($LCTL get_param -n mdc.*.stats osc.*.stats |
+	      awk '/ldlm_enqueue/ { sum += $2 } END { print sum + 0 }')
+	echo "$(($(date +%s) - stime)) $enq"
+}
+
+test_124c() {
+	[ -z "$($LCTL get_param -n ldlm.namespaces.*mdc*.lru_cost_aware)" ] &&
+		skip "no cost aware lru policy on client" && return 0
+
+	local nr=1000
+	local lru=100
+	local old_lru=$($LCTL get_param -n ldlm.namespaces.*mdc*.lru_size |
+			head -1)
+	local res
+
+	test_mkdir -p $DIR/$tdir/md || error "mkdir $DIR/$tdir/md failed"
+	test_mkdir -p $DIR/$tdir/io || error "mkdir $DIR/$tdir/io failed"
+	createmany -o $DIR/$tdir/md/f $nr || error "createmany failed"
+	for i in $(seq 0 $((nr / 10))); do
+		dd if=/dev/zero of=$DIR/$tdir/io/f$i bs=64k count=4 \
+			2>/dev/null || error "dd to f$i failed"
+	done
+
+	$LCTL set_param ldlm.namespaces.*.lru_size=$lru
+
+	for policy in 0 1; do
+		$LCTL set_param ldlm.namespaces.*.lru_cost_aware=$policy
+		res=($(lru_policy_run $DIR/$tdir $nr))
+		log "lru_cost_aware=$policy: ${res[0]} seconds," \
+		    "${res[1]} lock enqueues"
+		[ $($LCTL get_param -n ldlm.namespaces.*mdc*.lock_unused_count |
+		    head -1) -le $((lru * 2)) ] ||
+			error "unused locks exceed lru_size with policy $policy"
+	done
+
+	$LCTL set_param ldlm.namespaces.*.lru_cost_aware=0
+	$LCTL set_param ldlm.namespaces.*.lru_size=$old_lru
+	unlinkmany $DIR/$tdir/md/f $nr
+	rm -rf $DIR/$tdir
+}
+run_test 124c "lru cancel policy comparison (performance test) ====="
+
+test_124d() {
+	[ -z "$(do_facet $SINGLEMDS $LCTL get_param -n \
+		ldlm.namespaces.mdt-*.pool.mem_used 2>/dev/null)" ] &&
+		skip "no lock pool memory accounting on server" && return 0
+
+	local nsdir="ldlm.namespaces.mdt-$FSNAME-MDT0000*.pool"
+	local nr=500
+	local mem0
+	local mem1
+	local slv0
+	local slv1
+
+	test_mkdir -p $DIR/$tdir || error "mkdir $DIR/$tdir failed"
+	cancel_lru_locks mdc
+	mem0=$(do_facet $SINGLEMDS $LCTL get_param -n $nsdir.mem_used)
+	createmany -o $DIR/$tdir/f $nr || error "createmany failed"
+	ls -l $DIR/$tdir > /dev/null
+	mem1=$(do_facet $SINGLEMDS $LCTL get_param -n $nsdir.mem_used)
+	log "lock pool memory: $mem0 -> $mem1 bytes for $nr files"
+	[ $mem1 -gt $mem0 ] || error "lock memory did not grow: $mem0 $mem1"
+	do_facet $SINGLEMDS $LCTL get_param -n $nsdir.state | grep -q "ML:" ||
+		error "no memory limit in pool state"
+
+	# a tiny budget must drive the SLV down on next recalc
+	slv0=$(do_facet $SINGLEMDS $LCTL get_param -n \
+		$nsdir.server_lock_volume)
+	do_facet $SINGLEMDS $LCTL set_param $nsdir.mem_budget=4096
+	sleep 3
+	touch $DIR/$tdir/f0
+	slv1=$(do_facet $SINGLEMDS $LCTL get_param -n \
+		$nsdir.server_lock_volume)
+	do_facet $SINGLEMDS $LCTL set_param $nsdir.mem_budget=0
+	log "SLV with 4k budget: $slv0 -> $slv1"
+	[ $slv1 -lt $slv0 ] || error "SLV did not drop: $slv0 $slv1"
+
+	unlinkmany $DIR/$tdir/f $nr
+	cancel_lru_locks mdc
+	rm -rf $DIR/$tdir
+}
+run_test 124d "lock pool memory accounting and budget"
+
 test_125() { # 13358
 	[ -z "$(lctl get_param -n llite.*.client_type | grep local)" ] && skip "must run as local client" && return
 	[ -z "$(lctl get_param -n mdc.*-mdc-*.connect_flags | grep acl)" ] && skip "must have acl enabled" && return
@@ -9504,6 +9789,51 @@ test_160b() { # LU-3587
 }
 run_test 160b "Verify that very long rename doesn't crash in changelog"
 
+test_160c() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	remote_mds_nodsh && skip "remote MDS with nodsh" && return
+
+	local nfiles=${NFILES:-10000}
+	local rate_off
+	local rate_on
+	local creates
+	local unlinks
+	local gaps
+
+	test_mkdir -p $DIR/$tdir
+	rate_off=$(createmany -o $DIR/$tdir/off- $nfiles |
+		   awk '/creates\/second/ { print $(NF-1) }')
+	unlinkmany $DIR/$tdir/off- $nfiles
+
+	USER=$(do_facet $SINGLEMDS $LCTL --device $MDT0 changelog_register -n)
+	echo "Registered as changelog user $USER"
+	rate_on=$(createmany -o $DIR/$tdir/on- $nfiles |
+		  awk '/creates\/second/ { print $(NF-1) }')
+	unlinkmany $DIR/$tdir/on- $nfiles
+
+	# every record appended under load is there, once and in order
+	creates=$($LFS changelog $MDT0 |
+		  awk '/CREAT/ && $NF ~ /^on-/ { n++ } END { print n + 0 }')
+	unlinks=$($LFS changelog $MDT0 |
+		  awk '/UNLNK/ && $NF ~ /^on-/ { n++ } END { print n + 0 }')
+	gaps=$($LFS changelog $MDT0 |
+	       awk 'NR > 1 && $1 != prev + 1 { n++ } { prev = $1 }
+		    END { print n + 0 }')
+
+	$LFS changelog_clear $MDT0 $USER 0
+	do_facet $SINGLEMDS $LCTL --device $MDT0 changelog_deregister $USER
+
+	echo "create rate: changelog off $rate_off/s, on $rate_on/s"
+	[ -n "$rate_off" -a -n "$rate_on" ] ||
+		error "createmany failed: off '$rate_off' on '$rate_on'"
+	[ $creates -eq $nfiles ] ||
+		error "$creates CREAT records, expected $nfiles"
+	[ $unlinks -eq $nfiles ] ||
+		error "$unlinks UNLNK records, expected $nfiles"
+	[ $gaps -eq 0 ] || error "$gaps changelog records out of order"
+}
+run_test 160c "changelog records under a create load, and create rate"
+
 test_161a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
     test_mkdir -p $DIR/$tdir
@@ -11743,6 +12073,450 @@ test_236() {
 }
 run_test 236 "Layout swap on open unlinked file"
 
+ost_ping_count() {
+	do_facet ost1 "$LCTL get_param -n ost.OSS.ost.stats" |
+		awk '/^obd_ping/ { print $2 }'
+}
+
+test_237() {
+	[ $OSTCOUNT -lt 2 ] && skip "needs >= 2 OSTs" && return
+	[ $(facet_active_host ost1) != $(facet_active_host ost2) ] &&
+		skip "needs OSTs sharing a node" && return
+	$LCTL get_param -n osc.*.connect_flags | grep -q ping_aggregate ||
+		{ skip "server does not support aggregated pings"; return; }
+
+	local param=/sys/module/ptlrpc/parameters/ping_aggregate
+	local old=$(cat $param)
+	local interval=$(($($LCTL get_param -n timeout) / 4 + 1))
+	local before
+	local single
+	local aggr
+
+	echo 0 > $param
+	sleep $interval
+	before=$(ost_ping_count)
+	sleep $((interval * 2))
+	single=$(($(ost_ping_count) - before))
+
+	echo 1 > $param
+	sleep $interval
+	before=$(ost_ping_count)
+	sleep $((interval * 2))
+	aggr=$(($(ost_ping_count) - before))
+	echo $old > $param
+
+	echo "pings to ost1 node: $single single, $aggr aggregated"
+	[ $aggr -lt $single ] ||
+		error "aggregation did not reduce pings: $aggr >= $single"
+}
+run_test 237 "one ping per server node for all its targets"
+
+xattr_cache_stat() {
+	$LCTL get_param -n llite.*.xattr_cache_stats |
+		awk -F': ' '$1 == "'"$1"'" { sum += $2 } END { print sum + 0 }'
+}
+
+test_238a() {
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local file=$DIR/$tfile
+	local before
+	local i
+
+	save_lustre_params client "llite.*.xattr_cache" > $p
+	save_lustre_params client "llite.*.max_xattr_cache_mb" >> $p
+	lctl set_param llite.*.xattr_cache 1 ||
+		{ skip "xattr cache is not supported"; return 0; }
+
+	touch $file || error "touch failed"
+	setfattr -n user.present -v value $file || error "setfattr failed"
+	getfattr -n user.present $file || error "getfattr failed"
+
+	before=$(xattr_cache_stat "negative hits")
+	for i in $(seq 10); do
+		getfattr -n user.missing $file 2>/dev/null &&
+			error "user.missing should not exist"
+	done
+	(( $(xattr_cache_stat "negative hits") - before >= 10 )) ||
+		error "missing xattr was not answered from the cache"
+
+	# a zero limit drops every cache once it is used
+	before=$(xattr_cache_stat reclaimed)
+	lctl set_param llite.*.max_xattr_cache_mb 0
+	getfattr -n user.present $file | grep -q value ||
+		error "wrong value after reclaim"
+	getfattr -n user.present $file | grep -q value ||
+		error "wrong value after refill"
+	$LCTL get_param llite.*.xattr_cache_stats
+	(( $(xattr_cache_stat reclaimed) > before )) ||
+		error "xattr cache was not reclaimed"
+
+	restore_lustre_params < $p
+	rm -f $p $file
+}
+run_test 238a "xattr cache negative lookups and memory limit"
+
+test_238b() {
+	large_xattr_enabled || { skip "large_xattr disabled" && return; }
+
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local file=$DIR/$tfile
+	local size=$(($(max_xattr_size) - 1024))
+	local value=$(printf "%${size}s" | tr ' ' a)
+	local before
+	local i
+
+	save_lustre_params client "llite.*.xattr_cache" > $p
+	lctl set_param llite.*.xattr_cache 1 ||
+		{ skip "xattr cache is not supported"; return 0; }
+
+	touch $file || error "touch failed"
+	# more values than one refill can fetch, the cache is filled name by
+	# name after the refill failed with -ERANGE
+	for i in 0 1 2; do
+		setfattr -n user.big$i -v $value $file ||
+			error "setfattr user.big$i failed"
+	done
+	cancel_lru_locks mdc
+
+	before=$(xattr_cache_stat misses)
+	getfattr -n user.big1 $file > /dev/null || error "getfattr failed"
+	(( $(xattr_cache_stat misses) > before )) ||
+		error "first getxattr did not go to the MDS"
+
+	before=$(xattr_cache_stat hits)
+	for i in $(seq 10); do
+		getfattr -n user.big1 $file > /dev/null ||
+			error "getfattr $i failed"
+	done
+	(( $(xattr_cache_stat hits) - before >= 10 )) ||
+		error "cached xattr was not answered from the partial cache"
+
+	getfattr -n user.missing $file 2>/dev/null &&
+		error "user.missing should not exist"
+	before=$(xattr_cache_stat "negative hits")
+	for i in $(seq 10); do
+		getfattr -n user.missing $file 2>/dev/null &&
+			error "user.missing should not exist"
+	done
+	(( $(xattr_cache_stat "negative hits") - before >= 10 )) ||
+		error "missing xattr was not answered from the partial cache"
+
+	# a change revokes the lock, neither the old value nor the negative
+	# entry may be returned afterwards
+	setfattr -n user.big1 -v short $file || error "setfattr short failed"
+	setfattr -n user.missing -v here $file || error "setfattr here failed"
+	getfattr -n user.big1 $file | grep -q '"short"' ||
+		error "stale user.big1 returned after a change"
+	getfattr -n user.missing $file | grep -q '"here"' ||
+		error "stale negative entry for user.missing"
+	$LCTL get_param llite.*.xattr_cache_stats
+
+	restore_lustre_params < $p
+	rm -f $p $file
+}
+run_test 238b "partial xattr cache for xattrs too large for one refill"
+
+test_239() {
+	[ $OSTCOUNT -lt 2 ] && skip "needs >= 2 OSTs" && return
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+
+	local param="lov.$FSNAME-clilov-*.parallel_stripes"
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local file=$DIR/$tfile
+	local sum
+	local start
+	local elapsed
+	local n
+
+	$LCTL get_param -n $param > /dev/null 2>&1 ||
+		{ skip "no parallel stripe submission"; return 0; }
+	save_lustre_params client "$param" > $p
+
+	$SETSTRIPE -c -1 -S 1M $file || error "setstripe failed"
+	dd if=/dev/urandom of=$file bs=1M count=$((OSTCOUNT * 16)) ||
+		error "dd write failed"
+	sum=$(md5sum < $file)
+
+	for n in 0 2; do
+		$LCTL set_param -n $param $n
+		cancel_lru_locks osc
+		start=$(date +%s%N)
+		dd if=$file of=/dev/null bs=$((OSTCOUNT * 4))M ||
+			error "dd read failed"
+		elapsed=$((($(date +%s%N) - start) / 1000000))
+		echo "parallel_stripes=$n: read $((OSTCOUNT * 16))MB" \
+			"in $elapsed ms"
+
+		cancel_lru_locks osc
+		[ "$(md5sum < $file)" == "$sum" ] ||
+			error "data mismatch with parallel_stripes=$n"
+		dd if=$file of=$file.copy bs=1M oflag=direct ||
+			error "direct copy failed"
+		[ "$(md5sum < $file.copy)" == "$sum" ] ||
+			error "direct copy mismatch with parallel_stripes=$n"
+		rm -f $file.copy
+	done
+
+	# per file, with the mount tunable off
+	$LCTL set_param -n $param 0
+	cancel_lru_locks osc
+	start=$(date +%s%N)
+	#define LL_FILE_PARALLEL_IO 0x40
+	$MULTIOP $file oJ64r$((OSTCOUNT * 16 * 1048576))c ||
+		error "read with LL_FILE_PARALLEL_IO failed"
+	elapsed=$((($(date +%s%N) - start) / 1000000))
+	echo "LL_FILE_PARALLEL_IO: read $((OSTCOUNT * 16))MB in $elapsed ms"
+	# md5sum reads the pages multiop left in the cache
+	[ "$(md5sum < $file)" == "$sum" ] ||
+		error "data mismatch after LL_FILE_PARALLEL_IO read"
+
+	restore_lustre_params < $p
+	rm -f $p $file
+}
+run_test 239 "stripes of one submission are sent in parallel"
+
+mdc_close_count() {
+	$LCTL get_param -n mdc.*.stats |
+		awk '/^mds_close/ { sum += $2 } END { print sum + 0 }'
+}
+
+test_240() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local file=$DIR/$tfile
+	local closes
+	local i
+
+	$LCTL get_param -n llite.*.opencache_threshold > /dev/null 2>&1 ||
+		{ skip "no open handle cache"; return 0; }
+	save_lustre_params client "llite.*.opencache_threshold" > $p
+	save_lustre_params client "llite.*.opencache_max" >> $p
+	$LCTL set_param llite.*.opencache_threshold=2
+	$LCTL set_param llite.*.opencache_max=1024
+
+	echo data > $file || error "write failed"
+	cancel_lru_locks mdc
+	$LCTL set_param mdc.*.stats=clear
+	for i in $(seq 20); do
+		cat $file > /dev/null || error "cat $i failed"
+	done
+	closes=$(mdc_close_count)
+	$LCTL get_param llite.*.opencache_stats
+	echo "$closes close RPCs for 20 opens"
+	(( closes < 10 )) || error "open handles were not cached"
+
+	# no room in the cache, every handle is closed again
+	$LCTL set_param llite.*.opencache_max=0
+	$LCTL set_param mdc.*.stats=clear
+	for i in $(seq 5); do
+		cat $file > /dev/null || error "cat $i failed"
+	done
+	# the cancelled OPEN locks close the handles asynchronously
+	for i in $(seq 10); do
+		(( $(mdc_close_count) >= 5 )) && break
+		sleep 1
+	done
+	$LCTL get_param llite.*.opencache_stats
+	(( $(mdc_close_count) >= 5 )) ||
+		error "handles cached over the limit"
+
+	restore_lustre_params < $p
+	rm -f $p $file
+}
+run_test 240 "open handles are cached for frequently opened files"
+
+ost_sync_count() {
+	$LCTL get_param -n osc.*.stats |
+		awk '/^ost_sync/ { sum += $2 } END { print sum + 0 }'
+}
+
+test_241() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	$LCTL get_param -n osc.*.osc_stats | grep -q sync_skipped ||
+		{ skip "no OST commit tracking"; return 0; }
+
+	local file=$DIR/$tfile
+	local syncs
+
+	$SETSTRIPE -c 1 $file || error "setstripe failed"
+	clear_osc_stats
+	$LCTL set_param osc.*.stats=clear
+	# only the first fdatasync has uncommitted writes to flush
+	$MULTIOP $file Ow4096YYYYYc || error "multiop failed"
+	syncs=$(ost_sync_count)
+	$LCTL get_param osc.*.osc_stats | grep sync_skipped
+	echo "$syncs OST_SYNC RPCs for 5 fdatasyncs"
+	(( syncs <= 1 )) || error "committed writes were synced again"
+	[ $(calc_osc_stats sync_skipped) -ne 0 ] ||
+		error "no fdatasync was answered locally"
+
+	# a new write has to be synced again
+	$MULTIOP $file Ow4096Yc || error "multiop failed"
+	(( $(ost_sync_count) > syncs )) ||
+		error "uncommitted write was not synced"
+
+	# so does a truncate of committed data, which is no write at all
+	$MULTIOP $file OYYc || error "multiop failed"
+	syncs=$(ost_sync_count)
+	$MULTIOP $file OT1024Yc || error "multiop truncate failed"
+	(( $(ost_sync_count) > syncs )) ||
+		error "uncommitted truncate was not synced"
+	$CHECKSTAT -s 1024 $file || error "wrong size after truncate"
+	rm -f $file
+}
+run_test 241 "fsync skips OST_SYNC once the writes are committed"
+
+cache_dirty_max() {
+	$LCTL get_param -n llite.*.cache_usage |
+		awk "/$1-osc/ { print \$NF; exit }"
+}
+
+test_242() {
+	[ $OSTCOUNT -lt 2 ] && skip_env "needs >= 2 OSTs" && return
+	$LCTL get_param -n llite.*.cache_usage > /dev/null 2>&1 ||
+		{ skip "no client cache usage reporting"; return 0; }
+
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local ost0=$(ostname_from_index 0)
+	local ost1=$(ostname_from_index 1)
+	local dirty
+	local max_dirty=0
+	local share
+	local share2
+	local pid0
+	local pid1
+	local i
+
+	save_lustre_params client "osc.*.max_dirty_mb" > $p
+	$LCTL set_param -n osc.*.max_dirty_mb 1
+
+	$SETSTRIPE -c 1 -i 0 $DIR/$tfile.0 || error "setstripe $ost0 failed"
+	$SETSTRIPE -c 1 -i 1 $DIR/$tfile.1 || error "setstripe $ost1 failed"
+
+	# hold the BRW RPCs on the OSTs, so the written pages stay dirty
+	#define OBD_FAIL_OST_BRW_PAUSE_BULK 0x214
+	set_nodes_failloc "$(osts_nodes)" 0x214
+	dd if=/dev/zero of=$DIR/$tfile.0 bs=1M count=4 2>/dev/null &
+	pid0=$!
+
+	# alone, OST0 may use the max_dirty_mb of the idle OSCs as well
+	for i in $(seq 10); do
+		sleep 1
+		dirty=$($LCTL get_param -n osc.$ost0-osc-[^M]*.cur_dirty_bytes)
+		(( dirty > max_dirty )) && max_dirty=$dirty
+	done
+	share=$(cache_dirty_max $ost0)
+	$LCTL get_param llite.*.cache_usage
+
+	dd if=/dev/zero of=$DIR/$tfile.1 bs=1M count=4 2>/dev/null &
+	pid1=$!
+	sleep 5
+	share2=$(cache_dirty_max $ost0)
+	$LCTL get_param llite.*.cache_usage
+
+	set_nodes_failloc "$(osts_nodes)" 0
+	wait $pid0 || error "dd to $ost0 failed"
+	wait $pid1 || error "dd to $ost1 failed"
+
+	restore_lustre_params < $p
+	rm -f $p
+
+	(( max_dirty > 1048576 )) ||
+		error "$ost0 dirty $max_dirty never went over max_dirty_mb"
+	[ -n "$share2" ] || error "$ost0 is not listed in cache_usage"
+	(( share2 < share )) ||
+		error "$ost0 limit $share2 not reduced from $share by $ost1"
+	[ $OSTCOUNT -gt 2 ] || (( share2 == 1048576 )) ||
+		error "$ost0 limit $share2 not capped to max_dirty_mb"
+
+	cancel_lru_locks osc
+	for i in 0 1; do
+		[ $(stat -c %s $DIR/$tfile.$i) -eq $((4 * 1048576)) ] ||
+			error "wrong size of $tfile.$i"
+	done
+	rm -f $DIR/$tfile.*
+}
+run_test 242 "OSCs share the max_dirty_mb of idle OSCs"
+
+llite_stats_count() {
+	$LCTL get_param -n llite.*.stats |
+		awk "/^$1 / { sum += \$2 } END { print sum + 0 }"
+}
+
+test_243() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	$LCTL get_param -n llite.*.fast_fault > /dev/null 2>&1 ||
+		{ skip "no mmap fast fault"; return 0; }
+
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local file=$DIR/$tfile
+	local faults
+	local cached
+
+	save_lustre_params client "llite.*.fast_fault" > $p
+	$LCTL set_param -n llite.*.fast_fault 1
+
+	dd if=/dev/urandom of=$file bs=1M count=4 || error "dd failed"
+	cancel_lru_locks osc
+	# cache the pages, faults on them need no cl_io then
+	cat $file > /dev/null || error "read failed"
+	$LCTL set_param -n llite.*.stats=0
+	$MULTIOP $file OSMRUc || error "mmap read failed"
+	faults=$(llite_stats_count fault)
+	cached=$(llite_stats_count fault_cached)
+	echo "$cached of $faults faults served from cache"
+	(( faults > 0 )) || error "no faults counted"
+	(( cached * 2 >= faults )) || error "cached pages faulted the slow way"
+
+	$LCTL set_param -n llite.*.fast_fault 0
+	$LCTL set_param -n llite.*.stats=0
+	$MULTIOP $file OSMRUc || error "mmap read failed"
+	(( $(llite_stats_count fault_cached) == 0 )) ||
+		error "fast fault used while disabled"
+
+	restore_lustre_params < $p
+	rm -f $p $file
+}
+run_test 243 "mmap faults on cached pages skip the cl_io setup"
+
+test_244() {
+	local dir=$DIR/$tdir
+	local count=20000
+	local entries
+	local pid
+
+	mkdir -p $dir || error "mkdir failed"
+	createmany -o $dir/f- $count || error "createmany failed"
+	cancel_lru_locks mdc
+
+	entries=$(ls -f $dir | wc -l)
+	[ $entries -eq $((count + 2)) ] ||
+		error "readdir returned $entries entries, expected $((count + 2))"
+
+	# a create revokes the lock the readdir uses from page to page; the
+	# readdir has to take a new one and still return every entry once
+	cancel_lru_locks mdc
+	ls -f $dir > $TMP/$tfile.ls &
+	pid=$!
+	touch $dir/new || error "create during readdir failed"
+	wait $pid || error "readdir failed"
+	entries=$(grep -c "^f-" $TMP/$tfile.ls)
+	[ $entries -eq $count ] ||
+		error "readdir during create returned $entries of $count files"
+	[ -z "$(sort $TMP/$tfile.ls | uniq -d)" ] ||
+		error "readdir during create returned duplicate entries"
+	rm -f $TMP/$tfile.ls
+
+	entries=$(ls -f $dir | wc -l)
+	[ $entries -eq $((count + 3)) ] ||
+		error "readdir returned $entries entries, expected $((count + 3))"
+
+	unlinkmany $dir/f- $count || error "unlinkmany failed"
+	rm -rf $dir
+}
+run_test 244 "readdir reuses its lock across pages until it is revoked"
+
 #
 # tests that do cleanup/setup should be run at the end
 #
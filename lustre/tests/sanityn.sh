@@ -2543,6 +2543,96 @@ test_74() {
 }
 run_test 74 "flock deadlock: different mounts =============="
 
+test_75() {
+	$LCTL get_param -n mdc.*.connect_flags | grep -q lock_convert ||
+		{ skip "MDS does not support lock convert"; return 0; }
+
+	local before
+	local after
+
+	mkdir -p $DIR1/$tdir || error "mkdir $DIR1/$tdir failed"
+	touch $DIR1/$tdir/$tfile || error "touch $DIR1/$tdir/$tfile failed"
+	cancel_lru_locks mdc
+	# LOOKUP and UPDATE bits on the directory for the first mount
+	ls -l $DIR1/$tdir > /dev/null || error "ls $DIR1/$tdir failed"
+	before=$($LCTL get_param -n mdc.*.stats |
+		 awk '/ldlm_convert/ { sum += $2 } END { print sum + 0 }')
+
+	# create through the second mount conflicts with UPDATE only
+	touch $DIR2/$tdir/$tfile-2 || error "touch $DIR2/$tdir/$tfile-2 failed"
+	after=$($LCTL get_param -n mdc.*.stats |
+		awk '/ldlm_convert/ { sum += $2 } END { print sum + 0 }')
+	[ $after -gt $before ] ||
+		error "UPDATE bit was not dropped: $before -> $after converts"
+
+	# the kept lock has to be coherent with the change
+	ls $DIR1/$tdir | grep -q $tfile-2 ||
+		error "$tfile-2 not seen through $DIR1"
+	rm -rf $DIR1/$tdir
+}
+run_test 75 "inodebits lock drops conflicting bits on blocking AST"
+
+test_76() {
+	$LCTL get_param -n osc.*.contention_revokes > /dev/null 2>&1 ||
+		{ skip "no client-side contention detection"; return 0; }
+
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local i
+
+	save_lustre_params client "osc.*.contention_seconds" > $p
+	save_lustre_params client "osc.*.contention_revokes" >> $p
+
+	$LFS setstripe -c 1 -i 0 $DIR1/$tfile || error "setstripe failed"
+	clear_osc_stats
+	# both mounts write the same stripe, so its lock bounces between them
+	$LCTL set_param -n osc.*.contention_seconds 60
+	$LCTL set_param -n osc.*.contention_revokes 3
+	for i in $(seq 10); do
+		dd if=/dev/zero of=$DIR1/$tfile bs=4k count=1 seek=$((i * 2)) \
+			conv=notrunc > /dev/null 2>&1 || error "dd 1 failed"
+		dd if=/dev/zero of=$DIR2/$tfile bs=4k count=1 \
+			seek=$((i * 2 + 1)) conv=notrunc > /dev/null 2>&1 ||
+			error "dd 2 failed"
+	done
+	$LCTL get_param osc.*.osc_stats | grep -E "revokes|contended|lockless"
+	[ $(calc_osc_stats contended) -ne 0 ] ||
+		error "lock ping-pong was not detected"
+	[ $(calc_osc_stats lockless_write_bytes) -ne 0 ] ||
+		error "contended stripe was not written lockless"
+	$CHECKSTAT -s $((22 * 4096)) $DIR2/$tfile || error "wrong file size"
+
+	# without a threshold only the server decides
+	$LCTL set_param -n osc.*.contention_seconds 0
+	$LCTL set_param -n osc.*.contention_revokes 0
+	clear_osc_stats
+	for i in $(seq 10); do
+		dd if=/dev/zero of=$DIR1/$tfile bs=4k count=1 conv=notrunc \
+			> /dev/null 2>&1 || error "dd 1 failed"
+		dd if=/dev/zero of=$DIR2/$tfile bs=4k count=1 conv=notrunc \
+			> /dev/null 2>&1 || error "dd 2 failed"
+	done
+	[ $(calc_osc_stats contended) -eq 0 ] ||
+		error "contention detected while disabled"
+
+	# a file opened for lockless i/o is written without client locks,
+	# provided the OSTs agreed to lock for it
+	#define LL_FILE_LOCKLESS_IO	0x00000010
+	clear_osc_stats
+	if $LCTL get_param -n osc.*.connect_flags | grep -q server_lock; then
+		$MULTIOP $DIR1/$tfile oJ16c || error "LOCKLESS_IO refused"
+		$MULTIOP $DIR1/$tfile OJ16w4096c || error "lockless write failed"
+		[ $(calc_osc_stats lockless_write_bytes) -ne 0 ] ||
+			error "LL_FILE_LOCKLESS_IO write was not lockless"
+	else
+		$MULTIOP $DIR1/$tfile oJ16c &&
+			error "LOCKLESS_IO accepted without srvlock support"
+	fi
+
+	restore_lustre_params < $p
+	rm -f $p $DIR1/$tfile
+}
+run_test 76 "lock ping-pong switches a stripe to lockless i/o"
+
 log "cleanup: ======================================================"
 
 [ "$(mount | grep $MOUNT2)" ] && umount $MOUNT2
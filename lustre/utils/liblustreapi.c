@@ -4282,6 +4282,37 @@ int llapi_get_data_version(int fd, __u64 *data_version, __u64 flags)
         return rc;
 }
 
+/**
+ * Flush a byte range of an open file to the OSTs.
+ *
+ * Unlike fsync(), this does not have to block: without flags it only starts
+ * the writeback of the range and returns, so that an application can
+ * overlap it with more writes and call again with LL_SYNC_COMMIT later,
+ * which then only has to wait for whatever is not on disk yet.
+ *
+ * \param fd		File descriptor
+ * \param start	First byte of the range
+ * \param end		Last byte of the range, OBD_OBJECT_EOF for all
+ * \param flags	LL_SYNC_WAIT and/or LL_SYNC_COMMIT
+ *
+ * \retval 0 on success, negative errno on failure
+ */
+int llapi_file_sync_range(int fd, __u64 start, __u64 end, __u32 flags)
+{
+	struct ll_sync_range sr = {
+		.sr_start	= start,
+		.sr_end		= end,
+		.sr_flags	= flags,
+	};
+	int rc;
+
+	rc = ioctl(fd, LL_IOC_SYNC_RANGE, &sr);
+	if (rc)
+		rc = -errno;
+
+	return rc;
+}
+
 /*
  * Create a volatile file and open it for write:
  * - file is created as a standard file in the directory
@@ -523,6 +523,9 @@ check_obd_connect_data(void)
 	CHECK_DEFINE_64X(OBD_CONNECT_SHORTIO);
 	CHECK_DEFINE_64X(OBD_CONNECT_PINGLESS);
 	CHECK_DEFINE_64X(OBD_CONNECT_FLOCK_DEAD);
+	CHECK_DEFINE_64X(OBD_CONNECT_BL_BATCH);
+	CHECK_DEFINE_64X(OBD_CONNECT_LOCK_CONVERT);
+	CHECK_DEFINE_64X(OBD_CONNECT_PING_AGG);
 
 	CHECK_VALUE_X(OBD_CKSUM_CRC32);
 	CHECK_VALUE_X(OBD_CKSUM_ADLER);
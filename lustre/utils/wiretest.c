@@ -1168,6 +1168,12 @@ void lustre_assert_wire_constants(void)
 		 OBD_CONNECT_PINGLESS);
 	LASSERTF(OBD_CONNECT_FLOCK_DEAD == 0x8000000000000ULL, "found 0x%.16llxULL\n",
 	         OBD_CONNECT_FLOCK_DEAD);
+	LASSERTF(OBD_CONNECT_BL_BATCH == 0x10000000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT_BL_BATCH);
+	LASSERTF(OBD_CONNECT_LOCK_CONVERT == 0x20000000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT_LOCK_CONVERT);
+	LASSERTF(OBD_CONNECT_PING_AGG == 0x40000000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT_PING_AGG);
 	LASSERTF(OBD_CKSUM_CRC32 == 0x00000001UL, "found 0x%.8xUL\n",
 		(unsigned)OBD_CKSUM_CRC32);
 	LASSERTF(OBD_CKSUM_ADLER == 0x00000002UL, "found 0x%.8xUL\n",